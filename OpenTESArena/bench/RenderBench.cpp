@@ -0,0 +1,1636 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "SDL.h"
+
+#include "../src/Math/Constants.h"
+#include "../src/Math/Vector2.h"
+#include "../src/Math/Vector3.h"
+#include "../src/Rendering/Renderer.h"
+#include "../src/Rendering/SoftwareRenderer.h"
+#include "../src/Rendering/SpanKernels.h"
+#include "../src/Rendering/Surface.h"
+#include "../src/Utilities/Platform.h"
+#include "../src/World/DistantSky.h"
+#include "../src/World/LevelData.h"
+#include "../src/World/VoxelData.h"
+#include "../src/World/VoxelGrid.h"
+
+// Headless benchmark for the software renderer. It builds synthetic scenes (no game data),
+// renders them into a memory buffer along scripted camera paths, and writes frame and phase
+// timings as JSON to stdout so they can be tracked on machines without a GPU.
+
+namespace
+{
+	// Voxel texture IDs.
+	const int TEXTURE_COBBLE = 0;
+	const int TEXTURE_BRICK = 1;
+	const int TEXTURE_PLASTER = 2;
+	const int TEXTURE_STONE = 3;
+	const int TEXTURE_WOOD = 4;
+	const int TEXTURE_BARS = 5;
+	const int TEXTURE_WATER = 6;
+	const int TEXTURE_LAVA = 7;
+	const int TEXTURE_CEILING = 8;
+	const int VOXEL_TEXTURE_COUNT = 9;
+
+	// Flat texture IDs.
+	const int FLAT_TREE = 0;
+	const int FLAT_LAMP = 1;
+	const int FLAT_CREATURE = 2;
+	const int FLAT_TORCH = 3;
+	const int FLAT_TEXTURE_COUNT = 4;
+
+	const double FOV_Y = 60.0;
+	const double EYE_HEIGHT = 1.60;
+
+	// Renderer phases reported besides the whole frame. Render thread phases are averaged
+	// across threads.
+	const int PHASE_COUNT = 7;
+	const std::array<const char*, PHASE_COUNT> PHASE_NAMES =
+	{
+		"visibleDistantObjects", "visibleFlats", "skyGradient", "distantSky", "voxels",
+		"flats", "wait"
+	};
+
+	// Deterministic hash so scenes are identical on every machine.
+	uint32_t hash(uint32_t a, uint32_t b, uint32_t c)
+	{
+		uint32_t h = (a * 73856093u) ^ (b * 19349663u) ^ (c * 83492791u);
+		h ^= h >> 13;
+		h *= 0x5BD1E995u;
+		h ^= h >> 15;
+		return h;
+	}
+
+	// FNV-1a checksum of a frame's pixels, so frames can be compared between builds without
+	// saving images.
+	uint32_t hashFrame(const uint32_t *pixels, int count)
+	{
+		uint32_t h = 2166136261u;
+		for (int i = 0; i < count; i++)
+		{
+			uint32_t pixel = pixels[i];
+			for (int j = 0; j < 4; j++)
+			{
+				h = (h ^ (pixel & 0xFF)) * 16777619u;
+				pixel >>= 8;
+			}
+		}
+
+		return h;
+	}
+
+	uint32_t makeARGB(int r, int g, int b)
+	{
+		return 0xFF000000u | (static_cast<uint32_t>(std::min(std::max(r, 0), 255)) << 16) |
+			(static_cast<uint32_t>(std::min(std::max(g, 0), 255)) << 8) |
+			static_cast<uint32_t>(std::min(std::max(b, 0), 255));
+	}
+
+	// Generates a noisy 64x64 voxel texture with the given base color. Every 'mortar' pixels
+	// there is a darker line, and transparent textures get holes between bars.
+	std::vector<uint32_t> makeVoxelTexture(int textureID, int r, int g, int b, int mortar,
+		bool bars, bool window)
+	{
+		const int width = SpanKernels::TEXTURE_WIDTH;
+		const int height = SpanKernels::TEXTURE_HEIGHT;
+		std::vector<uint32_t> texels(width * height);
+
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				const int noise = static_cast<int>(hash(x, y, textureID) % 32) - 16;
+				const int brickOffset = (mortar > 0) ? ((y / mortar) * (mortar / 2)) : 0;
+				const bool isMortar = (mortar > 0) &&
+					(((y % mortar) == 0) || (((x + brickOffset) % (mortar * 2)) == 0));
+				const int shade = isMortar ? -60 : noise;
+				uint32_t &texel = texels[x + (y * width)];
+
+				if (bars && ((x % 16) >= 3) && ((y % 32) >= 3))
+				{
+					texel = 0; // Transparent.
+				}
+				else if (window && (x >= 24) && (x < 40) && (y >= 16) && (y < 40))
+				{
+					texel = 0xFFFFFFFF; // White, for night lights.
+				}
+				else
+				{
+					texel = makeARGB(r + shade, g + shade, b + shade);
+				}
+			}
+		}
+
+		return texels;
+	}
+
+	// Generates a flat texture: a filled ellipse with a transparent background.
+	std::vector<uint32_t> makeFlatTexture(int textureID, int width, int height, int r, int g,
+		int b, bool trunk)
+	{
+		std::vector<uint32_t> texels(width * height);
+
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				// An ellipse, or a smaller one on top of a trunk (mostly transparent, like
+				// real sprites).
+				const double xPercent = (static_cast<double>(x) + 0.50) / width;
+				const double yPercent = (static_cast<double>(y) + 0.50) / height;
+				bool inside;
+				if (trunk)
+				{
+					const double dx = xPercent - 0.50;
+					const double dy = (yPercent - 0.30) / 0.60;
+					inside = (((dx * dx) + (dy * dy)) < 0.09) ||
+						((yPercent >= 0.50) && (std::abs(dx) < 0.06));
+				}
+				else
+				{
+					const double dx = xPercent - 0.50;
+					const double dy = yPercent - 0.50;
+					inside = ((dx * dx) + (dy * dy)) < 0.25;
+				}
+
+				const int noise = static_cast<int>(hash(x, y, textureID + 100) % 40) - 20;
+				texels[x + (y * width)] = inside ? makeARGB(r + noise, g + noise, b + noise) : 0;
+			}
+		}
+
+		return texels;
+	}
+
+	// Creates a distant sky surface: a jagged silhouette (mountains) or a soft blob (clouds)
+	// on a transparent background.
+	Surface makeSkySurface(int width, int height, uint32_t seed, bool mountain)
+	{
+		Surface surface = Surface::createWithFormat(width, height,
+			Renderer::DEFAULT_BPP, Renderer::DEFAULT_PIXELFORMAT);
+		uint32_t *pixels = static_cast<uint32_t*>(surface.getPixels());
+
+		for (int x = 0; x < width; x++)
+		{
+			const double xPercent = static_cast<double>(x) / width;
+			const double ridge = 0.50 + (0.30 * std::sin((xPercent * 7.0) + seed)) +
+				(0.15 * std::sin((xPercent * 23.0) + (seed * 3))) - (0.05 * xPercent);
+
+			for (int y = 0; y < height; y++)
+			{
+				const double yPercent = 1.0 - (static_cast<double>(y) / height);
+				const bool inside = mountain ? (yPercent < ridge) :
+					(std::abs(yPercent - 0.50) < (0.40 * std::sin(xPercent * Constants::Pi)));
+				const int noise = static_cast<int>(hash(x, y, seed) % 24);
+				pixels[x + (y * width)] = !inside ? 0 : (mountain ?
+					makeARGB(70 + noise, 80 + noise, 90 + noise) :
+					makeARGB(220 + noise, 220 + noise, 230 + noise));
+			}
+		}
+
+		return surface;
+	}
+
+	// Owns the distant sky and the surfaces it points to.
+	struct SkyAssets
+	{
+		std::vector<std::unique_ptr<Surface>> surfaces;
+		DistantSky distantSky;
+
+		const Surface &addSurface(Surface &&surface)
+		{
+			this->surfaces.push_back(std::make_unique<Surface>(std::move(surface)));
+			return *this->surfaces.back();
+		}
+
+		void init(int starDensity)
+		{
+			// Mountains around the horizon.
+			const int mountainCount = 24;
+			for (int i = 0; i < mountainCount; i++)
+			{
+				const Surface &surface = this->addSurface(makeSkySurface(160, 60, i, true));
+				const double angle = (Constants::TwoPi * i) / mountainCount;
+				this->distantSky.addLandObject(DistantSky::LandObject(surface, angle));
+			}
+
+			// An animated land object (i.e., a volcano).
+			DistantSky::AnimatedLandObject animLandObject(0.75 * Constants::Pi);
+			for (int i = 0; i < 4; i++)
+			{
+				animLandObject.addSurface(this->addSurface(makeSkySurface(96, 80, 50 + i, true)));
+			}
+
+			this->distantSky.addAnimatedLandObject(animLandObject);
+
+			// Clouds at varying heights.
+			const int cloudCount = 12;
+			for (int i = 0; i < cloudCount; i++)
+			{
+				const Surface &surface = this->addSurface(makeSkySurface(128, 40, 100 + i, false));
+				const double angle = (Constants::TwoPi * i) / cloudCount;
+				const double height = 0.20 + (0.05 * (i % 8));
+				this->distantSky.addAirObject(DistantSky::AirObject(surface, angle, height));
+			}
+
+			// Moons, stars, and the sun.
+			const Surface &moonSurface = this->addSurface(makeSkySurface(24, 24, 200, false));
+			this->distantSky.addMoonObject(DistantSky::MoonObject(
+				moonSurface, 0.25, DistantSky::MoonObject::Type::First));
+			this->distantSky.addMoonObject(DistantSky::MoonObject(
+				moonSurface, 0.60, DistantSky::MoonObject::Type::Second));
+
+			const Surface &largeStarSurface = this->addSurface(makeSkySurface(5, 5, 300, false));
+			const int starCount = DistantSky::getStarCountFromDensity(starDensity);
+			for (int i = 0; i < starCount; i++)
+			{
+				const Double3 direction = Double3(
+					(static_cast<double>(hash(i, 0, 400) % 2001) / 1000.0) - 1.0,
+					(static_cast<double>(hash(i, 1, 400) % 2001) / 1000.0) - 1.0,
+					(static_cast<double>(hash(i, 2, 400) % 2001) / 1000.0) - 1.0).normalized();
+
+				if ((i % 100) == 0)
+				{
+					this->distantSky.addStarObject(
+						DistantSky::StarObject::makeLarge(largeStarSurface, direction));
+				}
+				else
+				{
+					const uint32_t color = makeARGB(190 + (i % 64), 190 + (i % 64), 255);
+					this->distantSky.addStarObject(DistantSky::StarObject::makeSmall(color, direction));
+				}
+			}
+
+			this->distantSky.setSunSurface(this->addSurface(makeSkySurface(20, 20, 500, false)));
+		}
+	};
+
+	struct BenchFlat
+	{
+		Double3 position;
+		double width, height;
+		int textureID;
+
+		BenchFlat(const Double3 &position, double width, double height, int textureID)
+			: position(position), width(width), height(height), textureID(textureID) { }
+	};
+
+	struct BenchLight
+	{
+		Double3 point, color;
+		double intensity;
+
+		BenchLight(const Double3 &point, const Double3 &color, double intensity)
+			: point(point), color(color), intensity(intensity) { }
+	};
+
+	// A synthetic level plus the lighting and camera path to render it with.
+	struct Scene
+	{
+		std::string name;
+		std::unique_ptr<VoxelGrid> voxelGrid;
+		std::vector<LevelData::DoorState> openDoors;
+		std::vector<BenchFlat> flats;
+		std::vector<BenchLight> lights;
+		std::vector<Double2> cameraPath; // Closed loop of XZ points.
+		std::vector<uint32_t> skyColors;
+		double daytimePercent, ambient, latitude, fogDistance, ceilingHeight;
+		bool hasDistantSky, nightLights;
+	};
+
+	// Makes an empty voxel grid. Like in the game's levels, voxel ID 0 is air.
+	std::unique_ptr<VoxelGrid> makeVoxelGrid(int width, int height, int depth)
+	{
+		auto voxelGrid = std::make_unique<VoxelGrid>(width, height, depth);
+		voxelGrid->addVoxelData(VoxelData());
+		return voxelGrid;
+	}
+
+	// City blocks: a street grid with buildings of varying heights, trees and lamps along the
+	// streets, and the distant sky. Daytime and nighttime variants light it differently.
+	Scene makeCityScene(bool night)
+	{
+		const int width = 80;
+		const int height = 4;
+		const int depth = 80;
+		const int blockSize = 10;
+		const int streetWidth = 3;
+
+		Scene scene;
+		scene.name = night ? "city-night" : "city-day";
+		scene.voxelGrid = makeVoxelGrid(width, height, depth);
+		VoxelGrid &voxelGrid = *scene.voxelGrid;
+
+		const uint16_t floorID = voxelGrid.addVoxelData(VoxelData::makeFloor(TEXTURE_COBBLE));
+		const uint16_t wallIDs[] =
+		{
+			voxelGrid.addVoxelData(VoxelData::makeWall(TEXTURE_BRICK, TEXTURE_COBBLE,
+				TEXTURE_CEILING, nullptr, VoxelData::WallData::Type::Solid)),
+			voxelGrid.addVoxelData(VoxelData::makeWall(TEXTURE_PLASTER, TEXTURE_COBBLE,
+				TEXTURE_CEILING, nullptr, VoxelData::WallData::Type::Solid)),
+			voxelGrid.addVoxelData(VoxelData::makeWall(TEXTURE_STONE, TEXTURE_COBBLE,
+				TEXTURE_CEILING, nullptr, VoxelData::WallData::Type::Solid))
+		};
+
+		const uint16_t fenceID = voxelGrid.addVoxelData(
+			VoxelData::makeTransparentWall(TEXTURE_BARS, true));
+
+		for (int x = 0; x < width; x++)
+		{
+			for (int z = 0; z < depth; z++)
+			{
+				voxelGrid.setVoxel(x, 0, z, floorID);
+
+				const bool isBorder = (x == 0) || (z == 0) || (x == (width - 1)) ||
+					(z == (depth - 1));
+				const bool isStreet = ((x % blockSize) < streetWidth) ||
+					((z % blockSize) < streetWidth);
+				const uint32_t blockHash = hash(x / blockSize, z / blockSize, 1);
+
+				if (isBorder)
+				{
+					voxelGrid.setVoxel(x, 1, z, wallIDs[2]);
+				}
+				else if (!isStreet)
+				{
+					// Courtyards are fenced in, everything else is a building.
+					const bool isCourtyard = (blockHash % 5) == 0;
+					const int localX = x % blockSize;
+					const int localZ = z % blockSize;
+					const bool isCourtyardEdge = (localX == streetWidth) ||
+						(localZ == streetWidth) || (localX == (blockSize - 1)) ||
+						(localZ == (blockSize - 1));
+
+					if (isCourtyard)
+					{
+						if (isCourtyardEdge)
+						{
+							voxelGrid.setVoxel(x, 1, z, fenceID);
+						}
+					}
+					else
+					{
+						const uint16_t wallID = wallIDs[blockHash % 2];
+						const int stories = 1 + static_cast<int>((blockHash / 7) % 3);
+						for (int y = 1; y <= stories; y++)
+						{
+							voxelGrid.setVoxel(x, y, z, wallID);
+						}
+					}
+				}
+				else if ((hash(x, z, 2) % 11) == 0)
+				{
+					// Street furniture on the sides of the street, off the camera path.
+					const int localX = x % blockSize;
+					const int localZ = z % blockSize;
+					if ((localX != 1) && (localZ != 1))
+					{
+						const bool isTree = (hash(x, z, 3) % 3) != 0;
+						scene.flats.push_back(BenchFlat(
+							Double3(x + 0.50, 1.0, z + 0.50), isTree ? 1.20 : 0.35,
+							isTree ? 1.80 : 1.40, isTree ? FLAT_TREE : FLAT_LAMP));
+
+						// Lamps are lit at night.
+						if (!isTree && night)
+						{
+							scene.lights.push_back(BenchLight(Double3(x + 0.50, 2.20, z + 0.50),
+								Double3(0.90, 0.75, 0.45), 5.0));
+						}
+					}
+				}
+			}
+		}
+
+		// Walk around the outer streets, then cut through the middle.
+		const double lo = 11.50;
+		const double mid = 41.50;
+		const double hi = 71.50;
+		scene.cameraPath = { Double2(lo, lo), Double2(hi, lo), Double2(hi, mid),
+			Double2(lo, mid), Double2(lo, hi), Double2(hi, hi), Double2(hi, hi - 10.0),
+			Double2(lo, hi - 10.0) };
+
+		const int skyColorCount = 64;
+		for (int i = 0; i < skyColorCount; i++)
+		{
+			// Dark at midnight, bright at noon.
+			const double percent = std::sin((Constants::Pi * i) / skyColorCount);
+			scene.skyColors.push_back(makeARGB(static_cast<int>(20 + (110 * percent)),
+				static_cast<int>(20 + (150 * percent)), static_cast<int>(50 + (200 * percent))));
+		}
+
+		scene.daytimePercent = night ? 0.05 : 0.50;
+		scene.ambient = night ? 0.20 : 1.0;
+		scene.latitude = 0.20;
+		scene.fogDistance = night ? 25.0 : 45.0;
+		scene.ceilingHeight = 1.0;
+		scene.hasDistantSky = true;
+		scene.nightLights = night;
+		return scene;
+	}
+
+	// Dungeon: a grid of rooms joined by corridors, with doors, chasms of each type,
+	// diagonal walls, bars, raised platforms, and creatures.
+	Scene makeDungeonScene()
+	{
+		const int width = 64;
+		const int height = 3;
+		const int depth = 64;
+		const int cellSize = 8;
+		const int cellCount = width / cellSize;
+
+		Scene scene;
+		scene.name = "dungeon";
+		scene.voxelGrid = makeVoxelGrid(width, height, depth);
+		VoxelGrid &voxelGrid = *scene.voxelGrid;
+
+		const uint16_t floorID = voxelGrid.addVoxelData(VoxelData::makeFloor(TEXTURE_STONE));
+		const uint16_t ceilingID = voxelGrid.addVoxelData(VoxelData::makeCeiling(TEXTURE_CEILING));
+		const uint16_t wallID = voxelGrid.addVoxelData(VoxelData::makeWall(TEXTURE_STONE,
+			TEXTURE_STONE, TEXTURE_CEILING, nullptr, VoxelData::WallData::Type::Solid));
+		const uint16_t barsID = voxelGrid.addVoxelData(
+			VoxelData::makeTransparentWall(TEXTURE_BARS, true));
+		const uint16_t diagonalIDs[] =
+		{
+			voxelGrid.addVoxelData(VoxelData::makeDiagonal(TEXTURE_BRICK, true)),
+			voxelGrid.addVoxelData(VoxelData::makeDiagonal(TEXTURE_BRICK, false))
+		};
+
+		const uint16_t raisedID = voxelGrid.addVoxelData(VoxelData::makeRaised(TEXTURE_WOOD,
+			TEXTURE_WOOD, TEXTURE_WOOD, 0.0, 0.25, 0.75, 1.0));
+
+		const VoxelData::DoorData::Type doorTypes[] =
+		{
+			VoxelData::DoorData::Type::Swinging, VoxelData::DoorData::Type::Sliding,
+			VoxelData::DoorData::Type::Raising, VoxelData::DoorData::Type::Splitting
+		};
+
+		uint16_t doorIDs[4];
+		for (int i = 0; i < 4; i++)
+		{
+			doorIDs[i] = voxelGrid.addVoxelData(VoxelData::makeDoor(TEXTURE_WOOD, doorTypes[i]));
+		}
+
+		// Solid rock with floor and ceiling everywhere, then carve out rooms and corridors.
+		for (int x = 0; x < width; x++)
+		{
+			for (int z = 0; z < depth; z++)
+			{
+				voxelGrid.setVoxel(x, 0, z, floorID);
+				voxelGrid.setVoxel(x, 1, z, wallID);
+				voxelGrid.setVoxel(x, 2, z, ceilingID);
+			}
+		}
+
+		const int corridorOffset = cellSize / 2;
+		const int roomStart = 2;
+		const int roomEnd = cellSize - 2;
+		std::vector<bool> isChasm(width * depth, false);
+		std::vector<VoxelData::ChasmData::Type> chasmTypes(width * depth);
+
+		for (int x = 1; x < (width - 1); x++)
+		{
+			for (int z = 1; z < (depth - 1); z++)
+			{
+				const int localX = x % cellSize;
+				const int localZ = z % cellSize;
+				const bool isCorridor = (localX == corridorOffset) || (localZ == corridorOffset);
+				const bool isRoom = (localX >= roomStart) && (localX < roomEnd) &&
+					(localZ >= roomStart) && (localZ < roomEnd);
+
+				if (isCorridor || isRoom)
+				{
+					voxelGrid.setVoxel(x, 1, z, 0);
+				}
+			}
+		}
+
+		for (int i = 0; i < cellCount; i++)
+		{
+			for (int j = 0; j < cellCount; j++)
+			{
+				const int cellX = i * cellSize;
+				const int cellZ = j * cellSize;
+				const uint32_t cellHash = hash(i, j, 10);
+
+				// Room corners: a diagonal wall, bars, and a raised platform.
+				voxelGrid.setVoxel(cellX + roomEnd - 1, 1, cellZ + roomEnd - 1,
+					diagonalIDs[cellHash % 2]);
+				voxelGrid.setVoxel(cellX + roomStart, 1, cellZ + roomEnd - 1, barsID);
+				voxelGrid.setVoxel(cellX + roomEnd - 1, 1, cellZ + roomStart, raisedID);
+
+				// A 2x2 chasm in the remaining corner.
+				const VoxelData::ChasmData::Type chasmType =
+					static_cast<VoxelData::ChasmData::Type>(cellHash % 3);
+				for (int dx = 0; dx < 2; dx++)
+				{
+					for (int dz = 0; dz < 2; dz++)
+					{
+						const int index = (cellX + roomStart + dx) + ((cellZ + roomStart + dz) * width);
+						isChasm[index] = true;
+						chasmTypes[index] = chasmType;
+					}
+				}
+
+				// A door where the east corridor leaves the room, and a creature in the room.
+				const int doorX = cellX + roomEnd;
+				const int doorZ = cellZ + corridorOffset;
+				if (doorX < (width - 1))
+				{
+					voxelGrid.setVoxel(doorX, 1, doorZ, doorIDs[cellHash % 4]);
+
+					// Some doors are partly open; the rest are closed.
+					if (((cellHash / 4) % 2) == 0)
+					{
+						const double percentOpen = 0.25 + (0.25 * ((cellHash / 8) % 4));
+						scene.openDoors.push_back(LevelData::DoorState(Int2(doorX, doorZ),
+							percentOpen, LevelData::DoorState::Direction::None));
+					}
+				}
+
+				scene.flats.push_back(BenchFlat(Double3(cellX + roomStart + 0.50, 1.0,
+					cellZ + corridorOffset + 1.50), 0.80, 0.90, FLAT_CREATURE));
+				scene.flats.push_back(BenchFlat(Double3(cellX + corridorOffset + 1.50, 1.0,
+					cellZ + roomEnd - 0.50), 0.25, 0.50, FLAT_TORCH));
+				scene.lights.push_back(BenchLight(Double3(cellX + corridorOffset + 1.50, 1.40,
+					cellZ + roomEnd - 0.50), Double3(0.85, 0.55, 0.25), 4.0));
+			}
+		}
+
+		// Chasm walls face non-chasm neighbors (+X is north, +Z is east).
+		const int chasmTextures[] = { TEXTURE_STONE, TEXTURE_WATER, TEXTURE_LAVA };
+		for (int x = 1; x < (width - 1); x++)
+		{
+			for (int z = 1; z < (depth - 1); z++)
+			{
+				const int index = x + (z * width);
+				if (isChasm[index])
+				{
+					const VoxelData::ChasmData::Type chasmType = chasmTypes[index];
+					const bool north = !isChasm[index + 1];
+					const bool south = !isChasm[index - 1];
+					const bool east = !isChasm[index + width];
+					const bool west = !isChasm[index - width];
+					const uint16_t chasmID = voxelGrid.addVoxelData(VoxelData::makeChasm(
+						chasmTextures[static_cast<int>(chasmType)], north, east, south, west,
+						chasmType));
+					voxelGrid.setVoxel(x, 0, z, chasmID);
+				}
+			}
+		}
+
+		// Loop along the corridors, passing through rooms and doorways.
+		const double lo = corridorOffset + 0.50;
+		const double hi = ((cellCount - 1) * cellSize) + corridorOffset + 0.50;
+		const double mid = ((cellCount / 2) * cellSize) + corridorOffset + 0.50;
+		scene.cameraPath = { Double2(lo, lo), Double2(hi, lo), Double2(hi, mid),
+			Double2(lo, mid), Double2(lo, hi), Double2(hi, hi), Double2(hi, hi - cellSize),
+			Double2(lo, hi - cellSize) };
+
+		scene.skyColors.push_back(makeARGB(0, 0, 0));
+		scene.daytimePercent = 0.50;
+		scene.ambient = 0.35;
+		scene.latitude = 0.0;
+		scene.fogDistance = 16.0;
+		scene.ceilingHeight = 1.0;
+		scene.hasDistantSky = false;
+		scene.nightLights = false;
+		return scene;
+	}
+
+	// Wilderness: open ground out to the fog with scattered ruins and a lot of trees, so most
+	// rays travel the whole fog distance. The clear variant sees far, the snowy one doesn't.
+	Scene makeWildernessScene(bool snow)
+	{
+		const int width = 160;
+		const int height = 3;
+		const int depth = 160;
+
+		Scene scene;
+		scene.name = snow ? "wild-snow" : "wild-clear";
+		scene.voxelGrid = makeVoxelGrid(width, height, depth);
+		VoxelGrid &voxelGrid = *scene.voxelGrid;
+
+		const uint16_t floorID = voxelGrid.addVoxelData(VoxelData::makeFloor(TEXTURE_COBBLE));
+		const uint16_t ruinIDs[] =
+		{
+			voxelGrid.addVoxelData(VoxelData::makeWall(TEXTURE_STONE, TEXTURE_STONE,
+				TEXTURE_STONE, nullptr, VoxelData::WallData::Type::Solid)),
+			voxelGrid.addVoxelData(VoxelData::makeWall(TEXTURE_BRICK, TEXTURE_STONE,
+				TEXTURE_STONE, nullptr, VoxelData::WallData::Type::Solid))
+		};
+
+		for (int x = 0; x < width; x++)
+		{
+			for (int z = 0; z < depth; z++)
+			{
+				voxelGrid.setVoxel(x, 0, z, floorID);
+
+				// Keep a clear ring for the camera path.
+				const int ringDistance = std::max(std::abs((2 * x) - width),
+					std::abs((2 * z) - depth)) / 2;
+				const bool isPath = std::abs(ringDistance - 40) <= 1;
+				if (isPath)
+				{
+					continue;
+				}
+
+				const uint32_t cellHash = hash(x, z, 20);
+				if ((cellHash % 97) == 0)
+				{
+					// A broken wall, one or two voxels high.
+					const uint16_t ruinID = ruinIDs[(cellHash / 97) % 2];
+					const int stories = 1 + static_cast<int>((cellHash / 194) % 2);
+					for (int y = 1; y <= stories; y++)
+					{
+						voxelGrid.setVoxel(x, y, z, ruinID);
+					}
+				}
+				else if ((cellHash % 7) == 0)
+				{
+					const double offsetX = static_cast<double>((cellHash / 7) % 5) * 0.15;
+					const double offsetZ = static_cast<double>((cellHash / 35) % 5) * 0.15;
+					const double treeScale = 1.0 + (static_cast<double>((cellHash / 175) % 4) * 0.25);
+					scene.flats.push_back(BenchFlat(Double3(x + 0.20 + offsetX, 1.0,
+						z + 0.20 + offsetZ), 1.20 * treeScale, 1.80 * treeScale, FLAT_TREE));
+				}
+			}
+		}
+
+		// Walk a square loop around the middle of the map.
+		const double lo = (width / 2) - 40.0 + 0.50;
+		const double hi = (width / 2) + 40.0 + 0.50;
+		scene.cameraPath = { Double2(lo, lo), Double2(hi, lo), Double2(hi, hi), Double2(lo, hi) };
+
+		const int skyColorCount = 64;
+		for (int i = 0; i < skyColorCount; i++)
+		{
+			// Snowy skies are a flat gray.
+			const double percent = std::sin((Constants::Pi * i) / skyColorCount);
+			scene.skyColors.push_back(snow ?
+				makeARGB(static_cast<int>(60 + (130 * percent)), static_cast<int>(60 + (130 * percent)),
+					static_cast<int>(70 + (130 * percent))) :
+				makeARGB(static_cast<int>(20 + (110 * percent)), static_cast<int>(20 + (150 * percent)),
+					static_cast<int>(50 + (200 * percent))));
+		}
+
+		scene.daytimePercent = 0.50;
+		scene.ambient = 1.0;
+		scene.latitude = 0.20;
+		scene.fogDistance = snow ? 20.0 : 100.0;
+		scene.ceilingHeight = 1.0;
+		scene.hasDistantSky = true;
+		scene.nightLights = false;
+		return scene;
+	}
+
+	Scene makeScene(const std::string &name)
+	{
+		if (name == "city-day")
+		{
+			return makeCityScene(false);
+		}
+		else if (name == "city-night")
+		{
+			return makeCityScene(true);
+		}
+		else if (name == "city-dusk")
+		{
+			// Between two of the sky's time of day steps, so shading that moves in steps (i.e.,
+			// with frame reuse) and smooth shading give different frames.
+			Scene scene = makeCityScene(false);
+			scene.name = "city-dusk";
+			scene.daytimePercent = 0.7413;
+			scene.ambient = 0.60;
+			return scene;
+		}
+		else if (name == "dungeon")
+		{
+			return makeDungeonScene();
+		}
+		else if (name == "wild-clear")
+		{
+			return makeWildernessScene(false);
+		}
+		else if (name == "wild-snow")
+		{
+			return makeWildernessScene(true);
+		}
+		else
+		{
+			throw std::runtime_error("Unknown scene \"" + name + "\".");
+		}
+	}
+
+	// Gets the camera position and direction for some percent through a scene's closed path.
+	// The camera looks back and forth while walking so frames see different geometry.
+	void getCameraPose(const Scene &scene, double percent, Double3 *outEye,
+		Double3 *outDirection)
+	{
+		const std::vector<Double2> &path = scene.cameraPath;
+		const int pointCount = static_cast<int>(path.size());
+
+		double totalLength = 0.0;
+		for (int i = 0; i < pointCount; i++)
+		{
+			totalLength += (path[(i + 1) % pointCount] - path[i]).length();
+		}
+
+		double distance = percent * totalLength;
+		int segment = 0;
+		double segmentLength = (path[1] - path[0]).length();
+		while ((distance > segmentLength) && (segment < (pointCount - 1)))
+		{
+			distance -= segmentLength;
+			segment++;
+			segmentLength = (path[(segment + 1) % pointCount] - path[segment]).length();
+		}
+
+		const Double2 &start = path[segment];
+		const Double2 &end = path[(segment + 1) % pointCount];
+		const Double2 forward = (end - start).normalized();
+		const Double2 position = start + (forward * std::min(distance, segmentLength));
+
+		const double yaw = std::atan2(forward.y, forward.x) +
+			(0.60 * std::sin(percent * Constants::TwoPi * 5.0));
+		const double pitch = 0.10 * std::sin(percent * Constants::TwoPi * 3.0);
+
+		*outEye = Double3(position.x, EYE_HEIGHT, position.y);
+		*outDirection = Double3(std::cos(yaw), pitch, std::sin(yaw)).normalized();
+	}
+
+	// Stand-in for the game's palette, since the scenes' textures aren't paletted: 8 levels of
+	// red and green and 4 of blue.
+	std::vector<uint32_t> makePalette()
+	{
+		std::vector<uint32_t> colors(256);
+		for (size_t i = 0; i < colors.size(); i++)
+		{
+			const int r = static_cast<int>((i >> 5) & 0x7) * 255 / 7;
+			const int g = static_cast<int>((i >> 2) & 0x7) * 255 / 7;
+			const int b = static_cast<int>(i & 0x3) * 255 / 3;
+			colors[i] = makeARGB(r, g, b);
+		}
+
+		return colors;
+	}
+
+	void loadTextures(SoftwareRenderer &renderer)
+	{
+		struct VoxelTextureDef
+		{
+			int r, g, b, mortar;
+			bool bars, window;
+		};
+
+		const VoxelTextureDef voxelDefs[VOXEL_TEXTURE_COUNT] =
+		{
+			{ 120, 115, 105, 8, false, false }, // Cobble.
+			{ 150, 70, 50, 8, false, false }, // Brick.
+			{ 200, 190, 160, 0, false, true }, // Plaster.
+			{ 100, 100, 100, 16, false, false }, // Stone.
+			{ 120, 80, 40, 32, false, false }, // Wood.
+			{ 60, 60, 70, 0, true, false }, // Bars.
+			{ 40, 60, 140, 0, false, false }, // Water.
+			{ 220, 80, 10, 0, false, false }, // Lava.
+			{ 70, 65, 60, 0, false, false } // Ceiling.
+		};
+
+		for (int i = 0; i < VOXEL_TEXTURE_COUNT; i++)
+		{
+			const VoxelTextureDef &def = voxelDefs[i];
+			const std::vector<uint32_t> texels =
+				makeVoxelTexture(i, def.r, def.g, def.b, def.mortar, def.bars, def.window);
+			renderer.setVoxelTexture(i, texels.data());
+		}
+
+		struct FlatTextureDef
+		{
+			int width, height, r, g, b;
+			bool trunk;
+		};
+
+		const FlatTextureDef flatDefs[FLAT_TEXTURE_COUNT] =
+		{
+			{ 64, 96, 40, 120, 40, true }, // Tree.
+			{ 16, 64, 230, 200, 120, false }, // Lamp.
+			{ 48, 56, 140, 110, 90, false }, // Creature.
+			{ 16, 32, 250, 150, 40, false } // Torch.
+		};
+
+		for (int i = 0; i < FLAT_TEXTURE_COUNT; i++)
+		{
+			const FlatTextureDef &def = flatDefs[i];
+			const std::vector<uint32_t> texels =
+				makeFlatTexture(i, def.width, def.height, def.r, def.g, def.b, def.trunk);
+			renderer.setFlatTexture(i, texels.data(), def.width, def.height);
+		}
+	}
+
+	struct BenchOptions
+	{
+		std::vector<std::string> scenes;
+		std::vector<Int2> resolutions;
+		std::vector<int> renderThreadsModes;
+		std::vector<int> depthBufferModes;
+		std::vector<SoftwareRenderer::TileLayout> tileLayouts;
+		std::vector<bool> framePipeliningModes;
+		int frames, warmupFrames;
+		int stillFrames; // Frames the camera stays at each pose.
+		double maxDrawDistance; // Zero for no limit besides the fog.
+		int starDensity; // Same as the star density option.
+		bool mipmapping;
+		bool paletted;
+		bool frameReuse; // Whether still frames show the last frame again like in the game.
+		int checkKernelSpans; // Random spans per span kernel check instead of benchmarking.
+		bool hashFrames; // Whether the checksum of each timed frame is written.
+
+		BenchOptions()
+		{
+			this->scenes = { "city-day", "city-night", "city-dusk", "dungeon", "wild-clear",
+				"wild-snow" };
+			this->resolutions = { Int2(320, 200), Int2(640, 400), Int2(1280, 720), Int2(1920, 1080) };
+			this->renderThreadsModes = { 0, 5 };
+			this->depthBufferModes = { 0 };
+			this->tileLayouts = { SoftwareRenderer::TileLayout::Columns };
+			this->framePipeliningModes = { false };
+			this->frames = 120;
+			this->warmupFrames = 10;
+			this->stillFrames = 1;
+			this->maxDrawDistance = 0.0;
+			this->starDensity = 1;
+			this->mipmapping = false;
+			this->paletted = false;
+			this->frameReuse = false;
+			this->checkKernelSpans = 0;
+			this->hashFrames = false;
+		}
+	};
+
+	std::vector<std::string> splitList(const std::string &str)
+	{
+		std::vector<std::string> values;
+		std::stringstream ss(str);
+		std::string value;
+		while (std::getline(ss, value, ','))
+		{
+			if (value.size() > 0)
+			{
+				values.push_back(value);
+			}
+		}
+
+		return values;
+	}
+
+	std::vector<int> parseIntList(const std::string &str)
+	{
+		std::vector<int> values;
+		for (const std::string &value : splitList(str))
+		{
+			values.push_back(std::stoi(value));
+		}
+
+		return values;
+	}
+
+	void printUsage()
+	{
+		std::cerr << "Usage: tes_render_bench [options]\n" <<
+			"  --scenes city-day,city-night,city-dusk,dungeon,wild-clear,wild-snow\n" <<
+			"  --resolutions 320x200,640x400,1280x720,1920x1080\n" <<
+			"  --threads 0,5          Render threads modes (0 = one thread, 5 = max).\n" <<
+			"  --depth 0              Depth buffer modes (0 = 64-bit, 1 = 32-bit, 2 = 16-bit).\n" <<
+			"  --tiles columns        Render thread tile layouts (columns, interleaved).\n" <<
+			"  --pipelining 0,1       Frame pipelining off and/or on.\n" <<
+			"  --frames 120           Timed frames per run.\n" <<
+			"  --warmup 10            Untimed frames per run.\n" <<
+			"  --still-frames 1       Frames the camera stays still at each pose.\n" <<
+			"  --draw-distance 0      Max draw distance (0 = fog distance only).\n" <<
+			"  --star-density 1       Star density (0 = classic, 1 = moderate, 2 = high).\n" <<
+			"  --mipmapping 0         Mipmapped voxel and flat textures off (0) or on (1).\n" <<
+			"  --paletted 0           Frames drawn in ARGB8888 (0) or as palette indices (1).\n" <<
+			"  --frame-reuse 0        Unchanged frames drawn again (0) or reused (1).\n" <<
+			"  --check-kernels 0      Compare SIMD span kernels with scalar ones on this many\n" <<
+			"                         random spans instead of benchmarking (0 = off).\n" <<
+			"  --hash 0               Write a checksum of each timed frame (1) or not (0).\n";
+	}
+
+	const char *getTileLayoutName(SoftwareRenderer::TileLayout tileLayout)
+	{
+		switch (tileLayout)
+		{
+		case SoftwareRenderer::TileLayout::Columns:
+			return "columns";
+		case SoftwareRenderer::TileLayout::Interleaved:
+			return "interleaved";
+		default:
+			return "unknown";
+		}
+	}
+
+	SoftwareRenderer::TileLayout getTileLayout(const std::string &name)
+	{
+		if (name == getTileLayoutName(SoftwareRenderer::TileLayout::Columns))
+		{
+			return SoftwareRenderer::TileLayout::Columns;
+		}
+		else if (name == getTileLayoutName(SoftwareRenderer::TileLayout::Interleaved))
+		{
+			return SoftwareRenderer::TileLayout::Interleaved;
+		}
+		else
+		{
+			throw std::runtime_error("Invalid tile layout \"" + name + "\".");
+		}
+	}
+
+	BenchOptions parseOptions(int argc, char *argv[])
+	{
+		BenchOptions options;
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+			if ((arg == "--help") || (arg == "-h"))
+			{
+				printUsage();
+				std::exit(EXIT_SUCCESS);
+			}
+
+			if ((i + 1) >= argc)
+			{
+				throw std::runtime_error("Missing value for \"" + arg + "\".");
+			}
+
+			const std::string value = argv[++i];
+			if (arg == "--scenes")
+			{
+				options.scenes = splitList(value);
+			}
+			else if (arg == "--resolutions")
+			{
+				options.resolutions.clear();
+				for (const std::string &resolution : splitList(value))
+				{
+					const size_t xIndex = resolution.find('x');
+					if (xIndex == std::string::npos)
+					{
+						throw std::runtime_error("Invalid resolution \"" + resolution + "\".");
+					}
+
+					options.resolutions.push_back(Int2(std::stoi(resolution.substr(0, xIndex)),
+						std::stoi(resolution.substr(xIndex + 1))));
+				}
+			}
+			else if (arg == "--threads")
+			{
+				options.renderThreadsModes = parseIntList(value);
+			}
+			else if (arg == "--depth")
+			{
+				options.depthBufferModes = parseIntList(value);
+			}
+			else if (arg == "--tiles")
+			{
+				options.tileLayouts.clear();
+				for (const std::string &name : splitList(value))
+				{
+					options.tileLayouts.push_back(getTileLayout(name));
+				}
+			}
+			else if (arg == "--pipelining")
+			{
+				options.framePipeliningModes.clear();
+				for (const int mode : parseIntList(value))
+				{
+					options.framePipeliningModes.push_back(mode != 0);
+				}
+			}
+			else if (arg == "--frames")
+			{
+				options.frames = std::max(std::stoi(value), 1);
+			}
+			else if (arg == "--warmup")
+			{
+				options.warmupFrames = std::max(std::stoi(value), 0);
+			}
+			else if (arg == "--still-frames")
+			{
+				options.stillFrames = std::max(std::stoi(value), 1);
+			}
+			else if (arg == "--draw-distance")
+			{
+				options.maxDrawDistance = std::max(std::stod(value), 0.0);
+			}
+			else if (arg == "--star-density")
+			{
+				options.starDensity = std::min(std::max(std::stoi(value), 0), 2);
+			}
+			else if (arg == "--mipmapping")
+			{
+				options.mipmapping = std::stoi(value) != 0;
+			}
+			else if (arg == "--paletted")
+			{
+				options.paletted = std::stoi(value) != 0;
+			}
+			else if (arg == "--frame-reuse")
+			{
+				options.frameReuse = std::stoi(value) != 0;
+			}
+			else if (arg == "--check-kernels")
+			{
+				options.checkKernelSpans = std::max(std::stoi(value), 0);
+			}
+			else if (arg == "--hash")
+			{
+				options.hashFrames = std::stoi(value) != 0;
+			}
+			else
+			{
+				throw std::runtime_error("Unknown option \"" + arg + "\".");
+			}
+		}
+
+		return options;
+	}
+
+	const char *getInstructionSetName(SpanKernels::InstructionSet instructionSet)
+	{
+		switch (instructionSet)
+		{
+		case SpanKernels::InstructionSet::Scalar:
+			return "Scalar";
+		case SpanKernels::InstructionSet::SSE2:
+			return "SSE2";
+		case SpanKernels::InstructionSet::AVX2:
+			return "AVX2";
+		default:
+			return "Unknown";
+		}
+	}
+
+	// Instruction sets besides scalar whose span kernels can run on this machine.
+	std::vector<SpanKernels::InstructionSet> getSIMDInstructionSets()
+	{
+		std::vector<SpanKernels::InstructionSet> instructionSets;
+		const SpanKernels::InstructionSet best = SpanKernels::getBestInstructionSet();
+		if (SpanKernels::isSSE2Built())
+		{
+			instructionSets.push_back(SpanKernels::InstructionSet::SSE2);
+		}
+
+		if (best == SpanKernels::InstructionSet::AVX2)
+		{
+			instructionSets.push_back(SpanKernels::InstructionSet::AVX2);
+		}
+
+		return instructionSets;
+	}
+
+	// Runs each SIMD span kernel and the scalar one on the same random spans (every mip level,
+	// row count and alignment) and counts spans whose texels, depths, or shaded colors differ
+	// in any bit. Returns whether all kernels matched.
+	bool checkSpanKernels(int spanCount)
+	{
+		std::mt19937 random(12345);
+		auto randomReal = [&random](double min, double max)
+		{
+			return std::uniform_real_distribution<double>(min, max)(random);
+		};
+
+		auto randomInt = [&random](int min, int max)
+		{
+			return std::uniform_int_distribution<int>(min, max)(random);
+		};
+
+		// Random texels for every mip level (smaller levels use the start of the buffer).
+		std::vector<uint32_t> texels(SpanKernels::TEXTURE_WIDTH * SpanKernels::TEXTURE_HEIGHT);
+		for (uint32_t &texel : texels)
+		{
+			texel = static_cast<uint32_t>(random());
+		}
+
+		const uint8_t *texelBytes = reinterpret_cast<const uint8_t*>(texels.data());
+
+		// Rows are kept inside the projected span like the renderer's clipped ranges, so
+		// texture coordinates stay in range.
+		auto getRows = [&randomInt](double yProjStart, double yProjEnd, int *yStart, int *yEnd)
+		{
+			const int firstRow = static_cast<int>(std::ceil(yProjStart));
+			const int lastRow = std::max(static_cast<int>(std::floor(yProjEnd)) - 1, firstRow);
+			*yStart = randomInt(firstRow, lastRow);
+			*yEnd = std::min(*yStart + randomInt(1, SpanKernels::MAX_ROWS), lastRow + 1);
+		};
+
+		bool success = true;
+		for (const SpanKernels::InstructionSet instructionSet : getSIMDInstructionSets())
+		{
+			const SpanKernels::WallSpanFunction sampleWallSpan =
+				SpanKernels::getWallSpanFunction(instructionSet);
+			const SpanKernels::PerspectiveSpanFunction samplePerspectiveSpan =
+				SpanKernels::getPerspectiveSpanFunction(instructionSet);
+			const SpanKernels::ShadeWallFunction shadeWallTexels =
+				SpanKernels::getShadeWallFunction(instructionSet);
+			const SpanKernels::ShadePerspectiveFunction shadePerspectiveTexels =
+				SpanKernels::getShadePerspectiveFunction(instructionSet);
+			const SpanKernels::ExpandIndicesFunction expandIndices =
+				SpanKernels::getExpandIndicesFunction(instructionSet);
+
+			std::array<uint32_t, SpanKernels::MAX_ROWS> expectedTexels, actualTexels;
+			std::array<double, SpanKernels::MAX_ROWS> expectedDepths, actualDepths;
+			int wallMismatches = 0;
+			int perspectiveMismatches = 0;
+			int shadeMismatches = 0;
+			int expandMismatches = 0;
+
+			for (int i = 0; i < spanCount; i++)
+			{
+				SpanKernels::WallSpan wallSpan;
+				wallSpan.texels = texelBytes;
+				wallSpan.textureBits = randomInt(0, SpanKernels::TEXTURE_BITS);
+				wallSpan.textureX = randomInt(0, (1 << wallSpan.textureBits) - 1);
+				wallSpan.yProjStart = randomReal(-400.0, 400.0);
+				wallSpan.yProjEnd = wallSpan.yProjStart + randomReal(1.0, 1200.0);
+				wallSpan.vStart = randomReal(0.0, Constants::JustBelowOne);
+				wallSpan.vEnd = randomReal(0.0, Constants::JustBelowOne);
+
+				int yStart, yEnd;
+				getRows(wallSpan.yProjStart, wallSpan.yProjEnd, &yStart, &yEnd);
+				const int rowCount = yEnd - yStart;
+
+				SpanKernels::sampleWallSpanScalar(wallSpan, yStart, yEnd, expectedTexels.data());
+				sampleWallSpan(wallSpan, yStart, yEnd, actualTexels.data());
+				if (std::memcmp(expectedTexels.data(), actualTexels.data(),
+					rowCount * sizeof(uint32_t)) != 0)
+				{
+					wallMismatches++;
+				}
+
+				const double depthStart = randomReal(0.05, 60.0);
+				const double depthEnd = randomReal(0.05, 60.0);
+				const Double2 startPoint(randomReal(-500.0, 500.0), randomReal(-500.0, 500.0));
+				const Double2 endPoint = startPoint +
+					Double2(randomReal(-8.0, 8.0), randomReal(-8.0, 8.0));
+				const Double2 startPointDiv = startPoint / depthStart;
+				const Double2 endPointDiv = endPoint / depthEnd;
+
+				SpanKernels::PerspectiveSpan perspectiveSpan;
+				perspectiveSpan.texels = texelBytes;
+				perspectiveSpan.textureBits = randomInt(0, SpanKernels::TEXTURE_BITS);
+				perspectiveSpan.yProjStart = randomReal(-400.0, 400.0);
+				perspectiveSpan.yProjEnd = perspectiveSpan.yProjStart + randomReal(1.0, 1200.0);
+				perspectiveSpan.depthStartRecip = 1.0 / depthStart;
+				perspectiveSpan.depthEndRecip = 1.0 / depthEnd;
+				perspectiveSpan.startPointDivX = startPointDiv.x;
+				perspectiveSpan.startPointDivY = startPointDiv.y;
+				perspectiveSpan.pointDivDiffX = endPointDiv.x - startPointDiv.x;
+				perspectiveSpan.pointDivDiffY = endPointDiv.y - startPointDiv.y;
+				perspectiveSpan.justBelowOne = Constants::JustBelowOne;
+				perspectiveSpan.lightEndR = 0;
+				perspectiveSpan.lightEndG = 0;
+				perspectiveSpan.lightEndB = 0;
+
+				getRows(perspectiveSpan.yProjStart, perspectiveSpan.yProjEnd, &yStart, &yEnd);
+				const int perspectiveRowCount = yEnd - yStart;
+
+				SpanKernels::samplePerspectiveSpanScalar(perspectiveSpan, yStart, yEnd,
+					expectedTexels.data(), expectedDepths.data());
+				samplePerspectiveSpan(perspectiveSpan, yStart, yEnd, actualTexels.data(),
+					actualDepths.data());
+				if ((std::memcmp(expectedTexels.data(), actualTexels.data(),
+					perspectiveRowCount * sizeof(uint32_t)) != 0) ||
+					(std::memcmp(expectedDepths.data(), actualDepths.data(),
+					perspectiveRowCount * sizeof(double)) != 0))
+				{
+					perspectiveMismatches++;
+				}
+
+				// Shade the sampled texels with random light and fog. Random texels also have
+				// random flags, so night light and emissive texels are covered.
+				SpanKernels::Shading shading;
+				shading.lightR = randomInt(0, SpanKernels::LIGHT_LEVEL_MAX);
+				shading.lightG = randomInt(0, SpanKernels::LIGHT_LEVEL_MAX);
+				shading.lightB = randomInt(0, SpanKernels::LIGHT_LEVEL_MAX);
+				shading.fogColor = static_cast<uint32_t>(random()) & 0xFFFFFF;
+				shading.fogScale = static_cast<double>(SpanKernels::FOG_FACTOR_MAX) /
+					randomReal(1.0, 100.0);
+				shading.nightLightTexel = static_cast<uint32_t>(random());
+
+				// Half of the perspective spans have constant light.
+				if (randomInt(0, 1) == 0)
+				{
+					perspectiveSpan.lightEndR = shading.lightR;
+					perspectiveSpan.lightEndG = shading.lightG;
+					perspectiveSpan.lightEndB = shading.lightB;
+				}
+				else
+				{
+					perspectiveSpan.lightEndR = randomInt(0, SpanKernels::LIGHT_LEVEL_MAX);
+					perspectiveSpan.lightEndG = randomInt(0, SpanKernels::LIGHT_LEVEL_MAX);
+					perspectiveSpan.lightEndB = randomInt(0, SpanKernels::LIGHT_LEVEL_MAX);
+				}
+
+				const int fogFactor = randomInt(0, SpanKernels::FOG_FACTOR_MAX);
+				std::array<uint32_t, SpanKernels::MAX_ROWS> expectedColors = expectedTexels;
+				std::array<uint32_t, SpanKernels::MAX_ROWS> actualColors = expectedTexels;
+				SpanKernels::shadeWallTexelsScalar(shading, fogFactor, perspectiveRowCount,
+					expectedColors.data());
+				shadeWallTexels(shading, fogFactor, perspectiveRowCount, actualColors.data());
+				const bool wallShadeMatches = std::memcmp(expectedColors.data(),
+					actualColors.data(), perspectiveRowCount * sizeof(uint32_t)) == 0;
+
+				expectedColors = expectedTexels;
+				actualColors = expectedTexels;
+				SpanKernels::shadePerspectiveTexelsScalar(perspectiveSpan, shading,
+					expectedDepths.data(), perspectiveRowCount, expectedColors.data());
+				shadePerspectiveTexels(perspectiveSpan, shading, expectedDepths.data(),
+					perspectiveRowCount, actualColors.data());
+				const bool perspectiveShadeMatches = std::memcmp(expectedColors.data(),
+					actualColors.data(), perspectiveRowCount * sizeof(uint32_t)) == 0;
+
+				if (!wallShadeMatches || !perspectiveShadeMatches)
+				{
+					shadeMismatches++;
+				}
+
+				// Expand a random run of palette indices with the random texels as the palette.
+				// The run starts at any byte so unaligned loads are covered.
+				std::array<uint8_t, SpanKernels::MAX_ROWS * 2> indices;
+				for (uint8_t &index : indices)
+				{
+					index = static_cast<uint8_t>(randomInt(0, 255));
+				}
+
+				const int indexStart = randomInt(0, SpanKernels::MAX_ROWS - 1);
+				const int indexCount = randomInt(0, SpanKernels::MAX_ROWS);
+				SpanKernels::expandIndicesScalar(texels.data(), indices.data() + indexStart,
+					indexCount, expectedColors.data());
+				expandIndices(texels.data(), indices.data() + indexStart, indexCount,
+					actualColors.data());
+				if (std::memcmp(expectedColors.data(), actualColors.data(),
+					indexCount * sizeof(uint32_t)) != 0)
+				{
+					expandMismatches++;
+				}
+			}
+
+			std::cout << getInstructionSetName(instructionSet) << " vs. Scalar: " <<
+				wallMismatches << " of " << spanCount << " wall spans, " <<
+				perspectiveMismatches << " of " << spanCount << " perspective spans, " <<
+				shadeMismatches << " of " << spanCount << " shaded spans, and " <<
+				expandMismatches << " of " << spanCount << " index runs differ.\n";
+
+			success &= (wallMismatches == 0) && (perspectiveMismatches == 0) &&
+				(shadeMismatches == 0) && (expandMismatches == 0);
+		}
+
+		return success;
+	}
+
+	// Nearest-rank percentile of sorted values.
+	double getPercentile(const std::vector<double> &sortedValues, double percent)
+	{
+		const int count = static_cast<int>(sortedValues.size());
+		const int rank = static_cast<int>(std::ceil(percent * count));
+		return sortedValues[std::min(std::max(rank - 1, 0), count - 1)];
+	}
+
+	// Writes the summary of a set of per-frame timings as a JSON object.
+	void writeTimings(std::ostream &stream, std::vector<double> frameTimes)
+	{
+		std::sort(frameTimes.begin(), frameTimes.end());
+
+		double total = 0.0;
+		for (const double frameTime : frameTimes)
+		{
+			total += frameTime;
+		}
+
+		stream << "{ \"mean\": " << (total / frameTimes.size()) <<
+			", \"min\": " << frameTimes.front() <<
+			", \"p50\": " << getPercentile(frameTimes, 0.50) <<
+			", \"p95\": " << getPercentile(frameTimes, 0.95) <<
+			", \"p99\": " << getPercentile(frameTimes, 0.99) <<
+			", \"max\": " << frameTimes.back() << " }";
+	}
+
+	// Gets the time of each reported phase, in the same order as the phase names.
+	std::array<double, PHASE_COUNT> getPhaseTimes(const SoftwareRenderer::FrameTimings &timings)
+	{
+		std::array<double, PHASE_COUNT> phaseTimes;
+		phaseTimes.fill(0.0);
+		phaseTimes[0] = timings.visibleDistantObjects;
+		phaseTimes[1] = timings.visibleFlats;
+
+		const double threadCount = static_cast<double>(timings.threads.size());
+		for (const SoftwareRenderer::FrameTimings::Thread &thread : timings.threads)
+		{
+			phaseTimes[2] += thread.skyGradient / threadCount;
+			phaseTimes[3] += thread.distantSky / threadCount;
+			phaseTimes[4] += thread.voxels / threadCount;
+			phaseTimes[5] += thread.flats / threadCount;
+			phaseTimes[6] += thread.wait / threadCount;
+		}
+
+		return phaseTimes;
+	}
+
+	struct RunResult
+	{
+		std::string scene;
+		Int2 resolution;
+		int renderThreadsMode, renderThreads, depthBufferMode;
+		SoftwareRenderer::TileLayout tileLayout;
+		bool framePipelining;
+		int stillFrames;
+		double maxDrawDistance;
+		bool mipmapping;
+		bool paletted;
+		bool frameReuse;
+		int reusedFrames; // Timed frames that showed the last frame again.
+		std::vector<double> frameTimes; // In milliseconds.
+		std::array<std::vector<double>, PHASE_COUNT> phaseTimes;
+		std::vector<uint32_t> frameHashes; // Empty unless frames are hashed.
+	};
+
+	RunResult runScene(const Scene &scene, const SkyAssets &skyAssets, const Int2 &resolution,
+		int renderThreadsMode, int depthBufferMode, SoftwareRenderer::TileLayout tileLayout,
+		bool framePipelining, double maxDrawDistance, bool mipmapping, bool paletted,
+		bool frameReuse, bool hashFrames, int frames, int warmupFrames, int stillFrames)
+	{
+		SoftwareRenderer renderer;
+		renderer.init(resolution.x, resolution.y, renderThreadsMode, depthBufferMode,
+			framePipelining);
+		renderer.setTileLayout(tileLayout);
+		renderer.setFogDistance(scene.fogDistance);
+
+		if (maxDrawDistance > 0.0)
+		{
+			renderer.setMaxDrawDistance(maxDrawDistance);
+		}
+
+		renderer.setMipmapping(mipmapping);
+
+		const std::vector<uint32_t> palette = makePalette();
+		renderer.setPalette(palette.data(), static_cast<int>(palette.size()));
+		renderer.setPalettedRendering(paletted);
+		renderer.setFrameReuse(frameReuse);
+
+		renderer.setSkyPalette(scene.skyColors.data(), static_cast<int>(scene.skyColors.size()));
+		loadTextures(renderer);
+
+		if (scene.hasDistantSky)
+		{
+			renderer.setDistantSky(skyAssets.distantSky);
+		}
+
+		renderer.setNightLightsActive(scene.nightLights);
+
+		for (size_t i = 0; i < scene.flats.size(); i++)
+		{
+			const BenchFlat &flat = scene.flats[i];
+			renderer.addFlat(static_cast<int>(i), flat.position, flat.width, flat.height,
+				flat.textureID);
+		}
+
+		for (size_t i = 0; i < scene.lights.size(); i++)
+		{
+			const BenchLight &light = scene.lights[i];
+			renderer.addLight(static_cast<int>(i), light.point, light.color, light.intensity);
+		}
+
+		std::vector<uint32_t> colorBuffer(resolution.x * resolution.y);
+		const uint32_t *frame = colorBuffer.data(); // Frame the caller would present.
+
+		RunResult result;
+		result.scene = scene.name;
+		result.resolution = resolution;
+		result.renderThreadsMode = renderThreadsMode;
+		result.renderThreads = SoftwareRenderer::getRenderThreadsFromMode(renderThreadsMode);
+		result.depthBufferMode = depthBufferMode;
+		result.tileLayout = tileLayout;
+		result.framePipelining = framePipelining;
+		result.stillFrames = stillFrames;
+		result.maxDrawDistance = maxDrawDistance;
+		result.mipmapping = mipmapping;
+		result.paletted = paletted;
+		result.frameReuse = frameReuse;
+		result.reusedFrames = 0;
+		result.frameTimes.reserve(frames);
+
+		const int totalFrames = warmupFrames + frames;
+		for (int i = 0; i < totalFrames; i++)
+		{
+			// The camera only moves to the next pose every few frames if it's standing still.
+			const double percent = static_cast<double>(i - (i % stillFrames)) / totalFrames;
+			Double3 eye, direction;
+			getCameraPose(scene, percent, &eye, &direction);
+
+			const auto startTime = std::chrono::steady_clock::now();
+
+			// Same as the game: an unchanged frame isn't given to the renderer at all.
+			const bool reused = renderer.isFrameReusable(eye, direction, FOV_Y, scene.ambient,
+				scene.daytimePercent, scene.latitude, true, scene.ceilingHeight, scene.openDoors,
+				*scene.voxelGrid);
+
+			if (reused)
+			{
+				// The last frame is still in the color buffer.
+			}
+			else if (framePipelining)
+			{
+				frame = renderer.renderPipelined(eye, direction, FOV_Y, scene.ambient,
+					scene.daytimePercent, scene.latitude, true, scene.ceilingHeight,
+					scene.openDoors, *scene.voxelGrid);
+			}
+			else
+			{
+				renderer.render(eye, direction, FOV_Y, scene.ambient, scene.daytimePercent,
+					scene.latitude, true, scene.ceilingHeight, scene.openDoors,
+					*scene.voxelGrid, colorBuffer.data());
+			}
+
+			const auto endTime = std::chrono::steady_clock::now();
+
+			if (i >= warmupFrames)
+			{
+				result.frameTimes.push_back(
+					std::chrono::duration<double, std::milli>(endTime - startTime).count());
+
+				if (reused)
+				{
+					result.reusedFrames++;
+				}
+
+				// With frame pipelining, these are from the previous frame. Reused frames didn't
+				// draw anything.
+				const std::array<double, PHASE_COUNT> phaseTimes = reused ?
+					std::array<double, PHASE_COUNT>() : getPhaseTimes(renderer.getFrameTimings());
+				for (int j = 0; j < PHASE_COUNT; j++)
+				{
+					result.phaseTimes[j].push_back(phaseTimes[j]);
+				}
+
+				if (hashFrames)
+				{
+					const int pixelCount = static_cast<int>(colorBuffer.size());
+					result.frameHashes.push_back(hashFrame(frame, pixelCount));
+				}
+			}
+		}
+
+		return result;
+	}
+
+	void writeResults(std::ostream &stream, const std::vector<RunResult> &results,
+		int starDensity)
+	{
+		stream << std::fixed << std::setprecision(4);
+		stream << "{\n";
+		stream << "  \"benchmark\": \"tes_render_bench\",\n";
+		stream << "  \"hardwareThreads\": " << Platform::getThreadCount() << ",\n";
+		stream << "  \"spanInstructionSet\": \"" <<
+			getInstructionSetName(SpanKernels::getBestInstructionSet()) << "\",\n";
+		stream << "  \"starDensity\": " << starDensity << ",\n";
+		stream << "  \"runs\": [\n";
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const RunResult &result = results[i];
+
+			double totalMilliseconds = 0.0;
+			for (const double frameTime : result.frameTimes)
+			{
+				totalMilliseconds += frameTime;
+			}
+
+			const double pixels = static_cast<double>(result.resolution.x) *
+				static_cast<double>(result.resolution.y) *
+				static_cast<double>(result.frameTimes.size());
+			const double pixelsPerSecond = pixels / (totalMilliseconds / 1000.0);
+
+			stream << "    {\n";
+			stream << "      \"scene\": \"" << result.scene << "\",\n";
+			stream << "      \"width\": " << result.resolution.x << ",\n";
+			stream << "      \"height\": " << result.resolution.y << ",\n";
+			stream << "      \"renderThreadsMode\": " << result.renderThreadsMode << ",\n";
+			stream << "      \"renderThreads\": " << result.renderThreads << ",\n";
+			stream << "      \"depthBufferMode\": " << result.depthBufferMode << ",\n";
+			stream << "      \"tileLayout\": \"" << getTileLayoutName(result.tileLayout) <<
+				"\",\n";
+			stream << "      \"framePipelining\": " <<
+				(result.framePipelining ? "true" : "false") << ",\n";
+			stream << "      \"stillFrames\": " << result.stillFrames << ",\n";
+			stream << "      \"maxDrawDistance\": " << result.maxDrawDistance << ",\n";
+			stream << "      \"mipmapping\": " << (result.mipmapping ? "true" : "false") << ",\n";
+			stream << "      \"paletted\": " << (result.paletted ? "true" : "false") << ",\n";
+			stream << "      \"frameReuse\": " << (result.frameReuse ? "true" : "false") << ",\n";
+			stream << "      \"reusedFrames\": " << result.reusedFrames << ",\n";
+			stream << "      \"frames\": " << result.frameTimes.size() << ",\n";
+			stream << "      \"phases\": {\n";
+			stream << "        \"frame\": ";
+			writeTimings(stream, result.frameTimes);
+
+			for (int j = 0; j < PHASE_COUNT; j++)
+			{
+				stream << ",\n        \"" << PHASE_NAMES[j] << "\": ";
+				writeTimings(stream, result.phaseTimes[j]);
+			}
+
+			stream << "\n";
+			stream << "      },\n";
+
+			if (result.frameHashes.size() > 0)
+			{
+				stream << "      \"frameHashes\": [";
+				for (size_t j = 0; j < result.frameHashes.size(); j++)
+				{
+					stream << ((j > 0) ? ", " : " ") << "\"" << std::hex << std::setw(8) <<
+						std::setfill('0') << result.frameHashes[j] << std::dec <<
+						std::setfill(' ') << "\"";
+				}
+
+				stream << " ],\n";
+			}
+
+			stream << "      \"pixelsPerSecond\": " << std::setprecision(0) << pixelsPerSecond <<
+				std::setprecision(4) << "\n";
+			stream << "    }" << (((i + 1) < results.size()) ? "," : "") << "\n";
+		}
+
+		stream << "  ]\n";
+		stream << "}\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	try
+	{
+		const BenchOptions options = parseOptions(argc, argv);
+
+		if (options.checkKernelSpans > 0)
+		{
+			return checkSpanKernels(options.checkKernelSpans) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		SkyAssets skyAssets;
+		skyAssets.init(options.starDensity);
+
+		std::vector<RunResult> results;
+		for (const std::string &sceneName : options.scenes)
+		{
+			const Scene scene = makeScene(sceneName);
+
+			for (const Int2 &resolution : options.resolutions)
+			{
+				for (const int renderThreadsMode : options.renderThreadsModes)
+				{
+					for (const int depthBufferMode : options.depthBufferModes)
+					{
+						for (const SoftwareRenderer::TileLayout tileLayout : options.tileLayouts)
+						{
+							for (const bool framePipelining : options.framePipeliningModes)
+							{
+								std::cerr << "Running " << scene.name << " at " << resolution.x <<
+									"x" << resolution.y << ", threads mode " << renderThreadsMode <<
+									", depth mode " << depthBufferMode << ", " <<
+									getTileLayoutName(tileLayout) << " tiles" <<
+									(framePipelining ? ", pipelined" : "") << "...\n";
+
+								results.push_back(runScene(scene, skyAssets, resolution,
+									renderThreadsMode, depthBufferMode, tileLayout,
+									framePipelining, options.maxDrawDistance, options.mipmapping,
+									options.paletted, options.frameReuse, options.hashFrames,
+									options.frames, options.warmupFrames, options.stillFrames));
+							}
+						}
+					}
+				}
+			}
+		}
+
+		writeResults(std::cout, results, options.starDensity);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "Error: " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -13,10 +13,13 @@
 #include "Options.h"
 #include "PlayerInterface.h"
 #include "../Assets/CityDataFile.h"
+#include "../Assets/COLFile.h"
 #include "../Interface/Panel.h"
 #include "../Media/FontManager.h"
 #include "../Media/MusicFile.h"
 #include "../Media/MusicName.h"
+#include "../Media/PaletteFile.h"
+#include "../Media/PaletteName.h"
 #include "../Media/TextureManager.h"
 #include "../Rendering/Renderer.h"
 #include "../Rendering/Surface.h"
@@ -82,10 +85,19 @@ Game::Game()
 	this->renderer.init(this->options.getGraphics_ScreenWidth(),
 		this->options.getGraphics_ScreenHeight(), this->options.getGraphics_Fullscreen(),
 		this->options.getGraphics_LetterboxMode());
+	this->renderer.setTargetFPS(this->options.getGraphics_TargetFPS());
+	this->renderer.setMaxDrawDistance(this->options.getGraphics_MaxDrawDistance());
+	this->renderer.setMipmapping(this->options.getGraphics_Mipmapping());
+	this->renderer.setPalettedRendering(this->options.getGraphics_PalettedRendering());
+	this->renderer.setFrameReuse(this->options.getGraphics_FrameReuse());
 
 	// Initialize the texture manager.
 	this->textureManager.init();
 
+	// The game world is drawn with the default palette when it's paletted. Its nearest color
+	// table is only built once paletted rendering is turned on.
+	this->renderer.setPalette(COLFile(PaletteFile::fromName(PaletteName::Default)).getPalette());
+
 	// Load various miscellaneous assets.
 	this->miscAssets.init();
 
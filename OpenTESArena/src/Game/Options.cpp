@@ -27,7 +27,14 @@ namespace
 		{ "LetterboxMode", OptionType::Int },
 		{ "CursorScale", OptionType::Double },
 		{ "ModernInterface", OptionType::Bool },
-		{ "RenderThreadsMode", OptionType::Int }
+		{ "RenderThreadsMode", OptionType::Int },
+		{ "DepthBufferMode", OptionType::Int },
+		{ "FramePipelining", OptionType::Bool },
+		{ "DynamicResolution", OptionType::Bool },
+		{ "MaxDrawDistance", OptionType::Double },
+		{ "Mipmapping", OptionType::Bool },
+		{ "PalettedRendering", OptionType::Bool },
+		{ "FrameReuse", OptionType::Bool }
 	};
 
 	const std::vector<std::pair<std::string, OptionType>> AudioMappings =
@@ -53,6 +60,7 @@ namespace
 		{ "Collision", OptionType::Bool },
 		{ "SkipIntro", OptionType::Bool },
 		{ "ShowDebug", OptionType::Bool },
+		{ "ShowRenderTimings", OptionType::Bool },
 		{ "ShowCompass", OptionType::Bool },
 		{ "TimeScale", OptionType::Double },
 		{ "StarDensity", OptionType::Int }
@@ -82,6 +90,10 @@ const int Options::MIN_LETTERBOX_MODE = 0;
 const int Options::MAX_LETTERBOX_MODE = 2;
 const int Options::MIN_RENDER_THREADS_MODE = 0;
 const int Options::MAX_RENDER_THREADS_MODE = 5;
+const int Options::MIN_DEPTH_BUFFER_MODE = 0;
+const int Options::MAX_DEPTH_BUFFER_MODE = 2;
+const double Options::MIN_DRAW_DISTANCE = 10.0;
+const double Options::MAX_DRAW_DISTANCE = 100.0;
 const double Options::MIN_HORIZONTAL_SENSITIVITY = 0.50;
 const double Options::MAX_HORIZONTAL_SENSITIVITY = 50.0;
 const double Options::MIN_VERTICAL_SENSITIVITY = 0.50;
@@ -503,6 +515,26 @@ void Options::checkGraphics_RenderThreadsMode(int value) const
 		std::to_string(Options::MAX_RENDER_THREADS_MODE) + ".");
 }
 
+void Options::checkGraphics_DepthBufferMode(int value) const
+{
+	DebugAssertMsg(value >= Options::MIN_DEPTH_BUFFER_MODE,
+		"Depth buffer mode cannot be less than " +
+		std::to_string(Options::MIN_DEPTH_BUFFER_MODE) + ".");
+	DebugAssertMsg(value <= Options::MAX_DEPTH_BUFFER_MODE,
+		"Depth buffer mode cannot be greater than " +
+		std::to_string(Options::MAX_DEPTH_BUFFER_MODE) + ".");
+}
+
+void Options::checkGraphics_MaxDrawDistance(double value) const
+{
+	DebugAssertMsg(value >= Options::MIN_DRAW_DISTANCE,
+		"Max draw distance cannot be less than " +
+		String::fixedPrecision(Options::MIN_DRAW_DISTANCE, 1) + ".");
+	DebugAssertMsg(value <= Options::MAX_DRAW_DISTANCE,
+		"Max draw distance cannot be greater than " +
+		String::fixedPrecision(Options::MAX_DRAW_DISTANCE, 1) + ".");
+}
+
 void Options::checkAudio_MusicVolume(double value) const
 {
 	DebugAssertMsg(value >= Options::MIN_VOLUME, "Music volume cannot be negative.");
@@ -68,6 +68,10 @@ public:
 	static const int MAX_LETTERBOX_MODE;
 	static const int MIN_RENDER_THREADS_MODE;
 	static const int MAX_RENDER_THREADS_MODE;
+	static const int MIN_DEPTH_BUFFER_MODE;
+	static const int MAX_DEPTH_BUFFER_MODE;
+	static const double MIN_DRAW_DISTANCE;
+	static const double MAX_DRAW_DISTANCE;
 	static const double MIN_HORIZONTAL_SENSITIVITY;
 	static const double MAX_HORIZONTAL_SENSITIVITY;
 	static const double MIN_VERTICAL_SENSITIVITY;
@@ -143,6 +147,13 @@ void set##section##_##name(const std::string &value) \
 	OPTION_DOUBLE(Graphics, CursorScale)
 	OPTION_BOOL(Graphics, ModernInterface)
 	OPTION_INT(Graphics, RenderThreadsMode)
+	OPTION_INT(Graphics, DepthBufferMode)
+	OPTION_BOOL(Graphics, FramePipelining)
+	OPTION_BOOL(Graphics, DynamicResolution)
+	OPTION_DOUBLE(Graphics, MaxDrawDistance)
+	OPTION_BOOL(Graphics, Mipmapping)
+	OPTION_BOOL(Graphics, PalettedRendering)
+	OPTION_BOOL(Graphics, FrameReuse)
 
 	OPTION_DOUBLE(Audio, MusicVolume)
 	OPTION_DOUBLE(Audio, SoundVolume)
@@ -159,6 +170,7 @@ void set##section##_##name(const std::string &value) \
 	OPTION_BOOL(Misc, Collision)
 	OPTION_BOOL(Misc, SkipIntro)
 	OPTION_BOOL(Misc, ShowDebug)
+	OPTION_BOOL(Misc, ShowRenderTimings)
 	OPTION_BOOL(Misc, ShowCompass)
 	OPTION_DOUBLE(Misc, TimeScale)
 	OPTION_INT(Misc, StarDensity)
@@ -237,7 +237,10 @@ ChooseAttributesPanel::ChooseAttributesPanel(Game &game,
 						renderer.initializeWorldRendering(
 							options.getGraphics_ResolutionScale(),
 							fullGameWindow,
-							options.getGraphics_RenderThreadsMode());
+							options.getGraphics_RenderThreadsMode(),
+							options.getGraphics_DepthBufferMode(),
+							options.getGraphics_FramePipelining(),
+							options.getGraphics_DynamicResolution());
 
 						std::unique_ptr<GameData> gameData = [this, &name, gender, raceID,
 							&charClass, &miscAssets]()
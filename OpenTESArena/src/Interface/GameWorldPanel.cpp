@@ -33,6 +33,7 @@
 #include "../Math/Vector2.h"
 #include "../Media/AudioManager.h"
 #include "../Media/Color.h"
+#include "../Media/Font.h"
 #include "../Media/FontManager.h"
 #include "../Media/FontName.h"
 #include "../Media/MusicName.h"
@@ -594,12 +595,18 @@ void GameWorldPanel::handleEvent(const SDL_Event &e)
 	auto &player = game.getGameData().getPlayer();
 	const auto &inputManager = game.getInputManager();
 	const bool escapePressed = inputManager.keyPressed(e, SDLK_ESCAPE);
+	const bool f3Pressed = inputManager.keyPressed(e, SDLK_F3);
 	const bool f4Pressed = inputManager.keyPressed(e, SDLK_F4);
 
 	if (escapePressed)
 	{
 		this->pauseButton.click(game);
 	}
+	else if (f3Pressed)
+	{
+		// Toggle render timings display.
+		options.setMisc_ShowRenderTimings(!options.getMisc_ShowRenderTimings());
+	}
 	else if (f4Pressed)
 	{
 		// Toggle debug display.
@@ -2025,7 +2032,8 @@ void GameWorldPanel::drawDebugText(Renderer &renderer)
 	const Int2 windowDims = renderer.getWindowDimensions();
 
 	auto &game = this->getGame();
-	const double resolutionScale = game.getOptions().getGraphics_ResolutionScale();
+	const double resolutionScale = renderer.getResolutionScale();
+	const std::string resolutionScaleMode = renderer.isDynamicResolution() ? " (dynamic)" : "";
 
 	auto &gameData = game.getGameData();
 	const auto &player = gameData.getPlayer();
@@ -2037,7 +2045,8 @@ void GameWorldPanel::drawDebugText(Renderer &renderer)
 
 	const std::string text =
 		"Screen: " + std::to_string(windowDims.x) + "x" + std::to_string(windowDims.y) + "\n" +
-		"Resolution scale: " + String::fixedPrecision(resolutionScale, 2) + "\n" +
+		"Resolution scale: " + String::fixedPrecision(resolutionScale, 2) +
+			resolutionScaleMode + "\n" +
 		"FPS: " + String::fixedPrecision(game.getFPSCounter().getFPS(), 1) + "\n" +
 		"Map: " + worldData.getMifName() + "\n" +
 		"Info: " + level.getInfFile().getName() + "\n" +
@@ -2062,6 +2071,118 @@ void GameWorldPanel::drawDebugText(Renderer &renderer)
 	renderer.drawOriginal(tempText.getTexture(), tempText.getX(), tempText.getY());
 }
 
+void GameWorldPanel::drawRenderTimings(Renderer &renderer)
+{
+	const SoftwareRenderer::FrameTimings &timings = renderer.getFrameTimings();
+	const int threadCount = static_cast<int>(timings.threads.size());
+	if (threadCount == 0)
+	{
+		return;
+	}
+
+	// Average time of each phase across render threads.
+	SoftwareRenderer::FrameTimings::Thread average;
+	for (const SoftwareRenderer::FrameTimings::Thread &thread : timings.threads)
+	{
+		average.skyGradient += thread.skyGradient / threadCount;
+		average.distantSky += thread.distantSky / threadCount;
+		average.voxels += thread.voxels / threadCount;
+		average.flats += thread.flats / threadCount;
+		average.wait += thread.wait / threadCount;
+	}
+
+	// Phase colors, in the order they are drawn in each thread's bar.
+	const Color skyGradientColor = Color::Cyan;
+	const Color distantSkyColor = Color::Blue;
+	const Color voxelsColor = Color::Green;
+	const Color flatsColor = Color::Yellow;
+	const Color waitColor = Color::Red;
+
+	auto &game = this->getGame();
+	auto &fontManager = game.getFontManager();
+	const int lineHeight = fontManager.getFont(FontName::D).getCharacterHeight();
+
+	const std::string text =
+		"Frame: " + String::fixedPrecision(timings.frame, 2) + "ms\n" +
+		"Main vis: " + String::fixedPrecision(timings.visibleDistantObjects, 2) + "/" +
+		String::fixedPrecision(timings.visibleFlats, 2) + "ms\n" +
+		"Sky gradient: " + String::fixedPrecision(average.skyGradient, 2) + "ms\n" +
+		"Distant sky: " + String::fixedPrecision(average.distantSky, 2) + "ms\n" +
+		"Voxels: " + String::fixedPrecision(average.voxels, 2) + "ms\n" +
+		"Flats: " + String::fixedPrecision(average.flats, 2) + "ms\n" +
+		"Wait: " + String::fixedPrecision(average.wait, 2) + "ms";
+
+	const RichTextString richText(
+		text,
+		FontName::D,
+		Color::White,
+		TextAlignment::Left,
+		fontManager);
+
+	// Legend in the top right corner, with a color swatch beside each thread phase.
+	const int graphWidth = 120;
+	const int graphX = Renderer::ORIGINAL_WIDTH - graphWidth - 2;
+	const int textX = graphX + 6;
+	const int textY = 2;
+	const TextBox legendText(textX, textY, richText, renderer);
+	renderer.drawOriginal(legendText.getTexture(), legendText.getX(), legendText.getY());
+
+	const std::array<Color, 5> legendColors =
+	{
+		skyGradientColor, distantSkyColor, voxelsColor, flatsColor, waitColor
+	};
+
+	for (size_t i = 0; i < legendColors.size(); i++)
+	{
+		const int swatchY = textY + ((static_cast<int>(i) + 2) * lineHeight);
+		renderer.fillOriginalRect(legendColors[i], graphX, swatchY, 4, 4);
+	}
+
+	// One bar for the main thread's visibility work, then one bar per render thread. The
+	// graph is at least a 60 FPS frame wide.
+	const int barsY = textY + (7 * lineHeight) + 3;
+	const int barHeight = std::max(std::min(96 / (threadCount + 1), 4), 1);
+	const double graphMilliseconds = std::max(timings.frame, 1000.0 / 60.0);
+	const double pixelsPerMillisecond = static_cast<double>(graphWidth) / graphMilliseconds;
+
+	// Lambda for drawing a bar's segments back to back.
+	auto drawBar = [&renderer, graphX, barHeight, pixelsPerMillisecond](int y,
+		const std::vector<std::pair<double, Color>> &segments)
+	{
+		double total = 0.0;
+		for (const auto &segment : segments)
+		{
+			const int segmentStart = static_cast<int>(total * pixelsPerMillisecond);
+			total += segment.first;
+			const int segmentEnd = static_cast<int>(total * pixelsPerMillisecond);
+
+			if (segmentEnd > segmentStart)
+			{
+				renderer.fillOriginalRect(segment.second, graphX + segmentStart, y,
+					segmentEnd - segmentStart, barHeight);
+			}
+		}
+	};
+
+	drawBar(barsY, { { timings.visibleDistantObjects, distantSkyColor },
+		{ timings.visibleFlats, flatsColor } });
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		const SoftwareRenderer::FrameTimings::Thread &thread = timings.threads[i];
+		const int barY = barsY + ((i + 1) * (barHeight + 1));
+		drawBar(barY, { { thread.skyGradient, skyGradientColor },
+			{ thread.distantSky, distantSkyColor }, { thread.voxels, voxelsColor },
+			{ thread.flats, flatsColor }, { thread.wait, waitColor } });
+	}
+
+	// Frame time marker.
+	const int markerX = graphX + std::min(
+		static_cast<int>(timings.frame * pixelsPerMillisecond), graphWidth - 1);
+	const int graphHeight = (threadCount + 1) * (barHeight + 1);
+	renderer.fillOriginalRect(Color::White, markerX, barsY, 1, graphHeight);
+}
+
 void GameWorldPanel::tick(double dt)
 {
 	auto &game = this->getGame();
@@ -2300,6 +2421,12 @@ void GameWorldPanel::render(Renderer &renderer)
 	{
 		this->drawDebugText(renderer);
 	}
+
+	// Draw the optional render timings graph.
+	if (options.getMisc_ShowRenderTimings())
+	{
+		this->drawRenderTimings(renderer);
+	}
 }
 
 void GameWorldPanel::renderSecondary(Renderer &renderer)
@@ -79,6 +79,9 @@ private:
 
 	// Draws some debug text.
 	void drawDebugText(Renderer &renderer);
+
+	// Draws a graph of the 3D renderer's per-thread phase timings for the last frame.
+	void drawRenderTimings(Renderer &renderer);
 public:
 	// Constructs the game world panel. The GameData object in Game must be initialized.
 	GameWorldPanel(Game &game);
@@ -243,7 +243,9 @@ MainMenuPanel::MainMenuPanel(Game &game)
 			const auto &options = game.getOptions();
 			const bool fullGameWindow = options.getGraphics_ModernInterface();
 			renderer.initializeWorldRendering(options.getGraphics_ResolutionScale(),
-				fullGameWindow, options.getGraphics_RenderThreadsMode());
+				fullGameWindow, options.getGraphics_RenderThreadsMode(),
+				options.getGraphics_DepthBufferMode(), options.getGraphics_FramePipelining(),
+				options.getGraphics_DynamicResolution());
 
 			// Game data instance, to be initialized further by one of the loading methods below.
 			// Create a player with random data for testing.
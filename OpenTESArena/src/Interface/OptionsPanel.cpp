@@ -220,10 +220,14 @@ const std::string OptionsPanel::DEV_TAB_NAME = "Dev";
 
 // Graphics.
 const std::string OptionsPanel::CURSOR_SCALE_NAME = "Cursor Scale";
+const std::string OptionsPanel::DYNAMIC_RESOLUTION_NAME = "Dynamic Resolution";
 const std::string OptionsPanel::FPS_LIMIT_NAME = "FPS Limit";
 const std::string OptionsPanel::FULLSCREEN_NAME = "Fullscreen";
 const std::string OptionsPanel::LETTERBOX_MODE_NAME = "Letterbox Mode";
+const std::string OptionsPanel::MAX_DRAW_DISTANCE_NAME = "Max Draw Distance";
+const std::string OptionsPanel::MIPMAPPING_NAME = "Mipmapping";
 const std::string OptionsPanel::MODERN_INTERFACE_NAME = "Modern Interface";
+const std::string OptionsPanel::PALETTED_RENDERING_NAME = "Paletted Rendering";
 const std::string OptionsPanel::PARALLAX_SKY_NAME = "Parallax Sky";
 const std::string OptionsPanel::RENDER_THREADS_MODE_NAME = "Render Threads Mode";
 const std::string OptionsPanel::RESOLUTION_SCALE_NAME = "Resolution Scale";
@@ -246,7 +250,11 @@ const std::string OptionsPanel::STAR_DENSITY_NAME = "Star Density";
 
 // Dev.
 const std::string OptionsPanel::COLLISION_NAME = "Collision";
+const std::string OptionsPanel::DEPTH_BUFFER_MODE_NAME = "Depth Buffer Mode";
+const std::string OptionsPanel::FRAME_PIPELINING_NAME = "Frame Pipelining";
+const std::string OptionsPanel::FRAME_REUSE_NAME = "Frame Reuse";
 const std::string OptionsPanel::SHOW_DEBUG_NAME = "Show Debug";
+const std::string OptionsPanel::SHOW_RENDER_TIMINGS_NAME = "Show Render Timings";
 
 OptionsPanel::OptionsPanel(Game &game)
 	: Panel(game)
@@ -369,7 +377,9 @@ OptionsPanel::OptionsPanel(Game &game)
 	{
 		auto &game = this->getGame();
 		auto &options = game.getOptions();
+		auto &renderer = game.getRenderer();
 		options.setGraphics_TargetFPS(value);
+		renderer.setTargetFPS(value);
 	}));
 
 	this->graphicsOptions.push_back(std::make_unique<DoubleOption>(
@@ -394,6 +404,62 @@ OptionsPanel::OptionsPanel(Game &game)
 			value, fullGameWindow);
 	}));
 
+	this->graphicsOptions.push_back(std::make_unique<BoolOption>(
+		OptionsPanel::DYNAMIC_RESOLUTION_NAME,
+		"Lowers the resolution scale when frames take too long\nto hold the FPS limit, and raises it again (up to the\nresolution scale option) when there's time to spare.",
+		options.getGraphics_DynamicResolution(),
+		[this](bool value)
+	{
+		auto &game = this->getGame();
+		auto &options = game.getOptions();
+		auto &renderer = game.getRenderer();
+		options.setGraphics_DynamicResolution(value);
+		renderer.setDynamicResolution(value);
+	}));
+
+	this->graphicsOptions.push_back(std::make_unique<DoubleOption>(
+		OptionsPanel::MAX_DRAW_DISTANCE_NAME,
+		"Farthest distance the game world is drawn at. If it's closer\nthan the weather's fog, the fog is brought in to it.\nLower values help performance outdoors.",
+		options.getGraphics_MaxDrawDistance(),
+		5.0,
+		Options::MIN_DRAW_DISTANCE,
+		Options::MAX_DRAW_DISTANCE,
+		1,
+		[this](double value)
+	{
+		auto &game = this->getGame();
+		auto &options = game.getOptions();
+		auto &renderer = game.getRenderer();
+		options.setGraphics_MaxDrawDistance(value);
+		renderer.setMaxDrawDistance(value);
+	}));
+
+	this->graphicsOptions.push_back(std::make_unique<BoolOption>(
+		OptionsPanel::MIPMAPPING_NAME,
+		"Draws far away walls, floors, and sprites with smaller\ncopies of their textures, so they shimmer less and\nrender faster. Off keeps the original look.",
+		options.getGraphics_Mipmapping(),
+		[this](bool value)
+	{
+		auto &game = this->getGame();
+		auto &options = game.getOptions();
+		auto &renderer = game.getRenderer();
+		options.setGraphics_Mipmapping(value);
+		renderer.setMipmapping(value);
+	}));
+
+	this->graphicsOptions.push_back(std::make_unique<BoolOption>(
+		OptionsPanel::PALETTED_RENDERING_NAME,
+		"Draws the game world with the original 256 colors,\nwhich also lowers memory use while drawing. Light\nand fog gradients look banded like the original.",
+		options.getGraphics_PalettedRendering(),
+		[this](bool value)
+	{
+		auto &game = this->getGame();
+		auto &options = game.getOptions();
+		auto &renderer = game.getRenderer();
+		options.setGraphics_PalettedRendering(value);
+		renderer.setPalettedRendering(value);
+	}));
+
 	this->graphicsOptions.push_back(std::make_unique<DoubleOption>(
 		OptionsPanel::VERTICAL_FOV_NAME,
 		"Recommended 60.0 for classic mode.",
@@ -670,6 +736,62 @@ OptionsPanel::OptionsPanel(Game &game)
 		options.setMisc_ShowDebug(value);
 	}));
 
+	this->devOptions.push_back(std::make_unique<BoolOption>(
+		OptionsPanel::SHOW_RENDER_TIMINGS_NAME,
+		"Displays how long each render thread spends on each\npart of the game world, including waiting on other threads.",
+		options.getMisc_ShowRenderTimings(),
+		[this](bool value)
+	{
+		auto &game = this->getGame();
+		auto &options = game.getOptions();
+		options.setMisc_ShowRenderTimings(value);
+	}));
+
+	auto depthBufferModeOption = std::make_unique<IntOption>(
+		OptionsPanel::DEPTH_BUFFER_MODE_NAME,
+		"Determines the precision of depth values in the game world.\nLower precision uses less memory bandwidth, which\nhelps performance at high resolutions.",
+		options.getGraphics_DepthBufferMode(),
+		1,
+		Options::MIN_DEPTH_BUFFER_MODE,
+		Options::MAX_DEPTH_BUFFER_MODE,
+		[this](int value)
+	{
+		auto &game = this->getGame();
+		auto &options = game.getOptions();
+		auto &renderer = game.getRenderer();
+		options.setGraphics_DepthBufferMode(value);
+		renderer.setDepthBufferMode(value);
+	});
+
+	depthBufferModeOption->setDisplayOverrides({ "64-bit", "32-bit", "16-bit" });
+	this->devOptions.push_back(std::move(depthBufferModeOption));
+
+	this->devOptions.push_back(std::make_unique<BoolOption>(
+		OptionsPanel::FRAME_PIPELINING_NAME,
+		"Draws the next frame of the game world while the current\none is shown. This can raise the frame rate, but adds\none frame of input latency.",
+		options.getGraphics_FramePipelining(),
+		[this](bool value)
+	{
+		auto &game = this->getGame();
+		auto &options = game.getOptions();
+		auto &renderer = game.getRenderer();
+		options.setGraphics_FramePipelining(value);
+		renderer.setFramePipelining(value);
+	}));
+
+	this->devOptions.push_back(std::make_unique<BoolOption>(
+		OptionsPanel::FRAME_REUSE_NAME,
+		"Shows the last frame of the game world again when\nnothing in view has changed, instead of drawing\nthe same frame again. This saves power when idle.",
+		options.getGraphics_FrameReuse(),
+		[this](bool value)
+	{
+		auto &game = this->getGame();
+		auto &options = game.getOptions();
+		auto &renderer = game.getRenderer();
+		options.setGraphics_FrameReuse(value);
+		renderer.setFrameReuse(value);
+	}));
+
 	// Set initial tab.
 	this->tab = OptionsPanel::Tab::Graphics;
 
@@ -136,10 +136,14 @@ private:
 
 	// Graphics.
 	static const std::string CURSOR_SCALE_NAME;
+	static const std::string DYNAMIC_RESOLUTION_NAME;
 	static const std::string FPS_LIMIT_NAME;
 	static const std::string FULLSCREEN_NAME;
 	static const std::string LETTERBOX_MODE_NAME;
+	static const std::string MAX_DRAW_DISTANCE_NAME;
+	static const std::string MIPMAPPING_NAME;
 	static const std::string MODERN_INTERFACE_NAME;
+	static const std::string PALETTED_RENDERING_NAME;
 	static const std::string PARALLAX_SKY_NAME;
 	static const std::string RENDER_THREADS_MODE_NAME;
 	static const std::string RESOLUTION_SCALE_NAME;
@@ -162,7 +166,11 @@ private:
 
 	// Dev.
 	static const std::string COLLISION_NAME;
+	static const std::string DEPTH_BUFFER_MODE_NAME;
+	static const std::string FRAME_PIPELINING_NAME;
+	static const std::string FRAME_REUSE_NAME;
 	static const std::string SHOW_DEBUG_NAME;
+	static const std::string SHOW_RENDER_TIMINGS_NAME;
 
 	std::unique_ptr<TextBox> titleTextBox, backToPauseMenuTextBox, graphicsTextBox, audioTextBox,
 		inputTextBox, miscTextBox, devTextBox;
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 
 #include "Constants.h"
@@ -234,8 +235,10 @@ uint32_t Vector3f<T>::toRGB() const
 template <class T>
 double Vector3f<T>::getYAngleRadians() const
 {
-	// Get the length of the direction vector's projection onto the XZ plane.
-	const double xzProjection = std::sqrt((this->x * this->x) + (this->z * this->z));
+	// Get the length of the direction vector's projection onto the XZ plane. Rounding can
+	// put it just over 1 when the direction is nearly level, which acos() can't take.
+	const double xzProjection = std::min(static_cast<double>(
+		std::sqrt((this->x * this->x) + (this->z * this->z))), 1.0);
 
 	if (this->y > 0.0)
 	{
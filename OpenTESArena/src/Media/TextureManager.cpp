@@ -243,6 +243,13 @@ const Texture &TextureManager::getTexture(const std::string &filename,
 
 		// Set alpha transparency on.
 		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+		// Small interface images are also drawn from the interface atlas. An image with its
+		// own palette is the only one using it, so it isn't given atlas pages of its own.
+		if (!useBuiltInPalette)
+		{
+			renderer.addUITexture(texture, surface.get(), paletteName);
+		}
 	}
 	else
 	{
@@ -441,6 +448,7 @@ const std::vector<Texture> &TextureManager::getTextures(
 			Surface surface = TextureManager::make32BitFromPaletted(
 				cfaFile.getWidth(), cfaFile.getHeight(), cfaFile.getPixels(i), palette);
 			SDL_Texture *texture = renderer.createTextureFromSurface(surface.get());
+			renderer.addUITexture(texture, surface.get(), paletteName);
 			textureSet.push_back(Texture(texture));
 		}
 	}
@@ -454,6 +462,7 @@ const std::vector<Texture> &TextureManager::getTextures(
 			Surface surface = TextureManager::make32BitFromPaletted(
 				cifFile.getWidth(i), cifFile.getHeight(i), cifFile.getPixels(i), palette);
 			SDL_Texture *texture = renderer.createTextureFromSurface(surface.get());
+			renderer.addUITexture(texture, surface.get(), paletteName);
 			textureSet.push_back(Texture(texture));
 		}
 	}
@@ -467,6 +476,7 @@ const std::vector<Texture> &TextureManager::getTextures(
 			Surface surface = TextureManager::make32BitFromPaletted(
 				dfaFile.getWidth(), dfaFile.getHeight(), dfaFile.getPixels(i), palette);
 			SDL_Texture *texture = renderer.createTextureFromSurface(surface.get());
+			renderer.addUITexture(texture, surface.get(), paletteName);
 			textureSet.push_back(Texture(texture));
 		}
 	}
@@ -474,7 +484,8 @@ const std::vector<Texture> &TextureManager::getTextures(
 	{
 		const FLCFile flcFile(filename);
 
-		// Create a texture for each frame in the .FLC.
+		// Create a texture for each frame in the .FLC. Movie frames are full screen and shown
+		// one at a time, so they aren't packed into the interface atlas.
 		for (int i = 0; i < flcFile.getFrameCount(); i++)
 		{
 			Surface surface = TextureManager::make32BitFromPaletted(
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cmath>
+
+#include "DynamicResolution.h"
+
+const double DynamicResolution::MIN_SCALE = 0.25;
+const double DynamicResolution::SCALE_STEP = 0.05;
+const double DynamicResolution::RENDER_BUDGET_PERCENT = 0.80;
+const double DynamicResolution::STEP_UP_BUDGET_PERCENT = 0.85;
+const double DynamicResolution::AVERAGE_WEIGHT = 0.10;
+const int DynamicResolution::STEP_DOWN_FRAMES = 10;
+const int DynamicResolution::STEP_UP_FRAMES = 60;
+const int DynamicResolution::COOLDOWN_FRAMES = 30;
+
+DynamicResolution::DynamicResolution()
+{
+	this->scale = 1.0;
+	this->maxScale = 1.0;
+	this->averageTime = 0.0;
+	this->budgetTime = 0.0;
+	this->slowFrames = 0;
+	this->fastFrames = 0;
+	this->cooldownFrames = 0;
+	this->enabled = false;
+}
+
+bool DynamicResolution::isEnabled() const
+{
+	return this->enabled;
+}
+
+double DynamicResolution::getScale() const
+{
+	return this->enabled ? this->scale : this->maxScale;
+}
+
+double DynamicResolution::getMaxScale() const
+{
+	return this->maxScale;
+}
+
+void DynamicResolution::setEnabled(bool enabled)
+{
+	this->enabled = enabled;
+	this->scale = this->maxScale;
+	this->averageTime = 0.0;
+	this->slowFrames = 0;
+	this->fastFrames = 0;
+	this->cooldownFrames = DynamicResolution::COOLDOWN_FRAMES;
+}
+
+void DynamicResolution::setMaxScale(double maxScale)
+{
+	this->maxScale = maxScale;
+	this->scale = std::min(this->scale, maxScale);
+}
+
+void DynamicResolution::setTargetFPS(int targetFPS)
+{
+	this->budgetTime = (1000.0 / static_cast<double>(targetFPS)) *
+		DynamicResolution::RENDER_BUDGET_PERCENT;
+}
+
+bool DynamicResolution::update(double renderTime)
+{
+	if (!this->enabled || (this->budgetTime <= 0.0))
+	{
+		return false;
+	}
+
+	// Smooth out single slow frames (i.e., loading textures).
+	const double weight = (this->averageTime > 0.0) ? DynamicResolution::AVERAGE_WEIGHT : 1.0;
+	this->averageTime += (renderTime - this->averageTime) * weight;
+
+	// Give the render time a chance to settle after a step.
+	if (this->cooldownFrames > 0)
+	{
+		this->cooldownFrames--;
+		return false;
+	}
+
+	// Render time at the next step up, assuming it goes with the pixel count.
+	const double stepUpScale = std::min(this->scale + DynamicResolution::SCALE_STEP,
+		this->maxScale);
+	const double stepUpRatio = stepUpScale / this->scale;
+	const double stepUpTime = this->averageTime * stepUpRatio * stepUpRatio;
+
+	if (this->averageTime > this->budgetTime)
+	{
+		this->slowFrames++;
+		this->fastFrames = 0;
+	}
+	else if (stepUpTime < (this->budgetTime * DynamicResolution::STEP_UP_BUDGET_PERCENT))
+	{
+		this->slowFrames = 0;
+		this->fastFrames++;
+	}
+	else
+	{
+		// Within the band where neither direction is worth it.
+		this->slowFrames = 0;
+		this->fastFrames = 0;
+	}
+
+	double newScale = this->scale;
+	if (this->slowFrames >= DynamicResolution::STEP_DOWN_FRAMES)
+	{
+		const double minScale = std::min(DynamicResolution::MIN_SCALE, this->maxScale);
+		newScale = std::max(this->scale - DynamicResolution::SCALE_STEP, minScale);
+	}
+	else if (this->fastFrames >= DynamicResolution::STEP_UP_FRAMES)
+	{
+		newScale = stepUpScale;
+	}
+	else
+	{
+		return false;
+	}
+
+	this->slowFrames = 0;
+	this->fastFrames = 0;
+
+	if (newScale == this->scale)
+	{
+		// Already at the min or max.
+		return false;
+	}
+
+	// Predict the new average so the next frames aren't compared against the old scale.
+	const double ratio = newScale / this->scale;
+	this->averageTime *= ratio * ratio;
+	this->scale = newScale;
+	this->cooldownFrames = DynamicResolution::COOLDOWN_FRAMES;
+	return true;
+}
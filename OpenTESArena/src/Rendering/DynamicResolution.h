@@ -0,0 +1,61 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+// Picks the resolution scale of the game world from recent render times, stepping it down
+// when frames take too long for the target frame rate and back up when there's room again.
+// Render time is assumed to go with the number of pixels (i.e., the scale squared).
+
+class DynamicResolution
+{
+private:
+	// Lowest scale it will step down to, and the size of each step.
+	static const double MIN_SCALE;
+	static const double SCALE_STEP;
+
+	// Percent of the frame time the game world gets to render in. The rest is left for the
+	// game tick, the interface, and presenting.
+	static const double RENDER_BUDGET_PERCENT;
+
+	// The scale only goes up if the render time after the step is predicted to be under this
+	// percent of the budget, so it doesn't go straight back down.
+	static const double STEP_UP_BUDGET_PERCENT;
+
+	// Weight of the newest render time in the average.
+	static const double AVERAGE_WEIGHT;
+
+	// Frames in a row the average has to be over (or under) the budget before stepping, and
+	// frames to wait after a step before counting again.
+	static const int STEP_DOWN_FRAMES;
+	static const int STEP_UP_FRAMES;
+	static const int COOLDOWN_FRAMES;
+
+	double scale, maxScale;
+	double averageTime; // Milliseconds.
+	double budgetTime; // Milliseconds.
+	int slowFrames, fastFrames, cooldownFrames;
+	bool enabled;
+public:
+	DynamicResolution();
+
+	bool isEnabled() const;
+
+	// Gets the resolution scale to render at. This is the max scale when not enabled.
+	double getScale() const;
+
+	// Gets the scale it will not go above.
+	double getMaxScale() const;
+
+	// Sets whether the scale follows render times. Enabling starts at the max scale.
+	void setEnabled(bool enabled);
+
+	// Sets the scale to not go above (i.e., the resolution scale option).
+	void setMaxScale(double maxScale);
+
+	// Sets the frame rate that render times are measured against.
+	void setTargetFPS(int targetFPS);
+
+	// Adds the render time of the most recent frame. Returns whether the scale changed.
+	bool update(double renderTime);
+};
+
+#endif
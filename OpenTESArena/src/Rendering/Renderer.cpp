@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 
@@ -10,6 +11,7 @@
 #include "../Math/Constants.h"
 #include "../Math/Rect.h"
 #include "../Media/Color.h"
+#include "../Media/Palette.h"
 #include "../Utilities/Debug.h"
 #include "../World/VoxelGrid.h"
 
@@ -33,6 +35,8 @@ Renderer::Renderer()
 	this->renderer = nullptr;
 	this->nativeTexture = nullptr;
 	this->gameWorldTexture = nullptr;
+	this->gameWorldWidth = 0;
+	this->gameWorldHeight = 0;
 	this->letterboxMode = 0;
 	this->fullGameWindow = false;
 }
@@ -43,6 +47,9 @@ Renderer::~Renderer()
 
 	SDL_DestroyWindow(this->window);
 
+	// The atlas pages must go before the renderer they belong to.
+	this->uiAtlas.clear();
+
 	// This also destroys the frame buffer textures.
 	SDL_DestroyRenderer(this->renderer);
 }
@@ -208,6 +215,21 @@ Surface Renderer::getScreenshot() const
 	return screenshot;
 }
 
+const SoftwareRenderer::FrameTimings &Renderer::getFrameTimings() const
+{
+	return this->softwareRenderer.getFrameTimings();
+}
+
+double Renderer::getResolutionScale() const
+{
+	return this->dynamicResolution.getScale();
+}
+
+bool Renderer::isDynamicResolution() const
+{
+	return this->dynamicResolution.isEnabled();
+}
+
 Int2 Renderer::nativeToOriginal(const Int2 &nativePoint) const
 {
 	// From native point to letterbox point.
@@ -300,6 +322,12 @@ SDL_Texture *Renderer::createTextureFromSurface(SDL_Surface *surface)
 	return SDL_CreateTextureFromSurface(this->renderer, surface);
 }
 
+void Renderer::addUITexture(SDL_Texture *texture, SDL_Surface *surface,
+	const std::string &paletteName)
+{
+	this->uiAtlas.add(texture, surface, paletteName, this->renderer);
+}
+
 void Renderer::init(int width, int height, bool fullscreen, int letterboxMode)
 {
 	DebugMention("Initializing.");
@@ -377,27 +405,109 @@ void Renderer::resize(int width, int height, double resolutionScale, bool fullGa
 		"Couldn't recreate native frame buffer, " + std::string(SDL_GetError()));
 
 	this->fullGameWindow = fullGameWindow;
+	this->dynamicResolution.setMaxScale(resolutionScale);
 
 	// Rebuild the 3D renderer if initialized.
 	if (this->softwareRenderer.isInited())
 	{
-		// Height of the game world view in pixels. Determined by whether the game 
-		// interface is visible or not.
-		const int viewHeight = this->getViewHeight();
+		this->resizeGameWorld();
+	}
+}
 
-		// Make sure render dimensions are at least 1x1.
-		const int renderWidth = std::max(static_cast<int>(width * resolutionScale), 1);
-		const int renderHeight = std::max(static_cast<int>(viewHeight * resolutionScale), 1);
+Int2 Renderer::getGameWorldDimensions(double resolutionScale) const
+{
+	const int screenWidth = this->getWindowDimensions().x;
 
-		// Reinitialize the game world frame buffer.
-		SDL_DestroyTexture(this->gameWorldTexture);
-		this->gameWorldTexture = this->createTexture(Renderer::DEFAULT_PIXELFORMAT,
-			SDL_TEXTUREACCESS_STREAMING, renderWidth, renderHeight);
-		DebugAssertMsg(this->gameWorldTexture != nullptr,
-			"Couldn't recreate game world texture, " + std::string(SDL_GetError()));
+	// Height of the game world view in pixels. Determined by whether the game 
+	// interface is visible or not.
+	const int viewHeight = this->getViewHeight();
+
+	// Make sure render dimensions are at least 1x1.
+	const int renderWidth = std::max(static_cast<int>(screenWidth * resolutionScale), 1);
+	const int renderHeight = std::max(static_cast<int>(viewHeight * resolutionScale), 1);
+	return Int2(renderWidth, renderHeight);
+}
+
+void Renderer::resizeGameWorld()
+{
+	// Reinitialize the game world frame buffer. It's big enough for any scale up to the max.
+	const Int2 textureDims = this->getGameWorldDimensions(this->dynamicResolution.getMaxScale());
+	SDL_DestroyTexture(this->gameWorldTexture);
+	this->gameWorldTexture = this->createTexture(Renderer::DEFAULT_PIXELFORMAT,
+		SDL_TEXTUREACCESS_STREAMING, textureDims.x, textureDims.y);
+	DebugAssertMsg(this->gameWorldTexture != nullptr,
+		"Couldn't recreate game world texture, " + std::string(SDL_GetError()));
+
+	this->rescaleGameWorld();
+}
+
+void Renderer::rescaleGameWorld()
+{
+	const Int2 renderDims = this->getGameWorldDimensions(this->dynamicResolution.getScale());
+	this->gameWorldWidth = renderDims.x;
+	this->gameWorldHeight = renderDims.y;
+
+	// Resize 3D renderer.
+	this->softwareRenderer.resize(renderDims.x, renderDims.y);
+}
+
+void Renderer::drawGameWorld()
+{
+	// Stretch the game world part of the texture over the game world view.
+	const Rect srcRect(this->gameWorldWidth, this->gameWorldHeight);
+	const Rect dstRect(this->getWindowDimensions().x, this->getViewHeight());
+	this->drawClipped(this->gameWorldTexture, srcRect, dstRect);
+}
+
+void Renderer::copyTexture(SDL_Texture *texture, const SDL_Rect *srcRect,
+	const SDL_Rect &dstRect)
+{
+	const TextureAtlas::Entry *entry = this->uiAtlas.find(texture);
+	if (entry != nullptr)
+	{
+		SDL_Rect atlasRect;
+		atlasRect.x = 0;
+		atlasRect.y = 0;
+		atlasRect.w = entry->width;
+		atlasRect.h = entry->height;
+		SDL_Rect atlasDstRect = dstRect;
+
+		if (srcRect != nullptr)
+		{
+			// Clip the source rectangle to the texture like SDL_RenderCopy() does, so it
+			// doesn't reach into its neighbors in the page, and shrink the destination with it.
+			const SDL_Rect textureRect = atlasRect;
+			if (!SDL_IntersectRect(srcRect, &textureRect, &atlasRect))
+			{
+				return;
+			}
 
-		// Resize 3D renderer.
-		this->softwareRenderer.resize(renderWidth, renderHeight);
+			atlasDstRect.x += ((atlasRect.x - srcRect->x) * dstRect.w) / srcRect->w;
+			atlasDstRect.y += ((atlasRect.y - srcRect->y) * dstRect.h) / srcRect->h;
+			atlasDstRect.w = (atlasRect.w * dstRect.w) / srcRect->w;
+			atlasDstRect.h = (atlasRect.h * dstRect.h) / srcRect->h;
+		}
+
+		// Move the source rectangle to where the texture is in its atlas page.
+		atlasRect.x += entry->x;
+		atlasRect.y += entry->y;
+		this->uiBatch.add(entry->page, atlasRect, atlasDstRect);
+	}
+	else
+	{
+		// Keep the draw order with any batched copies.
+		this->flushSprites();
+		SDL_SetRenderTarget(this->renderer, this->nativeTexture);
+		SDL_RenderCopy(this->renderer, texture, srcRect, &dstRect);
+	}
+}
+
+void Renderer::flushSprites()
+{
+	if (!this->uiBatch.isEmpty())
+	{
+		SDL_SetRenderTarget(this->renderer, this->nativeTexture);
+		this->uiBatch.flush(this->renderer);
 	}
 }
 
@@ -434,23 +544,24 @@ void Renderer::warpMouse(int x, int y)
 
 void Renderer::setClipRect(const SDL_Rect *rect)
 {
+	this->flushSprites();
 	SDL_RenderSetClipRect(this->renderer, rect);
 }
 
 void Renderer::initializeWorldRendering(double resolutionScale, bool fullGameWindow,
-	int renderThreadsMode)
+	int renderThreadsMode, int depthBufferMode, bool framePipelining, bool dynamicResolution)
 {
 	this->fullGameWindow = fullGameWindow;
 
-	const int screenWidth = this->getWindowDimensions().x;
+	// Dynamic resolution starts at the given scale.
+	this->dynamicResolution.setMaxScale(resolutionScale);
+	this->dynamicResolution.setEnabled(dynamicResolution);
 
-	// Height of the game world view in pixels, used in place of the screen height.
-	// Its value is a function of whether the game interface is visible or not.
-	const int viewHeight = this->getViewHeight();
-
-	// Make sure render dimensions are at least 1x1.
-	const int renderWidth = std::max(static_cast<int>(screenWidth * resolutionScale), 1);
-	const int renderHeight = std::max(static_cast<int>(viewHeight * resolutionScale), 1);
+	const Int2 renderDims = this->getGameWorldDimensions(resolutionScale);
+	const int renderWidth = renderDims.x;
+	const int renderHeight = renderDims.y;
+	this->gameWorldWidth = renderWidth;
+	this->gameWorldHeight = renderHeight;
 
 	// Remove any previous game world frame buffer.
 	if (this->softwareRenderer.isInited())
@@ -465,7 +576,8 @@ void Renderer::initializeWorldRendering(double resolutionScale, bool fullGameWin
 		"Couldn't create game world texture, " + std::string(SDL_GetError()));
 
 	// Initialize 3D rendering.
-	this->softwareRenderer.init(renderWidth, renderHeight, renderThreadsMode);
+	this->softwareRenderer.init(renderWidth, renderHeight, renderThreadsMode, depthBufferMode,
+		framePipelining);
 }
 
 void Renderer::setRenderThreadsMode(int mode)
@@ -474,6 +586,67 @@ void Renderer::setRenderThreadsMode(int mode)
 	this->softwareRenderer.setRenderThreadsMode(mode);
 }
 
+void Renderer::setDepthBufferMode(int mode)
+{
+	assert(this->softwareRenderer.isInited());
+	this->softwareRenderer.setDepthBufferMode(mode);
+}
+
+void Renderer::setFramePipelining(bool enabled)
+{
+	assert(this->softwareRenderer.isInited());
+	this->softwareRenderer.setFramePipelining(enabled);
+}
+
+void Renderer::setFrameReuse(bool enabled)
+{
+	this->softwareRenderer.setFrameReuse(enabled);
+}
+
+void Renderer::setDynamicResolution(bool enabled)
+{
+	assert(this->softwareRenderer.isInited());
+	const double oldScale = this->dynamicResolution.getScale();
+	this->dynamicResolution.setEnabled(enabled);
+
+	if (this->dynamicResolution.getScale() != oldScale)
+	{
+		this->rescaleGameWorld();
+	}
+}
+
+void Renderer::setTargetFPS(int targetFPS)
+{
+	this->dynamicResolution.setTargetFPS(targetFPS);
+}
+
+void Renderer::setMaxDrawDistance(double maxDrawDistance)
+{
+	this->softwareRenderer.setMaxDrawDistance(maxDrawDistance);
+}
+
+void Renderer::setMipmapping(bool mipmapping)
+{
+	this->softwareRenderer.setMipmapping(mipmapping);
+}
+
+void Renderer::setPalette(const Palette &palette)
+{
+	const auto &paletteColors = palette.get();
+	std::array<uint32_t, 256> colors;
+	for (size_t i = 0; i < colors.size(); i++)
+	{
+		colors[i] = paletteColors[i].toARGB();
+	}
+
+	this->softwareRenderer.setPalette(colors.data(), static_cast<int>(colors.size()));
+}
+
+void Renderer::setPalettedRendering(bool paletted)
+{
+	this->softwareRenderer.setPalettedRendering(paletted);
+}
+
 void Renderer::addFlat(int id, const Double3 &position, double width, 
 	double height, int textureID)
 {
@@ -563,6 +736,7 @@ void Renderer::clearDistantSky()
 
 void Renderer::clear(const Color &color)
 {
+	this->flushSprites();
 	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
 	SDL_SetRenderDrawColor(this->renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderClear(this->renderer);
@@ -575,6 +749,7 @@ void Renderer::clear()
 
 void Renderer::clearOriginal(const Color &color)
 {
+	this->flushSprites();
 	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
 	SDL_SetRenderDrawColor(this->renderer, color.r, color.g, color.b, color.a);
 
@@ -589,6 +764,7 @@ void Renderer::clearOriginal()
 
 void Renderer::drawPixel(const Color &color, int x, int y)
 {
+	this->flushSprites();
 	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
 	SDL_SetRenderDrawColor(this->renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawPoint(this->renderer, x, y);
@@ -596,6 +772,7 @@ void Renderer::drawPixel(const Color &color, int x, int y)
 
 void Renderer::drawLine(const Color &color, int x1, int y1, int x2, int y2)
 {
+	this->flushSprites();
 	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
 	SDL_SetRenderDrawColor(this->renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawLine(this->renderer, x1, y1, x2, y2);
@@ -603,6 +780,7 @@ void Renderer::drawLine(const Color &color, int x1, int y1, int x2, int y2)
 
 void Renderer::drawRect(const Color &color, int x, int y, int w, int h)
 {
+	this->flushSprites();
 	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
 	SDL_SetRenderDrawColor(this->renderer, color.r, color.g, color.b, color.a);
 
@@ -617,6 +795,7 @@ void Renderer::drawRect(const Color &color, int x, int y, int w, int h)
 
 void Renderer::fillRect(const Color &color, int x, int y, int w, int h)
 {
+	this->flushSprites();
 	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
 	SDL_SetRenderDrawColor(this->renderer, color.r, color.g, color.b, color.a);
 
@@ -631,6 +810,7 @@ void Renderer::fillRect(const Color &color, int x, int y, int w, int h)
 
 void Renderer::fillOriginalRect(const Color &color, int x, int y, int w, int h)
 {
+	this->flushSprites();
 	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
 	SDL_SetRenderDrawColor(this->renderer, color.r, color.g, color.b, color.a);
 
@@ -644,28 +824,86 @@ void Renderer::renderWorld(const Double3 &eye, const Double3 &forward, double fo
 {
 	// The 3D renderer must be initialized.
 	assert(this->softwareRenderer.isInited());
-	
-	// Lock the game world texture and give the pixel pointer to the software renderer.
-	// - Supposedly this is faster than SDL_UpdateTexture(). In any case, there's one
-	//   less frame buffer to take care of.
-	uint32_t *gameWorldPixels;
-	int gameWorldPitch;
-	int status = SDL_LockTexture(this->gameWorldTexture, nullptr, 
-		reinterpret_cast<void**>(&gameWorldPixels), &gameWorldPitch);
-	DebugAssertMsg(status == 0, "Couldn't lock game world texture, " +
-		std::string(SDL_GetError()));
-
-	// Render the game world to the game world frame buffer.
-	this->softwareRenderer.render(eye, forward, fovY, ambient, daytimePercent, latitude,
-		parallaxSky, ceilingHeight, openDoors, voxelGrid, gameWorldPixels);
-
-	// Update the game world texture with the new ARGB8888 pixels.
-	SDL_UnlockTexture(this->gameWorldTexture);
+
+	// If nothing in the game world has changed since the last frame (i.e., the player is
+	// idle), the game world texture already has this frame. The last frame's timings don't
+	// say anything new about the resolution either.
+	if (this->softwareRenderer.isFrameReusable(eye, forward, fovY, ambient, daytimePercent,
+		latitude, parallaxSky, ceilingHeight, openDoors, voxelGrid))
+	{
+		this->drawGameWorld();
+		return;
+	}
+
+	// Change the game world resolution if the last frames took too long (or were quick
+	// enough for more pixels). The render threads' time is used so frame pipelining and
+	// waiting for the target FPS don't count.
+	if (this->dynamicResolution.isEnabled())
+	{
+		double renderTime = 0.0;
+		for (const auto &threadTimings : this->softwareRenderer.getFrameTimings().threads)
+		{
+			renderTime = std::max(renderTime, threadTimings.getTotal());
+		}
+
+		if (this->dynamicResolution.update(renderTime))
+		{
+			this->rescaleGameWorld();
+		}
+	}
+
+	// The game world is drawn to the top left of its texture when at a lower scale.
+	const SDL_Rect gameWorldRect = { 0, 0, this->gameWorldWidth, this->gameWorldHeight };
+	int gameWorldTextureWidth, gameWorldTextureHeight;
+	SDL_QueryTexture(this->gameWorldTexture, nullptr, nullptr, &gameWorldTextureWidth,
+		&gameWorldTextureHeight);
+	const bool gameWorldFillsTexture = (this->gameWorldWidth == gameWorldTextureWidth) &&
+		(this->gameWorldHeight == gameWorldTextureHeight);
+
+	if (this->softwareRenderer.isFramePipelining())
+	{
+		// Start drawing this frame in the background and upload the previous one, so
+		// presenting overlaps with the render threads.
+		const uint32_t *gameWorldPixels = this->softwareRenderer.renderPipelined(eye, forward,
+			fovY, ambient, daytimePercent, latitude, parallaxSky, ceilingHeight, openDoors,
+			voxelGrid);
+
+		SDL_UpdateTexture(this->gameWorldTexture, &gameWorldRect, gameWorldPixels,
+			this->gameWorldWidth * sizeof(*gameWorldPixels));
+	}
+	else if (!gameWorldFillsTexture)
+	{
+		// The software renderer needs a tightly packed frame buffer, so render to one the
+		// game world's size and update that part of the texture.
+		this->gameWorldBuffer.resize(this->gameWorldWidth * this->gameWorldHeight);
+		this->softwareRenderer.render(eye, forward, fovY, ambient, daytimePercent, latitude,
+			parallaxSky, ceilingHeight, openDoors, voxelGrid, this->gameWorldBuffer.data());
+
+		SDL_UpdateTexture(this->gameWorldTexture, &gameWorldRect, this->gameWorldBuffer.data(),
+			this->gameWorldWidth * sizeof(*this->gameWorldBuffer.data()));
+	}
+	else
+	{
+		// Lock the game world texture and give the pixel pointer to the software renderer.
+		// - Supposedly this is faster than SDL_UpdateTexture(). In any case, there's one
+		//   less frame buffer to take care of.
+		uint32_t *gameWorldPixels;
+		int gameWorldPitch;
+		int status = SDL_LockTexture(this->gameWorldTexture, nullptr, 
+			reinterpret_cast<void**>(&gameWorldPixels), &gameWorldPitch);
+		DebugAssertMsg(status == 0, "Couldn't lock game world texture, " +
+			std::string(SDL_GetError()));
+
+		// Render the game world to the game world frame buffer.
+		this->softwareRenderer.render(eye, forward, fovY, ambient, daytimePercent, latitude,
+			parallaxSky, ceilingHeight, openDoors, voxelGrid, gameWorldPixels);
+
+		// Update the game world texture with the new ARGB8888 pixels.
+		SDL_UnlockTexture(this->gameWorldTexture);
+	}
 
 	// Now copy to the native frame buffer (stretching if needed).
-	const int screenWidth = this->getWindowDimensions().x;
-	const int viewHeight = this->getViewHeight();
-	this->draw(this->gameWorldTexture, 0, 0, screenWidth, viewHeight);
+	this->drawGameWorld();
 }
 
 void Renderer::drawCursor(SDL_Texture *cursor, CursorAlignment alignment,
@@ -735,15 +973,13 @@ void Renderer::drawCursor(SDL_Texture *cursor, CursorAlignment alignment,
 
 void Renderer::draw(SDL_Texture *texture, int x, int y, int w, int h)
 {
-	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
-
 	SDL_Rect rect;
 	rect.x = x;
 	rect.y = y;
 	rect.w = w;
 	rect.h = h;
 
-	SDL_RenderCopy(this->renderer, texture, nullptr, &rect);
+	this->copyTexture(texture, nullptr, rect);
 }
 
 void Renderer::draw(SDL_Texture *texture, int x, int y)
@@ -761,8 +997,7 @@ void Renderer::draw(SDL_Texture *texture)
 
 void Renderer::drawClipped(SDL_Texture *texture, const Rect &srcRect, const Rect &dstRect)
 {
-	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
-	SDL_RenderCopy(this->renderer, texture, &srcRect.getRect(), &dstRect.getRect());
+	this->copyTexture(texture, &srcRect.getRect(), dstRect.getRect());
 }
 
 void Renderer::drawClipped(SDL_Texture *texture, const Rect &srcRect, int x, int y)
@@ -772,13 +1007,11 @@ void Renderer::drawClipped(SDL_Texture *texture, const Rect &srcRect, int x, int
 
 void Renderer::drawOriginal(SDL_Texture *texture, int x, int y, int w, int h)
 {
-	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
-	
 	// The given coordinates and dimensions are in 320x200 space, so transform them
 	// to native space.
 	const Rect rect = this->originalToNative(Rect(x, y, w, h));
 
-	SDL_RenderCopy(this->renderer, texture, nullptr, &rect.getRect());
+	this->copyTexture(texture, nullptr, rect.getRect());
 }
 
 void Renderer::drawOriginal(SDL_Texture *texture, int x, int y)
@@ -796,13 +1029,11 @@ void Renderer::drawOriginal(SDL_Texture *texture)
 
 void Renderer::drawOriginalClipped(SDL_Texture *texture, const Rect &srcRect, const Rect &dstRect)
 {
-	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
-
 	// The destination coordinates and dimensions are in 320x200 space, so transform 
 	// them to native space.
 	const Rect rect = this->originalToNative(dstRect);
 
-	SDL_RenderCopy(this->renderer, texture, &srcRect.getRect(), &rect.getRect());
+	this->copyTexture(texture, &srcRect.getRect(), rect.getRect());
 }
 
 void Renderer::drawOriginalClipped(SDL_Texture *texture, const Rect &srcRect, int x, int y)
@@ -813,12 +1044,14 @@ void Renderer::drawOriginalClipped(SDL_Texture *texture, const Rect &srcRect, in
 
 void Renderer::fill(SDL_Texture *texture)
 {
+	this->flushSprites();
 	SDL_SetRenderTarget(this->renderer, this->nativeTexture);
 	SDL_RenderCopy(this->renderer, texture, nullptr, nullptr);
 }
 
 void Renderer::present()
 {
+	this->flushSprites();
 	SDL_SetRenderTarget(this->renderer, nullptr);
 	SDL_RenderCopy(this->renderer, this->nativeTexture, nullptr, nullptr);
 	SDL_RenderPresent(this->renderer);
@@ -6,7 +6,10 @@
 #include <string>
 #include <vector>
 
+#include "DynamicResolution.h"
 #include "SoftwareRenderer.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../World/LevelData.h"
@@ -17,6 +20,7 @@
 
 class Color;
 class DistantSky;
+class Palette;
 class Rect;
 class Surface;
 class VoxelGrid;
@@ -46,7 +50,12 @@ private:
 	SDL_Window *window;
 	SDL_Renderer *renderer;
 	SDL_Texture *nativeTexture, *gameWorldTexture; // Frame buffers.
+	std::vector<uint32_t> gameWorldBuffer; // Game world pixels when not the texture's size.
+	int gameWorldWidth, gameWorldHeight; // Game world render size in the top left of its texture.
 	SoftwareRenderer softwareRenderer; // Game world renderer.
+	TextureAtlas uiAtlas; // Interface textures packed together.
+	SpriteBatch uiBatch; // Interface textures drawn from the atlas since the last flush.
+	DynamicResolution dynamicResolution; // Game world resolution scale.
 	int letterboxMode; // Determines aspect ratio of the original UI (16:10, 4:3, etc.).
 	bool fullGameWindow; // Determines height of 3D frame buffer.
 
@@ -55,6 +64,29 @@ private:
 
 	// For use with window dimensions, etc.. No longer used for rendering.
 	SDL_Surface *getWindowSurface() const;
+
+	// Gets the game world render dimensions for a resolution scale (at least 1x1).
+	Int2 getGameWorldDimensions(double resolutionScale) const;
+
+	// Recreates the game world frame buffer at the max resolution scale for the current
+	// window dimensions, and resizes the 3D renderer.
+	void resizeGameWorld();
+
+	// Resizes the 3D renderer for the current resolution scale. The game world frame buffer
+	// is kept, and only its top left part is drawn to, so dynamic resolution steps don't
+	// recreate the texture.
+	void rescaleGameWorld();
+
+	// Draws the game world part of the game world frame buffer to the native frame buffer.
+	void drawGameWorld();
+
+	// Copies a texture to the native frame buffer. Textures in the interface atlas are
+	// batched with other atlas copies, and any other texture is drawn right away.
+	void copyTexture(SDL_Texture *texture, const SDL_Rect *srcRect, const SDL_Rect &dstRect);
+
+	// Draws the batched interface copies. Must be called before anything else is drawn to
+	// the native frame buffer.
+	void flushSprites();
 public:
 	// Only defined so members are initialized for Game ctor exception handling.
 	Renderer();
@@ -91,6 +123,16 @@ public:
 	// Gets a screenshot of the current window.
 	Surface getScreenshot() const;
 
+	// Gets the phase timings of the 3D renderer's most recently finished frame.
+	const SoftwareRenderer::FrameTimings &getFrameTimings() const;
+
+	// Gets the resolution scale the game world is currently rendered at. With dynamic
+	// resolution, this changes with render times.
+	double getResolutionScale() const;
+
+	// Returns whether the game world resolution scale follows render times.
+	bool isDynamicResolution() const;
+
 	// Transforms a native window (i.e., 1920x1080) point or rectangle to an original 
 	// (320x200) point or rectangle. Points outside the letterbox will either be negative 
 	// or outside the 320x200 limit when returned.
@@ -108,9 +150,16 @@ public:
 	SDL_Texture *createTexture(uint32_t format, int access, int w, int h);
 	SDL_Texture *createTextureFromSurface(SDL_Surface *surface);
 
+	// Packs a small interface texture into the interface atlas, so drawing it doesn't switch
+	// textures. The surface must have the texture's pixels, and the texture must live until
+	// the renderer is destroyed. Textures too big for the atlas are drawn on their own.
+	void addUITexture(SDL_Texture *texture, SDL_Surface *surface,
+		const std::string &paletteName);
+
 	void init(int width, int height, bool fullscreen, int letterboxMode);
 
-	// Resizes the renderer dimensions.
+	// Resizes the renderer dimensions. With dynamic resolution, the resolution scale is the
+	// highest one it will use.
 	void resize(int width, int height, double resolutionScale, bool fullGameWindow);
 
 	// Sets the letterbox mode.
@@ -137,11 +186,41 @@ public:
 	// the game interface. If there is an existing renderer in memory, it will be 
 	// overwritten with the new one.
 	void initializeWorldRendering(double resolutionScale, bool fullGameWindow,
-		int renderThreadsMode);
+		int renderThreadsMode, int depthBufferMode, bool framePipelining,
+		bool dynamicResolution);
 
 	// Sets which mode to use for software render threads (low, medium, high, etc.).
 	void setRenderThreadsMode(int mode);
 
+	// Sets which storage format to use for the software renderer's depth buffer.
+	void setDepthBufferMode(int mode);
+
+	// Sets whether the software renderer draws the next frame while this one is presented.
+	void setFramePipelining(bool enabled);
+
+	// Sets whether the last game world frame is shown again instead of drawing a new one when
+	// nothing in the game world has changed.
+	void setFrameReuse(bool enabled);
+
+	// Sets whether the game world resolution scale is lowered when frames take too long to
+	// render for the target FPS, and raised again when there's time to spare.
+	void setDynamicResolution(bool enabled);
+
+	// Sets the frame rate that dynamic resolution tries to hold.
+	void setTargetFPS(int targetFPS);
+
+	// Sets the farthest distance the game world is drawn at, bringing in the fog if needed.
+	void setMaxDrawDistance(double maxDrawDistance);
+
+	// Sets whether far away voxels and flats are drawn with smaller mip levels of their textures.
+	void setMipmapping(bool mipmapping);
+
+	// Sets the palette that the game world is drawn with when it's paletted.
+	void setPalette(const Palette &palette);
+
+	// Sets whether the game world is drawn as palette indices and converted to colors after.
+	void setPalettedRendering(bool paletted);
+
 	// Helper methods for changing data in the 3D renderer. Some data, like the voxel
 	// grid, are passed each frame by reference.
 	// - Some 'add' methods take a unique ID and parameters to create a new object.
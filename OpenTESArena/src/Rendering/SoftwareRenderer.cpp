@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <limits>
@@ -13,37 +14,310 @@
 #include "../World/VoxelDataType.h"
 #include "../World/VoxelGrid.h"
 
+namespace
+{
+	// Lookup table for converting 8-bit texel channels to the [0, 1] range. Uses the same
+	// division as Double4::fromARGB() so shading results match the old double texels exactly.
+	const std::array<double, 256> TexelChannelReals = []()
+	{
+		std::array<double, 256> reals;
+		for (size_t i = 0; i < reals.size(); i++)
+		{
+			reals[i] = static_cast<double>(static_cast<uint8_t>(i)) / 255.0;
+		}
+
+		return reals;
+	}();
+
+	// Number of entries in the inverse palette (5 bits of each color channel).
+	const int InversePaletteSize = 1 << 15;
+
+	// Gets the inverse palette entry of a color, from the top five bits of each channel.
+	int getInversePaletteIndex(uint32_t colorRGB)
+	{
+		return static_cast<int>(((colorRGB >> 9) & 0x7C00) | ((colorRGB >> 6) & 0x3E0) |
+			((colorRGB >> 3) & 0x1F));
+	}
+}
+
 SoftwareRenderer::VoxelTexel::VoxelTexel()
 {
-	this->r = 0.0;
-	this->g = 0.0;
-	this->b = 0.0;
-	this->emission = 0.0;
-	this->transparent = false;
+	static_assert(sizeof(VoxelTexel) == 4, "Span kernels expect four-byte voxel texels.");
+
+	this->r = 0;
+	this->g = 0;
+	this->b = 0;
+	this->flags = 0;
+}
+
+bool SoftwareRenderer::VoxelTexel::isTransparent() const
+{
+	return (this->flags & VoxelTexel::FLAG_TRANSPARENT) != 0;
+}
+
+bool SoftwareRenderer::VoxelTexel::isNightLight() const
+{
+	return (this->flags & VoxelTexel::FLAG_NIGHT_LIGHT) != 0;
+}
+
+void SoftwareRenderer::VoxelTexel::set(uint32_t argb)
+{
+	const uint8_t alpha = static_cast<uint8_t>(argb >> 24);
+	this->r = static_cast<uint8_t>(argb >> 16);
+	this->g = static_cast<uint8_t>(argb >> 8);
+	this->b = static_cast<uint8_t>(argb);
+	this->flags = (alpha == 0) ? VoxelTexel::FLAG_TRANSPARENT : 0;
 }
 
 SoftwareRenderer::FlatTexel::FlatTexel()
 {
-	this->r = 0.0;
-	this->g = 0.0;
-	this->b = 0.0;
-	this->a = 0.0;
+	this->r = 0;
+	this->g = 0;
+	this->b = 0;
+	this->a = 0;
+}
+
+void SoftwareRenderer::FlatTexel::set(uint32_t argb)
+{
+	this->r = static_cast<uint8_t>(argb >> 16);
+	this->g = static_cast<uint8_t>(argb >> 8);
+	this->b = static_cast<uint8_t>(argb);
+	this->a = static_cast<uint8_t>(argb >> 24);
 }
 
 SoftwareRenderer::SkyTexel::SkyTexel()
 {
-	this->r = 0.0;
-	this->g = 0.0;
-	this->b = 0.0;
+	this->r = 0;
+	this->g = 0;
+	this->b = 0;
 	this->transparent = false;
 }
 
+void SoftwareRenderer::SkyTexel::set(uint32_t argb)
+{
+	this->r = static_cast<uint8_t>(argb >> 16);
+	this->g = static_cast<uint8_t>(argb >> 8);
+	this->b = static_cast<uint8_t>(argb);
+	this->transparent = static_cast<uint8_t>(argb >> 24) == 0;
+}
+
+int SoftwareRenderer::VoxelTexture::getMipOffset(int mipLevel)
+{
+	// Each level's texels come after all the bigger levels.
+	int offset = 0;
+	for (int i = 0; i < mipLevel; i++)
+	{
+		const int levelWidth = VoxelTexture::WIDTH >> i;
+		offset += levelWidth * levelWidth;
+	}
+
+	return offset;
+}
+
+const SoftwareRenderer::VoxelTexel *SoftwareRenderer::VoxelTexture::getTexels(int mipLevel) const
+{
+	return this->texels.data() + VoxelTexture::getMipOffset(mipLevel);
+}
+
+void SoftwareRenderer::VoxelTexture::updateMipLevels()
+{
+	for (int level = 1; level < VoxelTexture::MIP_LEVEL_COUNT; level++)
+	{
+		const VoxelTexel *srcTexels = this->getTexels(level - 1);
+		VoxelTexel *dstTexels = this->texels.data() + VoxelTexture::getMipOffset(level);
+		const int srcWidth = VoxelTexture::WIDTH >> (level - 1);
+		const int dstWidth = srcWidth / 2;
+
+		for (int y = 0; y < dstWidth; y++)
+		{
+			for (int x = 0; x < dstWidth; x++)
+			{
+				// Average the opaque texels in the 2x2 block. The block is only transparent
+				// if most of it is, so alpha-tested edges don't wear away at each level. Night
+				// lights work the same way, and their color isn't averaged in since it's only
+				// known when shading.
+				int r = 0, g = 0, b = 0, opaqueCount = 0, nightLightCount = 0;
+				for (int i = 0; i < 4; i++)
+				{
+					const int srcX = (x * 2) + (i % 2);
+					const int srcY = (y * 2) + (i / 2);
+					const VoxelTexel &srcTexel = srcTexels[srcY + (srcX * srcWidth)];
+
+					// Transparency takes precedence over the other flags.
+					if (srcTexel.isTransparent())
+					{
+						continue;
+					}
+
+					opaqueCount++;
+					if (srcTexel.isNightLight())
+					{
+						nightLightCount++;
+					}
+					else
+					{
+						r += srcTexel.r;
+						g += srcTexel.g;
+						b += srcTexel.b;
+					}
+				}
+
+				VoxelTexel &dstTexel = dstTexels[y + (x * dstWidth)];
+				dstTexel = VoxelTexel();
+
+				if (opaqueCount < 2)
+				{
+					dstTexel.flags = VoxelTexel::FLAG_TRANSPARENT;
+				}
+				else if ((nightLightCount * 2) >= opaqueCount)
+				{
+					dstTexel.flags = VoxelTexel::FLAG_NIGHT_LIGHT;
+				}
+				else
+				{
+					const int colorCount = opaqueCount - nightLightCount;
+					const int halfCount = colorCount / 2;
+					dstTexel.r = static_cast<uint8_t>((r + halfCount) / colorCount);
+					dstTexel.g = static_cast<uint8_t>((g + halfCount) / colorCount);
+					dstTexel.b = static_cast<uint8_t>((b + halfCount) / colorCount);
+				}
+			}
+		}
+	}
+}
+
+SoftwareRenderer::FlatTexture::MipLevel::MipLevel(int offset, int columnOffset, int width,
+	int height)
+{
+	this->offset = offset;
+	this->columnOffset = columnOffset;
+	this->width = width;
+	this->height = height;
+}
+
+SoftwareRenderer::FlatTexture::OpaqueRun::OpaqueRun(int start, int end)
+{
+	this->start = start;
+	this->end = end;
+}
+
 SoftwareRenderer::FlatTexture::FlatTexture()
 {
 	this->width = 0;
 	this->height = 0;
 }
 
+void SoftwareRenderer::FlatTexture::updateMipLevels()
+{
+	// Lay out every level after the full-size one.
+	this->mipLevels.clear();
+	this->mipLevels.push_back(MipLevel(0, 0, this->width, this->height));
+
+	int texelCount = this->width * this->height;
+	int columnCount = this->width;
+	while ((this->mipLevels.back().width > 1) || (this->mipLevels.back().height > 1))
+	{
+		const MipLevel &prevLevel = this->mipLevels.back();
+		const int levelWidth = std::max(prevLevel.width / 2, 1);
+		const int levelHeight = std::max(prevLevel.height / 2, 1);
+		this->mipLevels.push_back(MipLevel(texelCount, columnCount, levelWidth, levelHeight));
+		texelCount += levelWidth * levelHeight;
+		columnCount += levelWidth;
+	}
+
+	this->texels.resize(texelCount);
+
+	for (size_t level = 1; level < this->mipLevels.size(); level++)
+	{
+		const MipLevel &srcLevel = this->mipLevels[level - 1];
+		const MipLevel &dstLevel = this->mipLevels[level];
+
+		// Odd sizes round down, so the last row or column of a level is dropped.
+		const int blockWidth = std::min(srcLevel.width, 2);
+		const int blockHeight = std::min(srcLevel.height, 2);
+		const int blockCount = blockWidth * blockHeight;
+
+		for (int y = 0; y < dstLevel.height; y++)
+		{
+			for (int x = 0; x < dstLevel.width; x++)
+			{
+				// Same as voxel textures: average the opaque texels, and only be transparent
+				// if most of the block is.
+				int r = 0, g = 0, b = 0, opaqueCount = 0;
+				for (int i = 0; i < blockCount; i++)
+				{
+					const int srcX = (x * blockWidth) + (i % blockWidth);
+					const int srcY = (y * blockHeight) + (i / blockWidth);
+					const FlatTexel &srcTexel =
+						this->texels[srcLevel.offset + srcY + (srcX * srcLevel.height)];
+
+					if (srcTexel.a > 0)
+					{
+						r += srcTexel.r;
+						g += srcTexel.g;
+						b += srcTexel.b;
+						opaqueCount++;
+					}
+				}
+
+				FlatTexel &dstTexel = this->texels[dstLevel.offset + y + (x * dstLevel.height)];
+				if ((opaqueCount * 2) >= blockCount)
+				{
+					const int halfCount = opaqueCount / 2;
+					dstTexel.r = static_cast<uint8_t>((r + halfCount) / opaqueCount);
+					dstTexel.g = static_cast<uint8_t>((g + halfCount) / opaqueCount);
+					dstTexel.b = static_cast<uint8_t>((b + halfCount) / opaqueCount);
+					dstTexel.a = 255;
+				}
+				else
+				{
+					dstTexel = FlatTexel();
+				}
+			}
+		}
+	}
+}
+
+void SoftwareRenderer::FlatTexture::updateOpaqueRuns()
+{
+	this->opaqueRuns.clear();
+	this->columnRuns.clear();
+
+	for (const MipLevel &mipLevel : this->mipLevels)
+	{
+		for (int x = 0; x < mipLevel.width; x++)
+		{
+			this->columnRuns.push_back(static_cast<int>(this->opaqueRuns.size()));
+
+			const FlatTexel *columnTexels =
+				this->texels.data() + mipLevel.offset + (x * mipLevel.height);
+
+			int y = 0;
+			while (y < mipLevel.height)
+			{
+				// Skip the transparent texels, then find where the opaque ones end.
+				while ((y < mipLevel.height) && (columnTexels[y].a == 0))
+				{
+					y++;
+				}
+
+				const int runStart = y;
+				while ((y < mipLevel.height) && (columnTexels[y].a > 0))
+				{
+					y++;
+				}
+
+				if (y > runStart)
+				{
+					this->opaqueRuns.push_back(OpaqueRun(runStart, y));
+				}
+			}
+		}
+	}
+
+	this->columnRuns.push_back(static_cast<int>(this->opaqueRuns.size()));
+}
+
 SoftwareRenderer::SkyTexture::SkyTexture()
 {
 	this->width = 0;
@@ -280,6 +554,14 @@ SoftwareRenderer::ShadingInfo::ShadingInfo(const std::vector<Double3> &skyPalett
 	this->distantAmbient = MathUtils::clamp(ambient, 0.25, 1.0);
 
 	this->fogDistance = fogDistance;
+
+	const Double3 fogColor = this->getFogColor().clamped();
+	this->fogColorRGB = SpanKernels::packColor(fogColor.x, fogColor.y, fogColor.z);
+	this->fogScale = SpanKernels::getFogScale(fogDistance);
+
+	this->mipPixelSize = 0.0;
+	this->nightLightTexel = 0;
+	this->lightGrid = nullptr;
 }
 
 const Double3 &SoftwareRenderer::ShadingInfo::getFogColor() const
@@ -288,122 +570,629 @@ const Double3 &SoftwareRenderer::ShadingInfo::getFogColor() const
 	return this->skyColors.front();
 }
 
-SoftwareRenderer::FrameView::FrameView(uint32_t *colorBuffer, double *depthBuffer, 
-	int width, int height)
+Double3 SoftwareRenderer::ShadingInfo::getSunlight(const Double3 &normal) const
+{
+	const double lightNormalDot = std::max(0.0, this->sunDirection.dot(normal));
+	const Double3 sunComponent = (this->sunColor * lightNormalDot).clamped(
+		0.0, 1.0 - this->ambient);
+	return Double3(this->ambient, this->ambient, this->ambient) + sunComponent;
+}
+
+const uint16_t SoftwareRenderer::FrameView::FIXED16_INFINITY =
+	std::numeric_limits<uint16_t>::max();
+
+SoftwareRenderer::DepthRows::DepthRows()
+{
+	this->yStart = 0;
+	this->yEnd = 0;
+}
+
+SoftwareRenderer::FrameView::FrameView(uint32_t *colorBuffer, uint8_t *indexBuffer,
+	const uint8_t *inversePalette, void *depthBuffer, DepthRows *depthRows,
+	DepthFormat depthFormat, double depthRange, int width, int height)
 {
 	this->colorBuffer = colorBuffer;
+	this->indexBuffer = indexBuffer;
+	this->inversePalette = inversePalette;
 	this->depthBuffer = depthBuffer;
+	this->depthRows = depthRows;
+	this->depthFormat = depthFormat;
+
+	// The largest 16-bit value is reserved for infinity, so finite depths saturate one below it.
+	// Anything beyond the depth range is completely fogged, so precision there doesn't matter.
+	assert(depthRange > 0.0);
+	this->fixed16Step = depthRange / static_cast<double>(FrameView::FIXED16_INFINITY - 1);
+	this->fixed16StepRecip = 1.0 / this->fixed16Step;
+
+	// Walls are only drawn over depths they're nearer than by the bias, so it must be at least
+	// the format's precision within the depth range, or else rounding lets a surface at the
+	// same distance through.
+	if (depthFormat == DepthFormat::Double)
+	{
+		this->depthBias = Constants::Epsilon;
+	}
+	else if (depthFormat == DepthFormat::Float)
+	{
+		this->depthBias = std::max(Constants::Epsilon,
+			depthRange * static_cast<double>(std::numeric_limits<float>::epsilon()));
+	}
+	else
+	{
+		this->depthBias = std::max(Constants::Epsilon, this->fixed16Step);
+	}
+
 	this->width = width;
 	this->height = height;
 	this->widthReal = static_cast<double>(width);
 	this->heightReal = static_cast<double>(height);
 }
 
-SoftwareRenderer::VisibleFlat::VisibleFlat(const Flat &flat, Flat::Frame &&frame)
+void SoftwareRenderer::FrameView::setColor(int index, uint32_t colorRGB) const
 {
-	this->flat = &flat;
-	this->frame = std::move(frame);
+	if (this->indexBuffer == nullptr)
+	{
+		this->colorBuffer[index] = colorRGB;
+	}
+	else
+	{
+		this->indexBuffer[index] = this->inversePalette[getInversePaletteIndex(colorRGB)];
+	}
 }
 
-const SoftwareRenderer::Flat &SoftwareRenderer::VisibleFlat::getFlat() const
+void SoftwareRenderer::FrameView::fillColor(int index, int count, uint32_t colorRGB) const
 {
-	return *this->flat;
+	if (this->indexBuffer == nullptr)
+	{
+		uint32_t *colorPtr = this->colorBuffer + index;
+		std::fill(colorPtr, colorPtr + count, colorRGB);
+	}
+	else
+	{
+		uint8_t *indexPtr = this->indexBuffer + index;
+		std::fill(indexPtr, indexPtr + count,
+			this->inversePalette[getInversePaletteIndex(colorRGB)]);
+	}
 }
 
-const SoftwareRenderer::Flat::Frame &SoftwareRenderer::VisibleFlat::getFrame() const
+template <>
+double SoftwareRenderer::FrameView::getDepthAs<double>(int index) const
 {
-	return this->frame;
+	return static_cast<const double*>(this->depthBuffer)[index];
 }
 
-template <typename T>
-SoftwareRenderer::DistantObject<T>::DistantObject(const T &obj, int textureIndex)
-	: obj(obj)
+template <>
+double SoftwareRenderer::FrameView::getDepthAs<float>(int index) const
 {
-	this->textureIndex = textureIndex;
+	return static_cast<double>(static_cast<const float*>(this->depthBuffer)[index]);
 }
 
-const int SoftwareRenderer::DistantObjects::NO_SUN = -1;
+template <>
+double SoftwareRenderer::FrameView::getDepthAs<uint16_t>(int index) const
+{
+	const uint16_t depth = static_cast<const uint16_t*>(this->depthBuffer)[index];
+	return (depth != FrameView::FIXED16_INFINITY) ?
+		(static_cast<double>(depth) * this->fixed16Step) :
+		std::numeric_limits<double>::infinity();
+}
 
-SoftwareRenderer::DistantObjects::DistantObjects()
+template <>
+void SoftwareRenderer::FrameView::setDepthAs<double>(int index, double depth) const
 {
-	this->sunTextureIndex = DistantObjects::NO_SUN;
+	static_cast<double*>(this->depthBuffer)[index] = depth;
 }
 
-void SoftwareRenderer::DistantObjects::init(const DistantSky &distantSky,
-	std::vector<SkyTexture> &skyTextures)
+template <>
+void SoftwareRenderer::FrameView::setDepthAs<float>(int index, double depth) const
 {
-	assert(skyTextures.size() == 0);
+	static_cast<float*>(this->depthBuffer)[index] = static_cast<float>(depth);
+}
 
-	// Creates a render texture from the given surface, adds it to the sky textures list, and
-	// returns its index in the sky textures list.
-	auto addSkyTexture = [&skyTextures](const Surface &surface)
+template <>
+void SoftwareRenderer::FrameView::setDepthAs<uint16_t>(int index, double depth) const
+{
+	// Round to the nearest step, saturating below the infinity value.
+	const double maxDepth = static_cast<double>(FrameView::FIXED16_INFINITY - 1);
+	const double quantized = std::min((depth * this->fixed16StepRecip) + 0.50, maxDepth);
+	static_cast<uint16_t*>(this->depthBuffer)[index] = static_cast<uint16_t>(quantized);
+}
+
+double SoftwareRenderer::FrameView::getDepth(int index) const
+{
+	if (this->depthFormat == DepthFormat::Double)
 	{
-		const int width = surface.getWidth();
-		const int height = surface.getHeight();
-		const uint32_t *texels = static_cast<const uint32_t*>(surface.getPixels());
-		const int texelCount = width * height;
+		return this->getDepthAs<double>(index);
+	}
+	else if (this->depthFormat == DepthFormat::Float)
+	{
+		return this->getDepthAs<float>(index);
+	}
+	else
+	{
+		return this->getDepthAs<uint16_t>(index);
+	}
+}
 
-		skyTextures.push_back(SkyTexture());
-		SkyTexture &texture = skyTextures.back();
-		texture.texels = std::vector<SkyTexel>(texelCount);
-		texture.width = width;
-		texture.height = height;
+void SoftwareRenderer::FrameView::setDepth(int index, double depth) const
+{
+	if (this->depthFormat == DepthFormat::Double)
+	{
+		this->setDepthAs<double>(index, depth);
+	}
+	else if (this->depthFormat == DepthFormat::Float)
+	{
+		this->setDepthAs<float>(index, depth);
+	}
+	else
+	{
+		this->setDepthAs<uint16_t>(index, depth);
+	}
+}
 
-		for (int i = 0; i < texelCount; i++)
+void SoftwareRenderer::FrameView::clearDepth(int x, int yStart, int yEnd) const
+{
+	const int startIndex = x + (yStart * this->width);
+	const int endIndex = x + (yEnd * this->width);
+
+	if (this->depthFormat == DepthFormat::Double)
+	{
+		double *depthPtr = static_cast<double*>(this->depthBuffer);
+		for (int index = startIndex; index < endIndex; index += this->width)
 		{
-			const Double4 srcTexel = Double4::fromARGB(texels[i]);
-			SkyTexel &dstTexel = texture.texels[i];
-			dstTexel.r = srcTexel.x;
-			dstTexel.g = srcTexel.y;
-			dstTexel.b = srcTexel.z;
-			dstTexel.transparent = srcTexel.w == 0.0;
+			depthPtr[index] = std::numeric_limits<double>::infinity();
 		}
-
-		return static_cast<int>(skyTextures.size()) - 1;
-	};
-
-	// Creates a render texture with a single texel for small stars.
-	auto addSmallStarTexture = [&skyTextures](uint32_t color)
+	}
+	else if (this->depthFormat == DepthFormat::Float)
 	{
-		skyTextures.push_back(SkyTexture());
-		SkyTexture &texture = skyTextures.back();
-		texture.texels = std::vector<SkyTexel>(1);
-		texture.width = 1;
-		texture.height = 1;
-
-		const Double4 srcColor = Double4::fromARGB(color);
-		SkyTexel &dstTexel = texture.texels.front();
-		dstTexel.r = srcColor.x;
-		dstTexel.g = srcColor.y;
-		dstTexel.b = srcColor.z;
-		dstTexel.transparent = false;
+		float *depthPtr = static_cast<float*>(this->depthBuffer);
+		for (int index = startIndex; index < endIndex; index += this->width)
+		{
+			depthPtr[index] = std::numeric_limits<float>::infinity();
+		}
+	}
+	else
+	{
+		uint16_t *depthPtr = static_cast<uint16_t*>(this->depthBuffer);
+		for (int index = startIndex; index < endIndex; index += this->width)
+		{
+			depthPtr[index] = FrameView::FIXED16_INFINITY;
+		}
+	}
+}
 
-		return static_cast<int>(skyTextures.size()) - 1;
-	};
+void SoftwareRenderer::FrameView::resetDepthRows(int x) const
+{
+	this->depthRows[x] = DepthRows();
+}
 
-	// Reverse iterate through each distant object type in the distant sky, creating associations
-	// between the distant sky object and its render texture. Order of insertion matters.
-	for (int i = distantSky.getLandObjectCount() - 1; i >= 0; i--)
+void SoftwareRenderer::FrameView::prepareDepth(int x, int yStart, int yEnd) const
+{
+	if (yStart >= yEnd)
 	{
-		const DistantSky::LandObject &landObject = distantSky.getLandObject(i);
-		const int textureIndex = addSkyTexture(landObject.getSurface());
-		this->lands.push_back(DistantObject<DistantSky::LandObject>(
-			landObject, textureIndex));
+		return;
 	}
 
-	for (int i = distantSky.getAnimatedLandObjectCount() - 1; i >= 0; i--)
+	DepthRows &rows = this->depthRows[x];
+	if (rows.yStart >= rows.yEnd)
 	{
-		const DistantSky::AnimatedLandObject &animLandObject = distantSky.getAnimatedLandObject(i);
-
-		// Add first texture to get the start index of the animated textures.
-		const int textureIndex = addSkyTexture(animLandObject.getSurface(0));
-
-		for (int j = 1; j < animLandObject.getSurfaceCount(); j++)
+		// Nothing in the column is cleared yet.
+		this->clearDepth(x, yStart, yEnd);
+		rows.yStart = yStart;
+		rows.yEnd = yEnd;
+	}
+	else
+	{
+		// Grow the cleared rows to include the new ones, so they stay one contiguous range.
+		if (yStart < rows.yStart)
 		{
-			addSkyTexture(animLandObject.getSurface(j));
+			this->clearDepth(x, yStart, rows.yStart);
+			rows.yStart = yStart;
 		}
 
-		this->animLands.push_back(DistantObject<DistantSky::AnimatedLandObject>(
+		if (yEnd > rows.yEnd)
+		{
+			this->clearDepth(x, rows.yEnd, yEnd);
+			rows.yEnd = yEnd;
+		}
+	}
+}
+
+SoftwareRenderer::DepthRows SoftwareRenderer::FrameView::claimDepth(int x, int yStart,
+	int yEnd) const
+{
+	DepthRows &rows = this->depthRows[x];
+	const DepthRows clearedRows = rows;
+
+	if (yStart >= yEnd)
+	{
+		return clearedRows;
+	}
+
+	if (rows.yStart >= rows.yEnd)
+	{
+		rows.yStart = yStart;
+		rows.yEnd = yEnd;
+	}
+	else
+	{
+		// Only a gap between the claimed rows and the cleared ones needs clearing.
+		if (yEnd < rows.yStart)
+		{
+			this->clearDepth(x, yEnd, rows.yStart);
+		}
+		else if (yStart > rows.yEnd)
+		{
+			this->clearDepth(x, rows.yEnd, yStart);
+		}
+
+		rows.yStart = std::min(rows.yStart, yStart);
+		rows.yEnd = std::max(rows.yEnd, yEnd);
+	}
+
+	return clearedRows;
+}
+
+SoftwareRenderer::FlatChunk::FlatChunk()
+{
+	this->maxHalfWidth = 0.0;
+}
+
+SoftwareRenderer::Light::Light()
+{
+	this->intensity = 0.0;
+}
+
+SoftwareRenderer::LightGrid::LightGrid()
+{
+	this->cellDim = 0.0;
+	this->cellCount = 0;
+}
+
+void SoftwareRenderer::LightGrid::update(const std::unordered_map<int, Light> &lights,
+	const Camera &camera, double fogDistance, int frameWidth)
+{
+	this->lights.clear();
+	this->cellStarts.clear();
+	this->cellLights.clear();
+	this->cellLightPairs.clear();
+	this->eye = Double2(camera.eye.x, camera.eye.z);
+	this->cellCount = 0;
+
+	// Ray direction of each screen column, for getting points on walls from their depth.
+	const Double2 forwardZoomed(camera.forwardZoomedX, camera.forwardZoomedZ);
+	const Double2 rightAspected(camera.rightAspectedX, camera.rightAspectedZ);
+	const double frameWidthReal = static_cast<double>(frameWidth);
+	this->columnDirections.resize(frameWidth);
+	for (int x = 0; x < frameWidth; x++)
+	{
+		const double xPercent = (static_cast<double>(x) + 0.50) / frameWidthReal;
+		const Double2 rightComp = rightAspected * ((2.0 * xPercent) - 1.0);
+		this->columnDirections[x] = (forwardZoomed + rightComp).normalized();
+	}
+
+	// Nothing to sort when no lights are registered (i.e., the game doesn't add any yet).
+	if (lights.empty())
+	{
+		return;
+	}
+
+	// The grid only covers what can be seen through the fog. Cells get bigger instead of
+	// more numerous when the fog distance is large.
+	const double range = std::max(fogDistance, SoftwareRenderer::LIGHT_CELL_DIM);
+	const double gridDim = range * 2.0;
+	this->cellCount = std::min(std::max(static_cast<int>(
+		std::ceil(gridDim / SoftwareRenderer::LIGHT_CELL_DIM)), 1),
+		SoftwareRenderer::MAX_LIGHT_CELLS);
+	this->cellDim = gridDim / static_cast<double>(this->cellCount);
+	this->origin = Double2(this->eye.x - range, this->eye.y - range);
+
+	// Put each light in every cell its radius touches.
+	for (const auto &pair : lights)
+	{
+		const Light &light = pair.second;
+		if (light.intensity <= 0.0)
+		{
+			continue;
+		}
+
+		const double localX = (light.point.x - this->origin.x) / this->cellDim;
+		const double localZ = (light.point.z - this->origin.y) / this->cellDim;
+		const double localRadius = light.intensity / this->cellDim;
+		const int startX = std::max(static_cast<int>(std::floor(localX - localRadius)), 0);
+		const int endX = std::min(static_cast<int>(std::floor(localX + localRadius)),
+			this->cellCount - 1);
+		const int startZ = std::max(static_cast<int>(std::floor(localZ - localRadius)), 0);
+		const int endZ = std::min(static_cast<int>(std::floor(localZ + localRadius)),
+			this->cellCount - 1);
+
+		if ((startX > endX) || (startZ > endZ))
+		{
+			// Entirely outside the grid.
+			continue;
+		}
+
+		const int lightIndex = static_cast<int>(this->lights.size());
+		this->lights.push_back(light);
+
+		for (int z = startZ; z <= endZ; z++)
+		{
+			for (int x = startX; x <= endX; x++)
+			{
+				// Closest point in the cell to the light.
+				const double nearestX = std::min(std::max(localX, static_cast<double>(x)),
+					static_cast<double>(x + 1));
+				const double nearestZ = std::min(std::max(localZ, static_cast<double>(z)),
+					static_cast<double>(z + 1));
+				const double diffX = nearestX - localX;
+				const double diffZ = nearestZ - localZ;
+
+				if (((diffX * diffX) + (diffZ * diffZ)) < (localRadius * localRadius))
+				{
+					const int cellIndex = x + (z * this->cellCount);
+					this->cellLightPairs.push_back(Int2(cellIndex, lightIndex));
+				}
+			}
+		}
+	}
+
+	// Group the lights by cell, nearest to the cell's center first, so crowded cells keep
+	// the lights that matter most.
+	auto getCenterDistSqr = [this](const Int2 &cellLightPair)
+	{
+		const int cellX = cellLightPair.x % this->cellCount;
+		const int cellZ = cellLightPair.x / this->cellCount;
+		const Light &light = this->lights[cellLightPair.y];
+		const double diffX = (this->origin.x +
+			((static_cast<double>(cellX) + 0.50) * this->cellDim)) - light.point.x;
+		const double diffZ = (this->origin.y +
+			((static_cast<double>(cellZ) + 0.50) * this->cellDim)) - light.point.z;
+		return (diffX * diffX) + (diffZ * diffZ);
+	};
+
+	std::sort(this->cellLightPairs.begin(), this->cellLightPairs.end(),
+		[&getCenterDistSqr](const Int2 &a, const Int2 &b)
+	{
+		if (a.x != b.x)
+		{
+			return a.x < b.x;
+		}
+
+		return getCenterDistSqr(a) < getCenterDistSqr(b);
+	});
+
+	const int totalCells = this->cellCount * this->cellCount;
+	this->cellStarts.resize(totalCells + 1);
+
+	int pairIndex = 0;
+	const int pairCount = static_cast<int>(this->cellLightPairs.size());
+	for (int cellIndex = 0; cellIndex < totalCells; cellIndex++)
+	{
+		this->cellStarts[cellIndex] = static_cast<int>(this->cellLights.size());
+
+		int cellLightCount = 0;
+		while ((pairIndex < pairCount) && (this->cellLightPairs[pairIndex].x == cellIndex))
+		{
+			if (cellLightCount < SoftwareRenderer::MAX_LIGHTS_PER_CELL)
+			{
+				this->cellLights.push_back(this->cellLightPairs[pairIndex].y);
+				cellLightCount++;
+			}
+
+			pairIndex++;
+		}
+	}
+
+	this->cellStarts[totalCells] = static_cast<int>(this->cellLights.size());
+}
+
+Double2 SoftwareRenderer::LightGrid::getColumnPoint(int x, double depth) const
+{
+	return this->eye + (this->columnDirections[x] * depth);
+}
+
+Double3 SoftwareRenderer::LightGrid::getLight(const Double2 &point, const Double2 &normal) const
+{
+	Double3 light = Double3::Zero;
+	if (this->cellLights.empty())
+	{
+		return light;
+	}
+
+	const int cellX = static_cast<int>(std::floor((point.x - this->origin.x) / this->cellDim));
+	const int cellZ = static_cast<int>(std::floor((point.y - this->origin.y) / this->cellDim));
+	if ((cellX < 0) || (cellX >= this->cellCount) || (cellZ < 0) || (cellZ >= this->cellCount))
+	{
+		return light;
+	}
+
+	const int cellIndex = cellX + (cellZ * this->cellCount);
+	const int startIndex = this->cellStarts[cellIndex];
+	const int endIndex = this->cellStarts[cellIndex + 1];
+	for (int i = startIndex; i < endIndex; i++)
+	{
+		const Light &pointLight = this->lights[this->cellLights[i]];
+		const Double2 diff(pointLight.point.x - point.x, pointLight.point.z - point.y);
+
+		// Skip lights behind the surface.
+		if (normal.dot(diff) < 0.0)
+		{
+			continue;
+		}
+
+		const double dist = diff.length();
+		if (dist < pointLight.intensity)
+		{
+			light = light + (pointLight.color * (1.0 - (dist / pointLight.intensity)));
+		}
+	}
+
+	return light;
+}
+
+SoftwareRenderer::VisibleFlat::VisibleFlat(const Flat &flat, Flat::Frame &&frame)
+{
+	this->flat = &flat;
+	this->frame = std::move(frame);
+}
+
+const SoftwareRenderer::Flat &SoftwareRenderer::VisibleFlat::getFlat() const
+{
+	return *this->flat;
+}
+
+const SoftwareRenderer::Flat::Frame &SoftwareRenderer::VisibleFlat::getFrame() const
+{
+	return this->frame;
+}
+
+void SoftwareRenderer::VisibleFlat::setFlat(const Flat &flat)
+{
+	this->flat = &flat;
+}
+
+template <typename T>
+SoftwareRenderer::DistantObject<T>::DistantObject(const T &obj, int textureIndex)
+	: obj(obj)
+{
+	this->textureIndex = textureIndex;
+}
+
+void SoftwareRenderer::DistantBuckets::init(const std::vector<Double3> &directions,
+	const std::vector<Double2> &dimensions)
+{
+	assert(directions.size() == dimensions.size());
+
+	const int azimuthCount = SoftwareRenderer::DISTANT_BUCKET_AZIMUTHS;
+	const int elevationCount = SoftwareRenderer::DISTANT_BUCKET_ELEVATIONS;
+	this->buckets = std::vector<Bucket>(azimuthCount * elevationCount);
+
+	// Put each object in the bucket of its azimuth and elevation cell.
+	for (int i = 0; i < static_cast<int>(directions.size()); i++)
+	{
+		const Double3 &direction = directions[i];
+		const double azimuth = MathUtils::fullAtan2(direction.x, direction.z);
+		const double elevation = std::asin(MathUtils::clamp(direction.y, -1.0, 1.0));
+		const int azimuthIndex = std::min(static_cast<int>(
+			(azimuth / Constants::TwoPi) * azimuthCount), azimuthCount - 1);
+		const int elevationIndex = std::min(static_cast<int>(
+			((elevation + Constants::HalfPi) / Constants::Pi) * elevationCount), elevationCount - 1);
+
+		Bucket &bucket = this->buckets[azimuthIndex + (elevationIndex * azimuthCount)];
+		bucket.indices.push_back(i);
+	}
+
+	this->buckets.erase(std::remove_if(this->buckets.begin(), this->buckets.end(),
+		[](const Bucket &bucket) { return bucket.indices.size() == 0; }), this->buckets.end());
+
+	// Fit a cone around the objects in each bucket.
+	for (Bucket &bucket : this->buckets)
+	{
+		Double3 directionSum = Double3::Zero;
+		for (const int index : bucket.indices)
+		{
+			directionSum = directionSum + directions[index];
+		}
+
+		bucket.direction = directionSum.normalized();
+		bucket.radius = 0.0;
+		bucket.maxHalfWidthRadians = 0.0;
+		bucket.maxHeight = 0.0;
+
+		for (const int index : bucket.indices)
+		{
+			const double cosAngle = MathUtils::clamp(bucket.direction.dot(directions[index]),
+				-1.0, 1.0);
+			const Double2 &objDimensions = dimensions[index];
+			bucket.radius = std::max(bucket.radius, std::acos(cosAngle));
+			bucket.maxHalfWidthRadians = std::max(bucket.maxHalfWidthRadians,
+				(objDimensions.x * 0.50) * DistantSky::IDENTITY_ANGLE_RADIANS);
+			bucket.maxHeight = std::max(bucket.maxHeight, objDimensions.y);
+		}
+
+		// Leave room for rounding in each object's own angles.
+		bucket.radius += Constants::Epsilon;
+	}
+}
+
+void SoftwareRenderer::DistantBuckets::clear()
+{
+	this->buckets.clear();
+}
+
+const int SoftwareRenderer::DistantObjects::NO_SUN = -1;
+
+SoftwareRenderer::DistantObjects::DistantObjects()
+{
+	this->sunTextureIndex = DistantObjects::NO_SUN;
+}
+
+void SoftwareRenderer::DistantObjects::init(const DistantSky &distantSky,
+	std::vector<SkyTexture> &skyTextures)
+{
+	assert(skyTextures.size() == 0);
+
+	// Creates a render texture from the given surface, adds it to the sky textures list, and
+	// returns its index in the sky textures list.
+	auto addSkyTexture = [&skyTextures](const Surface &surface)
+	{
+		const int width = surface.getWidth();
+		const int height = surface.getHeight();
+		const uint32_t *texels = static_cast<const uint32_t*>(surface.getPixels());
+		const int texelCount = width * height;
+
+		skyTextures.push_back(SkyTexture());
+		SkyTexture &texture = skyTextures.back();
+		texture.texels = std::vector<SkyTexel>(texelCount);
+		texture.width = width;
+		texture.height = height;
+
+		for (int i = 0; i < texelCount; i++)
+		{
+			texture.texels[i].set(texels[i]);
+		}
+
+		return static_cast<int>(skyTextures.size()) - 1;
+	};
+
+	// Creates a render texture with a single texel for small stars.
+	auto addSmallStarTexture = [&skyTextures](uint32_t color)
+	{
+		skyTextures.push_back(SkyTexture());
+		SkyTexture &texture = skyTextures.back();
+		texture.texels = std::vector<SkyTexel>(1);
+		texture.width = 1;
+		texture.height = 1;
+
+		// Small stars are always opaque.
+		SkyTexel &dstTexel = texture.texels.front();
+		dstTexel.set(color);
+		dstTexel.transparent = false;
+
+		return static_cast<int>(skyTextures.size()) - 1;
+	};
+
+	// Reverse iterate through each distant object type in the distant sky, creating associations
+	// between the distant sky object and its render texture. Order of insertion matters.
+	for (int i = distantSky.getLandObjectCount() - 1; i >= 0; i--)
+	{
+		const DistantSky::LandObject &landObject = distantSky.getLandObject(i);
+		const int textureIndex = addSkyTexture(landObject.getSurface());
+		this->lands.push_back(DistantObject<DistantSky::LandObject>(
+			landObject, textureIndex));
+	}
+
+	for (int i = distantSky.getAnimatedLandObjectCount() - 1; i >= 0; i--)
+	{
+		const DistantSky::AnimatedLandObject &animLandObject = distantSky.getAnimatedLandObject(i);
+
+		// Add first texture to get the start index of the animated textures.
+		const int textureIndex = addSkyTexture(animLandObject.getSurface(0));
+
+		for (int j = 1; j < animLandObject.getSurfaceCount(); j++)
+		{
+			addSkyTexture(animLandObject.getSurface(j));
+		}
+
+		this->animLands.push_back(DistantObject<DistantSky::AnimatedLandObject>(
 			animLandObject, textureIndex));
 	}
 
@@ -454,6 +1243,73 @@ void SoftwareRenderer::DistantObjects::init(const DistantSky &distantSky,
 		// Add the sun to the sky textures and assign its texture index.
 		this->sunTextureIndex = addSkyTexture(distantSky.getSunSurface());
 	}
+
+	// Group the objects that there can be many of into buckets by direction. The moons and
+	// sun are only a few objects, so they're always tested.
+	std::vector<Double3> directions;
+	std::vector<Double2> dimensions;
+
+	// Lambda for getting the dimensions of a sky texture relative to the identity dim.
+	auto getDimensions = [&skyTextures](int textureIndex)
+	{
+		const SkyTexture &texture = skyTextures.at(textureIndex);
+		return Double2(
+			static_cast<double>(texture.width) / DistantSky::IDENTITY_DIM,
+			static_cast<double>(texture.height) / DistantSky::IDENTITY_DIM);
+	};
+
+	for (const auto &land : this->lands)
+	{
+		const double xAngleRadians = land.obj.getAngleRadians();
+		directions.push_back(Double3(std::sin(xAngleRadians), 0.0, std::cos(xAngleRadians)));
+		dimensions.push_back(getDimensions(land.textureIndex));
+	}
+
+	this->landBuckets.init(directions, dimensions);
+	directions.clear();
+	dimensions.clear();
+
+	for (const auto &animLand : this->animLands)
+	{
+		// Use the largest image of the animation.
+		Double2 maxDimensions = Double2::Zero;
+		for (int i = 0; i < animLand.obj.getSurfaceCount(); i++)
+		{
+			const Double2 imageDimensions = getDimensions(animLand.textureIndex + i);
+			maxDimensions = Double2(std::max(maxDimensions.x, imageDimensions.x),
+				std::max(maxDimensions.y, imageDimensions.y));
+		}
+
+		const double xAngleRadians = animLand.obj.getAngleRadians();
+		directions.push_back(Double3(std::sin(xAngleRadians), 0.0, std::cos(xAngleRadians)));
+		dimensions.push_back(maxDimensions);
+	}
+
+	this->animLandBuckets.init(directions, dimensions);
+	directions.clear();
+	dimensions.clear();
+
+	for (const auto &air : this->airs)
+	{
+		const double xAngleRadians = air.obj.getAngleRadians();
+		const double yAngleRadians = air.obj.getHeight() *
+			(SoftwareRenderer::DISTANT_CLOUDS_MAX_ANGLE * Constants::DegToRad);
+		directions.push_back(Double3(std::sin(xAngleRadians), std::tan(yAngleRadians),
+			std::cos(xAngleRadians)).normalized());
+		dimensions.push_back(getDimensions(air.textureIndex));
+	}
+
+	this->airBuckets.init(directions, dimensions);
+	directions.clear();
+	dimensions.clear();
+
+	for (const auto &star : this->stars)
+	{
+		directions.push_back(star.obj.getDirection().normalized());
+		dimensions.push_back(getDimensions(star.textureIndex));
+	}
+
+	this->starBuckets.init(directions, dimensions);
 }
 
 void SoftwareRenderer::DistantObjects::clear()
@@ -463,6 +1319,10 @@ void SoftwareRenderer::DistantObjects::clear()
 	this->airs.clear();
 	this->moons.clear();
 	this->stars.clear();
+	this->landBuckets.clear();
+	this->animLandBuckets.clear();
+	this->airBuckets.clear();
+	this->starBuckets.clear();
 	this->sunTextureIndex = DistantObjects::NO_SUN;
 }
 
@@ -534,78 +1394,486 @@ void SoftwareRenderer::VisDistantObjects::clear()
 	this->starEnd = 0;
 }
 
-void SoftwareRenderer::RenderThreadData::SkyGradient::init(double projectedYTop,
-	double projectedYBottom, std::vector<Double3> &rowCache)
+SoftwareRenderer::SkyLayer::SkyLayer()
 {
-	this->threadsDone = 0;
-	this->rowCache = &rowCache;
-	this->projectedYTop = projectedYTop;
-	this->projectedYBottom = projectedYBottom;
-	this->shouldDrawStars = false;
+	this->fovY = 0.0;
+	this->latitude = 0.0;
+	this->width = 0;
+	this->daytimeStep = 0;
+	this->distantLightLevel = 0;
+	this->yStart = 0;
+	this->yEnd = 0;
+	this->parallaxSky = false;
+	this->saved = false;
+}
+
+void SoftwareRenderer::SkyLayer::init(int width, int height)
+{
+	this->colors = std::vector<uint32_t>(width * height);
+	this->indices = std::vector<uint8_t>(width * height);
+	this->width = width;
+	this->yStart = 0;
+	this->yEnd = 0;
+	this->saved = false;
+}
+
+SoftwareRenderer::SkyLayer::Use SoftwareRenderer::SkyLayer::update(const Double3 &direction,
+	double fovY, int daytimeStep, double latitude, int distantLightLevel, bool parallaxSky,
+	const DistantObjects &distantObjects)
+{
+	// Animated lands (i.e., volcanoes) are the only distant objects that change on their own.
+	const auto &animLands = distantObjects.animLands;
+	bool sameAnimLands = this->animLandIndices.size() == animLands.size();
+	for (size_t i = 0; sameAnimLands && (i < animLands.size()); i++)
+	{
+		sameAnimLands = this->animLandIndices[i] == animLands[i].obj.getIndex();
+	}
+
+	// Distant objects are infinitely far away, so the camera's position doesn't matter. The
+	// latitude tilts the stars, sun, and moons. Fog isn't applied to distant objects, and
+	// weather changes go through the sky palette and distant sky setters, which reset this.
+	const bool sameSky = sameAnimLands && (this->direction == direction) &&
+		(this->fovY == fovY) && (this->daytimeStep == daytimeStep) &&
+		(this->latitude == latitude) && (this->distantLightLevel == distantLightLevel) &&
+		(this->parallaxSky == parallaxSky);
+
+	if (!sameSky)
+	{
+		this->animLandIndices.resize(animLands.size());
+		for (size_t i = 0; i < animLands.size(); i++)
+		{
+			this->animLandIndices[i] = animLands[i].obj.getIndex();
+		}
+
+		this->direction = direction;
+		this->fovY = fovY;
+		this->daytimeStep = daytimeStep;
+		this->latitude = latitude;
+		this->distantLightLevel = distantLightLevel;
+		this->parallaxSky = parallaxSky;
+		this->saved = false;
+		return Use::Draw;
+	}
+	else if (!this->saved)
+	{
+		// The rows to save are set once the visible distant objects are known.
+		this->yStart = 0;
+		this->yEnd = 0;
+		this->saved = true;
+		return Use::DrawAndSave;
+	}
+	else
+	{
+		return Use::Copy;
+	}
+}
+
+void SoftwareRenderer::SkyLayer::updateRows(const VisDistantObjects &visDistantObjs)
+{
+	if (visDistantObjs.objs.size() == 0)
+	{
+		this->yStart = 0;
+		this->yEnd = 0;
+		return;
+	}
+
+	// Stars are included even though they might not be drawn.
+	this->yStart = std::numeric_limits<int>::max();
+	this->yEnd = 0;
+	for (const VisDistantObject &obj : visDistantObjs.objs)
+	{
+		this->yStart = std::min(this->yStart, obj.drawRange.yStart);
+		this->yEnd = std::max(this->yEnd, obj.drawRange.yEnd);
+	}
+
+	this->yEnd = std::max(this->yStart, this->yEnd);
+}
+
+void SoftwareRenderer::SkyLayer::copyRow(int y, const FrameView &frame) const
+{
+	if (frame.indexBuffer == nullptr)
+	{
+		const uint32_t *srcPtr = this->colors.data() + (y * this->width);
+		std::copy(srcPtr, srcPtr + this->width, frame.colorBuffer + (y * frame.width));
+	}
+	else
+	{
+		const uint8_t *srcPtr = this->indices.data() + (y * this->width);
+		std::copy(srcPtr, srcPtr + this->width, frame.indexBuffer + (y * frame.width));
+	}
+}
+
+void SoftwareRenderer::SkyLayer::saveColumns(int startX, int endX, const FrameView &frame)
+{
+	for (int y = this->yStart; y < this->yEnd; y++)
+	{
+		if (frame.indexBuffer == nullptr)
+		{
+			const uint32_t *srcPtr = frame.colorBuffer + (y * frame.width);
+			uint32_t *dstPtr = this->colors.data() + (y * this->width);
+			std::copy(srcPtr + startX, srcPtr + endX, dstPtr + startX);
+		}
+		else
+		{
+			const uint8_t *srcPtr = frame.indexBuffer + (y * frame.width);
+			uint8_t *dstPtr = this->indices.data() + (y * this->width);
+			std::copy(srcPtr + startX, srcPtr + endX, dstPtr + startX);
+		}
+	}
+}
+
+SoftwareRenderer::LastFrame::LastFrame()
+{
+	this->fovY = 0.0;
+	this->ambient = 0.0;
+	this->latitude = 0.0;
+	this->ceilingHeight = 0.0;
+	this->voxelRevision = 0;
+	this->daytimeStep = 0;
+	this->parallaxSky = false;
+	this->valid = false;
+}
+
+bool SoftwareRenderer::LastFrame::matches(const Double3 &eye, const Double3 &direction,
+	double fovY, int daytimeStep, double ambient, double latitude, bool parallaxSky,
+	double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
+	const VoxelGrid &voxelGrid, const DistantObjects &distantObjects) const
+{
+	// Compare the camera and shading values first since they change the most often. The
+	// voxel grid's revision covers any change to its voxels or voxel data.
+	const bool sameView = this->valid && (this->eye == eye) && (this->direction == direction) &&
+		(this->fovY == fovY) && (this->daytimeStep == daytimeStep) &&
+		(this->ambient == ambient) && (this->latitude == latitude) &&
+		(this->parallaxSky == parallaxSky) && (this->ceilingHeight == ceilingHeight) &&
+		(this->voxelRevision == voxelGrid.getRevision());
+
+	if (!sameView)
+	{
+		return false;
+	}
+
+	// Doors that are opening or closing change every frame.
+	bool sameDoors = this->openDoors.size() == openDoors.size();
+	for (size_t i = 0; sameDoors && (i < openDoors.size()); i++)
+	{
+		const LevelData::DoorState &oldDoor = this->openDoors[i];
+		const LevelData::DoorState &newDoor = openDoors[i];
+		sameDoors = (oldDoor.getVoxel() == newDoor.getVoxel()) &&
+			(oldDoor.getPercentOpen() == newDoor.getPercentOpen());
+	}
+
+	const auto &animLands = distantObjects.animLands;
+	bool sameAnimLands = this->animLandIndices.size() == animLands.size();
+	for (size_t i = 0; sameAnimLands && (i < animLands.size()); i++)
+	{
+		sameAnimLands = this->animLandIndices[i] == animLands[i].obj.getIndex();
+	}
+
+	return sameDoors && sameAnimLands;
+}
+
+void SoftwareRenderer::LastFrame::update(const Double3 &eye, const Double3 &direction,
+	double fovY, int daytimeStep, double ambient, double latitude, bool parallaxSky,
+	double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
+	const VoxelGrid &voxelGrid, const DistantObjects &distantObjects)
+{
+	this->eye = eye;
+	this->direction = direction;
+	this->fovY = fovY;
+	this->daytimeStep = daytimeStep;
+	this->ambient = ambient;
+	this->latitude = latitude;
+	this->parallaxSky = parallaxSky;
+	this->ceilingHeight = ceilingHeight;
+	this->openDoors = openDoors;
+
+	const auto &animLands = distantObjects.animLands;
+	this->animLandIndices.resize(animLands.size());
+	for (size_t i = 0; i < animLands.size(); i++)
+	{
+		this->animLandIndices[i] = animLands[i].obj.getIndex();
+	}
+
+	this->voxelRevision = voxelGrid.getRevision();
+	this->valid = true;
+}
+
+SoftwareRenderer::RenderThreadData::TilePhase::TilePhase()
+{
+	this->doneCount = 0;
+	this->tileCount = 0;
+	this->interleaved = false;
+}
+
+void SoftwareRenderer::RenderThreadData::TilePhase::init(int tileCount, int threadCount,
+	bool interleaved)
+{
+	this->tileCount = tileCount;
+	this->interleaved = interleaved;
+	this->ranges = std::vector<std::atomic<uint64_t>>(threadCount);
+	this->tilesDone = std::vector<std::atomic<bool>>(tileCount);
+	this->reset();
+}
+
+void SoftwareRenderer::RenderThreadData::TilePhase::reset()
+{
+	// Split the tiles evenly between threads. The begin tile is in the upper half of a range.
+	const uint64_t threadCount = static_cast<uint64_t>(this->ranges.size());
+	const uint64_t tileCount = static_cast<uint64_t>(this->tileCount);
+	for (uint64_t i = 0; i < threadCount; i++)
+	{
+		uint64_t begin, end;
+		if (this->interleaved)
+		{
+			// Number of tiles i, i + N, i + 2N, and so on.
+			begin = 0;
+			end = (tileCount + threadCount - 1 - i) / threadCount;
+		}
+		else
+		{
+			begin = (i * tileCount) / threadCount;
+			end = ((i + 1) * tileCount) / threadCount;
+		}
+
+		this->ranges[i].store((begin << 32) | end, std::memory_order_relaxed);
+	}
+
+	for (auto &tileDone : this->tilesDone)
+	{
+		tileDone.store(false, std::memory_order_relaxed);
+	}
+
+	this->doneCount.store(0, std::memory_order_relaxed);
+}
+
+bool SoftwareRenderer::RenderThreadData::TilePhase::tryTakeTile(int threadIndex, int *outTile)
+{
+	const int threadCount = static_cast<int>(this->ranges.size());
+
+	// Take from the front of this thread's own range first, then from the back of the other
+	// threads' ranges so the owners keep working on neighboring tiles. Interleaved tiles are
+	// never stolen.
+	const int rangeCount = this->interleaved ? 1 : threadCount;
+	for (int i = 0; i < rangeCount; i++)
+	{
+		const bool isOwnRange = i == 0;
+		std::atomic<uint64_t> &range = this->ranges[(threadIndex + i) % threadCount];
+		uint64_t current = range.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			const uint64_t begin = current >> 32;
+			const uint64_t end = current & 0xFFFFFFFF;
+			if (begin >= end)
+			{
+				break;
+			}
+
+			const uint64_t desired = isOwnRange ?
+				(((begin + 1) << 32) | end) : ((begin << 32) | (end - 1));
+
+			// On failure, 'current' is refreshed and the range is checked again.
+			if (range.compare_exchange_weak(current, desired, std::memory_order_acquire,
+				std::memory_order_relaxed))
+			{
+				const int index = static_cast<int>(isOwnRange ? begin : (end - 1));
+				*outTile = this->interleaved ? ((index * threadCount) + threadIndex) : index;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void SoftwareRenderer::RenderThreadData::TilePhase::setTileDone(int tile)
+{
+	this->tilesDone[tile].store(true, std::memory_order_release);
+	this->doneCount.fetch_add(1, std::memory_order_release);
+}
+
+bool SoftwareRenderer::RenderThreadData::TilePhase::isTileDone(int tile) const
+{
+	return this->tilesDone[tile].load(std::memory_order_acquire);
+}
+
+void SoftwareRenderer::RenderThreadData::TilePhase::waitForTile(int tile) const
+{
+	while (!this->isTileDone(tile))
+	{
+		std::this_thread::yield();
+	}
+}
+
+void SoftwareRenderer::RenderThreadData::TilePhase::waitForAll() const
+{
+	while (this->doneCount.load(std::memory_order_acquire) < this->tileCount)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void SoftwareRenderer::RenderThreadData::SkyGradient::init(double projectedYTop,
+	double projectedYBottom, std::vector<Double3> &rowCache, const SkyLayer *skyLayer)
+{
+	this->tiles.reset();
+	this->rowCache = &rowCache;
+	this->skyLayer = skyLayer;
+	this->projectedYTop = projectedYTop;
+	this->projectedYBottom = projectedYBottom;
+	this->shouldDrawStars = false;
 }
 
 void SoftwareRenderer::RenderThreadData::DistantSky::init(bool parallaxSky,
-	const VisDistantObjects &visDistantObjs,
-	const std::vector<SkyTexture> &skyTextures)
+	const VisDistantObjects &visDistantObjs, const std::vector<SkyTexture> &skyTextures,
+	SkyLayer *skyLayer)
 {
-	this->threadsDone = 0;
+	this->tiles.reset();
 	this->visDistantObjs = &visDistantObjs;
 	this->skyTextures = &skyTextures;
+	this->skyLayer = skyLayer;
 	this->parallaxSky = parallaxSky;
 	this->doneVisTesting = false;
 }
 
 void SoftwareRenderer::RenderThreadData::Voxels::init(double ceilingHeight,
 	const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
+	const std::vector<VoxelDataType> &voxelDataTypes,
 	const std::vector<VoxelTexture> &voxelTextures, std::vector<OcclusionData> &occlusion)
 {
-	this->threadsDone = 0;
+	this->tiles.reset();
 	this->ceilingHeight = ceilingHeight;
 	this->openDoors = &openDoors;
 	this->voxelGrid = &voxelGrid;
+	this->voxelDataTypes = &voxelDataTypes;
 	this->voxelTextures = &voxelTextures;
 	this->occlusion = &occlusion;
 }
 
 void SoftwareRenderer::RenderThreadData::Flats::init(const Double3 &flatNormal,
-	const std::vector<VisibleFlat> &visibleFlats, const std::vector<FlatTexture> &flatTextures)
+	const std::vector<VisibleFlat> &visibleFlats,
+	const std::vector<std::vector<int>> &visibleFlatBins,
+	const std::vector<FlatTexture> &flatTextures)
 {
-	this->threadsDone = 0;
+	this->tiles.reset();
 	this->flatNormal = &flatNormal;
 	this->visibleFlats = &visibleFlats;
+	this->visibleFlatBins = &visibleFlatBins;
 	this->flatTextures = &flatTextures;
 	this->doneSorting = false;
 }
 
 SoftwareRenderer::RenderThreadData::RenderThreadData()
 {
-	// Make sure 'go' is initialized to false.
+	this->tileRows = 0;
+	this->tileColumns = 0;
 	this->totalThreads = 0;
-	this->go = false;
+	this->threadsDone = 0;
+	this->frameNumber = 0;
 	this->isDestructing = false;
 	this->camera = nullptr;
 	this->shadingInfo = nullptr;
+	this->skyShadingInfo = nullptr;
 	this->frame = nullptr;
 }
 
-void SoftwareRenderer::RenderThreadData::init(int totalThreads, const Camera &camera,
-	const ShadingInfo &shadingInfo, const FrameView &frame)
+void SoftwareRenderer::RenderThreadData::initTiles(int width, int height, int totalThreads,
+	int tileRows, int tileColumns, bool interleaved)
 {
+	this->tileRows = tileRows;
+	this->tileColumns = tileColumns;
 	this->totalThreads = totalThreads;
+
+	// Distant sky, voxel, and flat tiles share the same columns so a tile only depends on
+	// the same tile in the previous phase.
+	const int rowTileCount = (height + tileRows - 1) / tileRows;
+	const int columnTileCount = (width + tileColumns - 1) / tileColumns;
+
+	this->threadTimings = std::vector<FrameTimings::Thread>(totalThreads);
+	this->skyGradient.tiles.init(rowTileCount, totalThreads, interleaved);
+	this->distantSky.tiles.init(columnTileCount, totalThreads, interleaved);
+	this->voxels.tiles.init(columnTileCount, totalThreads, interleaved);
+	this->flats.tiles.init(columnTileCount, totalThreads, interleaved);
+}
+
+void SoftwareRenderer::RenderThreadData::init(const Camera &camera,
+	const ShadingInfo &shadingInfo, const ShadingInfo &skyShadingInfo, const FrameView &frame)
+{
 	this->camera = &camera;
 	this->shadingInfo = &shadingInfo;
+	this->skyShadingInfo = &skyShadingInfo;
 	this->frame = &frame;
-	this->go = false;
-	this->isDestructing = false;
+	this->threadsDone = 0;
+}
+
+SoftwareRenderer::FrameState::FrameState(const Camera &camera, ShadingInfo &&shadingInfo,
+	ShadingInfo &&skyShadingInfo, const FrameView &frame, const Double3 &flatNormal)
+	: camera(camera), shadingInfo(std::move(shadingInfo)),
+	skyShadingInfo(std::move(skyShadingInfo)), frame(frame), flatNormal(flatNormal)
+{
+	this->startTime = std::chrono::steady_clock::now();
+	this->visibleDistantObjectsTime = 0.0;
+	this->visibleFlatsTime = 0.0;
+}
+
+SoftwareRenderer::VoxelColumnContext::VoxelColumnContext(int x, int voxelX, int voxelZ,
+	const Camera &camera, const Ray &ray, VoxelData::Facing facing, const Double3 &wallNormal,
+	const Double2 &nearPoint, const Double2 &farPoint, double nearZ, double farZ, double wallU,
+	const ShadingInfo &shadingInfo, double ceilingHeight,
+	const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
+	const std::vector<VoxelTexture> &textures, OcclusionData &occlusion, const FrameView &frame)
+	: camera(camera), ray(ray), wallNormal(wallNormal), nearPoint(nearPoint), farPoint(farPoint),
+	shadingInfo(shadingInfo), openDoors(openDoors), voxelGrid(voxelGrid), textures(textures),
+	occlusion(occlusion), frame(frame)
+{
+	this->x = x;
+	this->voxelX = voxelX;
+	this->voxelZ = voxelZ;
+	this->facing = facing;
+	this->nearZ = nearZ;
+	this->farZ = farZ;
+	this->wallU = wallU;
+	this->ceilingHeight = ceilingHeight;
+}
+
+SoftwareRenderer::FrameTimings::Thread::Thread()
+{
+	this->skyGradient = 0.0;
+	this->distantSky = 0.0;
+	this->voxels = 0.0;
+	this->flats = 0.0;
+	this->wait = 0.0;
+}
+
+double SoftwareRenderer::FrameTimings::Thread::getTotal() const
+{
+	return this->skyGradient + this->distantSky + this->voxels + this->flats + this->wait;
+}
+
+SoftwareRenderer::FrameTimings::FrameTimings()
+{
+	this->visibleDistantObjects = 0.0;
+	this->visibleFlats = 0.0;
+	this->frame = 0.0;
 }
 
 const double SoftwareRenderer::NEAR_PLANE = 0.0001;
 const double SoftwareRenderer::FAR_PLANE = 1000.0;
+const double SoftwareRenderer::MIN_DRAW_DISTANCE = 0.10;
 const int SoftwareRenderer::DEFAULT_VOXEL_TEXTURE_COUNT = 64;
 const int SoftwareRenderer::DEFAULT_FLAT_TEXTURE_COUNT = 256;
 const double SoftwareRenderer::DOOR_MIN_VISIBLE = 0.10;
 const double SoftwareRenderer::SKY_GRADIENT_ANGLE = 30.0;
 const double SoftwareRenderer::DISTANT_CLOUDS_MAX_ANGLE = 25.0;
+const int SoftwareRenderer::DISTANT_BUCKET_AZIMUTHS = 16;
+const int SoftwareRenderer::DISTANT_BUCKET_ELEVATIONS = 8;
+const int SoftwareRenderer::SKY_DAYTIME_STEPS = 2880;
+const int SoftwareRenderer::TILE_ROWS = 16;
+const int SoftwareRenderer::CACHE_LINE_SIZE = 64;
+const int SoftwareRenderer::FLAT_CHUNK_DIM = 8;
+const double SoftwareRenderer::LIGHT_CELL_DIM = 4.0;
+const int SoftwareRenderer::MAX_LIGHT_CELLS = 64;
+const int SoftwareRenderer::MAX_LIGHTS_PER_CELL = 8;
 const double SoftwareRenderer::TALL_PIXEL_RATIO = 1.20;
 
 SoftwareRenderer::SoftwareRenderer()
@@ -614,11 +1882,23 @@ SoftwareRenderer::SoftwareRenderer()
 	this->width = 0;
 	this->height = 0;
 	this->renderThreadsMode = 0;
+	this->depthBufferMode = 0;
+	this->tileLayout = TileLayout::Columns;
 	this->fogDistance = 0.0;
+	this->maxDrawDistance = SoftwareRenderer::FAR_PLANE;
+	this->framePipelining = false;
+	this->frameReuse = false;
+	this->mipmapping = false;
+	this->paletteCount = 0;
+	this->palettedRendering = false;
+	this->nightLightsActive = false;
+	this->frameInFlight = false;
+	this->hasFrontBuffer = false;
 }
 
 SoftwareRenderer::~SoftwareRenderer()
 {
+	this->waitForFrame();
 	this->resetRenderThreads();
 }
 
@@ -628,25 +1908,31 @@ bool SoftwareRenderer::isInited() const
 	return (this->width > 0) && (this->height > 0);
 }
 
-void SoftwareRenderer::init(int width, int height, int renderThreadsMode)
+void SoftwareRenderer::init(int width, int height, int renderThreadsMode, int depthBufferMode,
+	bool framePipelining)
 {
-	// Initialize 2D frame buffer.
-	const int pixelCount = width * height;
-	this->depthBuffer = std::vector<double>(pixelCount,
-		std::numeric_limits<double>::infinity());
+	this->waitForFrame();
+
+	this->width = width;
+	this->height = height;
+	this->depthBufferMode = depthBufferMode;
 
-	// Initialize occlusion columns.
+	// Initialize 2D frame buffers.
+	this->initDepthBuffer();
+	this->initIndexBuffer();
+
+	// Initialize occlusion and cleared depth rows of each column.
 	this->occlusion = std::vector<OcclusionData>(width, OcclusionData(0, height));
+	this->depthRows = std::vector<DepthRows>(width);
 
-	// Initialize sky gradient cache.
+	// Initialize sky gradient cache and sky layer.
 	this->skyGradientRowCache = std::vector<Double3>(height, Double3::Zero);
+	this->skyLayer.init(width, height);
 
 	// Initialize texture vectors to default sizes.
 	this->voxelTextures = std::vector<VoxelTexture>(SoftwareRenderer::DEFAULT_VOXEL_TEXTURE_COUNT);
 	this->flatTextures = std::vector<FlatTexture>(SoftwareRenderer::DEFAULT_FLAT_TEXTURE_COUNT);
 
-	this->width = width;
-	this->height = height;
 	this->renderThreadsMode = renderThreadsMode;
 
 	// Fog distance is zero by default.
@@ -655,10 +1941,14 @@ void SoftwareRenderer::init(int width, int height, int renderThreadsMode)
 	// Initialize render threads.
 	const int threadCount = SoftwareRenderer::getRenderThreadsFromMode(renderThreadsMode);
 	this->initRenderThreads(width, height, threadCount);
+
+	this->framePipelining = framePipelining;
+	this->resetFramePipeline();
 }
 
 void SoftwareRenderer::setRenderThreadsMode(int mode)
 {
+	this->waitForFrame();
 	this->renderThreadsMode = mode;
 
 	// Re-initialize render threads.
@@ -666,6 +1956,65 @@ void SoftwareRenderer::setRenderThreadsMode(int mode)
 	this->initRenderThreads(this->width, this->height, threadCount);
 }
 
+void SoftwareRenderer::setDepthBufferMode(int mode)
+{
+	this->waitForFrame();
+	this->depthBufferMode = mode;
+	this->initDepthBuffer();
+
+	// Column tiles are sized by the depth format.
+	const int threadCount = static_cast<int>(this->renderThreads.size());
+	this->initTiles(this->width, this->height, threadCount);
+}
+
+void SoftwareRenderer::setTileLayout(TileLayout tileLayout)
+{
+	this->waitForFrame();
+	this->tileLayout = tileLayout;
+
+	const int threadCount = static_cast<int>(this->renderThreads.size());
+	this->initTiles(this->width, this->height, threadCount);
+}
+
+void SoftwareRenderer::setFramePipelining(bool enabled)
+{
+	this->waitForFrame();
+	this->framePipelining = enabled;
+	this->resetFramePipeline();
+}
+
+bool SoftwareRenderer::isFramePipelining() const
+{
+	return this->framePipelining;
+}
+
+void SoftwareRenderer::setFrameReuse(bool enabled)
+{
+	this->frameReuse = enabled;
+	this->lastFrame.valid = false;
+}
+
+bool SoftwareRenderer::isFrameReusable(const Double3 &eye, const Double3 &direction,
+	double fovY, double ambient, double daytimePercent, double latitude, bool parallaxSky,
+	double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
+	const VoxelGrid &voxelGrid) const
+{
+	// A frame in flight hasn't been given to the caller yet.
+	if (!this->frameReuse || this->frameInFlight)
+	{
+		return false;
+	}
+
+	return this->lastFrame.matches(eye, direction, fovY,
+		SoftwareRenderer::getSkyDaytimeStep(daytimePercent), ambient, latitude, parallaxSky,
+		ceilingHeight, openDoors, voxelGrid, this->distantObjects);
+}
+
+const SoftwareRenderer::FrameTimings &SoftwareRenderer::getFrameTimings() const
+{
+	return this->frameTimings;
+}
+
 void SoftwareRenderer::addFlat(int id, const Double3 &position, double width, 
 	double height, int textureID)
 {
@@ -681,54 +2030,73 @@ void SoftwareRenderer::addFlat(int id, const Double3 &position, double width,
 	flat.flipped = false; // The initial value doesn't matter; it's updated frequently.
 
 	// Add the flat (sprite, door, store sign, etc.).
-	this->flats.insert(std::make_pair(id, flat));
+	const auto flatIter = this->flats.insert(std::make_pair(id, flat)).first;
+	this->addFlatToChunk(flatIter->second);
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::addLight(int id, const Double3 &point, const Double3 &color, 
 	double intensity)
 {
-	DebugNotImplemented();
+	// Ignore duplicate light ID definitions.
+	DebugAssertMsg(this->lights.find(id) == this->lights.end(),
+		"Light ID \"" + std::to_string(id) + "\" already taken.");
+
+	SoftwareRenderer::Light light;
+	light.point = point;
+	light.color = color;
+	light.intensity = intensity;
+
+	// Lights are copied into the light grid when a frame starts, so they can change while
+	// a pipelined frame is in flight.
+	this->lights.insert(std::make_pair(id, light));
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::setVoxelTexture(int id, const uint32_t *srcTexels)
 {
+	this->waitForFrame();
+
 	// Clear the selected texture.
 	VoxelTexture &texture = this->voxelTextures.at(id);
 	std::fill(texture.texels.begin(), texture.texels.end(), VoxelTexel());
-	texture.lightTexels.clear();
 
 	for (int y = 0; y < VoxelTexture::HEIGHT; y++)
 	{
 		for (int x = 0; x < VoxelTexture::WIDTH; x++)
 		{
-			// @todo: change this calculation for rotated textures. Make sure to have a 
-			// source index and destination index.
-			// - "dstX" and "dstY" should be calculated, and also used with lightTexels.
-			const int index = x + (y * VoxelTexture::WIDTH);
-
-			// Convert ARGB color from integer to double-precision format. This does waste
-			// an extreme amount of memory (32 bytes per pixel!), but it's not a big deal
-			// for Arena's textures (eight textures is a megabyte).
-			const Double4 srcTexel = Double4::fromARGB(srcTexels[index]);
-			VoxelTexel &dstTexel = texture.texels[index];
-			dstTexel.r = srcTexel.x;
-			dstTexel.g = srcTexel.y;
-			dstTexel.b = srcTexel.z;
-			dstTexel.transparent = srcTexel.w == 0.0;
-
-			// If it's a white texel, it's used with night lights (i.e., yellow at night).
-			const bool isWhite = (srcTexel.x == 1.0) && (srcTexel.y == 1.0) && (srcTexel.z == 1.0);
-
-			if (isWhite)
+			// @todo: change this calculation for rotated textures.
+			// - "dstX" and "dstY" should be calculated.
+			// - The destination is column-major, so texels down a wall column are contiguous.
+			const int srcIndex = x + (y * VoxelTexture::WIDTH);
+			const int dstIndex = y + (x * VoxelTexture::HEIGHT);
+
+			// Keep the ARGB color in its packed 8-bit format. Conversion to double-precision
+			// happens when sampling, so each texel is only four bytes.
+			const uint32_t srcTexel = srcTexels[srcIndex];
+			VoxelTexel &dstTexel = texture.texels[dstIndex];
+			dstTexel.set(srcTexel);
+
+			// If it's an opaque white texel, it's used with night lights (i.e., yellow at
+			// night). Its color comes from the time of day when shading, so the texture never
+			// changes. Transparent texels stay transparent whatever their color.
+			const bool isWhite = (dstTexel.r == 255) && (dstTexel.g == 255) && (dstTexel.b == 255);
+
+			if (isWhite && !dstTexel.isTransparent())
 			{
-				texture.lightTexels.push_back(Int2(x, y));
+				dstTexel.flags |= VoxelTexel::FLAG_NIGHT_LIGHT;
 			}
 		}
 	}
+
+	texture.updateMipLevels();
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::setFlatTexture(int id, const uint32_t *srcTexels, int width, int height)
 {
+	this->waitForFrame();
+
 	const int texelCount = width * height;
 
 	// Reset the selected texture.
@@ -737,15 +2105,18 @@ void SoftwareRenderer::setFlatTexture(int id, const uint32_t *srcTexels, int wid
 	texture.width = width;
 	texture.height = height;
 
-	for (int i = 0; i < texelCount; i++)
+	// Transpose the texels so each column is contiguous.
+	for (int y = 0; y < height; y++)
 	{
-		const Double4 srcTexel = Double4::fromARGB(srcTexels[i]);
-		FlatTexel &dstTexel = texture.texels[i];
-		dstTexel.r = srcTexel.x;
-		dstTexel.g = srcTexel.y;
-		dstTexel.b = srcTexel.z;
-		dstTexel.a = srcTexel.w;
+		for (int x = 0; x < width; x++)
+		{
+			texture.texels[y + (x * height)].set(srcTexels[x + (y * width)]);
+		}
 	}
+
+	texture.updateMipLevels();
+	texture.updateOpaqueRuns();
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::updateFlat(int id, const Double3 *position, const double *width, 
@@ -756,6 +2127,7 @@ void SoftwareRenderer::updateFlat(int id, const Double3 *position, const double
 		"Cannot update a non-existent flat (" + std::to_string(id) + ").");
 
 	SoftwareRenderer::Flat &flat = flatIter->second;
+	const Int2 oldChunk = SoftwareRenderer::getFlatChunk(flat.position);
 
 	// Check which values requested updating and update them.
 	if (position != nullptr)
@@ -782,64 +2154,189 @@ void SoftwareRenderer::updateFlat(int id, const Double3 *position, const double
 	{
 		flat.flipped = *flipped;
 	}
+
+	// Keep the flat's chunk up to date if it moved or got wider.
+	if ((position != nullptr) || (width != nullptr))
+	{
+		const Int2 newChunk = SoftwareRenderer::getFlatChunk(flat.position);
+		if (newChunk != oldChunk)
+		{
+			this->removeFlatFromChunk(flat, oldChunk);
+			this->addFlatToChunk(flat);
+		}
+		else
+		{
+			FlatChunk &chunk = this->flatChunks.at(newChunk);
+			chunk.maxHalfWidth = std::max(chunk.maxHalfWidth, flat.width * 0.50);
+		}
+	}
+
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::updateLight(int id, const Double3 *point,
 	const Double3 *color, const double *intensity)
 {
-	DebugNotImplemented();
+	const auto lightIter = this->lights.find(id);
+	DebugAssertMsg(lightIter != this->lights.end(),
+		"Cannot update a non-existent light (" + std::to_string(id) + ").");
+
+	SoftwareRenderer::Light &light = lightIter->second;
+
+	// Check which values requested updating and update them.
+	if (point != nullptr)
+	{
+		light.point = *point;
+	}
+
+	if (color != nullptr)
+	{
+		light.color = *color;
+	}
+
+	if (intensity != nullptr)
+	{
+		light.intensity = *intensity;
+	}
+
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::setFogDistance(double fogDistance)
 {
 	this->fogDistance = fogDistance;
+	this->lastFrame.valid = false;
 }
 
-void SoftwareRenderer::setDistantSky(const DistantSky &distantSky)
+void SoftwareRenderer::setMaxDrawDistance(double maxDrawDistance)
 {
-	// Clear old distant sky data.
-	this->distantObjects.clear();
-	this->skyTextures.clear();
+	this->maxDrawDistance = maxDrawDistance;
+	this->lastFrame.valid = false;
+}
 
-	// Create distant objects and set the sky textures.
-	this->distantObjects.init(distantSky, this->skyTextures);
+void SoftwareRenderer::setMipmapping(bool mipmapping)
+{
+	this->mipmapping = mipmapping;
+	this->lastFrame.valid = false;
 }
 
-void SoftwareRenderer::setSkyPalette(const uint32_t *colors, int count)
+void SoftwareRenderer::setPalette(const uint32_t *colors, int count)
 {
-	this->skyPalette = std::vector<Double3>(count);
+	assert(count > 0);
+	assert(count <= 256);
+	this->waitForFrame();
 
-	for (size_t i = 0; i < this->skyPalette.size(); i++)
+	// Unused entries are black so any 8-bit index can be expanded. Alpha is dropped like
+	// it is for ARGB8888 frames.
+	this->palette = std::vector<uint32_t>(256, 0);
+	for (int i = 0; i < count; i++)
 	{
-		this->skyPalette[i] = Double3::fromRGB(colors[i]);
+		this->palette[i] = colors[i] & 0x00FFFFFF;
 	}
-}
 
-void SoftwareRenderer::setNightLightsActive(bool active)
-{
-	// @todo: activate lights (don't worry about textures).
+	this->paletteCount = count;
+	this->inversePalette.clear();
+	this->initInversePalette();
 
-	// Change voxel texels based on whether it's night.
-	const Double4 texelColor = Double4::fromARGB(
-		(active ? Color(255, 166, 0) : Color::Black).toARGB());
-	const double texelEmission = active ? 1.0 : 0.0;
+	// Frames might only now be paletted, and the sky layer might have old palette indices.
+	// Column tiles are sized by the index buffer when paletted.
+	this->initIndexBuffer();
+	this->initTiles(this->width, this->height, static_cast<int>(this->renderThreads.size()));
+	this->skyLayer.saved = false;
+	this->lastFrame.valid = false;
+}
 
-	for (auto &voxelTexture : this->voxelTextures)
+void SoftwareRenderer::initInversePalette()
+{
+	if (!this->isPaletted() || (this->inversePalette.size() > 0))
 	{
-		auto &texels = voxelTexture.texels;
-
-		for (const auto &lightTexels : voxelTexture.lightTexels)
-		{
-			const int index = lightTexels.x + (lightTexels.y * VoxelTexture::WIDTH);
+		return;
+	}
 
-			VoxelTexel &texel = texels.at(index);
-			texel.r = texelColor.x;
-			texel.g = texelColor.y;
-			texel.b = texelColor.z;
-			texel.transparent = texelColor.w == 0.0;
-			texel.emission = texelEmission;
+	// Find the nearest palette color of each 15-bit color once, so drawing a pixel is just
+	// one lookup.
+	this->inversePalette = std::vector<uint8_t>(InversePaletteSize);
+	for (int i = 0; i < InversePaletteSize; i++)
+	{
+		// Expand each 5-bit channel to eight bits.
+		const int r5 = (i >> 10) & 0x1F;
+		const int g5 = (i >> 5) & 0x1F;
+		const int b5 = i & 0x1F;
+		const int r = (r5 << 3) | (r5 >> 2);
+		const int g = (g5 << 3) | (g5 >> 2);
+		const int b = (b5 << 3) | (b5 >> 2);
+
+		int nearestIndex = 0;
+		int nearestDistance = std::numeric_limits<int>::max();
+		for (int j = 0; j < this->paletteCount; j++)
+		{
+			const uint32_t color = this->palette[j];
+			const int dr = static_cast<int>((color >> 16) & 0xFF) - r;
+			const int dg = static_cast<int>((color >> 8) & 0xFF) - g;
+			const int db = static_cast<int>(color & 0xFF) - b;
+			const int distance = (dr * dr) + (dg * dg) + (db * db);
+			if (distance < nearestDistance)
+			{
+				nearestIndex = j;
+				nearestDistance = distance;
+			}
 		}
+
+		this->inversePalette[i] = static_cast<uint8_t>(nearestIndex);
+	}
+}
+
+void SoftwareRenderer::setPalettedRendering(bool paletted)
+{
+	this->waitForFrame();
+	this->palettedRendering = paletted;
+	this->initInversePalette();
+	this->initIndexBuffer();
+
+	// Column tiles are sized by the index buffer when paletted.
+	const int threadCount = static_cast<int>(this->renderThreads.size());
+	this->initTiles(this->width, this->height, threadCount);
+
+	// The sky layer is saved in the other format.
+	this->skyLayer.saved = false;
+	this->lastFrame.valid = false;
+}
+
+void SoftwareRenderer::setDistantSky(const DistantSky &distantSky)
+{
+	this->waitForFrame();
+
+	// Clear old distant sky data.
+	this->distantObjects.clear();
+	this->skyTextures.clear();
+
+	// Create distant objects and set the sky textures.
+	this->distantObjects.init(distantSky, this->skyTextures);
+	this->skyLayer.saved = false;
+	this->lastFrame.valid = false;
+}
+
+void SoftwareRenderer::setSkyPalette(const uint32_t *colors, int count)
+{
+	this->skyPalette = std::vector<Double3>(count);
+
+	for (size_t i = 0; i < this->skyPalette.size(); i++)
+	{
+		this->skyPalette[i] = Double3::fromRGB(colors[i]);
 	}
+
+	this->skyLayer.saved = false;
+	this->lastFrame.valid = false;
+}
+
+void SoftwareRenderer::setNightLightsActive(bool active)
+{
+	// @todo: activate lights (don't worry about textures).
+
+	// Night light texels are shaded with this when the next frame starts, so textures don't
+	// change and a frame in flight doesn't need to finish first.
+	this->nightLightsActive = active;
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::removeFlat(int id)
@@ -849,25 +2346,36 @@ void SoftwareRenderer::removeFlat(int id)
 	DebugAssertMsg(flatIter != this->flats.end(),
 		"Cannot remove a non-existent flat (" + std::to_string(id) + ").");
 
+	const Flat &flat = flatIter->second;
+	this->removeFlatFromChunk(flat, SoftwareRenderer::getFlatChunk(flat.position));
 	this->flats.erase(flatIter);
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::removeLight(int id)
 {
-	DebugNotImplemented();
+	// Make sure the light exists before removing it.
+	const auto lightIter = this->lights.find(id);
+	DebugAssertMsg(lightIter != this->lights.end(),
+		"Cannot remove a non-existent light (" + std::to_string(id) + ").");
+
+	this->lights.erase(lightIter);
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::clearTextures()
 {
+	this->waitForFrame();
+
 	for (auto &texture : this->voxelTextures)
 	{
 		std::fill(texture.texels.begin(), texture.texels.end(), VoxelTexel());
-		texture.lightTexels.clear();
 	}
 
 	for (auto &texture : this->flatTextures)
 	{
 		std::fill(texture.texels.begin(), texture.texels.end(), FlatTexel());
+		texture.mipLevels.clear();
 		texture.width = 0;
 		texture.height = 0;
 	}
@@ -875,32 +2383,137 @@ void SoftwareRenderer::clearTextures()
 	// Distant sky textures are cleared because the vector size is managed internally.
 	this->skyTextures.clear();
 	this->distantObjects.sunTextureIndex = SoftwareRenderer::DistantObjects::NO_SUN;
+	this->skyLayer.saved = false;
+	this->lastFrame.valid = false;
 }
 
 void SoftwareRenderer::clearDistantSky()
 {
+	this->waitForFrame();
 	this->distantObjects.clear();
+	this->skyLayer.saved = false;
+	this->lastFrame.valid = false;
+}
+
+void SoftwareRenderer::initDepthBuffer()
+{
+	const DepthFormat depthFormat = SoftwareRenderer::getDepthFormatFromMode(this->depthBufferMode);
+	const int pixelCount = this->width * this->height;
+	const int depthSize = SoftwareRenderer::getDepthFormatSize(depthFormat);
+	this->depthBuffer.resize((pixelCount * depthSize) + SoftwareRenderer::CACHE_LINE_SIZE);
+}
+
+bool SoftwareRenderer::isPaletted() const
+{
+	return this->palettedRendering && (this->palette.size() > 0);
+}
+
+void SoftwareRenderer::initIndexBuffer()
+{
+	const int pixelCount = this->isPaletted() ? (this->width * this->height) : 0;
+	this->indexBuffer.resize((pixelCount > 0) ? (pixelCount + SoftwareRenderer::CACHE_LINE_SIZE) : 0);
+}
+
+void SoftwareRenderer::expandIndexBuffer(uint32_t *colorBuffer)
+{
+	// One sequential pass with a lookup per pixel. The 1 KB palette stays in the L1 cache,
+	// so this only costs the index reads and color writes.
+	const SpanKernels::ExpandIndicesFunction expandIndices =
+		SpanKernels::getExpandIndicesFunction(SpanKernels::getBestInstructionSet());
+	expandIndices(this->palette.data(), SoftwareRenderer::getCacheLineStart(this->indexBuffer),
+		this->width * this->height, colorBuffer);
 }
 
 void SoftwareRenderer::resize(int width, int height)
 {
-	const int pixelCount = width * height;
-	this->depthBuffer.resize(pixelCount);
-	std::fill(this->depthBuffer.begin(), this->depthBuffer.end(), 
-		std::numeric_limits<double>::infinity());
+	this->waitForFrame();
+
+	this->width = width;
+	this->height = height;
+	this->initDepthBuffer();
+	this->initIndexBuffer();
 
 	this->occlusion.resize(width);
 	std::fill(this->occlusion.begin(), this->occlusion.end(), OcclusionData(0, height));
+	this->depthRows.resize(width);
 
 	this->skyGradientRowCache.resize(height);
 	std::fill(this->skyGradientRowCache.begin(), this->skyGradientRowCache.end(), Double3::Zero);
+	this->skyLayer.init(width, height);
 
-	this->width = width;
-	this->height = height;
-
-	// Restart render threads with new dimensions.
+	// The render threads only get their tiles from the thread data, so they keep running
+	// (i.e., dynamic resolution steps don't restart them).
 	const int threadCount = SoftwareRenderer::getRenderThreadsFromMode(this->renderThreadsMode);
-	this->initRenderThreads(width, height, threadCount);
+	this->initTiles(width, height, threadCount);
+
+	this->resetFramePipeline();
+}
+
+void SoftwareRenderer::waitForFrame()
+{
+	if (!this->frameInFlight)
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lk(this->threadData.mutex);
+	this->threadData.condVar.wait(lk, [this]()
+	{
+		return this->threadData.threadsDone == this->threadData.totalThreads;
+	});
+
+	// Keep the finished frame's timings for profiling.
+	const FrameState &frameState = *this->frameState;
+	this->frameTimings.threads = this->threadData.threadTimings;
+	this->frameTimings.visibleDistantObjects = frameState.visibleDistantObjectsTime;
+	this->frameTimings.visibleFlats = frameState.visibleFlatsTime;
+	this->frameTimings.frame = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - frameState.startTime).count();
+
+	this->frameInFlight = false;
+}
+
+void SoftwareRenderer::resetFramePipeline()
+{
+	assert(!this->frameInFlight);
+
+	// Pipelined frames are drawn to internal color buffers instead of the caller's.
+	const int pixelCount = this->framePipelining ? (this->width * this->height) : 0;
+	this->frontColorBuffer.resize(pixelCount);
+	this->backColorBuffer.resize(pixelCount);
+	this->hasFrontBuffer = false;
+
+	// The caller's frame might not be the last one anymore (e.g., after resizing).
+	this->lastFrame.valid = false;
+}
+
+int SoftwareRenderer::getTileColumns() const
+{
+	if (this->tileLayout == TileLayout::Interleaved)
+	{
+		return 1;
+	}
+
+	// Enough columns to fill a cache line in whichever frame buffer has the smallest pixels
+	// (the palette index buffer when paletted), rounded up to a whole cache line of colors.
+	// The depth and index buffers start on a cache line, so tile edges fall on cache line
+	// boundaries in every row when the frame width is a multiple of the tile columns.
+	const DepthFormat depthFormat = SoftwareRenderer::getDepthFormatFromMode(this->depthBufferMode);
+	const int depthSize = SoftwareRenderer::getDepthFormatSize(depthFormat);
+	const int colorSize = this->isPaletted() ? static_cast<int>(sizeof(uint8_t)) :
+		static_cast<int>(sizeof(uint32_t));
+	const int pixelSize = std::min(colorSize, depthSize);
+	const int colorsPerLine = SoftwareRenderer::CACHE_LINE_SIZE / static_cast<int>(sizeof(uint32_t));
+	const int tileColumns = std::max(SoftwareRenderer::CACHE_LINE_SIZE / pixelSize, 1);
+	return ((tileColumns + colorsPerLine - 1) / colorsPerLine) * colorsPerLine;
+}
+
+void SoftwareRenderer::initTiles(int width, int height, int threadCount)
+{
+	const bool interleaved = this->tileLayout == TileLayout::Interleaved;
+	const int tileRows = interleaved ? 1 : SoftwareRenderer::TILE_ROWS;
+	this->threadData.initTiles(width, height, threadCount, tileRows, this->getTileColumns(),
+		interleaved);
 }
 
 void SoftwareRenderer::initRenderThreads(int width, int height, int threadCount)
@@ -917,29 +2530,14 @@ void SoftwareRenderer::initRenderThreads(int width, int height, int threadCount)
 		this->renderThreads.resize(threadCount);
 	}
 
-	// Block width and height are the approximate number of columns and rows per thread,
-	// respectively.
-	const double blockWidth = static_cast<double>(width) / static_cast<double>(threadCount);
-	const double blockHeight = static_cast<double>(height) / static_cast<double>(threadCount);
+	this->initTiles(width, height, threadCount);
 
-	// Start thread loop for each render thread. Rounding is involved so the start and stop
-	// coordinates are correct for all resolutions.
+	// Start thread loop for each render thread. They all wait for the frame number to change.
 	for (size_t i = 0; i < this->renderThreads.size(); i++)
 	{
 		const int threadIndex = static_cast<int>(i);
-		const int startX = static_cast<int>(std::round(static_cast<double>(i) * blockWidth));
-		const int endX = static_cast<int>(std::round(static_cast<double>(i + 1) * blockWidth));
-		const int startY = static_cast<int>(std::round(static_cast<double>(i) * blockHeight));
-		const int endY = static_cast<int>(std::round(static_cast<double>(i + 1) * blockHeight));
-
-		// Make sure the rounding is correct.
-		assert(startX >= 0);
-		assert(endX <= width);
-		assert(startY >= 0);
-		assert(endY <= height);
-
 		this->renderThreads.at(i) = std::thread(SoftwareRenderer::renderThreadLoop,
-			std::ref(this->threadData), threadIndex, startX, endX, startY, endY);
+			std::ref(this->threadData), threadIndex, this->threadData.frameNumber);
 	}
 }
 
@@ -947,7 +2545,6 @@ void SoftwareRenderer::resetRenderThreads()
 {
 	// Tell each render thread it needs to terminate.
 	std::unique_lock<std::mutex> lk(this->threadData.mutex);
-	this->threadData.go = true;
 	this->threadData.isDestructing = true;
 	lk.unlock();
 	this->threadData.condVar.notify_all();
@@ -960,8 +2557,7 @@ void SoftwareRenderer::resetRenderThreads()
 		}
 	}
 
-	// Set signal variables back to defaults, in case the render threads are used again.
-	this->threadData.go = false;
+	// Set signal variable back to default, in case the render threads are used again.
 	this->threadData.isDestructing = false;
 }
 
@@ -1002,15 +2598,7 @@ void SoftwareRenderer::updateVisibleDistantObjects(bool parallaxSky,
 			// to get the top. This keeps objects from appearing squished the higher they are
 			// in the sky. Don't need to worry about cases when the Y angle is at an extreme;
 			// the start and end projections will both be off-screen (i.e., +inf or -inf).
-			const Double3 objDirBottom = Double3(
-				camera.forwardX,
-				std::tan(yAngleRadians),
-				camera.forwardZ).normalized();
-
-			const Double3 objPointBottom = camera.eye + objDirBottom;
-
-			const double yProjEnd = SoftwareRenderer::getProjectedY(
-				objPointBottom, camera.transform, camera.yShear);
+			const double yProjEnd = SoftwareRenderer::getDistantProjectedY(yAngleRadians, camera);
 			const double yProjStart = yProjEnd - (objHeight * camera.zoom);
 
 			const double yProjBias = (orientation == Orientation::Top) ?
@@ -1174,13 +2762,105 @@ void SoftwareRenderer::updateVisibleDistantObjects(bool parallaxSky,
 		}
 	};
 
-	// Iterate all distant objects and gather up the visible ones. Set the start
-	// and end ranges for each object type to be used during rendering for
+	// Objects in space have their position modified by latitude and time of day.
+	// My quaternions are broken or something, so use matrix multiplication instead.
+	const Matrix4d &timeRotation = shadingInfo.timeRotation;
+	const Matrix4d &latitudeRotation = shadingInfo.latitudeRotation;
+
+	// Camera angles for testing distant buckets.
+	const double cameraAngleRadians = camera.getXZAngleRadians();
+	const double halfCameraHFovRadians = (MathUtils::verticalFovToHorizontalFov(
+		camera.fovY, camera.aspect) * 0.50) * Constants::DegToRad;
+
+	// Lambda for checking if any object in a distant bucket might be on-screen, given the
+	// direction of the bucket's cone. It's conservative, so the objects in visible buckets
+	// still need their own test.
+	auto isBucketVisible = [parallaxSky, &camera, cameraAngleRadians, halfCameraHFovRadians](
+		const DistantBuckets::Bucket &bucket, const Double3 &direction)
+	{
+		const double elevation = std::asin(MathUtils::clamp(direction.y, -1.0, 1.0));
+		const double radius = bucket.radius;
+
+		// The cone covers every azimuth if it contains a pole.
+		if ((std::abs(elevation) + radius) < Constants::HalfPi)
+		{
+			const double azimuth = MathUtils::fullAtan2(direction.x, direction.z);
+			const double azimuthSpread = std::asin(
+				std::min(std::sin(radius) / std::cos(elevation), 1.0));
+
+			// Parallax objects are visible when their angle range overlaps the camera's.
+			// Classic objects need their center in front of the camera.
+			const double halfAngleRange = parallaxSky ?
+				(halfCameraHFovRadians + bucket.maxHalfWidthRadians) : Constants::HalfPi;
+
+			// Smallest angle between the cone's azimuth and the camera's.
+			double azimuthDiff = std::fmod(std::abs(azimuth - cameraAngleRadians),
+				Constants::TwoPi);
+			azimuthDiff = std::min(azimuthDiff, Constants::TwoPi - azimuthDiff);
+
+			if (azimuthDiff > (azimuthSpread + halfAngleRange))
+			{
+				return false;
+			}
+		}
+
+		// Objects are drawn upward from their bottom edge, so the lowest one in the cone must
+		// start above the bottom of the screen, and the tallest one at the highest angle must
+		// reach below the top. Angles near a pole are always on-screen vertically.
+		const double maxAngle = Constants::HalfPi - Constants::Epsilon;
+		const double yAngleLow = elevation - radius;
+		const double yAngleHigh = elevation + radius;
+		const bool bottomVisible = (yAngleLow <= -maxAngle) ||
+			(SoftwareRenderer::getDistantProjectedY(yAngleLow, camera) >= 0.0);
+		const bool topVisible = (yAngleHigh >= maxAngle) ||
+			((SoftwareRenderer::getDistantProjectedY(yAngleHigh, camera) -
+				(bucket.maxHeight * camera.zoom)) <= 1.0);
+		return bottomVisible && topVisible;
+	};
+
+	// Lambda for getting the objects in the distant buckets that might be on-screen. Buckets of
+	// objects in space are rotated like the objects in them. Indices are sorted so objects are
+	// drawn in the same order as if every one was tested.
+	auto getBucketedIndices = [&timeRotation, &latitudeRotation, &isBucketVisible](
+		const DistantBuckets &distantBuckets, bool inSpace, std::vector<int> &indices)
+	{
+		indices.clear();
+
+		for (const DistantBuckets::Bucket &bucket : distantBuckets.buckets)
+		{
+			const Double3 direction = [&timeRotation, &latitudeRotation, inSpace, &bucket]()
+			{
+				if (inSpace)
+				{
+					const Double4 dir = latitudeRotation *
+						(timeRotation * Double4(bucket.direction, 0.0));
+					return Double3(dir.x, dir.y, dir.z);
+				}
+				else
+				{
+					return bucket.direction;
+				}
+			}();
+
+			if (isBucketVisible(bucket, direction))
+			{
+				indices.insert(indices.end(), bucket.indices.begin(), bucket.indices.end());
+			}
+		}
+
+		std::sort(indices.begin(), indices.end());
+	};
+
+	// Iterate all distant objects that might be on-screen and gather up the visible ones. Set
+	// the start and end ranges for each object type to be used during rendering for
 	// different types of shading.
+	std::vector<int> indices;
 	this->visDistantObjs.landStart = 0;
 
-	for (const auto &land : this->distantObjects.lands)
+	getBucketedIndices(this->distantObjects.landBuckets, false, indices);
+	for (const int index : indices)
 	{
+		const auto &land = this->distantObjects.lands[index];
 		const SkyTexture &texture = this->skyTextures.at(land.textureIndex);
 		const double xAngleRadians = land.obj.getAngleRadians();
 		const double yAngleRadians = 0.0;
@@ -1193,8 +2873,10 @@ void SoftwareRenderer::updateVisibleDistantObjects(bool parallaxSky,
 	this->visDistantObjs.landEnd = static_cast<int>(this->visDistantObjs.objs.size());
 	this->visDistantObjs.animLandStart = this->visDistantObjs.landEnd;
 
-	for (const auto &animLand : this->distantObjects.animLands)
+	getBucketedIndices(this->distantObjects.animLandBuckets, false, indices);
+	for (const int index : indices)
 	{
+		const auto &animLand = this->distantObjects.animLands[index];
 		const SkyTexture &texture = this->skyTextures.at(
 			animLand.textureIndex + animLand.obj.getIndex());
 		const double xAngleRadians = animLand.obj.getAngleRadians();
@@ -1208,8 +2890,10 @@ void SoftwareRenderer::updateVisibleDistantObjects(bool parallaxSky,
 	this->visDistantObjs.animLandEnd = static_cast<int>(this->visDistantObjs.objs.size());
 	this->visDistantObjs.airStart = this->visDistantObjs.animLandEnd;
 
-	for (const auto &air : this->distantObjects.airs)
+	getBucketedIndices(this->distantObjects.airBuckets, false, indices);
+	for (const int index : indices)
 	{
+		const auto &air = this->distantObjects.airs[index];
 		const SkyTexture &texture = skyTextures.at(air.textureIndex);
 		const double xAngleRadians = air.obj.getAngleRadians();
 		const double yAngleRadians = [&air]()
@@ -1229,11 +2913,6 @@ void SoftwareRenderer::updateVisibleDistantObjects(bool parallaxSky,
 	this->visDistantObjs.airEnd = static_cast<int>(this->visDistantObjs.objs.size());
 	this->visDistantObjs.moonStart = this->visDistantObjs.airEnd;
 
-	// Objects in space have their position modified by latitude and time of day.
-	// My quaternions are broken or something, so use matrix multiplication instead.
-	const Matrix4d &timeRotation = shadingInfo.timeRotation;
-	const Matrix4d &latitudeRotation = shadingInfo.latitudeRotation;
-
 	auto getSpaceCorrectedAngles = [&timeRotation, &latitudeRotation](double xAngleRadians,
 		double yAngleRadians, double &newXAngleRadians, double &newYAngleRadians)
 	{
@@ -1326,8 +3005,10 @@ void SoftwareRenderer::updateVisibleDistantObjects(bool parallaxSky,
 	this->visDistantObjs.sunEnd = static_cast<int>(this->visDistantObjs.objs.size());
 	this->visDistantObjs.starStart = this->visDistantObjs.sunEnd;
 
-	for (const auto &star : this->distantObjects.stars)
+	getBucketedIndices(this->distantObjects.starBuckets, true, indices);
+	for (const int index : indices)
 	{
+		const auto &star = this->distantObjects.stars[index];
 		const SkyTexture &texture = skyTextures.at(star.textureIndex);
 
 		const Double3 &direction = star.obj.getDirection();
@@ -1346,7 +3027,51 @@ void SoftwareRenderer::updateVisibleDistantObjects(bool parallaxSky,
 	this->visDistantObjs.starEnd = static_cast<int>(this->visDistantObjs.objs.size());
 }
 
-void SoftwareRenderer::updateVisibleFlats(const Camera &camera)
+Int2 SoftwareRenderer::getFlatChunk(const Double3 &position)
+{
+	const double chunkDim = static_cast<double>(SoftwareRenderer::FLAT_CHUNK_DIM);
+	return Int2(
+		static_cast<int>(std::floor(position.x / chunkDim)),
+		static_cast<int>(std::floor(position.z / chunkDim)));
+}
+
+void SoftwareRenderer::addFlatToChunk(const Flat &flat)
+{
+	FlatChunk &chunk = this->flatChunks[SoftwareRenderer::getFlatChunk(flat.position)];
+	chunk.flats.push_back(&flat);
+	chunk.maxHalfWidth = std::max(chunk.maxHalfWidth, flat.width * 0.50);
+}
+
+void SoftwareRenderer::removeFlatFromChunk(const Flat &flat, const Int2 &chunk)
+{
+	const auto chunkIter = this->flatChunks.find(chunk);
+	assert(chunkIter != this->flatChunks.end());
+
+	std::vector<const Flat*> &chunkFlats = chunkIter->second.flats;
+	const auto flatIter = std::find(chunkFlats.begin(), chunkFlats.end(), &flat);
+	assert(flatIter != chunkFlats.end());
+
+	// Order within a chunk doesn't matter, so swap with the last one.
+	*flatIter = chunkFlats.back();
+	chunkFlats.pop_back();
+
+	// The chunk's max half width is left as-is (it's only a bound), and is reset when
+	// the chunk is erased.
+	if (chunkFlats.empty())
+	{
+		this->flatChunks.erase(chunkIter);
+	}
+}
+
+double SoftwareRenderer::getDrawDistance() const
+{
+	// The fog distance is zero until a level sets it.
+	return std::max(std::min(this->fogDistance, this->maxDrawDistance),
+		SoftwareRenderer::MIN_DRAW_DISTANCE);
+}
+
+void SoftwareRenderer::updateVisibleFlats(const Camera &camera, double drawDistance,
+	bool copyFlats)
 {
 	this->visibleFlats.clear();
 
@@ -1359,55 +3084,118 @@ void SoftwareRenderer::updateVisibleFlats(const Camera &camera)
 	const Double2 eye2D(camera.eye.x, camera.eye.z);
 	const Double2 direction(camera.forwardX, camera.forwardZ);
 
-	// This is the visible flat determination algorithm. It goes through all flats and sees 
-	// which ones would be at least partially visible in the view frustum.
-	for (const auto &pair : this->flats)
+	// Directions perpendicular to the frustum edges, pointing towards the inside. The camera's
+	// right vector is the left perpendicular of its forward vector.
+	const Double2 frustumLeftPerp = Double2(camera.frustumLeftX, camera.frustumLeftZ).leftPerp();
+	const Double2 frustumRightPerp = Double2(camera.frustumRightX, camera.frustumRightZ).rightPerp();
+
+	// Returns whether some point in the given XZ box is on the inner side of a frustum edge.
+	auto boxTouchesHalfPlane = [&eye2D](const Double2 &perp, const Double2 &boxMin,
+		const Double2 &boxMax)
 	{
-		const Flat &flat = pair.second;
+		// Only the box corner farthest along the perpendicular needs checking.
+		const Double2 corner(
+			(perp.x > 0.0) ? boxMax.x : boxMin.x,
+			(perp.y > 0.0) ? boxMax.y : boxMin.y);
+		return perp.dot(corner - eye2D) >= 0.0;
+	};
+
+	const double chunkDim = static_cast<double>(SoftwareRenderer::FLAT_CHUNK_DIM);
+
+	// This is the visible flat determination algorithm. It goes through the flats in chunks
+	// that touch the view frustum and sees which ones would be at least partially visible.
+	for (const auto &chunkPair : this->flatChunks)
+	{
+		const Int2 &chunkCoord = chunkPair.first;
+		const FlatChunk &chunk = chunkPair.second;
 
-		// Scaled axes based on flat dimensions.
-		const Double3 flatRightScaled = flatRight * (flat.width * 0.50);
-		const Double3 flatUpScaled = flatUp * flat.height;
+		// Bounds of the chunk, grown by how far its widest flat could reach outside of it.
+		const Double2 chunkMin(
+			(static_cast<double>(chunkCoord.x) * chunkDim) - chunk.maxHalfWidth,
+			(static_cast<double>(chunkCoord.y) * chunkDim) - chunk.maxHalfWidth);
+		const Double2 chunkMax(
+			chunkMin.x + chunkDim + (chunk.maxHalfWidth * 2.0),
+			chunkMin.y + chunkDim + (chunk.maxHalfWidth * 2.0));
 
-		// Calculate each corner of the flat in world space.
-		Flat::Frame flatFrame;
-		flatFrame.bottomStart = flat.position + flatRightScaled;
-		flatFrame.bottomEnd = flat.position - flatRightScaled;
-		flatFrame.topStart = flatFrame.bottomStart + flatUpScaled;
-		flatFrame.topEnd = flatFrame.bottomEnd + flatUpScaled;
+		if (!boxTouchesHalfPlane(frustumLeftPerp, chunkMin, chunkMax) ||
+			!boxTouchesHalfPlane(frustumRightPerp, chunkMin, chunkMax))
+		{
+			continue;
+		}
 
-		// If the flat is somewhere in front of the camera, do further checks.
-		const Double2 flatPosition2D(flat.position.x, flat.position.z);
-		const Double2 flatEyeDiff = (flatPosition2D - eye2D).normalized();
-		const bool inFrontOfCamera = direction.dot(flatEyeDiff) > 0.0;
+		// Skip the chunk if all of it is past the draw distance.
+		const Double2 chunkNearest(
+			std::min(std::max(eye2D.x, chunkMin.x), chunkMax.x),
+			std::min(std::max(eye2D.y, chunkMin.y), chunkMax.y));
+		if ((chunkNearest - eye2D).lengthSquared() >= (drawDistance * drawDistance))
+		{
+			continue;
+		}
 
-		if (inFrontOfCamera)
+		for (const Flat *flatPtr : chunk.flats)
 		{
-			// Now project two of the flat's opposing corner points into camera space.
-			// The Z value is used with flat sorting (not rendering), and the X and Y values 
-			// are used to find where the flat is on-screen.
-			Double4 projStart = camera.transform * Double4(flatFrame.topStart, 1.0);
-			Double4 projEnd = camera.transform * Double4(flatFrame.bottomEnd, 1.0);
+			const Flat &flat = *flatPtr;
 
-			// Normalize coordinates.
-			projStart = projStart / projStart.w;
-			projEnd = projEnd / projEnd.w;
+			// Skip the flat if it's entirely outside one of the frustum edges. No point on it
+			// can be farther than half its width from its center.
+			const Double2 flatPosition2D(flat.position.x, flat.position.z);
+			const double flatHalfWidth = flat.width * 0.50;
+			const Double2 flatEyeOffset = flatPosition2D - eye2D;
+			if ((frustumLeftPerp.dot(flatEyeOffset) < -flatHalfWidth) ||
+				(frustumRightPerp.dot(flatEyeOffset) < -flatHalfWidth))
+			{
+				continue;
+			}
+
+			// Skip the flat if it's entirely past the draw distance, like walls are.
+			if ((flatEyeOffset.length() - flatHalfWidth) >= drawDistance)
+			{
+				continue;
+			}
+
+			// Scaled axes based on flat dimensions.
+			const Double3 flatRightScaled = flatRight * flatHalfWidth;
+			const Double3 flatUpScaled = flatUp * flat.height;
 
-			// Assign each screen value to the flat frame data.
-			flatFrame.startX = 0.50 + (projStart.x * 0.50);
-			flatFrame.endX = 0.50 + (projEnd.x * 0.50);
-			flatFrame.startY = (0.50 + camera.yShear) - (projStart.y * 0.50);
-			flatFrame.endY = (0.50 + camera.yShear) - (projEnd.y * 0.50);
-			flatFrame.z = projStart.z;
+			// Calculate each corner of the flat in world space.
+			Flat::Frame flatFrame;
+			flatFrame.bottomStart = flat.position + flatRightScaled;
+			flatFrame.bottomEnd = flat.position - flatRightScaled;
+			flatFrame.topStart = flatFrame.bottomStart + flatUpScaled;
+			flatFrame.topEnd = flatFrame.bottomEnd + flatUpScaled;
 
-			// Check that the Z value is within the clipping planes.
-			const bool inPlanes = (flatFrame.z >= SoftwareRenderer::NEAR_PLANE) &&
-				(flatFrame.z <= SoftwareRenderer::FAR_PLANE);
+			// If the flat is somewhere in front of the camera, do further checks.
+			const Double2 flatEyeDiff = flatEyeOffset.normalized();
+			const bool inFrontOfCamera = direction.dot(flatEyeDiff) > 0.0;
 
-			if (inPlanes)
+			if (inFrontOfCamera)
 			{
-				// Add the flat data to the draw list.
-				this->visibleFlats.push_back(VisibleFlat(flat, std::move(flatFrame)));
+				// Now project two of the flat's opposing corner points into camera space.
+				// The Z value is used with flat sorting (not rendering), and the X and Y values 
+				// are used to find where the flat is on-screen.
+				Double4 projStart = camera.transform * Double4(flatFrame.topStart, 1.0);
+				Double4 projEnd = camera.transform * Double4(flatFrame.bottomEnd, 1.0);
+
+				// Normalize coordinates.
+				projStart = projStart / projStart.w;
+				projEnd = projEnd / projEnd.w;
+
+				// Assign each screen value to the flat frame data.
+				flatFrame.startX = 0.50 + (projStart.x * 0.50);
+				flatFrame.endX = 0.50 + (projEnd.x * 0.50);
+				flatFrame.startY = (0.50 + camera.yShear) - (projStart.y * 0.50);
+				flatFrame.endY = (0.50 + camera.yShear) - (projEnd.y * 0.50);
+				flatFrame.z = projStart.z;
+
+				// Check that the Z value is within the clipping planes.
+				const bool inPlanes = (flatFrame.z >= SoftwareRenderer::NEAR_PLANE) &&
+					(flatFrame.z <= SoftwareRenderer::FAR_PLANE);
+
+				if (inPlanes)
+				{
+					// Add the flat data to the draw list.
+					this->visibleFlats.push_back(VisibleFlat(flat, std::move(flatFrame)));
+				}
 			}
 		}
 	}
@@ -1418,6 +3206,57 @@ void SoftwareRenderer::updateVisibleFlats(const Camera &camera)
 	{
 		return a.getFrame().z > b.getFrame().z;
 	});
+
+	// Only the visible flats are copied, and only when the frame needs copies.
+	if (copyFlats)
+	{
+		const int visibleFlatCount = static_cast<int>(this->visibleFlats.size());
+		this->pipelinedFlats.resize(visibleFlatCount);
+		for (int i = 0; i < visibleFlatCount; i++)
+		{
+			VisibleFlat &visibleFlat = this->visibleFlats[i];
+			this->pipelinedFlats[i] = visibleFlat.getFlat();
+			visibleFlat.setFlat(this->pipelinedFlats[i]);
+		}
+	}
+}
+
+void SoftwareRenderer::binVisibleFlats(const FrameView &frame)
+{
+	const int tileColumns = this->threadData.tileColumns;
+	const int tileCount = (frame.width + tileColumns - 1) / tileColumns;
+	this->visibleFlatBins.resize(tileCount);
+
+	for (std::vector<int> &bin : this->visibleFlatBins)
+	{
+		bin.clear();
+	}
+
+	for (int i = 0; i < static_cast<int>(this->visibleFlats.size()); i++)
+	{
+		const Flat::Frame &flatFrame = this->visibleFlats[i].getFrame();
+
+		// Screen-space X range of the flat, with a pixel of slack on each side since
+		// drawFlat() tests tile edges against pixel centers.
+		const double xMin = (std::min(flatFrame.startX, flatFrame.endX) * frame.widthReal) - 1.0;
+		const double xMax = (std::max(flatFrame.startX, flatFrame.endX) * frame.widthReal) + 1.0;
+
+		if ((xMax < 0.0) || (xMin >= frame.widthReal))
+		{
+			continue;
+		}
+
+		const int pixelStart = static_cast<int>(std::max(xMin, 0.0));
+		const int pixelEnd = static_cast<int>(std::min(xMax, frame.widthReal - 1.0));
+		const int tileStart = pixelStart / tileColumns;
+		const int tileEnd = pixelEnd / tileColumns;
+
+		// Flats are visited in sorted order, so each bin stays sorted too.
+		for (int tile = tileStart; tile <= tileEnd; tile++)
+		{
+			this->visibleFlatBins[tile].push_back(i);
+		}
+	}
 }
 
 /*Double3 SoftwareRenderer::castRay(const Double3 &direction,
@@ -1769,6 +3608,67 @@ int SoftwareRenderer::getRenderThreadsFromMode(int mode)
 	}
 }
 
+SoftwareRenderer::DepthFormat SoftwareRenderer::getDepthFormatFromMode(int mode)
+{
+	if (mode == 0)
+	{
+		return DepthFormat::Double;
+	}
+	else if (mode == 1)
+	{
+		return DepthFormat::Float;
+	}
+	else if (mode == 2)
+	{
+		return DepthFormat::Fixed16;
+	}
+	else
+	{
+		throw DebugException("Invalid depth buffer mode \"" +
+			std::to_string(mode) + "\".");
+	}
+}
+
+int SoftwareRenderer::getDepthFormatSize(DepthFormat depthFormat)
+{
+	if (depthFormat == DepthFormat::Double)
+	{
+		return static_cast<int>(sizeof(double));
+	}
+	else if (depthFormat == DepthFormat::Float)
+	{
+		return static_cast<int>(sizeof(float));
+	}
+	else if (depthFormat == DepthFormat::Fixed16)
+	{
+		return static_cast<int>(sizeof(uint16_t));
+	}
+	else
+	{
+		throw DebugException("Invalid depth format \"" +
+			std::to_string(static_cast<int>(depthFormat)) + "\".");
+	}
+}
+
+int SoftwareRenderer::getSkyDaytimeStep(double daytimePercent)
+{
+	const double skyDaytimeSteps = static_cast<double>(SoftwareRenderer::SKY_DAYTIME_STEPS);
+	return static_cast<int>(daytimePercent * skyDaytimeSteps);
+}
+
+uint8_t *SoftwareRenderer::getCacheLineStart(std::vector<uint8_t> &buffer)
+{
+	if (buffer.size() == 0)
+	{
+		return nullptr;
+	}
+
+	const uintptr_t address = reinterpret_cast<uintptr_t>(buffer.data());
+	const uintptr_t lineSize = static_cast<uintptr_t>(SoftwareRenderer::CACHE_LINE_SIZE);
+	const uintptr_t offset = (lineSize - (address % lineSize)) % lineSize;
+	return buffer.data() + offset;
+}
+
 VoxelData::Facing SoftwareRenderer::getInitialChasmFarFacing(int voxelX, int voxelZ,
 	const Double2 &eye, const Ray &ray)
 {
@@ -2067,6 +3967,42 @@ double SoftwareRenderer::getProjectedY(const Double3 &point,
 	return (0.50 + yShear) - (projectedY * 0.50);
 }
 
+double SoftwareRenderer::getDistantProjectedY(double yAngleRadians, const Camera &camera)
+{
+	// Distant objects are projected as if they were straight ahead of the camera, so only
+	// their angle above the horizon matters.
+	const Double3 objDirBottom = Double3(
+		camera.forwardX,
+		std::tan(yAngleRadians),
+		camera.forwardZ).normalized();
+
+	const Double3 objPointBottom = camera.eye + objDirBottom;
+	return SoftwareRenderer::getProjectedY(objPointBottom, camera.transform, camera.yShear);
+}
+
+int SoftwareRenderer::getMipLevel(double texelsPerPixel, int mipLevelCount)
+{
+	// Also true for NaN (i.e., from a zero-height span).
+	if (!(texelsPerPixel >= 2.0))
+	{
+		return 0;
+	}
+
+	const double maxMipLevel = static_cast<double>(mipLevelCount - 1);
+	return static_cast<int>(std::min(std::log2(texelsPerPixel), maxMipLevel));
+}
+
+int SoftwareRenderer::getVoxelMipLevel(double columnTexelsPerPixel, double depth,
+	const ShadingInfo &shadingInfo)
+{
+	// Surfaces seen at a glancing angle step over many more texels down the column than
+	// across it, so the smaller of the two keeps them from blurring.
+	const double rowTexelsPerPixel =
+		static_cast<double>(VoxelTexture::WIDTH) * shadingInfo.mipPixelSize * depth;
+	return SoftwareRenderer::getMipLevel(std::min(rowTexelsPerPixel, columnTexelsPerPixel),
+		VoxelTexture::MIP_LEVEL_COUNT);
+}
+
 int SoftwareRenderer::getLowerBoundedPixel(double projected, int frameDim)
 {
 	return MathUtils::clamp(static_cast<int>(std::ceil(projected - 0.50)), 0, frameDim);
@@ -3027,89 +4963,196 @@ bool SoftwareRenderer::findDoorIntersection(int voxelX, int voxelZ,
 	}
 }
 
-void SoftwareRenderer::drawPixels(int x, const DrawRange &drawRange, double depth, double u,
-	double vStart, double vEnd, const Double3 &normal, const VoxelTexture &texture,
-	const ShadingInfo &shadingInfo, OcclusionData &occlusion, const FrameView &frame)
+Double3 SoftwareRenderer::getSurfaceLight(const Double3 &normal, const Double2 &point,
+	const ShadingInfo &shadingInfo)
 {
-	// Draw range values.
-	const double yProjStart = drawRange.yProjStart;
-	const double yProjEnd = drawRange.yProjEnd;
-	int yStart = drawRange.yStart;
-	int yEnd = drawRange.yEnd;
-
-	// Horizontal offset in texture.
-	const int textureX = static_cast<int>(u * static_cast<double>(VoxelTexture::WIDTH));
-
-	// Linearly interpolated fog.
-	const Double3 &fogColor = shadingInfo.getFogColor();
-	const double fogPercent = std::min(depth / shadingInfo.fogDistance, 1.0);
-
-	// Contribution from the sun.
-	const double lightNormalDot = std::max(0.0, shadingInfo.sunDirection.dot(normal));
-	const Double3 sunComponent = (shadingInfo.sunColor * lightNormalDot).clamped(
-		0.0, 1.0 - shadingInfo.ambient);
+	const Double3 sunlight = shadingInfo.getSunlight(normal);
+	const Double3 pointLight = shadingInfo.lightGrid->getLight(point, Double2(normal.x, normal.z));
+	return sunlight + pointLight;
+}
 
-	// Shading on the texture.
-	// - @todo: contribution from lights.
-	const Double3 shading(
-		shadingInfo.ambient + sunComponent.x,
-		shadingInfo.ambient + sunComponent.y,
-		shadingInfo.ambient + sunComponent.z);
+SpanKernels::Shading SoftwareRenderer::getSpanShading(const Double3 &light,
+	const ShadingInfo &shadingInfo)
+{
+	SpanKernels::Shading shading;
+	shading.lightR = SpanKernels::getLightLevel(light.x);
+	shading.lightG = SpanKernels::getLightLevel(light.y);
+	shading.lightB = SpanKernels::getLightLevel(light.z);
+	shading.fogColor = shadingInfo.fogColorRGB;
+	shading.fogScale = shadingInfo.fogScale;
+	shading.nightLightTexel = shadingInfo.nightLightTexel;
+	return shading;
+}
 
-	// Clip the Y start and end coordinates as needed, and refresh the occlusion buffer.
-	occlusion.clipRange(&yStart, &yEnd);
-	occlusion.update(yStart, yEnd);
+void SoftwareRenderer::drawColumnRows(int x, int yStart, int yEnd, const uint32_t *texels,
+	bool checkTransparency, const double *depths, double depth, double depthBias,
+	const DepthRows *clearedRows, const SpanKernels::Shading &shading,
+	const SpanKernels::PerspectiveSpan *perspectiveSpan, const FrameView &frame)
+{
+	if (frame.indexBuffer == nullptr)
+	{
+		if (frame.depthFormat == DepthFormat::Double)
+		{
+			SoftwareRenderer::drawColumnRows<double, false>(x, yStart, yEnd, texels,
+				checkTransparency, depths, depth, depthBias, clearedRows, shading,
+				perspectiveSpan, frame);
+		}
+		else if (frame.depthFormat == DepthFormat::Float)
+		{
+			SoftwareRenderer::drawColumnRows<float, false>(x, yStart, yEnd, texels,
+				checkTransparency, depths, depth, depthBias, clearedRows, shading,
+				perspectiveSpan, frame);
+		}
+		else
+		{
+			SoftwareRenderer::drawColumnRows<uint16_t, false>(x, yStart, yEnd, texels,
+				checkTransparency, depths, depth, depthBias, clearedRows, shading,
+				perspectiveSpan, frame);
+		}
+	}
+	else
+	{
+		if (frame.depthFormat == DepthFormat::Double)
+		{
+			SoftwareRenderer::drawColumnRows<double, true>(x, yStart, yEnd, texels,
+				checkTransparency, depths, depth, depthBias, clearedRows, shading,
+				perspectiveSpan, frame);
+		}
+		else if (frame.depthFormat == DepthFormat::Float)
+		{
+			SoftwareRenderer::drawColumnRows<float, true>(x, yStart, yEnd, texels,
+				checkTransparency, depths, depth, depthBias, clearedRows, shading,
+				perspectiveSpan, frame);
+		}
+		else
+		{
+			SoftwareRenderer::drawColumnRows<uint16_t, true>(x, yStart, yEnd, texels,
+				checkTransparency, depths, depth, depthBias, clearedRows, shading,
+				perspectiveSpan, frame);
+		}
+	}
+}
+
+template <typename DepthType, bool Paletted>
+void SoftwareRenderer::drawColumnRows(int x, int yStart, int yEnd, const uint32_t *texels,
+	bool checkTransparency, const double *depths, double depth, double depthBias,
+	const DepthRows *clearedRows, const SpanKernels::Shading &shading,
+	const SpanKernels::PerspectiveSpan *perspectiveSpan, const FrameView &frame)
+{
+	// Rows outside the cleared rows have stale depth, or none do if they aren't given.
+	const int clearedStart = (clearedRows != nullptr) ? clearedRows->yStart : yStart;
+	const int clearedEnd = (clearedRows != nullptr) ? clearedRows->yEnd : yEnd;
+
+	// Rows that pass the depth test, packed together so only their texels get shaded.
+	std::array<int, SpanKernels::MAX_ROWS> rows;
+	std::array<uint32_t, SpanKernels::MAX_ROWS> colors;
+	std::array<double, SpanKernels::MAX_ROWS> rowDepths;
+	int count = 0;
 
-	// Draw the column to the output buffer.
 	for (int y = yStart; y < yEnd; y++)
 	{
+		const int row = y - yStart;
+		const uint32_t texel = texels[row];
+		if (checkTransparency && SpanKernels::isTexelTransparent(texel))
+		{
+			continue;
+		}
+
 		const int index = x + (y * frame.width);
+		const double rowDepth = (depths != nullptr) ? depths[row] : depth;
+		const bool isStale = (y < clearedStart) || (y >= clearedEnd);
 
 		// Check depth of the pixel before rendering.
 		// - @todo: implement occlusion culling and back-to-front transparent rendering so
 		//   this depth check isn't needed.
-		if (depth <= (frame.depthBuffer[index] - Constants::Epsilon))
+		if (isStale || (rowDepth <= (frame.getDepthAs<DepthType>(index) - depthBias)))
 		{
-			// Percent stepped from beginning to end on the column.
-			const double yPercent = 
-				((static_cast<double>(y) + 0.50) - yProjStart) / (yProjEnd - yProjStart);
+			rows[count] = y;
+			colors[count] = texel;
+			rowDepths[count] = rowDepth;
+			count++;
+		}
+	}
 
-			// Vertical texture coordinate.
-			const double v = vStart + ((vEnd - vStart) * yPercent);
+	const SpanKernels::InstructionSet instructionSet = SpanKernels::getBestInstructionSet();
+	if (perspectiveSpan != nullptr)
+	{
+		const SpanKernels::ShadePerspectiveFunction shadePerspectiveTexels =
+			SpanKernels::getShadePerspectiveFunction(instructionSet);
+		shadePerspectiveTexels(*perspectiveSpan, shading, rowDepths.data(), count, colors.data());
+	}
+	else
+	{
+		const SpanKernels::ShadeWallFunction shadeWallTexels =
+			SpanKernels::getShadeWallFunction(instructionSet);
+		shadeWallTexels(shading, SpanKernels::getFogFactor(depth, shading.fogScale), count,
+			colors.data());
+	}
 
-			// Y position in texture.
-			const int textureY = static_cast<int>(v * static_cast<double>(VoxelTexture::HEIGHT));
+	for (int i = 0; i < count; i++)
+	{
+		const int index = x + (rows[i] * frame.width);
+		if (Paletted)
+		{
+			frame.indexBuffer[index] = frame.inversePalette[getInversePaletteIndex(colors[i])];
+		}
+		else
+		{
+			frame.colorBuffer[index] = colors[i];
+		}
 
-			// Alpha is ignored in this loop, so transparent texels will appear black.
-			const int textureIndex = textureX + (textureY * VoxelTexture::WIDTH);
-			const VoxelTexel &texel = texture.texels[textureIndex];
+		frame.setDepthAs<DepthType>(index, rowDepths[i]);
+	}
+}
 
-			// Texture color with shading.
-			const double shadingMax = 1.0;
-			double colorR = texel.r * std::min(shading.x + texel.emission, shadingMax);
-			double colorG = texel.g * std::min(shading.y + texel.emission, shadingMax);
-			double colorB = texel.b * std::min(shading.z + texel.emission, shadingMax);
+void SoftwareRenderer::drawPixels(int x, const DrawRange &drawRange, double depth, double u,
+	double vStart, double vEnd, const Double3 &normal, const VoxelTexture &texture,
+	const ShadingInfo &shadingInfo, OcclusionData &occlusion, const FrameView &frame)
+{
+	// Draw range values.
+	int yStart = drawRange.yStart;
+	int yEnd = drawRange.yEnd;
 
-			// Linearly interpolate with fog.
-			colorR += (fogColor.x - colorR) * fogPercent;
-			colorG += (fogColor.y - colorG) * fogPercent;
-			colorB += (fogColor.z - colorB) * fogPercent;
+	// Light at the point where the column's ray hits the wall.
+	const Double2 point = shadingInfo.lightGrid->getColumnPoint(x, depth);
+	const SpanKernels::Shading shading = SoftwareRenderer::getSpanShading(
+		SoftwareRenderer::getSurfaceLight(normal, point, shadingInfo), shadingInfo);
 
-			// Clamp maximum (don't worry about negative values).
-			const double high = 1.0;
-			colorR = (colorR > high) ? high : colorR;
-			colorG = (colorG > high) ? high : colorG;
-			colorB = (colorB > high) ? high : colorB;
+	// Mip level from how many texels are stepped over per pixel.
+	const int mipLevel = SoftwareRenderer::getVoxelMipLevel(
+		(std::abs(vEnd - vStart) * static_cast<double>(VoxelTexture::HEIGHT)) /
+		std::abs(drawRange.yProjEnd - drawRange.yProjStart), depth, shadingInfo);
 
-			// Convert floats to integers.
-			const uint32_t colorRGB = static_cast<uint32_t>(
-				((static_cast<uint8_t>(colorR * 255.0)) << 16) |
-				((static_cast<uint8_t>(colorG * 255.0)) << 8) |
-				((static_cast<uint8_t>(colorB * 255.0))));
+	// Horizontal offset in texture.
+	SpanKernels::WallSpan span;
+	span.texels = reinterpret_cast<const uint8_t*>(texture.getTexels(mipLevel));
+	span.textureBits = SpanKernels::TEXTURE_BITS - mipLevel;
+	span.textureX = static_cast<int>(u * static_cast<double>(1 << span.textureBits));
+	span.yProjStart = drawRange.yProjStart;
+	span.yProjEnd = drawRange.yProjEnd;
+	span.vStart = vStart;
+	span.vEnd = vEnd;
 
-			frame.colorBuffer[index] = colorRGB;
-			frame.depthBuffer[index] = depth;
-		}
+	// Clip the Y start and end coordinates as needed, and refresh the occlusion buffer.
+	occlusion.clipRange(&yStart, &yEnd);
+	occlusion.update(yStart, yEnd);
+
+	// Rows with stale depth from earlier frames are drawn without a depth check.
+	const DepthRows clearedRows = frame.claimDepth(x, yStart, yEnd);
+
+	// Draw the column to the output buffer, sampling a chunk of rows at a time. Alpha is
+	// ignored here, so transparent texels will appear black.
+	const SpanKernels::WallSpanFunction sampleWallSpan =
+		SpanKernels::getWallSpanFunction(SpanKernels::getBestInstructionSet());
+	std::array<uint32_t, SpanKernels::MAX_ROWS> texels;
+
+	for (int chunkStart = yStart; chunkStart < yEnd; chunkStart += SpanKernels::MAX_ROWS)
+	{
+		const int chunkEnd = std::min(chunkStart + SpanKernels::MAX_ROWS, yEnd);
+		sampleWallSpan(span, chunkStart, chunkEnd, texels.data());
+
+		SoftwareRenderer::drawColumnRows(x, chunkStart, chunkEnd, texels.data(), false,
+			nullptr, depth, frame.depthBias, &clearedRows, shading, nullptr, frame);
 	}
 }
 
@@ -3119,25 +5162,14 @@ void SoftwareRenderer::drawPerspectivePixels(int x, const DrawRange &drawRange,
 	OcclusionData &occlusion, const FrameView &frame)
 {
 	// Draw range values.
-	const double yProjStart = drawRange.yProjStart;
-	const double yProjEnd = drawRange.yProjEnd;
 	int yStart = drawRange.yStart;
 	int yEnd = drawRange.yEnd;
 
-	// Fog color to interpolate with.
-	const Double3 &fogColor = shadingInfo.getFogColor();
-
-	// Contribution from the sun.
-	const double lightNormalDot = std::max(0.0, shadingInfo.sunDirection.dot(normal));
-	const Double3 sunComponent = (shadingInfo.sunColor * lightNormalDot).clamped(
-		0.0, 1.0 - shadingInfo.ambient);
-
-	// Shading on the texture.
-	// - @todo: contribution from lights.
-	const Double3 shading(
-		shadingInfo.ambient + sunComponent.x,
-		shadingInfo.ambient + sunComponent.y,
-		shadingInfo.ambient + sunComponent.z);
+	// Light at both ends of the span. Rows in between are interpolated by the span kernels.
+	const SpanKernels::Shading shading = SoftwareRenderer::getSpanShading(
+		SoftwareRenderer::getSurfaceLight(normal, startPoint, shadingInfo), shadingInfo);
+	const SpanKernels::Shading endShading = SoftwareRenderer::getSpanShading(
+		SoftwareRenderer::getSurfaceLight(normal, endPoint, shadingInfo), shadingInfo);
 
 	// Values for perspective-correct interpolation.
 	const double depthStartRecip = 1.0 / depthStart;
@@ -3145,78 +5177,51 @@ void SoftwareRenderer::drawPerspectivePixels(int x, const DrawRange &drawRange,
 	const Double2 startPointDiv = startPoint * depthStartRecip;
 	const Double2 endPointDiv = endPoint * depthEndRecip;
 	const Double2 pointDivDiff = endPointDiv - startPointDiv;
+
+	// Mip level from how many texels are stepped over per pixel, using the near end for
+	// texels across the screen.
+	const int mipLevel = SoftwareRenderer::getVoxelMipLevel(
+		((endPoint - startPoint).length() * static_cast<double>(VoxelTexture::WIDTH)) /
+		std::abs(drawRange.yProjEnd - drawRange.yProjStart),
+		std::min(depthStart, depthEnd), shadingInfo);
+
+	SpanKernels::PerspectiveSpan span;
+	span.texels = reinterpret_cast<const uint8_t*>(texture.getTexels(mipLevel));
+	span.textureBits = SpanKernels::TEXTURE_BITS - mipLevel;
+	span.yProjStart = drawRange.yProjStart;
+	span.yProjEnd = drawRange.yProjEnd;
+	span.depthStartRecip = depthStartRecip;
+	span.depthEndRecip = depthEndRecip;
+	span.startPointDivX = startPointDiv.x;
+	span.startPointDivY = startPointDiv.y;
+	span.pointDivDiffX = pointDivDiff.x;
+	span.pointDivDiffY = pointDivDiff.y;
+	span.justBelowOne = Constants::JustBelowOne;
+	span.lightEndR = endShading.lightR;
+	span.lightEndG = endShading.lightG;
+	span.lightEndB = endShading.lightB;
 	
 	// Clip the Y start and end coordinates as needed, and refresh the occlusion buffer.
 	occlusion.clipRange(&yStart, &yEnd);
 	occlusion.update(yStart, yEnd);
 
-	// Draw the column to the output buffer.
-	for (int y = yStart; y < yEnd; y++)
-	{
-		const int index = x + (y * frame.width);
-
-		// Percent stepped from beginning to end on the column.
-		const double yPercent = 
-			((static_cast<double>(y) + 0.50) - yProjStart) / (yProjEnd - yProjStart);
-
-		// Interpolate between the near and far depth.
-		const double depth = 1.0 / 
-			(depthStartRecip + ((depthEndRecip - depthStartRecip) * yPercent));
-
-		// Check depth of the pixel before rendering.
-		// - @todo: implement occlusion culling and back-to-front transparent rendering so
-		//   this depth check isn't needed.
-		if (depth <= frame.depthBuffer[index])
-		{
-			// Linearly interpolated fog.
-			const double fogPercent = std::min(depth / shadingInfo.fogDistance, 1.0);
-
-			// Interpolate between start and end points.
-			const double currentPointX = (startPointDiv.x + (pointDivDiff.x * yPercent)) * depth;
-			const double currentPointY = (startPointDiv.y + (pointDivDiff.y * yPercent)) * depth;
-
-			// Texture coordinates.
-			const double u = MathUtils::clamp(
-				Constants::JustBelowOne - (currentPointX - std::floor(currentPointX)),
-				0.0, Constants::JustBelowOne);
-			const double v = MathUtils::clamp(
-				Constants::JustBelowOne - (currentPointY - std::floor(currentPointY)),
-				0.0, Constants::JustBelowOne);
-
-			// Offsets in texture.
-			const int textureX = static_cast<int>(u * static_cast<double>(VoxelTexture::WIDTH));
-			const int textureY = static_cast<int>(v * static_cast<double>(VoxelTexture::HEIGHT));
-
-			// Alpha is ignored in this loop, so transparent texels will appear black.
-			const int textureIndex = textureX + (textureY * VoxelTexture::WIDTH);
-			const VoxelTexel &texel = texture.texels[textureIndex];
+	// Rows with stale depth from earlier frames are drawn without a depth check.
+	const DepthRows clearedRows = frame.claimDepth(x, yStart, yEnd);
 
-			// Texture color with shading.
-			const double shadingMax = 1.0;
-			double colorR = texel.r * std::min(shading.x + texel.emission, shadingMax);
-			double colorG = texel.g * std::min(shading.y + texel.emission, shadingMax);
-			double colorB = texel.b * std::min(shading.z + texel.emission, shadingMax);
-
-			// Linearly interpolate with fog.
-			colorR += (fogColor.x - colorR) * fogPercent;
-			colorG += (fogColor.y - colorG) * fogPercent;
-			colorB += (fogColor.z - colorB) * fogPercent;
-
-			// Clamp maximum (don't worry about negative values).
-			const double high = 1.0;
-			colorR = (colorR > high) ? high : colorR;
-			colorG = (colorG > high) ? high : colorG;
-			colorB = (colorB > high) ? high : colorB;
+	// Draw the column to the output buffer, sampling a chunk of rows at a time. Alpha is
+	// ignored here, so transparent texels will appear black.
+	const SpanKernels::PerspectiveSpanFunction samplePerspectiveSpan =
+		SpanKernels::getPerspectiveSpanFunction(SpanKernels::getBestInstructionSet());
+	std::array<uint32_t, SpanKernels::MAX_ROWS> texels;
+	std::array<double, SpanKernels::MAX_ROWS> depths;
 
-			// Convert floats to integers.
-			const uint32_t colorRGB = static_cast<uint32_t>(
-				((static_cast<uint8_t>(colorR * 255.0)) << 16) |
-				((static_cast<uint8_t>(colorG * 255.0)) << 8) |
-				((static_cast<uint8_t>(colorB * 255.0))));
+	for (int chunkStart = yStart; chunkStart < yEnd; chunkStart += SpanKernels::MAX_ROWS)
+	{
+		const int chunkEnd = std::min(chunkStart + SpanKernels::MAX_ROWS, yEnd);
+		samplePerspectiveSpan(span, chunkStart, chunkEnd, texels.data(), depths.data());
 
-			frame.colorBuffer[index] = colorRGB;
-			frame.depthBuffer[index] = depth;
-		}
+		SoftwareRenderer::drawColumnRows(x, chunkStart, chunkEnd, texels.data(), false,
+			depths.data(), 0.0, 0.0, &clearedRows, shading, &span, frame);
 	}
 }
 
@@ -3225,85 +5230,47 @@ void SoftwareRenderer::drawTransparentPixels(int x, const DrawRange &drawRange,
 	const ShadingInfo &shadingInfo, const OcclusionData &occlusion, const FrameView &frame)
 {
 	// Draw range values.
-	const double yProjStart = drawRange.yProjStart;
-	const double yProjEnd = drawRange.yProjEnd;
 	int yStart = drawRange.yStart;
 	int yEnd = drawRange.yEnd;
 
-	// Horizontal offset in texture.
-	const int textureX = static_cast<int>(u * static_cast<double>(VoxelTexture::WIDTH));
-
-	// Linearly interpolated fog.
-	const Double3 &fogColor = shadingInfo.getFogColor();
-	const double fogPercent = std::min(depth / shadingInfo.fogDistance, 1.0);
+	// Light at the point where the column's ray hits the wall.
+	const Double2 point = shadingInfo.lightGrid->getColumnPoint(x, depth);
+	const SpanKernels::Shading shading = SoftwareRenderer::getSpanShading(
+		SoftwareRenderer::getSurfaceLight(normal, point, shadingInfo), shadingInfo);
 
-	// Contribution from the sun.
-	const double lightNormalDot = std::max(0.0, shadingInfo.sunDirection.dot(normal));
-	const Double3 sunComponent = (shadingInfo.sunColor * lightNormalDot).clamped(
-		0.0, 1.0 - shadingInfo.ambient);
+	// Mip level from how many texels are stepped over per pixel.
+	const int mipLevel = SoftwareRenderer::getVoxelMipLevel(
+		(std::abs(vEnd - vStart) * static_cast<double>(VoxelTexture::HEIGHT)) /
+		std::abs(drawRange.yProjEnd - drawRange.yProjStart), depth, shadingInfo);
 
-	// Shading on the texture.
-	// - @todo: contribution from lights.
-	const Double3 shading(
-		shadingInfo.ambient + sunComponent.x,
-		shadingInfo.ambient + sunComponent.y,
-		shadingInfo.ambient + sunComponent.z);
+	// Horizontal offset in texture.
+	SpanKernels::WallSpan span;
+	span.texels = reinterpret_cast<const uint8_t*>(texture.getTexels(mipLevel));
+	span.textureBits = SpanKernels::TEXTURE_BITS - mipLevel;
+	span.textureX = static_cast<int>(u * static_cast<double>(1 << span.textureBits));
+	span.yProjStart = drawRange.yProjStart;
+	span.yProjEnd = drawRange.yProjEnd;
+	span.vStart = vStart;
+	span.vEnd = vEnd;
 
 	// Clip the Y start and end coordinates as needed, but do not refresh the occlusion buffer,
 	// because transparent ranges do not occlude as simply as opaque ranges.
 	occlusion.clipRange(&yStart, &yEnd);
+	frame.prepareDepth(x, yStart, yEnd);
 
-	// Draw the column to the output buffer.
-	for (int y = yStart; y < yEnd; y++)
-	{
-		const int index = x + (y * frame.width);
-
-		// Check depth of the pixel before rendering.
-		if (depth <= (frame.depthBuffer[index] - Constants::Epsilon))
-		{
-			// Percent stepped from beginning to end on the column.
-			const double yPercent =
-				((static_cast<double>(y) + 0.50) - yProjStart) / (yProjEnd - yProjStart);
-
-			// Vertical texture coordinate.
-			const double v = vStart + ((vEnd - vStart) * yPercent);
-
-			// Y position in texture.
-			const int textureY = static_cast<int>(v * static_cast<double>(VoxelTexture::HEIGHT));
-
-			// Alpha is checked in this loop, and transparent texels are not drawn.
-			const int textureIndex = textureX + (textureY * VoxelTexture::WIDTH);
-			const VoxelTexel &texel = texture.texels[textureIndex];
-			
-			if (!texel.transparent)
-			{
-				// Texture color with shading.
-				const double shadingMax = 1.0;
-				double colorR = texel.r * std::min(shading.x + texel.emission, shadingMax);
-				double colorG = texel.g * std::min(shading.y + texel.emission, shadingMax);
-				double colorB = texel.b * std::min(shading.z + texel.emission, shadingMax);
-
-				// Linearly interpolate with fog.
-				colorR += (fogColor.x - colorR) * fogPercent;
-				colorG += (fogColor.y - colorG) * fogPercent;
-				colorB += (fogColor.z - colorB) * fogPercent;
-				
-				// Clamp maximum (don't worry about negative values).
-				const double high = 1.0;
-				colorR = (colorR > high) ? high : colorR;
-				colorG = (colorG > high) ? high : colorG;
-				colorB = (colorB > high) ? high : colorB;
+	// Draw the column to the output buffer, sampling a chunk of rows at a time. Alpha is
+	// checked here, and transparent texels are not drawn.
+	const SpanKernels::WallSpanFunction sampleWallSpan =
+		SpanKernels::getWallSpanFunction(SpanKernels::getBestInstructionSet());
+	std::array<uint32_t, SpanKernels::MAX_ROWS> texels;
 
-				// Convert floats to integers.
-				const uint32_t colorRGB = static_cast<uint32_t>(
-					((static_cast<uint8_t>(colorR * 255.0)) << 16) |
-					((static_cast<uint8_t>(colorG * 255.0)) << 8) |
-					((static_cast<uint8_t>(colorB * 255.0))));
+	for (int chunkStart = yStart; chunkStart < yEnd; chunkStart += SpanKernels::MAX_ROWS)
+	{
+		const int chunkEnd = std::min(chunkStart + SpanKernels::MAX_ROWS, yEnd);
+		sampleWallSpan(span, chunkStart, chunkEnd, texels.data());
 
-				frame.colorBuffer[index] = colorRGB;
-				frame.depthBuffer[index] = depth;
-			}
-		}
+		SoftwareRenderer::drawColumnRows(x, chunkStart, chunkEnd, texels.data(), true,
+			nullptr, depth, frame.depthBias, nullptr, shading, nullptr, frame);
 	}
 }
 
@@ -3321,7 +5288,9 @@ void SoftwareRenderer::drawDistantPixels(int x, const DrawRange &drawRange, doub
 	const int textureX = static_cast<int>(u * static_cast<double>(texture.width));
 	
 	// Shading on the texture. Some distant objects are completely bright.
-	const double shading = emissive ? 1.0 : shadingInfo.distantAmbient;
+	const int lightLevel = emissive ? SpanKernels::LIGHT_LEVEL_MAX :
+		SpanKernels::getLightLevel(shadingInfo.distantAmbient);
+	const auto &shadeTable = SpanKernels::getShadeTables()[lightLevel];
 
 	// Draw the column to the output buffer.
 	for (int y = yStart; y < yEnd; y++)
@@ -3345,23 +5314,9 @@ void SoftwareRenderer::drawDistantPixels(int x, const DrawRange &drawRange, doub
 		if (!texel.transparent)
 		{
 			// Texture color with shading.
-			double colorR = texel.r * shading;
-			double colorG = texel.g * shading;
-			double colorB = texel.b * shading;
-
-			// Clamp maximum (don't worry about negative values).
-			const double high = 1.0;
-			colorR = (colorR > high) ? high : colorR;
-			colorG = (colorG > high) ? high : colorG;
-			colorB = (colorB > high) ? high : colorB;
-
-			// Convert floats to integers.
-			const uint32_t colorRGB = static_cast<uint32_t>(
-				((static_cast<uint8_t>(colorR * 255.0)) << 16) |
-				((static_cast<uint8_t>(colorG * 255.0)) << 8) |
-				((static_cast<uint8_t>(colorB * 255.0))));
-
-			frame.colorBuffer[index] = colorRGB;
+			frame.setColor(index, (static_cast<uint32_t>(shadeTable[texel.r]) << 16) |
+				(static_cast<uint32_t>(shadeTable[texel.g]) << 8) |
+				static_cast<uint32_t>(shadeTable[texel.b]));
 		}
 	}
 }
@@ -3385,7 +5340,9 @@ void SoftwareRenderer::drawMoonPixels(int x, const DrawRange &drawRange, double
 
 	// The 'signal' color used in the original game to denote moon texels that should
 	// use the gradient color behind the moon instead.
-	const Double3 unlitColor(170.0 / 255.0, 0.0, 0.0);
+	constexpr uint8_t unlitR = 170;
+	constexpr uint8_t unlitG = 0;
+	constexpr uint8_t unlitB = 0;
 
 	// Draw the column to the output buffer.
 	for (int y = yStart; y < yEnd; y++)
@@ -3408,10 +5365,9 @@ void SoftwareRenderer::drawMoonPixels(int x, const DrawRange &drawRange, double
 
 		if (!texel.transparent)
 		{
-			// Determine how the pixel should be shaded based on the moon texel. Should be
-			// safe to do floating-point comparisons here with no error.
-			const bool texelIsLit = (texel.r != unlitColor.x) && (texel.g != unlitColor.y) &&
-				(texel.b != unlitColor.z);
+			// Determine how the pixel should be shaded based on the moon texel.
+			const bool texelIsLit = (texel.r != unlitR) && (texel.g != unlitG) &&
+				(texel.b != unlitB);
 
 			double colorR;
 			double colorG;
@@ -3420,9 +5376,9 @@ void SoftwareRenderer::drawMoonPixels(int x, const DrawRange &drawRange, double
 			if (texelIsLit)
 			{
 				// Use the moon texel.
-				colorR = texel.r;
-				colorG = texel.g;
-				colorB = texel.b;
+				colorR = TexelChannelReals[texel.r];
+				colorG = TexelChannelReals[texel.g];
+				colorB = TexelChannelReals[texel.b];
 			}
 			else
 			{
@@ -3444,7 +5400,7 @@ void SoftwareRenderer::drawMoonPixels(int x, const DrawRange &drawRange, double
 				((static_cast<uint8_t>(colorG * 255.0)) << 8) |
 				((static_cast<uint8_t>(colorB * 255.0))));
 
-			frame.colorBuffer[index] = colorRGB;
+			frame.setColor(index, colorRGB);
 		}
 	}
 }
@@ -3504,9 +5460,9 @@ void SoftwareRenderer::drawStarPixels(int x, const DrawRange &drawRange, double
 					0.0, 1.0);
 
 				// Texture color with shading.
-				double colorR = texel.r;
-				double colorG = texel.g;
-				double colorB = texel.b;
+				double colorR = TexelChannelReals[texel.r];
+				double colorG = TexelChannelReals[texel.g];
+				double colorB = TexelChannelReals[texel.b];
 
 				// Lerp with sky gradient for smoother transition between day and night.
 				colorR += (gradientColor.x - colorR) * gradientVisPercent;
@@ -3525,2226 +5481,2604 @@ void SoftwareRenderer::drawStarPixels(int x, const DrawRange &drawRange, double
 					((static_cast<uint8_t>(colorG * 255.0)) << 8) |
 					((static_cast<uint8_t>(colorB * 255.0))));
 
-				frame.colorBuffer[index] = colorRGB;
+				frame.setColor(index, colorRGB);
 			}
 		}
 	}
 }
 
-void SoftwareRenderer::drawInitialVoxelColumn(int x, int voxelX, int voxelZ, const Camera &camera,
-	const Ray &ray, VoxelData::Facing facing, const Double2 &nearPoint, const Double2 &farPoint,
-	double nearZ, double farZ, const ShadingInfo &shadingInfo, double ceilingHeight,
-	const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
-	const std::vector<VoxelTexture> &textures, OcclusionData &occlusion, const FrameView &frame)
+template <VoxelDataType DataType>
+void SoftwareRenderer::drawInitialVoxel(int, const VoxelData&, const VoxelColumnContext&)
 {
-	// This method handles some special cases such as drawing the back-faces of wall sides.
+	// Air, and data types with nothing visible from this position.
+}
 
-	// When clamping Y values for drawing ranges, subtract 0.5 from starts and add 0.5 to 
-	// ends before converting to integers because the drawing methods sample at the center 
-	// of pixels. The clamping function depends on which side of the range is being clamped; 
-	// either way, the drawing range should be contained within the projected range at the 
-	// sub-pixel level. This ensures that the vertical texture coordinate is always within 0->1.
+template <>
+void SoftwareRenderer::drawInitialVoxel<VoxelDataType::Wall>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw inner ceiling, wall, and floor.
+	const VoxelData::WallData &wallData = voxelData.wall;
+
+	const Double3 farCeilingPoint(
+		column.farPoint.x,
+		voxelYReal + voxelHeight,
+		column.farPoint.y);
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		farCeilingPoint.y,
+		column.nearPoint.y);
+	const Double3 farFloorPoint(
+		column.farPoint.x,
+		voxelYReal,
+		column.farPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		farFloorPoint.y,
+		column.nearPoint.y);
+
+	const auto drawRanges = SoftwareRenderer::makeDrawRangeThreePart(
+		nearCeilingPoint, farCeilingPoint, farFloorPoint, nearFloorPoint, column.camera,
+		column.frame);
+
+	// Ceiling.
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(0), column.nearPoint,
+		column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+		column.textures.at(wallData.ceilingID), column.shadingInfo, column.occlusion, column.frame);
+
+	// Wall.
+	SoftwareRenderer::drawPixels(column.x, drawRanges.at(1), column.farZ, column.wallU, 0.0,
+		Constants::JustBelowOne, column.wallNormal, column.textures.at(wallData.sideID),
+		column.shadingInfo, column.occlusion, column.frame);
+
+	// Floor.
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(2), column.farPoint,
+		column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+		column.textures.at(wallData.floorID), column.shadingInfo, column.occlusion, column.frame);
+}
 
-	const double wallU = [&farPoint, facing]()
+template <>
+void SoftwareRenderer::drawInitialVoxel<VoxelDataType::Ceiling>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw bottom of ceiling voxel if the camera is below it.
+	if (column.camera.eye.y < voxelYReal)
 	{
-		const double uVal = [&farPoint, facing]()
-		{
-			if (facing == VoxelData::Facing::PositiveX)
-			{
-				return farPoint.y - std::floor(farPoint.y);
-			}
-			else if (facing == VoxelData::Facing::NegativeX)
-			{
-				return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
-			}
-			else if (facing == VoxelData::Facing::PositiveZ)
-			{
-				return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
-			}
-			else
-			{
-				return farPoint.x - std::floor(farPoint.x);
-			}
-		}();
+		const VoxelData::CeilingData &ceilingData = voxelData.ceiling;
 
-		return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
-	}();
+		const Double3 nearFloorPoint(
+			column.nearPoint.x,
+			voxelYReal,
+			column.nearPoint.y);
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
 
-	// Normal of the wall for the incoming ray, potentially shared between multiple voxels in
-	// this voxel column.
-	const Double3 wallNormal = -VoxelData::getNormal(facing);
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(ceilingData.id), column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-	auto drawInitialVoxel = [x, voxelX, voxelZ, &camera, &ray, &wallNormal, &nearPoint,
-		&farPoint, nearZ, farZ, wallU, &shadingInfo, ceilingHeight, &openDoors, &voxelGrid,
-		&textures, &occlusion, &frame](int voxelY)
+template <>
+void SoftwareRenderer::drawInitialVoxel<VoxelDataType::Raised>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::RaisedData &raisedData = voxelData.raised;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal + (raisedData.yOffset * voxelHeight),
+		column.nearPoint.y);
+
+	// Draw order depends on the player's Y position relative to the platform.
+	if (column.camera.eye.y > nearCeilingPoint.y)
+	{
+		// Above platform.
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			nearCeilingPoint.y,
+			column.farPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			farCeilingPoint, nearCeilingPoint, column.camera, column.frame);
+
+		// Ceiling.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.farPoint,
+			column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+			column.textures.at(raisedData.ceilingID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else if (column.camera.eye.y < nearFloorPoint.y)
+	{
+		// Below platform.
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+		// Floor.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(raisedData.floorID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else
 	{
-		const uint16_t voxelID = voxelGrid.getVoxel(voxelX, voxelY, voxelZ);
-		const VoxelData &voxelData = voxelGrid.getVoxelData(voxelID);
-		const double voxelHeight = ceilingHeight;
-		const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+		// Between top and bottom.
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			nearCeilingPoint.y,
+			column.farPoint.y);
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRanges = SoftwareRenderer::makeDrawRangeThreePart(
+			nearCeilingPoint, farCeilingPoint, farFloorPoint, nearFloorPoint,
+			column.camera, column.frame);
+
+		// Ceiling.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(0), column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(raisedData.ceilingID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Wall.
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRanges.at(1), column.farZ,
+			column.wallU, raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Floor.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(2), column.farPoint,
+			column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+			column.textures.at(raisedData.floorID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+}
 
-		if (voxelData.dataType == VoxelDataType::Wall)
-		{
-			// Draw inner ceiling, wall, and floor.
-			const VoxelData::WallData &wallData = voxelData.wall;
+template <>
+void SoftwareRenderer::drawInitialVoxel<VoxelDataType::Diagonal>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = diagData.type1 ? SoftwareRenderer::findDiag1Intersection(column.voxelX,
+		column.voxelZ, column.nearPoint, column.farPoint,
+		hit) : SoftwareRenderer::findDiag2Intersection(column.voxelX, column.voxelZ,
+		column.nearPoint, column.farPoint, hit);
+
+	if (success)
+	{
+		const Double3 diagTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight,
+			hit.point.y);
+		const Double3 diagBottomPoint(
+			diagTopPoint.x,
+			voxelYReal,
+			diagTopPoint.z);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			diagTopPoint, diagBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawPixels(column.x, drawRange, column.nearZ + hit.innerZ, hit.u, 0.0,
+			Constants::JustBelowOne, hit.normal, column.textures.at(diagData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-			const Double3 farCeilingPoint(
-				farPoint.x,
-				voxelYReal + voxelHeight,
-				farPoint.y);
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				farCeilingPoint.y,
-				nearPoint.y);
-			const Double3 farFloorPoint(
-				farPoint.x,
-				voxelYReal,
-				farPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				farFloorPoint.y,
-				nearPoint.y);
+template <>
+void SoftwareRenderer::drawInitialVoxel<VoxelDataType::Edge>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::EdgeData &edgeData = voxelData.edge;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = SoftwareRenderer::findInitialEdgeIntersection(
+		column.voxelX, column.voxelZ, edgeData.facing, edgeData.flipped, column.nearPoint,
+		column.farPoint, column.camera, column.ray, hit);
+
+	if (success)
+	{
+		const Double3 edgeTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight + edgeData.yOffset,
+			hit.point.y);
+		const Double3 edgeBottomPoint(
+			edgeTopPoint.x,
+			voxelYReal + edgeData.yOffset,
+			edgeTopPoint.z);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			edgeTopPoint, edgeBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+			hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(edgeData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-			const auto drawRanges = SoftwareRenderer::makeDrawRangeThreePart(
-				nearCeilingPoint, farCeilingPoint, farFloorPoint, nearFloorPoint, camera, frame);
+template <>
+void SoftwareRenderer::drawInitialVoxel<VoxelDataType::Chasm>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
 
-			// Ceiling.
-			SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(0), nearPoint, farPoint,
-				nearZ, farZ, -Double3::UnitY, textures.at(wallData.ceilingID), shadingInfo,
-				occlusion, frame);
+	// Render back-face.
+	const VoxelData::ChasmData &chasmData = voxelData.chasm;
 
-			// Wall.
-			SoftwareRenderer::drawPixels(x, drawRanges.at(1), farZ, wallU, 0.0,
-				Constants::JustBelowOne, wallNormal, textures.at(wallData.sideID), shadingInfo,
-				occlusion, frame);
+	// Find which far face on the chasm was intersected.
+	const VoxelData::Facing farFacing = SoftwareRenderer::getInitialChasmFarFacing(
+		column.voxelX, column.voxelZ, Double2(column.camera.eye.x, column.camera.eye.z),
+		column.ray);
 
-			// Floor.
-			SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(2), farPoint, nearPoint,
-				farZ, nearZ, Double3::UnitY, textures.at(wallData.floorID), shadingInfo,
-				occlusion, frame);
-		}
-		else if (voxelData.dataType == VoxelDataType::Floor)
-		{
-			// Do nothing. Floors can only be seen from above.
-		}
-		else if (voxelData.dataType == VoxelDataType::Ceiling)
+	// Far.
+	if (chasmData.faceIsVisible(farFacing))
+	{
+		const double farU = [&farPoint = column.farPoint, farFacing]()
 		{
-			// Draw bottom of ceiling voxel if the camera is below it.
-			if (camera.eye.y < voxelYReal)
+			const double uVal = [&farPoint, farFacing]()
 			{
-				const VoxelData::CeilingData &ceilingData = voxelData.ceiling;
-
-				const Double3 nearFloorPoint(
-					nearPoint.x,
-					voxelYReal,
-					nearPoint.y);
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearFloorPoint, farFloorPoint, camera, frame);
-
-				SoftwareRenderer::drawPerspectivePixels(x, drawRange, nearPoint, farPoint,
-					nearZ, farZ, -Double3::UnitY, textures.at(ceilingData.id), shadingInfo,
-					occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Raised)
-		{
-			const VoxelData::RaisedData &raisedData = voxelData.raised;
+				if (farFacing == VoxelData::Facing::PositiveX)
+				{
+					return farPoint.y - std::floor(farPoint.y);
+				}
+				else if (farFacing == VoxelData::Facing::NegativeX)
+				{
+					return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
+				}
+				else if (farFacing == VoxelData::Facing::PositiveZ)
+				{
+					return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
+				}
+				else
+				{
+					return farPoint.x - std::floor(farPoint.x);
+				}
+			}();
 
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal + (raisedData.yOffset * voxelHeight),
-				nearPoint.y);
+			return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
+		}();
 
-			// Draw order depends on the player's Y position relative to the platform.
-			if (camera.eye.y > nearCeilingPoint.y)
-			{
-				// Above platform.
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					nearCeilingPoint.y,
-					farPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					farCeilingPoint, nearCeilingPoint, camera, frame);
-
-				// Ceiling.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRange, farPoint, nearPoint, farZ,
-					nearZ, Double3::UnitY, textures.at(raisedData.ceilingID), shadingInfo,
-					occlusion, frame);
-			}
-			else if (camera.eye.y < nearFloorPoint.y)
-			{
-				// Below platform.
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearFloorPoint, farFloorPoint, camera, frame);
-
-				// Floor.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRange, nearPoint, farPoint, nearZ,
-					farZ, -Double3::UnitY, textures.at(raisedData.floorID), shadingInfo,
-					occlusion, frame);
-			}
-			else
-			{
-				// Between top and bottom.
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					nearCeilingPoint.y,
-					farPoint.y);
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRanges = SoftwareRenderer::makeDrawRangeThreePart(
-					nearCeilingPoint, farCeilingPoint, farFloorPoint, nearFloorPoint,
-					camera, frame);
-
-				// Ceiling.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(0), nearPoint, farPoint,
-					nearZ, farZ, -Double3::UnitY, textures.at(raisedData.ceilingID), shadingInfo,
-					occlusion, frame);
-
-				// Wall.
-				SoftwareRenderer::drawTransparentPixels(x, drawRanges.at(1), farZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-
-				// Floor.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(2), farPoint, nearPoint,
-					farZ, nearZ, Double3::UnitY, textures.at(raisedData.floorID), shadingInfo,
-					occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Diagonal)
-		{
-			const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+		const Double3 farNormal = -VoxelData::getNormal(farFacing);
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = diagData.type1 ?
-				SoftwareRenderer::findDiag1Intersection(voxelX, voxelZ, nearPoint, farPoint, hit) :
-				SoftwareRenderer::findDiag2Intersection(voxelX, voxelZ, nearPoint, farPoint, hit);
+		// Wet chasms and lava chasms are unaffected by ceiling height.
+		const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
+			voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
 
-			if (success)
-			{
-				const Double3 diagTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight,
-					hit.point.y);
-				const Double3 diagBottomPoint(
-					diagTopPoint.x,
-					voxelYReal,
-					diagTopPoint.z);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					diagTopPoint, diagBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawPixels(x, drawRange, nearZ + hit.innerZ, hit.u, 0.0,
-					Constants::JustBelowOne, hit.normal, textures.at(diagData.id), shadingInfo,
-					occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::TransparentWall)
-		{
-			// Do nothing. Transparent walls have no back-faces.
-		}
-		else if (voxelData.dataType == VoxelDataType::Edge)
-		{
-			const VoxelData::EdgeData &edgeData = voxelData.edge;
-
-			// Find intersection.
-			RayHit hit;
-			const bool success = SoftwareRenderer::findInitialEdgeIntersection(
-				voxelX, voxelZ, edgeData.facing, edgeData.flipped, nearPoint, farPoint,
-				camera, ray, hit);
-
-			if (success)
-			{
-				const Double3 edgeTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight + edgeData.yOffset,
-					hit.point.y);
-				const Double3 edgeBottomPoint(
-					edgeTopPoint.x,
-					voxelYReal + edgeData.yOffset,
-					edgeTopPoint.z);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					edgeTopPoint, edgeBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ, hit.u,
-					0.0, Constants::JustBelowOne, hit.normal, textures.at(edgeData.id),
-					shadingInfo, occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Chasm)
-		{
-			// Render back-face.
-			const VoxelData::ChasmData &chasmData = voxelData.chasm;
-
-			// Find which far face on the chasm was intersected.
-			const VoxelData::Facing farFacing = SoftwareRenderer::getInitialChasmFarFacing(
-				voxelX, voxelZ, Double2(camera.eye.x, camera.eye.z), ray);
-
-			// Far.
-			if (chasmData.faceIsVisible(farFacing))
-			{
-				const double farU = [&farPoint, farFacing]()
-				{
-					const double uVal = [&farPoint, farFacing]()
-					{
-						if (farFacing == VoxelData::Facing::PositiveX)
-						{
-							return farPoint.y - std::floor(farPoint.y);
-						}
-						else if (farFacing == VoxelData::Facing::NegativeX)
-						{
-							return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
-						}
-						else if (farFacing == VoxelData::Facing::PositiveZ)
-						{
-							return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
-						}
-						else
-						{
-							return farPoint.x - std::floor(farPoint.x);
-						}
-					}();
-
-					return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
-				}();
-
-				const Double3 farNormal = -VoxelData::getNormal(farFacing);
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			voxelYReal + voxelHeight,
+			column.farPoint.y);
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			farCeilingPoint.y - chasmDepth,
+			column.farPoint.y);
 
-				// Wet chasms and lava chasms are unaffected by ceiling height.
-				const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
-					voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			farCeilingPoint, farFloorPoint, column.camera, column.frame);
 
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					voxelYReal + voxelHeight,
-					farPoint.y);
-				const Double3 farFloorPoint(
-					farPoint.x,
-					farCeilingPoint.y - chasmDepth,
-					farPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					farCeilingPoint, farFloorPoint, camera, frame);
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.farZ, farU, 0.0,
+			Constants::JustBelowOne, farNormal, column.textures.at(chasmData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, farZ, farU, 0.0,
-					Constants::JustBelowOne, farNormal, textures.at(chasmData.id), shadingInfo,
-					occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Door)
-		{
-			const VoxelData::DoorData &doorData = voxelData.door;
-			const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
-				voxelX, voxelZ, openDoors);
+template <>
+void SoftwareRenderer::drawInitialVoxel<VoxelDataType::Door>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
 
-			RayHit hit;
-			const bool success = SoftwareRenderer::findInitialDoorIntersection(voxelX, voxelZ,
-				doorData.type, percentOpen, nearPoint, farPoint, camera, ray, voxelGrid, hit);
+	const VoxelData::DoorData &doorData = voxelData.door;
+	const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
+		column.voxelX, column.voxelZ, column.openDoors);
 
-			if (success)
-			{
-				if (doorData.type == VoxelData::DoorData::Type::Swinging)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Sliding)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Raising)
-				{
-					// Top point is fixed, bottom point depends on percent open.
-					const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
-					const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
-
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal + raisedAmount,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					// The start of the vertical texture coordinate depends on the percent open.
-					const double vStart = raisedAmount / voxelHeight;
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, vStart, Constants::JustBelowOne, hit.normal,
-						textures.at(doorData.id), shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Splitting)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-			}
-		}
-	};
+	RayHit hit;
+	const bool success = SoftwareRenderer::findInitialDoorIntersection(column.voxelX, column.voxelZ,
+		doorData.type, percentOpen, column.nearPoint, column.farPoint, column.camera, column.ray,
+		column.voxelGrid, hit);
 
-	auto drawInitialVoxelBelow = [x, voxelX, voxelZ, &camera, &ray, &wallNormal, &nearPoint,
-		&farPoint, nearZ, farZ, wallU, &shadingInfo, ceilingHeight, &openDoors, &voxelGrid,
-		&textures, &occlusion, &frame](int voxelY)
+	if (success)
 	{
-		const uint16_t voxelID = voxelGrid.getVoxel(voxelX, voxelY, voxelZ);
-		const VoxelData &voxelData = voxelGrid.getVoxelData(voxelID);
-		const double voxelHeight = ceilingHeight;
-		const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
-
-		if (voxelData.dataType == VoxelDataType::Wall)
+		if (doorData.type == VoxelData::DoorData::Type::Swinging)
 		{
-			const VoxelData::WallData &wallData = voxelData.wall;
-
-			const Double3 farCeilingPoint(
-				farPoint.x,
+			const Double3 doorTopPoint(
+				hit.point.x,
 				voxelYReal + voxelHeight,
-				farPoint.y);
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				farCeilingPoint.y,
-				nearPoint.y);
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
 			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				farCeilingPoint, nearCeilingPoint, camera, frame);
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			// Ceiling.
-			SoftwareRenderer::drawPerspectivePixels(x, drawRange, farPoint, nearPoint, farZ,
-				nearZ, Double3::UnitY, textures.at(wallData.ceilingID), shadingInfo,
-				occlusion, frame);
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Floor)
+		else if (doorData.type == VoxelData::DoorData::Type::Sliding)
 		{
-			// Draw top of floor voxel.
-			const VoxelData::FloorData &floorData = voxelData.floor;
-
-			const Double3 farCeilingPoint(
-				farPoint.x,
+			const Double3 doorTopPoint(
+				hit.point.x,
 				voxelYReal + voxelHeight,
-				farPoint.y);
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				farCeilingPoint.y,
-				nearPoint.y);
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
 			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				farCeilingPoint, nearCeilingPoint, camera, frame);
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			// Ceiling.
-			SoftwareRenderer::drawPerspectivePixels(x, drawRange, farPoint, nearPoint, farZ,
-				nearZ, Double3::UnitY, textures.at(floorData.id), shadingInfo,
-				occlusion, frame);
-		}
-		else if (voxelData.dataType == VoxelDataType::Ceiling)
-		{
-			// Do nothing. Ceilings can only be seen from below.
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Raised)
+		else if (doorData.type == VoxelData::DoorData::Type::Raising)
 		{
-			const VoxelData::RaisedData &raisedData = voxelData.raised;
+			// Top point is fixed, bottom point depends on percent open.
+			const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
+			const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
 
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal + (raisedData.yOffset * voxelHeight),
-				nearPoint.y);
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal + raisedAmount,
+				doorTopPoint.z);
 
-			// Draw order depends on the player's Y position relative to the platform.
-			if (camera.eye.y > nearCeilingPoint.y)
-			{
-				// Above platform.
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					nearCeilingPoint.y,
-					farPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					farCeilingPoint, nearCeilingPoint, camera, frame);
-
-				// Ceiling.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRange, farPoint, nearPoint, farZ,
-					nearZ, Double3::UnitY, textures.at(raisedData.ceilingID), shadingInfo,
-					occlusion, frame);
-			}
-			else if (camera.eye.y < nearFloorPoint.y)
-			{
-				// Below platform.
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearFloorPoint, farFloorPoint, camera, frame);
-
-				// Floor.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRange, nearPoint, farPoint, nearZ,
-					farZ, -Double3::UnitY, textures.at(raisedData.floorID), shadingInfo,
-					occlusion, frame);
-			}
-			else
-			{
-				// Between top and bottom.
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					nearCeilingPoint.y,
-					farPoint.y);
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRanges = SoftwareRenderer::makeDrawRangeThreePart(
-					nearCeilingPoint, farCeilingPoint, farFloorPoint, nearFloorPoint,
-					camera, frame);
-
-				// Ceiling.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(0), nearPoint, farPoint,
-					nearZ, farZ, -Double3::UnitY, textures.at(raisedData.ceilingID), shadingInfo,
-					occlusion, frame);
-
-				// Wall.
-				SoftwareRenderer::drawTransparentPixels(x, drawRanges.at(1), farZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-
-				// Floor.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(2), farPoint, nearPoint,
-					farZ, nearZ, Double3::UnitY, textures.at(raisedData.floorID), shadingInfo,
-					occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Diagonal)
-		{
-			const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = diagData.type1 ?
-				SoftwareRenderer::findDiag1Intersection(voxelX, voxelZ, nearPoint, farPoint, hit) :
-				SoftwareRenderer::findDiag2Intersection(voxelX, voxelZ, nearPoint, farPoint, hit);
+			// The start of the vertical texture coordinate depends on the percent open.
+			const double vStart = raisedAmount / voxelHeight;
 
-			if (success)
-			{
-				const Double3 diagTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight,
-					hit.point.y);
-				const Double3 diagBottomPoint(
-					diagTopPoint.x,
-					voxelYReal,
-					diagTopPoint.z);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					diagTopPoint, diagBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawPixels(x, drawRange, nearZ + hit.innerZ, hit.u, 0.0,
-					Constants::JustBelowOne, hit.normal, textures.at(diagData.id), shadingInfo,
-					occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::TransparentWall)
-		{
-			// Do nothing. Transparent walls have no back-faces.
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, vStart, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Edge)
+		else if (doorData.type == VoxelData::DoorData::Type::Splitting)
 		{
-			const VoxelData::EdgeData &edgeData = voxelData.edge;
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = SoftwareRenderer::findInitialEdgeIntersection(
-				voxelX, voxelZ, edgeData.facing, edgeData.flipped, nearPoint, farPoint,
-				camera, ray, hit);
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			if (success)
-			{
-				const Double3 edgeTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight + edgeData.yOffset,
-					hit.point.y);
-				const Double3 edgeBottomPoint(
-					hit.point.x,
-					voxelYReal + edgeData.yOffset,
-					hit.point.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					edgeTopPoint, edgeBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ, hit.u,
-					0.0, Constants::JustBelowOne, hit.normal, textures.at(edgeData.id),
-					shadingInfo, occlusion, frame);
-			}
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Chasm)
-		{
-			// Render back-face.
-			const VoxelData::ChasmData &chasmData = voxelData.chasm;
+	}
+}
 
-			// Find which far face on the chasm was intersected.
-			const VoxelData::Facing farFacing = SoftwareRenderer::getInitialChasmFarFacing(
-				voxelX, voxelZ, Double2(camera.eye.x, camera.eye.z), ray);
+template <VoxelDataType DataType>
+void SoftwareRenderer::drawInitialVoxelBelow(int, const VoxelData&, const VoxelColumnContext&)
+{
+	// Air, and data types with nothing visible from this position.
+}
 
-			// Far.
-			if (chasmData.faceIsVisible(farFacing))
-			{
-				const double farU = [&farPoint, farFacing]()
-				{
-					const double uVal = [&farPoint, farFacing]()
-					{
-						if (farFacing == VoxelData::Facing::PositiveX)
-						{
-							return farPoint.y - std::floor(farPoint.y);
-						}
-						else if (farFacing == VoxelData::Facing::NegativeX)
-						{
-							return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
-						}
-						else if (farFacing == VoxelData::Facing::PositiveZ)
-						{
-							return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
-						}
-						else
-						{
-							return farPoint.x - std::floor(farPoint.x);
-						}
-					}();
+template <>
+void SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Wall>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::WallData &wallData = voxelData.wall;
+
+	const Double3 farCeilingPoint(
+		column.farPoint.x,
+		voxelYReal + voxelHeight,
+		column.farPoint.y);
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		farCeilingPoint.y,
+		column.nearPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		farCeilingPoint, nearCeilingPoint, column.camera, column.frame);
+
+	// Ceiling.
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.farPoint, column.nearPoint,
+		column.farZ, column.nearZ, Double3::UnitY, column.textures.at(wallData.ceilingID),
+		column.shadingInfo, column.occlusion, column.frame);
+}
 
-					return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
-				}();
+template <>
+void SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Floor>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw top of floor voxel.
+	const VoxelData::FloorData &floorData = voxelData.floor;
+
+	const Double3 farCeilingPoint(
+		column.farPoint.x,
+		voxelYReal + voxelHeight,
+		column.farPoint.y);
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		farCeilingPoint.y,
+		column.nearPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		farCeilingPoint, nearCeilingPoint, column.camera, column.frame);
+
+	// Ceiling.
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.farPoint, column.nearPoint,
+		column.farZ, column.nearZ, Double3::UnitY, column.textures.at(floorData.id),
+		column.shadingInfo, column.occlusion, column.frame);
+}
 
-				const Double3 farNormal = -VoxelData::getNormal(farFacing);
+template <>
+void SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Raised>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::RaisedData &raisedData = voxelData.raised;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal + (raisedData.yOffset * voxelHeight),
+		column.nearPoint.y);
+
+	// Draw order depends on the player's Y position relative to the platform.
+	if (column.camera.eye.y > nearCeilingPoint.y)
+	{
+		// Above platform.
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			nearCeilingPoint.y,
+			column.farPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			farCeilingPoint, nearCeilingPoint, column.camera, column.frame);
+
+		// Ceiling.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.farPoint,
+			column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+			column.textures.at(raisedData.ceilingID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else if (column.camera.eye.y < nearFloorPoint.y)
+	{
+		// Below platform.
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+		// Floor.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(raisedData.floorID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else
+	{
+		// Between top and bottom.
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			nearCeilingPoint.y,
+			column.farPoint.y);
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRanges = SoftwareRenderer::makeDrawRangeThreePart(
+			nearCeilingPoint, farCeilingPoint, farFloorPoint, nearFloorPoint,
+			column.camera, column.frame);
+
+		// Ceiling.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(0), column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(raisedData.ceilingID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Wall.
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRanges.at(1), column.farZ,
+			column.wallU, raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Floor.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(2), column.farPoint,
+			column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+			column.textures.at(raisedData.floorID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+}
 
-				// Wet chasms and lava chasms are unaffected by ceiling height.
-				const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
-					voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
+template <>
+void SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Diagonal>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = diagData.type1 ? SoftwareRenderer::findDiag1Intersection(column.voxelX,
+		column.voxelZ, column.nearPoint, column.farPoint,
+		hit) : SoftwareRenderer::findDiag2Intersection(column.voxelX, column.voxelZ,
+		column.nearPoint, column.farPoint, hit);
+
+	if (success)
+	{
+		const Double3 diagTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight,
+			hit.point.y);
+		const Double3 diagBottomPoint(
+			diagTopPoint.x,
+			voxelYReal,
+			diagTopPoint.z);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			diagTopPoint, diagBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawPixels(column.x, drawRange, column.nearZ + hit.innerZ, hit.u, 0.0,
+			Constants::JustBelowOne, hit.normal, column.textures.at(diagData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					voxelYReal + voxelHeight,
-					farPoint.y);
-				const Double3 farFloorPoint(
-					farPoint.x,
-					farCeilingPoint.y - chasmDepth,
-					farPoint.y);
+template <>
+void SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Edge>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::EdgeData &edgeData = voxelData.edge;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = SoftwareRenderer::findInitialEdgeIntersection(
+		column.voxelX, column.voxelZ, edgeData.facing, edgeData.flipped, column.nearPoint,
+		column.farPoint, column.camera, column.ray, hit);
+
+	if (success)
+	{
+		const Double3 edgeTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight + edgeData.yOffset,
+			hit.point.y);
+		const Double3 edgeBottomPoint(
+			hit.point.x,
+			voxelYReal + edgeData.yOffset,
+			hit.point.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			edgeTopPoint, edgeBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+			hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(edgeData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					farCeilingPoint, farFloorPoint, camera, frame);
+template <>
+void SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Chasm>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
 
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, farZ, farU, 0.0,
-					Constants::JustBelowOne, farNormal, textures.at(chasmData.id), shadingInfo,
-					occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Door)
-		{
-			const VoxelData::DoorData &doorData = voxelData.door;
-			const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
-				voxelX, voxelZ, openDoors);
+	// Render back-face.
+	const VoxelData::ChasmData &chasmData = voxelData.chasm;
 
-			RayHit hit;
-			const bool success = SoftwareRenderer::findInitialDoorIntersection(voxelX, voxelZ,
-				doorData.type, percentOpen, nearPoint, farPoint, camera, ray, voxelGrid, hit);
+	// Find which far face on the chasm was intersected.
+	const VoxelData::Facing farFacing = SoftwareRenderer::getInitialChasmFarFacing(
+		column.voxelX, column.voxelZ, Double2(column.camera.eye.x, column.camera.eye.z),
+		column.ray);
 
-			if (success)
+	// Far.
+	if (chasmData.faceIsVisible(farFacing))
+	{
+		const double farU = [&farPoint = column.farPoint, farFacing]()
+		{
+			const double uVal = [&farPoint, farFacing]()
 			{
-				if (doorData.type == VoxelData::DoorData::Type::Swinging)
+				if (farFacing == VoxelData::Facing::PositiveX)
 				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
+					return farPoint.y - std::floor(farPoint.y);
 				}
-				else if (doorData.type == VoxelData::DoorData::Type::Sliding)
+				else if (farFacing == VoxelData::Facing::NegativeX)
 				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
+					return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
 				}
-				else if (doorData.type == VoxelData::DoorData::Type::Raising)
+				else if (farFacing == VoxelData::Facing::PositiveZ)
 				{
-					// Top point is fixed, bottom point depends on percent open.
-					const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
-					const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
-
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal + raisedAmount,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					// The start of the vertical texture coordinate depends on the percent open.
-					const double vStart = raisedAmount / voxelHeight;
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, vStart, Constants::JustBelowOne, hit.normal,
-						textures.at(doorData.id), shadingInfo, occlusion, frame);
+					return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
 				}
-				else if (doorData.type == VoxelData::DoorData::Type::Splitting)
+				else
 				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
+					return farPoint.x - std::floor(farPoint.x);
 				}
-			}
-		}
-	};
+			}();
 
-	auto drawInitialVoxelAbove = [x, voxelX, voxelZ, &camera, &ray, &wallNormal, &nearPoint,
-		&farPoint, nearZ, farZ, wallU, &shadingInfo, ceilingHeight, &openDoors, &voxelGrid,
-		&textures, &occlusion, &frame](int voxelY)
-	{
-		const uint16_t voxelID = voxelGrid.getVoxel(voxelX, voxelY, voxelZ);
-		const VoxelData &voxelData = voxelGrid.getVoxelData(voxelID);
-		const double voxelHeight = ceilingHeight;
-		const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+			return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
+		}();
 
-		if (voxelData.dataType == VoxelDataType::Wall)
-		{
-			const VoxelData::WallData &wallData = voxelData.wall;
+		const Double3 farNormal = -VoxelData::getNormal(farFacing);
 
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal,
-				nearPoint.y);
-			const Double3 farFloorPoint(
-				farPoint.x,
-				nearFloorPoint.y,
-				farPoint.y);
+		// Wet chasms and lava chasms are unaffected by ceiling height.
+		const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
+			voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
 
-			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				nearFloorPoint, farFloorPoint, camera, frame);
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			voxelYReal + voxelHeight,
+			column.farPoint.y);
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			farCeilingPoint.y - chasmDepth,
+			column.farPoint.y);
 
-			// Floor.
-			SoftwareRenderer::drawPerspectivePixels(x, drawRange, nearPoint, farPoint, nearZ,
-				farZ, -Double3::UnitY, textures.at(wallData.floorID), shadingInfo,
-				occlusion, frame);
-		}
-		else if (voxelData.dataType == VoxelDataType::Floor)
-		{
-			// Do nothing. Floors can only be seen from above.
-		}
-		else if (voxelData.dataType == VoxelDataType::Ceiling)
-		{
-			// Draw bottom of ceiling voxel.
-			const VoxelData::CeilingData &ceilingData = voxelData.ceiling;
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			farCeilingPoint, farFloorPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.farZ, farU, 0.0,
+			Constants::JustBelowOne, farNormal, column.textures.at(chasmData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Door>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DoorData &doorData = voxelData.door;
+	const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
+		column.voxelX, column.voxelZ, column.openDoors);
 
-			const Double3 nearFloorPoint(
-				nearPoint.x,
+	RayHit hit;
+	const bool success = SoftwareRenderer::findInitialDoorIntersection(column.voxelX, column.voxelZ,
+		doorData.type, percentOpen, column.nearPoint, column.farPoint, column.camera, column.ray,
+		column.voxelGrid, hit);
+
+	if (success)
+	{
+		if (doorData.type == VoxelData::DoorData::Type::Swinging)
+		{
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
 				voxelYReal,
-				nearPoint.y);
-			const Double3 farFloorPoint(
-				farPoint.x,
-				nearFloorPoint.y,
-				farPoint.y);
+				doorTopPoint.z);
 
 			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				nearFloorPoint, farFloorPoint, camera, frame);
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			SoftwareRenderer::drawPerspectivePixels(x, drawRange, nearPoint, farPoint, nearZ,
-				farZ, -Double3::UnitY, textures.at(ceilingData.id), shadingInfo,
-				occlusion, frame);
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Raised)
+		else if (doorData.type == VoxelData::DoorData::Type::Sliding)
 		{
-			const VoxelData::RaisedData &raisedData = voxelData.raised;
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal + (raisedData.yOffset * voxelHeight),
-				nearPoint.y);
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			// Draw order depends on the player's Y position relative to the platform.
-			if (camera.eye.y > nearCeilingPoint.y)
-			{
-				// Above platform.
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					nearCeilingPoint.y,
-					farPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					farCeilingPoint, nearCeilingPoint, camera, frame);
-
-				// Ceiling.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRange, farPoint, nearPoint, farZ,
-					nearZ, Double3::UnitY, textures.at(raisedData.ceilingID), shadingInfo,
-					occlusion, frame);
-			}
-			else if (camera.eye.y < nearFloorPoint.y)
-			{
-				// Below platform.
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearFloorPoint, farFloorPoint, camera, frame);
-
-				// Floor.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRange, nearPoint, farPoint, nearZ,
-					farZ, -Double3::UnitY, textures.at(raisedData.floorID), shadingInfo,
-					occlusion, frame);
-			}
-			else
-			{
-				// Between top and bottom.
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					nearCeilingPoint.y,
-					farPoint.y);
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRanges = SoftwareRenderer::makeDrawRangeThreePart(
-					nearCeilingPoint, farCeilingPoint, farFloorPoint, nearFloorPoint,
-					camera, frame);
-
-				// Ceiling.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(0), nearPoint, farPoint,
-					nearZ, farZ, -Double3::UnitY, textures.at(raisedData.ceilingID), shadingInfo,
-					occlusion, frame);
-
-				// Wall.
-				SoftwareRenderer::drawTransparentPixels(x, drawRanges.at(1), farZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-
-				// Floor.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(2), farPoint, nearPoint,
-					farZ, nearZ, Double3::UnitY, textures.at(raisedData.floorID), shadingInfo,
-					occlusion, frame);
-			}
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Diagonal)
+		else if (doorData.type == VoxelData::DoorData::Type::Raising)
 		{
-			const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+			// Top point is fixed, bottom point depends on percent open.
+			const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
+			const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = diagData.type1 ?
-				SoftwareRenderer::findDiag1Intersection(voxelX, voxelZ, nearPoint, farPoint, hit) :
-				SoftwareRenderer::findDiag2Intersection(voxelX, voxelZ, nearPoint, farPoint, hit);
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal + raisedAmount,
+				doorTopPoint.z);
 
-			if (success)
-			{
-				const Double3 diagTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight,
-					hit.point.y);
-				const Double3 diagBottomPoint(
-					diagTopPoint.x,
-					voxelYReal,
-					diagTopPoint.z);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					diagTopPoint, diagBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawPixels(x, drawRange, nearZ + hit.innerZ, hit.u, 0.0,
-					Constants::JustBelowOne, hit.normal, textures.at(diagData.id), shadingInfo,
-					occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::TransparentWall)
-		{
-			// Do nothing. Transparent walls have no back-faces.
-		}
-		else if (voxelData.dataType == VoxelDataType::Edge)
-		{
-			const VoxelData::EdgeData &edgeData = voxelData.edge;
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = SoftwareRenderer::findInitialEdgeIntersection(
-				voxelX, voxelZ, edgeData.facing, edgeData.flipped, nearPoint, farPoint,
-				camera, ray, hit);
+			// The start of the vertical texture coordinate depends on the percent open.
+			const double vStart = raisedAmount / voxelHeight;
 
-			if (success)
-			{
-				const Double3 edgeTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight + edgeData.yOffset,
-					hit.point.y);
-				const Double3 edgeBottomPoint(
-					hit.point.x,
-					voxelYReal + edgeData.yOffset,
-					hit.point.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					edgeTopPoint, edgeBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ, hit.u,
-					0.0, Constants::JustBelowOne, hit.normal, textures.at(edgeData.id),
-					shadingInfo, occlusion, frame);
-			}
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, vStart, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Chasm)
+		else if (doorData.type == VoxelData::DoorData::Type::Splitting)
 		{
-			// Ignore. Chasms should never be above the player's voxel.
-		}
-		else if (voxelData.dataType == VoxelDataType::Door)
-		{
-			const VoxelData::DoorData &doorData = voxelData.door;
-			const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
-				voxelX, voxelZ, openDoors);
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
-			RayHit hit;
-			const bool success = SoftwareRenderer::findInitialDoorIntersection(voxelX, voxelZ,
-				doorData.type, percentOpen, nearPoint, farPoint, camera, ray, voxelGrid, hit);
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			if (success)
-			{
-				if (doorData.type == VoxelData::DoorData::Type::Swinging)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Sliding)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Raising)
-				{
-					// Top point is fixed, bottom point depends on percent open.
-					const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
-					const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
-
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal + raisedAmount,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					// The start of the vertical texture coordinate depends on the percent open.
-					const double vStart = raisedAmount / voxelHeight;
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, vStart, Constants::JustBelowOne, hit.normal,
-						textures.at(doorData.id), shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Splitting)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-			}
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-	};
+	}
+}
 
-	// Relative Y voxel coordinate of the camera, compensating for the ceiling height.
-	const int adjustedVoxelY = camera.getAdjustedEyeVoxelY(ceilingHeight);
+template <VoxelDataType DataType>
+void SoftwareRenderer::drawInitialVoxelAbove(int, const VoxelData&, const VoxelColumnContext&)
+{
+	// Air, and data types with nothing visible from this position.
+}
 
-	// Draw the player's current voxel first.
-	drawInitialVoxel(adjustedVoxelY);
+template <>
+void SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Wall>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::WallData &wallData = voxelData.wall;
+
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal,
+		column.nearPoint.y);
+	const Double3 farFloorPoint(
+		column.farPoint.x,
+		nearFloorPoint.y,
+		column.farPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+	// Floor.
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.nearPoint, column.farPoint,
+		column.nearZ, column.farZ, -Double3::UnitY, column.textures.at(wallData.floorID),
+		column.shadingInfo, column.occlusion, column.frame);
+}
 
-	// Draw voxels below the player's voxel.
-	for (int voxelY = (adjustedVoxelY - 1); voxelY >= 0; voxelY--)
-	{
-		drawInitialVoxelBelow(voxelY);
-	}
+template <>
+void SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Ceiling>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw bottom of ceiling voxel.
+	const VoxelData::CeilingData &ceilingData = voxelData.ceiling;
+
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal,
+		column.nearPoint.y);
+	const Double3 farFloorPoint(
+		column.farPoint.x,
+		nearFloorPoint.y,
+		column.farPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.nearPoint, column.farPoint,
+		column.nearZ, column.farZ, -Double3::UnitY, column.textures.at(ceilingData.id),
+		column.shadingInfo, column.occlusion, column.frame);
+}
 
-	// Draw voxels above the player's voxel.
-	for (int voxelY = (adjustedVoxelY + 1); voxelY < voxelGrid.getHeight(); voxelY++)
+template <>
+void SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Raised>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::RaisedData &raisedData = voxelData.raised;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal + (raisedData.yOffset * voxelHeight),
+		column.nearPoint.y);
+
+	// Draw order depends on the player's Y position relative to the platform.
+	if (column.camera.eye.y > nearCeilingPoint.y)
+	{
+		// Above platform.
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			nearCeilingPoint.y,
+			column.farPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			farCeilingPoint, nearCeilingPoint, column.camera, column.frame);
+
+		// Ceiling.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.farPoint,
+			column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+			column.textures.at(raisedData.ceilingID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else if (column.camera.eye.y < nearFloorPoint.y)
+	{
+		// Below platform.
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+		// Floor.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(raisedData.floorID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else
 	{
-		drawInitialVoxelAbove(voxelY);
+		// Between top and bottom.
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			nearCeilingPoint.y,
+			column.farPoint.y);
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRanges = SoftwareRenderer::makeDrawRangeThreePart(
+			nearCeilingPoint, farCeilingPoint, farFloorPoint, nearFloorPoint,
+			column.camera, column.frame);
+
+		// Ceiling.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(0), column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(raisedData.ceilingID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Wall.
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRanges.at(1), column.farZ,
+			column.wallU, raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Floor.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(2), column.farPoint,
+			column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+			column.textures.at(raisedData.floorID), column.shadingInfo, column.occlusion,
+			column.frame);
 	}
 }
 
-void SoftwareRenderer::drawVoxelColumn(int x, int voxelX, int voxelZ, const Camera &camera,
-	const Ray &ray, VoxelData::Facing facing, const Double2 &nearPoint, const Double2 &farPoint,
-	double nearZ, double farZ, const ShadingInfo &shadingInfo, double ceilingHeight,
-	const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
-	const std::vector<VoxelTexture> &textures, OcclusionData &occlusion, const FrameView &frame)
+template <>
+void SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Diagonal>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
 {
-	// Much of the code here is duplicated from the initial voxel column drawing method, but
-	// there are a couple differences, like the horizontal texture coordinate being flipped,
-	// and the drawing orders being slightly modified. The reason for having so much code is
-	// so we cover all the different ray casting cases efficiently. It would slow down this 
-	// method if it had to worry about an "initialColumn" boolean that's always false in the
-	// general case.
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = diagData.type1 ? SoftwareRenderer::findDiag1Intersection(column.voxelX,
+		column.voxelZ, column.nearPoint, column.farPoint,
+		hit) : SoftwareRenderer::findDiag2Intersection(column.voxelX, column.voxelZ,
+		column.nearPoint, column.farPoint, hit);
+
+	if (success)
+	{
+		const Double3 diagTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight,
+			hit.point.y);
+		const Double3 diagBottomPoint(
+			diagTopPoint.x,
+			voxelYReal,
+			diagTopPoint.z);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			diagTopPoint, diagBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawPixels(column.x, drawRange, column.nearZ + hit.innerZ, hit.u, 0.0,
+			Constants::JustBelowOne, hit.normal, column.textures.at(diagData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-	// When clamping Y values for drawing ranges, subtract 0.5 from starts and add 0.5 to 
-	// ends before converting to integers because the drawing methods sample at the center 
-	// of pixels. The clamping function depends on which side of the range is being clamped; 
-	// either way, the drawing range should be contained within the projected range at the 
-	// sub-pixel level. This ensures that the vertical texture coordinate is always within 0->1.
+template <>
+void SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Edge>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::EdgeData &edgeData = voxelData.edge;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = SoftwareRenderer::findInitialEdgeIntersection(
+		column.voxelX, column.voxelZ, edgeData.facing, edgeData.flipped, column.nearPoint,
+		column.farPoint, column.camera, column.ray, hit);
+
+	if (success)
+	{
+		const Double3 edgeTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight + edgeData.yOffset,
+			hit.point.y);
+		const Double3 edgeBottomPoint(
+			hit.point.x,
+			voxelYReal + edgeData.yOffset,
+			hit.point.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			edgeTopPoint, edgeBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+			hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(edgeData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-	// Horizontal texture coordinate for the wall, potentially shared between multiple voxels
-	// in this voxel column.
-	const double wallU = [&nearPoint, facing]()
-	{
-		const double uVal = [&nearPoint, facing]()
-		{
-			if (facing == VoxelData::Facing::PositiveX)
-			{
-				return Constants::JustBelowOne - (nearPoint.y - std::floor(nearPoint.y));
-			}
-			else if (facing == VoxelData::Facing::NegativeX)
-			{
-				return nearPoint.y - std::floor(nearPoint.y);
-			}
-			else if (facing == VoxelData::Facing::PositiveZ)
-			{
-				return nearPoint.x - std::floor(nearPoint.x);
-			}
-			else
-			{
-				return Constants::JustBelowOne - (nearPoint.x - std::floor(nearPoint.x));
-			}
-		}();
+template <>
+void SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Door>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
 
-		return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
-	}();
+	const VoxelData::DoorData &doorData = voxelData.door;
+	const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
+		column.voxelX, column.voxelZ, column.openDoors);
 
-	// Normal of the wall for the incoming ray, potentially shared between multiple voxels in
-	// this voxel column.
-	const Double3 wallNormal = VoxelData::getNormal(facing);
+	RayHit hit;
+	const bool success = SoftwareRenderer::findInitialDoorIntersection(column.voxelX, column.voxelZ,
+		doorData.type, percentOpen, column.nearPoint, column.farPoint, column.camera, column.ray,
+		column.voxelGrid, hit);
 
-	auto drawVoxel = [x, voxelX, voxelZ, &camera, &ray, facing, &wallNormal, &nearPoint,
-		&farPoint, nearZ, farZ, wallU, &shadingInfo, ceilingHeight, &openDoors, &voxelGrid,
-		&textures, &occlusion, &frame](int voxelY)
+	if (success)
 	{
-		const uint16_t voxelID = voxelGrid.getVoxel(voxelX, voxelY, voxelZ);
-		const VoxelData &voxelData = voxelGrid.getVoxelData(voxelID);
-		const double voxelHeight = ceilingHeight;
-		const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
-
-		if (voxelData.dataType == VoxelDataType::Wall)
+		if (doorData.type == VoxelData::DoorData::Type::Swinging)
 		{
-			// Draw side.
-			const VoxelData::WallData &wallData = voxelData.wall;
-
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
+			const Double3 doorTopPoint(
+				hit.point.x,
 				voxelYReal + voxelHeight,
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
 				voxelYReal,
-				nearPoint.y);
+				doorTopPoint.z);
 
 			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				nearCeilingPoint, nearFloorPoint, camera, frame);
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			SoftwareRenderer::drawPixels(x, drawRange, nearZ, wallU, 0.0, Constants::JustBelowOne,
-				wallNormal, textures.at(wallData.sideID), shadingInfo, occlusion, frame);
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Floor)
+		else if (doorData.type == VoxelData::DoorData::Type::Sliding)
 		{
-			// Do nothing. Floors can only be seen from above.
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
+
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
+
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Ceiling)
+		else if (doorData.type == VoxelData::DoorData::Type::Raising)
 		{
-			// Draw bottom of ceiling voxel if the camera is below it.
-			if (camera.eye.y < voxelYReal)
-			{
-				const VoxelData::CeilingData &ceilingData = voxelData.ceiling;
-
-				const Double3 nearFloorPoint(
-					nearPoint.x,
-					voxelYReal,
-					nearPoint.y);
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearFloorPoint, farFloorPoint, camera, frame);
-
-				SoftwareRenderer::drawPerspectivePixels(x, drawRange, nearPoint, farPoint, nearZ,
-					farZ, -Double3::UnitY, textures.at(ceilingData.id), shadingInfo,
-					occlusion, frame);
-			}
+			// Top point is fixed, bottom point depends on percent open.
+			const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
+			const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
+
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal + raisedAmount,
+				doorTopPoint.z);
+
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
+
+			// The start of the vertical texture coordinate depends on the percent open.
+			const double vStart = raisedAmount / voxelHeight;
+
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, vStart, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Raised)
+		else if (doorData.type == VoxelData::DoorData::Type::Splitting)
 		{
-			const VoxelData::RaisedData &raisedData = voxelData.raised;
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
+
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal + (raisedData.yOffset * voxelHeight),
-				nearPoint.y);
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
+		}
+	}
+}
 
-			// Draw order depends on the player's Y position relative to the platform.
-			if (camera.eye.y > nearCeilingPoint.y)
-			{
-				// Above platform.
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					nearCeilingPoint.y,
-					farPoint.y);
-
-				const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
-					farCeilingPoint, nearCeilingPoint, nearFloorPoint, camera, frame);
-
-				// Ceiling.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(0), farPoint, nearPoint,
-					farZ, nearZ, Double3::UnitY, textures.at(raisedData.ceilingID), shadingInfo,
-					occlusion, frame);
-
-				// Wall.
-				SoftwareRenderer::drawTransparentPixels(x, drawRanges.at(1), nearZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-			}
-			else if (camera.eye.y < nearFloorPoint.y)
-			{
-				// Below platform.
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
-					nearCeilingPoint, nearFloorPoint, farFloorPoint, camera, frame);
-
-				// Wall.
-				SoftwareRenderer::drawTransparentPixels(x, drawRanges.at(0), nearZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-
-				// Floor.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(1), nearPoint, farPoint,
-					nearZ, farZ, -Double3::UnitY, textures.at(raisedData.floorID), shadingInfo,
-					occlusion, frame);
-			}
-			else
+template <VoxelDataType DataType>
+void SoftwareRenderer::drawVoxel(int, const VoxelData&, const VoxelColumnContext&)
+{
+	// Air, and data types with nothing visible from this position.
+}
+
+template <>
+void SoftwareRenderer::drawVoxel<VoxelDataType::Wall>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw side.
+	const VoxelData::WallData &wallData = voxelData.wall;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + voxelHeight,
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal,
+		column.nearPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+	SoftwareRenderer::drawPixels(column.x, drawRange, column.nearZ, column.wallU, 0.0,
+		Constants::JustBelowOne, column.wallNormal, column.textures.at(wallData.sideID),
+		column.shadingInfo, column.occlusion, column.frame);
+}
+
+template <>
+void SoftwareRenderer::drawVoxel<VoxelDataType::Ceiling>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw bottom of ceiling voxel if the camera is below it.
+	if (column.camera.eye.y < voxelYReal)
+	{
+		const VoxelData::CeilingData &ceilingData = voxelData.ceiling;
+
+		const Double3 nearFloorPoint(
+			column.nearPoint.x,
+			voxelYReal,
+			column.nearPoint.y);
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(ceilingData.id), column.shadingInfo, column.occlusion, column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawVoxel<VoxelDataType::Raised>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::RaisedData &raisedData = voxelData.raised;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal + (raisedData.yOffset * voxelHeight),
+		column.nearPoint.y);
+
+	// Draw order depends on the player's Y position relative to the platform.
+	if (column.camera.eye.y > nearCeilingPoint.y)
+	{
+		// Above platform.
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			nearCeilingPoint.y,
+			column.farPoint.y);
+
+		const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
+			farCeilingPoint, nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+		// Ceiling.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(0), column.farPoint,
+			column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+			column.textures.at(raisedData.ceilingID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Wall.
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRanges.at(1), column.nearZ,
+			column.wallU, raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else if (column.camera.eye.y < nearFloorPoint.y)
+	{
+		// Below platform.
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
+			nearCeilingPoint, nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+		// Wall.
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRanges.at(0), column.nearZ,
+			column.wallU, raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Floor.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(1), column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(raisedData.floorID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else
+	{
+		// Between top and bottom.
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, column.wallU,
+			raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawVoxel<VoxelDataType::Diagonal>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = diagData.type1 ? SoftwareRenderer::findDiag1Intersection(column.voxelX,
+		column.voxelZ, column.nearPoint, column.farPoint,
+		hit) : SoftwareRenderer::findDiag2Intersection(column.voxelX, column.voxelZ,
+		column.nearPoint, column.farPoint, hit);
+
+	if (success)
+	{
+		const Double3 diagTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight,
+			hit.point.y);
+		const Double3 diagBottomPoint(
+			diagTopPoint.x,
+			voxelYReal,
+			diagTopPoint.z);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			diagTopPoint, diagBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawPixels(column.x, drawRange, column.nearZ + hit.innerZ, hit.u, 0.0,
+			Constants::JustBelowOne, hit.normal, column.textures.at(diagData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawVoxel<VoxelDataType::TransparentWall>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw transparent side.
+	const VoxelData::TransparentWallData &transparentWallData = voxelData.transparentWall;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + voxelHeight,
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal,
+		column.nearPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+	SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, column.wallU, 0.0,
+		Constants::JustBelowOne, column.wallNormal, column.textures.at(transparentWallData.id),
+		column.shadingInfo, column.occlusion, column.frame);
+}
+
+template <>
+void SoftwareRenderer::drawVoxel<VoxelDataType::Edge>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::EdgeData &edgeData = voxelData.edge;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = SoftwareRenderer::findEdgeIntersection(column.voxelX, column.voxelZ,
+		edgeData.facing, edgeData.flipped, column.facing, column.nearPoint, column.farPoint,
+		column.wallU, column.camera, column.ray, hit);
+
+	if (success)
+	{
+		const Double3 edgeTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight + edgeData.yOffset,
+			hit.point.y);
+		const Double3 edgeBottomPoint(
+			hit.point.x,
+			voxelYReal + edgeData.yOffset,
+			hit.point.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			edgeTopPoint, edgeBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+			hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(edgeData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawVoxel<VoxelDataType::Chasm>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Render front and back-faces.
+	const VoxelData::ChasmData &chasmData = voxelData.chasm;
+
+	// Find which faces on the chasm were intersected.
+	const VoxelData::Facing nearFacing = column.facing;
+	const VoxelData::Facing farFacing = SoftwareRenderer::getChasmFarFacing(
+		column.voxelX, column.voxelZ, nearFacing, column.camera, column.ray);
+
+	// Near.
+	if (chasmData.faceIsVisible(nearFacing))
+	{
+		const double nearU = Constants::JustBelowOne - column.wallU;
+		const Double3 nearNormal = column.wallNormal;
+
+		// Wet chasms and lava chasms are unaffected by ceiling height.
+		const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
+			voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
+
+		const Double3 nearCeilingPoint(
+			column.nearPoint.x,
+			voxelYReal + voxelHeight,
+			column.nearPoint.y);
+		const Double3 nearFloorPoint(
+			column.nearPoint.x,
+			nearCeilingPoint.y - chasmDepth,
+			column.nearPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, nearU, 0.0,
+			Constants::JustBelowOne, nearNormal, column.textures.at(chasmData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+
+	// Far.
+	if (chasmData.faceIsVisible(farFacing))
+	{
+		const double farU = [&farPoint = column.farPoint, farFacing]()
+		{
+			const double uVal = [&farPoint, farFacing]()
 			{
-				// Between top and bottom.
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearCeilingPoint, nearFloorPoint, camera, frame);
+				if (farFacing == VoxelData::Facing::PositiveX)
+				{
+					return farPoint.y - std::floor(farPoint.y);
+				}
+				else if (farFacing == VoxelData::Facing::NegativeX)
+				{
+					return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
+				}
+				else if (farFacing == VoxelData::Facing::PositiveZ)
+				{
+					return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
+				}
+				else
+				{
+					return farPoint.x - std::floor(farPoint.x);
+				}
+			}();
 
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Diagonal)
+			return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
+		}();
+
+		const Double3 farNormal = -VoxelData::getNormal(farFacing);
+
+		// Wet chasms and lava chasms are unaffected by ceiling height.
+		const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
+			voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
+
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			voxelYReal + voxelHeight,
+			column.farPoint.y);
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			farCeilingPoint.y - chasmDepth,
+			column.farPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			farCeilingPoint, farFloorPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.farZ, farU, 0.0,
+			Constants::JustBelowOne, farNormal, column.textures.at(chasmData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawVoxel<VoxelDataType::Door>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DoorData &doorData = voxelData.door;
+	const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
+		column.voxelX, column.voxelZ, column.openDoors);
+
+	RayHit hit;
+	const bool success = SoftwareRenderer::findDoorIntersection(column.voxelX, column.voxelZ,
+		doorData.type, percentOpen, column.facing, column.nearPoint, column.farPoint,
+		column.wallU, hit);
+
+	if (success)
+	{
+		if (doorData.type == VoxelData::DoorData::Type::Swinging)
 		{
-			const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = diagData.type1 ?
-				SoftwareRenderer::findDiag1Intersection(voxelX, voxelZ, nearPoint, farPoint, hit) :
-				SoftwareRenderer::findDiag2Intersection(voxelX, voxelZ, nearPoint, farPoint, hit);
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			if (success)
-			{
-				const Double3 diagTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight,
-					hit.point.y);
-				const Double3 diagBottomPoint(
-					diagTopPoint.x,
-					voxelYReal,
-					diagTopPoint.z);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					diagTopPoint, diagBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawPixels(x, drawRange, nearZ + hit.innerZ, hit.u, 0.0,
-					Constants::JustBelowOne, hit.normal, textures.at(diagData.id), shadingInfo,
-					occlusion, frame);
-			}
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::TransparentWall)
+		else if (doorData.type == VoxelData::DoorData::Type::Sliding)
 		{
-			// Draw transparent side.
-			const VoxelData::TransparentWallData &transparentWallData = voxelData.transparentWall;
-
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
+			const Double3 doorTopPoint(
+				hit.point.x,
 				voxelYReal + voxelHeight,
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
 				voxelYReal,
-				nearPoint.y);
+				doorTopPoint.z);
 
 			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				nearCeilingPoint, nearFloorPoint, camera, frame);
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, wallU, 0.0,
-				Constants::JustBelowOne, wallNormal, textures.at(transparentWallData.id),
-				shadingInfo, occlusion, frame);
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, hit.u, 0.0,
+				Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Edge)
+		else if (doorData.type == VoxelData::DoorData::Type::Raising)
 		{
-			const VoxelData::EdgeData &edgeData = voxelData.edge;
+			// Top point is fixed, bottom point depends on percent open.
+			const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
+			const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = SoftwareRenderer::findEdgeIntersection(voxelX, voxelZ,
-				edgeData.facing, edgeData.flipped, facing, nearPoint, farPoint, wallU,
-				camera, ray, hit);
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal + raisedAmount,
+				doorTopPoint.z);
 
-			if (success)
-			{
-				const Double3 edgeTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight + edgeData.yOffset,
-					hit.point.y);
-				const Double3 edgeBottomPoint(
-					hit.point.x,
-					voxelYReal + edgeData.yOffset,
-					hit.point.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					edgeTopPoint, edgeBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ, hit.u,
-					0.0, Constants::JustBelowOne, hit.normal, textures.at(edgeData.id),
-					shadingInfo, occlusion, frame);
-			}
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
+
+			// The start of the vertical texture coordinate depends on the percent open.
+			const double vStart = raisedAmount / voxelHeight;
+
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, hit.u,
+				vStart, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Chasm)
+		else if (doorData.type == VoxelData::DoorData::Type::Splitting)
 		{
-			// Render front and back-faces.
-			const VoxelData::ChasmData &chasmData = voxelData.chasm;
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
-			// Find which faces on the chasm were intersected.
-			const VoxelData::Facing nearFacing = facing;
-			const VoxelData::Facing farFacing = SoftwareRenderer::getChasmFarFacing(
-				voxelX, voxelZ, nearFacing, camera, ray);
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			// Near.
-			if (chasmData.faceIsVisible(nearFacing))
-			{
-				const double nearU = Constants::JustBelowOne - wallU;
-				const Double3 nearNormal = wallNormal;
-				
-				// Wet chasms and lava chasms are unaffected by ceiling height.
-				const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
-					voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
-
-				const Double3 nearCeilingPoint(
-					nearPoint.x,
-					voxelYReal + voxelHeight,
-					nearPoint.y);
-				const Double3 nearFloorPoint(
-					nearPoint.x,
-					nearCeilingPoint.y - chasmDepth,
-					nearPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearCeilingPoint, nearFloorPoint, camera, frame);
-
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, nearU, 0.0,
-					Constants::JustBelowOne, nearNormal, textures.at(chasmData.id),
-					shadingInfo, occlusion, frame);
-			}
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, hit.u, 0.0,
+				Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
+		}
+	}
+}
 
-			// Far.
-			if (chasmData.faceIsVisible(farFacing))
-			{
-				const double farU = [&farPoint, farFacing]()
-				{
-					const double uVal = [&farPoint, farFacing]()
-					{
-						if (farFacing == VoxelData::Facing::PositiveX)
-						{
-							return farPoint.y - std::floor(farPoint.y);
-						}
-						else if (farFacing == VoxelData::Facing::NegativeX)
-						{
-							return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
-						}
-						else if (farFacing == VoxelData::Facing::PositiveZ)
-						{
-							return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
-						}
-						else
-						{
-							return farPoint.x - std::floor(farPoint.x);
-						}
-					}();
+template <VoxelDataType DataType>
+void SoftwareRenderer::drawVoxelBelow(int, const VoxelData&, const VoxelColumnContext&)
+{
+	// Air, and data types with nothing visible from this position.
+}
 
-					return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
-				}();
+template <>
+void SoftwareRenderer::drawVoxelBelow<VoxelDataType::Wall>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::WallData &wallData = voxelData.wall;
+
+	const Double3 farCeilingPoint(
+		column.farPoint.x,
+		voxelYReal + voxelHeight,
+		column.farPoint.y);
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		farCeilingPoint.y,
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal,
+		column.nearPoint.y);
+
+	const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
+		farCeilingPoint, nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+	// Ceiling.
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(0), column.farPoint,
+		column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+		column.textures.at(wallData.ceilingID), column.shadingInfo, column.occlusion, column.frame);
+
+	// Wall.
+	SoftwareRenderer::drawPixels(column.x, drawRanges.at(1), column.nearZ, column.wallU, 0.0,
+		Constants::JustBelowOne, column.wallNormal, column.textures.at(wallData.sideID),
+		column.shadingInfo, column.occlusion, column.frame);
+}
 
-				const Double3 farNormal = -VoxelData::getNormal(farFacing);
+template <>
+void SoftwareRenderer::drawVoxelBelow<VoxelDataType::Floor>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw top of floor voxel.
+	const VoxelData::FloorData &floorData = voxelData.floor;
+
+	const Double3 farCeilingPoint(
+		column.farPoint.x,
+		voxelYReal + voxelHeight,
+		column.farPoint.y);
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		farCeilingPoint.y,
+		column.nearPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		farCeilingPoint, nearCeilingPoint, column.camera, column.frame);
+
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.farPoint, column.nearPoint,
+		column.farZ, column.nearZ, Double3::UnitY, column.textures.at(floorData.id),
+		column.shadingInfo, column.occlusion, column.frame);
+}
+
+template <>
+void SoftwareRenderer::drawVoxelBelow<VoxelDataType::Raised>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::RaisedData &raisedData = voxelData.raised;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal + (raisedData.yOffset * voxelHeight),
+		column.nearPoint.y);
+
+	// Draw order depends on the player's Y position relative to the platform.
+	if (column.camera.eye.y > nearCeilingPoint.y)
+	{
+		// Above platform.
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			nearCeilingPoint.y,
+			column.farPoint.y);
+
+		const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
+			farCeilingPoint, nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+		// Ceiling.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(0), column.farPoint,
+			column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+			column.textures.at(raisedData.ceilingID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Wall.
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRanges.at(1), column.nearZ,
+			column.wallU, raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else if (column.camera.eye.y < nearFloorPoint.y)
+	{
+		// Below platform.
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
+			nearCeilingPoint, nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+		// Wall.
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRanges.at(0), column.nearZ,
+			column.wallU, raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Floor.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(1), column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(raisedData.floorID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else
+	{
+		// Between top and bottom.
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
 
-				// Wet chasms and lava chasms are unaffected by ceiling height.
-				const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
-					voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, column.wallU,
+			raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+}
 
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					voxelYReal + voxelHeight,
-					farPoint.y);
-				const Double3 farFloorPoint(
-					farPoint.x,
-					farCeilingPoint.y - chasmDepth,
-					farPoint.y);
+template <>
+void SoftwareRenderer::drawVoxelBelow<VoxelDataType::Diagonal>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = diagData.type1 ? SoftwareRenderer::findDiag1Intersection(column.voxelX,
+		column.voxelZ, column.nearPoint, column.farPoint,
+		hit) : SoftwareRenderer::findDiag2Intersection(column.voxelX, column.voxelZ,
+		column.nearPoint, column.farPoint, hit);
+
+	if (success)
+	{
+		const Double3 diagTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight,
+			hit.point.y);
+		const Double3 diagBottomPoint(
+			diagTopPoint.x,
+			voxelYReal,
+			diagTopPoint.z);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			diagTopPoint, diagBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawPixels(column.x, drawRange, column.nearZ + hit.innerZ, hit.u, 0.0,
+			Constants::JustBelowOne, hit.normal, column.textures.at(diagData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					farCeilingPoint, farFloorPoint, camera, frame);
+template <>
+void SoftwareRenderer::drawVoxelBelow<VoxelDataType::TransparentWall>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw transparent side.
+	const VoxelData::TransparentWallData &transparentWallData = voxelData.transparentWall;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + voxelHeight,
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal,
+		column.nearPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+	SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, column.wallU, 0.0,
+		Constants::JustBelowOne, column.wallNormal, column.textures.at(transparentWallData.id),
+		column.shadingInfo, column.occlusion, column.frame);
+}
 
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, farZ, farU, 0.0,
-					Constants::JustBelowOne, farNormal, textures.at(chasmData.id),
-					shadingInfo, occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Door)
-		{
-			const VoxelData::DoorData &doorData = voxelData.door;
-			const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
-				voxelX, voxelZ, openDoors);
+template <>
+void SoftwareRenderer::drawVoxelBelow<VoxelDataType::Edge>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::EdgeData &edgeData = voxelData.edge;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = SoftwareRenderer::findEdgeIntersection(column.voxelX, column.voxelZ,
+		edgeData.facing, edgeData.flipped, column.facing, column.nearPoint, column.farPoint,
+		column.wallU, column.camera, column.ray, hit);
+
+	if (success)
+	{
+		const Double3 edgeTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight + edgeData.yOffset,
+			hit.point.y);
+		const Double3 edgeBottomPoint(
+			hit.point.x,
+			voxelYReal + edgeData.yOffset,
+			hit.point.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			edgeTopPoint, edgeBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+			hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(edgeData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
 
-			RayHit hit;
-			const bool success = SoftwareRenderer::findDoorIntersection(voxelX, voxelZ,
-				doorData.type, percentOpen, facing, nearPoint, farPoint, wallU, hit);
+template <>
+void SoftwareRenderer::drawVoxelBelow<VoxelDataType::Chasm>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Render front and back-faces.
+	const VoxelData::ChasmData &chasmData = voxelData.chasm;
+
+	// Find which faces on the chasm were intersected.
+	const VoxelData::Facing nearFacing = column.facing;
+	const VoxelData::Facing farFacing = SoftwareRenderer::getChasmFarFacing(
+		column.voxelX, column.voxelZ, nearFacing, column.camera, column.ray);
+
+	// Near.
+	if (chasmData.faceIsVisible(nearFacing))
+	{
+		const double nearU = Constants::JustBelowOne - column.wallU;
+		const Double3 nearNormal = column.wallNormal;
+
+		// Wet chasms and lava chasms are unaffected by ceiling height.
+		const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
+			voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
+
+		const Double3 nearCeilingPoint(
+			column.nearPoint.x,
+			voxelYReal + voxelHeight,
+			column.nearPoint.y);
+		const Double3 nearFloorPoint(
+			column.nearPoint.x,
+			nearCeilingPoint.y - chasmDepth,
+			column.nearPoint.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, nearU, 0.0,
+			Constants::JustBelowOne, nearNormal, column.textures.at(chasmData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
 
-			if (success)
+	// Far.
+	if (chasmData.faceIsVisible(farFacing))
+	{
+		const double farU = [&farPoint = column.farPoint, farFacing]()
+		{
+			const double uVal = [&farPoint, farFacing]()
 			{
-				if (doorData.type == VoxelData::DoorData::Type::Swinging)
+				if (farFacing == VoxelData::Facing::PositiveX)
 				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
+					return farPoint.y - std::floor(farPoint.y);
 				}
-				else if (doorData.type == VoxelData::DoorData::Type::Sliding)
+				else if (farFacing == VoxelData::Facing::NegativeX)
 				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, hit.u, 0.0,
-						Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
+					return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
 				}
-				else if (doorData.type == VoxelData::DoorData::Type::Raising)
+				else if (farFacing == VoxelData::Facing::PositiveZ)
 				{
-					// Top point is fixed, bottom point depends on percent open.
-					const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
-					const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
-
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal + raisedAmount,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					// The start of the vertical texture coordinate depends on the percent open.
-					const double vStart = raisedAmount / voxelHeight;
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, hit.u, vStart,
-						Constants::JustBelowOne, hit.normal, textures.at(doorData.id), shadingInfo,
-						occlusion, frame);
+					return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
 				}
-				else if (doorData.type == VoxelData::DoorData::Type::Splitting)
+				else
 				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, hit.u, 0.0,
-						Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
+					return farPoint.x - std::floor(farPoint.x);
 				}
-			}
-		}
-	};
+			}();
 
-	auto drawVoxelBelow = [x, voxelX, voxelZ, &camera, &ray, facing, &wallNormal, &nearPoint,
-		&farPoint, nearZ, farZ, wallU, &shadingInfo, ceilingHeight, &openDoors, &voxelGrid,
-		&textures, &occlusion, &frame](int voxelY)
-	{
-		const uint16_t voxelID = voxelGrid.getVoxel(voxelX, voxelY, voxelZ);
-		const VoxelData &voxelData = voxelGrid.getVoxelData(voxelID);
-		const double voxelHeight = ceilingHeight;
-		const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+			return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
+		}();
 
-		if (voxelData.dataType == VoxelDataType::Wall)
-		{
-			const VoxelData::WallData &wallData = voxelData.wall;
+		const Double3 farNormal = -VoxelData::getNormal(farFacing);
 
-			const Double3 farCeilingPoint(
-				farPoint.x,
-				voxelYReal + voxelHeight,
-				farPoint.y);
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				farCeilingPoint.y,
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal,
-				nearPoint.y);
+		// Wet chasms and lava chasms are unaffected by ceiling height.
+		const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
+			voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
 
-			const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
-				farCeilingPoint, nearCeilingPoint, nearFloorPoint, camera, frame);
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			voxelYReal + voxelHeight,
+			column.farPoint.y);
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			farCeilingPoint.y - chasmDepth,
+			column.farPoint.y);
 
-			// Ceiling.
-			SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(0), farPoint, nearPoint, farZ,
-				nearZ, Double3::UnitY, textures.at(wallData.ceilingID), shadingInfo,
-				occlusion, frame);
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			farCeilingPoint, farFloorPoint, column.camera, column.frame);
 
-			// Wall.
-			SoftwareRenderer::drawPixels(x, drawRanges.at(1), nearZ, wallU, 0.0,
-				Constants::JustBelowOne, wallNormal, textures.at(wallData.sideID), shadingInfo,
-				occlusion, frame);
-		}
-		else if (voxelData.dataType == VoxelDataType::Floor)
-		{
-			// Draw top of floor voxel.
-			const VoxelData::FloorData &floorData = voxelData.floor;
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.farZ, farU, 0.0,
+			Constants::JustBelowOne, farNormal, column.textures.at(chasmData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawVoxelBelow<VoxelDataType::Door>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DoorData &doorData = voxelData.door;
+	const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
+		column.voxelX, column.voxelZ, column.openDoors);
+
+	RayHit hit;
+	const bool success = SoftwareRenderer::findDoorIntersection(column.voxelX, column.voxelZ,
+		doorData.type, percentOpen, column.facing, column.nearPoint, column.farPoint,
+		column.wallU, hit);
 
-			const Double3 farCeilingPoint(
-				farPoint.x,
+	if (success)
+	{
+		if (doorData.type == VoxelData::DoorData::Type::Swinging)
+		{
+			const Double3 doorTopPoint(
+				hit.point.x,
 				voxelYReal + voxelHeight,
-				farPoint.y);
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				farCeilingPoint.y,
-				nearPoint.y);
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
 			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				farCeilingPoint, nearCeilingPoint, camera, frame);
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			SoftwareRenderer::drawPerspectivePixels(x, drawRange, farPoint, nearPoint, farZ,
-				nearZ, Double3::UnitY, textures.at(floorData.id), shadingInfo, 
-				occlusion, frame);
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Ceiling)
+		else if (doorData.type == VoxelData::DoorData::Type::Sliding)
 		{
-			// Do nothing. Ceilings can only be seen from below.
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
+
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
+
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, hit.u, 0.0,
+				Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Raised)
+		else if (doorData.type == VoxelData::DoorData::Type::Raising)
 		{
-			const VoxelData::RaisedData &raisedData = voxelData.raised;
+			// Top point is fixed, bottom point depends on percent open.
+			const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
+			const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
 
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal + (raisedData.yOffset * voxelHeight),
-				nearPoint.y);
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal + raisedAmount,
+				doorTopPoint.z);
 
-			// Draw order depends on the player's Y position relative to the platform.
-			if (camera.eye.y > nearCeilingPoint.y)
-			{
-				// Above platform.
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					nearCeilingPoint.y,
-					farPoint.y);
-
-				const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
-					farCeilingPoint, nearCeilingPoint, nearFloorPoint, camera, frame);
-
-				// Ceiling.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(0), farPoint, nearPoint,
-					farZ, nearZ, Double3::UnitY, textures.at(raisedData.ceilingID), shadingInfo,
-					occlusion, frame);
-
-				// Wall.
-				SoftwareRenderer::drawTransparentPixels(x, drawRanges.at(1), nearZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-			}
-			else if (camera.eye.y < nearFloorPoint.y)
-			{
-				// Below platform.
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
-					nearCeilingPoint, nearFloorPoint, farFloorPoint, camera, frame);
-
-				// Wall.
-				SoftwareRenderer::drawTransparentPixels(x, drawRanges.at(0), nearZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-
-				// Floor.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(1), nearPoint, farPoint,
-					nearZ, farZ, -Double3::UnitY, textures.at(raisedData.floorID), shadingInfo,
-					occlusion, frame);
-			}
-			else
-			{
-				// Between top and bottom.
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearCeilingPoint, nearFloorPoint, camera, frame);
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-			}
+			// The start of the vertical texture coordinate depends on the percent open.
+			const double vStart = raisedAmount / voxelHeight;
+
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, hit.u,
+				vStart, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Diagonal)
+		else if (doorData.type == VoxelData::DoorData::Type::Splitting)
 		{
-			const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = diagData.type1 ?
-				SoftwareRenderer::findDiag1Intersection(voxelX, voxelZ, nearPoint, farPoint, hit) :
-				SoftwareRenderer::findDiag2Intersection(voxelX, voxelZ, nearPoint, farPoint, hit);
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			if (success)
-			{
-				const Double3 diagTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight,
-					hit.point.y);
-				const Double3 diagBottomPoint(
-					diagTopPoint.x,
-					voxelYReal,
-					diagTopPoint.z);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					diagTopPoint, diagBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawPixels(x, drawRange, nearZ + hit.innerZ, hit.u, 0.0,
-					Constants::JustBelowOne, hit.normal, textures.at(diagData.id), shadingInfo,
-					occlusion, frame);
-			}
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, hit.u, 0.0,
+				Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::TransparentWall)
-		{
-			// Draw transparent side.
-			const VoxelData::TransparentWallData &transparentWallData = voxelData.transparentWall;
+	}
+}
+
+template <VoxelDataType DataType>
+void SoftwareRenderer::drawVoxelAbove(int, const VoxelData&, const VoxelColumnContext&)
+{
+	// Air, and data types with nothing visible from this position.
+}
+
+template <>
+void SoftwareRenderer::drawVoxelAbove<VoxelDataType::Wall>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::WallData &wallData = voxelData.wall;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + voxelHeight,
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal,
+		column.nearPoint.y);
+	const Double3 farFloorPoint(
+		column.farPoint.x,
+		nearFloorPoint.y,
+		column.farPoint.y);
+
+	const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
+		nearCeilingPoint, nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+	// Wall.
+	SoftwareRenderer::drawPixels(column.x, drawRanges.at(0), column.nearZ, column.wallU, 0.0,
+		Constants::JustBelowOne, column.wallNormal, column.textures.at(wallData.sideID),
+		column.shadingInfo, column.occlusion, column.frame);
+
+	// Floor.
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(1), column.nearPoint,
+		column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+		column.textures.at(wallData.floorID), column.shadingInfo, column.occlusion, column.frame);
+}
+
+template <>
+void SoftwareRenderer::drawVoxelAbove<VoxelDataType::Ceiling>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw bottom of ceiling voxel.
+	const VoxelData::CeilingData &ceilingData = voxelData.ceiling;
+
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal,
+		column.nearPoint.y);
+	const Double3 farFloorPoint(
+		column.farPoint.x,
+		nearFloorPoint.y,
+		column.farPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+	SoftwareRenderer::drawPerspectivePixels(column.x, drawRange, column.nearPoint, column.farPoint,
+		column.nearZ, column.farZ, -Double3::UnitY, column.textures.at(ceilingData.id),
+		column.shadingInfo, column.occlusion, column.frame);
+}
+
+template <>
+void SoftwareRenderer::drawVoxelAbove<VoxelDataType::Raised>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::RaisedData &raisedData = voxelData.raised;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal + (raisedData.yOffset * voxelHeight),
+		column.nearPoint.y);
+
+	// Draw order depends on the player's Y position relative to the platform.
+	if (column.camera.eye.y > nearCeilingPoint.y)
+	{
+		// Above platform.
+		const Double3 farCeilingPoint(
+			column.farPoint.x,
+			nearCeilingPoint.y,
+			column.farPoint.y);
+
+		const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
+			farCeilingPoint, nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+		// Ceiling.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(0), column.farPoint,
+			column.nearPoint, column.farZ, column.nearZ, Double3::UnitY,
+			column.textures.at(raisedData.ceilingID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Wall.
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRanges.at(1), column.nearZ,
+			column.wallU, raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else if (column.camera.eye.y < nearFloorPoint.y)
+	{
+		// Below platform.
+		const Double3 farFloorPoint(
+			column.farPoint.x,
+			nearFloorPoint.y,
+			column.farPoint.y);
+
+		const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
+			nearCeilingPoint, nearFloorPoint, farFloorPoint, column.camera, column.frame);
+
+		// Wall.
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRanges.at(0), column.nearZ,
+			column.wallU, raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+
+		// Floor.
+		SoftwareRenderer::drawPerspectivePixels(column.x, drawRanges.at(1), column.nearPoint,
+			column.farPoint, column.nearZ, column.farZ, -Double3::UnitY,
+			column.textures.at(raisedData.floorID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+	else
+	{
+		// Between top and bottom.
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
 
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, column.wallU,
+			raisedData.vTop, raisedData.vBottom, column.wallNormal,
+			column.textures.at(raisedData.sideID), column.shadingInfo, column.occlusion,
+			column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawVoxelAbove<VoxelDataType::Diagonal>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DiagonalData &diagData = voxelData.diagonal;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = diagData.type1 ? SoftwareRenderer::findDiag1Intersection(column.voxelX,
+		column.voxelZ, column.nearPoint, column.farPoint,
+		hit) : SoftwareRenderer::findDiag2Intersection(column.voxelX, column.voxelZ,
+		column.nearPoint, column.farPoint, hit);
+
+	if (success)
+	{
+		const Double3 diagTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight,
+			hit.point.y);
+		const Double3 diagBottomPoint(
+			diagTopPoint.x,
+			voxelYReal,
+			diagTopPoint.z);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			diagTopPoint, diagBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawPixels(column.x, drawRange, column.nearZ + hit.innerZ, hit.u, 0.0,
+			Constants::JustBelowOne, hit.normal, column.textures.at(diagData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawVoxelAbove<VoxelDataType::TransparentWall>(int voxelY,
+	const VoxelData &voxelData, const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	// Draw transparent side.
+	const VoxelData::TransparentWallData &transparentWallData = voxelData.transparentWall;
+
+	const Double3 nearCeilingPoint(
+		column.nearPoint.x,
+		voxelYReal + voxelHeight,
+		column.nearPoint.y);
+	const Double3 nearFloorPoint(
+		column.nearPoint.x,
+		voxelYReal,
+		column.nearPoint.y);
+
+	const auto drawRange = SoftwareRenderer::makeDrawRange(
+		nearCeilingPoint, nearFloorPoint, column.camera, column.frame);
+
+	SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, column.wallU, 0.0,
+		Constants::JustBelowOne, column.wallNormal, column.textures.at(transparentWallData.id),
+		column.shadingInfo, column.occlusion, column.frame);
+}
+
+template <>
+void SoftwareRenderer::drawVoxelAbove<VoxelDataType::Edge>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::EdgeData &edgeData = voxelData.edge;
+
+	// Find intersection.
+	RayHit hit;
+	const bool success = SoftwareRenderer::findEdgeIntersection(column.voxelX, column.voxelZ,
+		edgeData.facing, edgeData.flipped, column.facing, column.nearPoint, column.farPoint,
+		column.wallU, column.camera, column.ray, hit);
+
+	if (success)
+	{
+		const Double3 edgeTopPoint(
+			hit.point.x,
+			voxelYReal + voxelHeight + edgeData.yOffset,
+			hit.point.y);
+		const Double3 edgeBottomPoint(
+			hit.point.x,
+			voxelYReal + edgeData.yOffset,
+			hit.point.y);
+
+		const auto drawRange = SoftwareRenderer::makeDrawRange(
+			edgeTopPoint, edgeBottomPoint, column.camera, column.frame);
+
+		SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+			hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(edgeData.id),
+			column.shadingInfo, column.occlusion, column.frame);
+	}
+}
+
+template <>
+void SoftwareRenderer::drawVoxelAbove<VoxelDataType::Door>(int voxelY, const VoxelData &voxelData,
+	const VoxelColumnContext &column)
+{
+	const double voxelHeight = column.ceilingHeight;
+	const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
+
+	const VoxelData::DoorData &doorData = voxelData.door;
+	const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
+		column.voxelX, column.voxelZ, column.openDoors);
+
+	RayHit hit;
+	const bool success = SoftwareRenderer::findDoorIntersection(column.voxelX, column.voxelZ,
+		doorData.type, percentOpen, column.facing, column.nearPoint, column.farPoint,
+		column.wallU, hit);
+
+	if (success)
+	{
+		if (doorData.type == VoxelData::DoorData::Type::Swinging)
+		{
+			const Double3 doorTopPoint(
+				hit.point.x,
 				voxelYReal + voxelHeight,
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
 				voxelYReal,
-				nearPoint.y);
+				doorTopPoint.z);
 
 			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				nearCeilingPoint, nearFloorPoint, camera, frame);
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, wallU, 0.0,
-				Constants::JustBelowOne, wallNormal, textures.at(transparentWallData.id),
-				shadingInfo, occlusion, frame);
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ + hit.innerZ,
+				hit.u, 0.0, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Edge)
+		else if (doorData.type == VoxelData::DoorData::Type::Sliding)
 		{
-			const VoxelData::EdgeData &edgeData = voxelData.edge;
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = SoftwareRenderer::findEdgeIntersection(voxelX, voxelZ,
-				edgeData.facing, edgeData.flipped, facing, nearPoint, farPoint, wallU,
-				camera, ray, hit);
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			if (success)
-			{
-				const Double3 edgeTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight + edgeData.yOffset,
-					hit.point.y);
-				const Double3 edgeBottomPoint(
-					hit.point.x,
-					voxelYReal + edgeData.yOffset,
-					hit.point.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					edgeTopPoint, edgeBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ, hit.u,
-					0.0, Constants::JustBelowOne, hit.normal, textures.at(edgeData.id),
-					shadingInfo, occlusion, frame);
-			}
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, hit.u, 0.0,
+				Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
 		}
-		else if (voxelData.dataType == VoxelDataType::Chasm)
+		else if (doorData.type == VoxelData::DoorData::Type::Raising)
 		{
-			// Render front and back-faces.
-			const VoxelData::ChasmData &chasmData = voxelData.chasm;
+			// Top point is fixed, bottom point depends on percent open.
+			const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
+			const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
 
-			// Find which faces on the chasm were intersected.
-			const VoxelData::Facing nearFacing = facing;
-			const VoxelData::Facing farFacing = SoftwareRenderer::getChasmFarFacing(
-				voxelX, voxelZ, nearFacing, camera, ray);
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal + raisedAmount,
+				doorTopPoint.z);
 
-			// Near.
-			if (chasmData.faceIsVisible(nearFacing))
-			{
-				const double nearU = Constants::JustBelowOne - wallU;
-				const Double3 nearNormal = wallNormal;
-
-				// Wet chasms and lava chasms are unaffected by ceiling height.
-				const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
-					voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
-
-				const Double3 nearCeilingPoint(
-					nearPoint.x,
-					voxelYReal + voxelHeight,
-					nearPoint.y);
-				const Double3 nearFloorPoint(
-					nearPoint.x,
-					nearCeilingPoint.y - chasmDepth,
-					nearPoint.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearCeilingPoint, nearFloorPoint, camera, frame);
-
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, nearU, 0.0,
-					Constants::JustBelowOne, nearNormal, textures.at(chasmData.id),
-					shadingInfo, occlusion, frame);
-			}
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
 
-			// Far.
-			if (chasmData.faceIsVisible(farFacing))
-			{
-				const double farU = [&farPoint, farFacing]()
-				{
-					const double uVal = [&farPoint, farFacing]()
-					{
-						if (farFacing == VoxelData::Facing::PositiveX)
-						{
-							return farPoint.y - std::floor(farPoint.y);
-						}
-						else if (farFacing == VoxelData::Facing::NegativeX)
-						{
-							return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
-						}
-						else if (farFacing == VoxelData::Facing::PositiveZ)
-						{
-							return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
-						}
-						else
-						{
-							return farPoint.x - std::floor(farPoint.x);
-						}
-					}();
+			// The start of the vertical texture coordinate depends on the percent open.
+			const double vStart = raisedAmount / voxelHeight;
 
-					return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
-				}();
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, hit.u,
+				vStart, Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
+		}
+		else if (doorData.type == VoxelData::DoorData::Type::Splitting)
+		{
+			const Double3 doorTopPoint(
+				hit.point.x,
+				voxelYReal + voxelHeight,
+				hit.point.y);
+			const Double3 doorBottomPoint(
+				doorTopPoint.x,
+				voxelYReal,
+				doorTopPoint.z);
 
-				const Double3 farNormal = -VoxelData::getNormal(farFacing);
+			const auto drawRange = SoftwareRenderer::makeDrawRange(
+				doorTopPoint, doorBottomPoint, column.camera, column.frame);
+
+			SoftwareRenderer::drawTransparentPixels(column.x, drawRange, column.nearZ, hit.u, 0.0,
+				Constants::JustBelowOne, hit.normal, column.textures.at(doorData.id),
+				column.shadingInfo, column.occlusion, column.frame);
+		}
+	}
+}
+
+// The voxel draw tables list one function per data type in declaration order, so they are
+// indexed by the data type's value. The table size comes from Door being the last one.
+static_assert(static_cast<int>(VoxelDataType::None) == 0, "Voxel draw table order.");
+static_assert(static_cast<int>(VoxelDataType::Wall) == 1, "Voxel draw table order.");
+static_assert(static_cast<int>(VoxelDataType::Floor) == 2, "Voxel draw table order.");
+static_assert(static_cast<int>(VoxelDataType::Ceiling) == 3, "Voxel draw table order.");
+static_assert(static_cast<int>(VoxelDataType::Raised) == 4, "Voxel draw table order.");
+static_assert(static_cast<int>(VoxelDataType::Diagonal) == 5, "Voxel draw table order.");
+static_assert(static_cast<int>(VoxelDataType::TransparentWall) == 6, "Voxel draw table order.");
+static_assert(static_cast<int>(VoxelDataType::Edge) == 7, "Voxel draw table order.");
+static_assert(static_cast<int>(VoxelDataType::Chasm) == 8, "Voxel draw table order.");
+static_assert(static_cast<int>(VoxelDataType::Door) == 9, "Voxel draw table order.");
+
+const SoftwareRenderer::VoxelDrawTable SoftwareRenderer::INITIAL_VOXEL_DRAW_TABLE =
+{
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::None>,
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::Wall>,
+	// Floors can only be seen from above.
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::Floor>,
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::Ceiling>,
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::Raised>,
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::Diagonal>,
+	// Transparent walls have no back-faces.
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::TransparentWall>,
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::Edge>,
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::Chasm>,
+	SoftwareRenderer::drawInitialVoxel<VoxelDataType::Door>
+};
+
+const SoftwareRenderer::VoxelDrawTable SoftwareRenderer::INITIAL_VOXEL_BELOW_DRAW_TABLE =
+{
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::None>,
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Wall>,
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Floor>,
+	// Ceilings can only be seen from below.
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Ceiling>,
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Raised>,
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Diagonal>,
+	// Transparent walls have no back-faces.
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::TransparentWall>,
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Edge>,
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Chasm>,
+	SoftwareRenderer::drawInitialVoxelBelow<VoxelDataType::Door>
+};
+
+const SoftwareRenderer::VoxelDrawTable SoftwareRenderer::INITIAL_VOXEL_ABOVE_DRAW_TABLE =
+{
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::None>,
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Wall>,
+	// Floors can only be seen from above.
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Floor>,
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Ceiling>,
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Raised>,
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Diagonal>,
+	// Transparent walls have no back-faces.
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::TransparentWall>,
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Edge>,
+	// Chasms should never be above the player's voxel.
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Chasm>,
+	SoftwareRenderer::drawInitialVoxelAbove<VoxelDataType::Door>
+};
+
+const SoftwareRenderer::VoxelDrawTable SoftwareRenderer::VOXEL_DRAW_TABLE =
+{
+	SoftwareRenderer::drawVoxel<VoxelDataType::None>,
+	SoftwareRenderer::drawVoxel<VoxelDataType::Wall>,
+	// Floors can only be seen from above.
+	SoftwareRenderer::drawVoxel<VoxelDataType::Floor>,
+	SoftwareRenderer::drawVoxel<VoxelDataType::Ceiling>,
+	SoftwareRenderer::drawVoxel<VoxelDataType::Raised>,
+	SoftwareRenderer::drawVoxel<VoxelDataType::Diagonal>,
+	SoftwareRenderer::drawVoxel<VoxelDataType::TransparentWall>,
+	SoftwareRenderer::drawVoxel<VoxelDataType::Edge>,
+	SoftwareRenderer::drawVoxel<VoxelDataType::Chasm>,
+	SoftwareRenderer::drawVoxel<VoxelDataType::Door>
+};
+
+const SoftwareRenderer::VoxelDrawTable SoftwareRenderer::VOXEL_BELOW_DRAW_TABLE =
+{
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::None>,
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::Wall>,
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::Floor>,
+	// Ceilings can only be seen from below.
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::Ceiling>,
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::Raised>,
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::Diagonal>,
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::TransparentWall>,
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::Edge>,
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::Chasm>,
+	SoftwareRenderer::drawVoxelBelow<VoxelDataType::Door>
+};
+
+const SoftwareRenderer::VoxelDrawTable SoftwareRenderer::VOXEL_ABOVE_DRAW_TABLE =
+{
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::None>,
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::Wall>,
+	// Floors can only be seen from above.
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::Floor>,
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::Ceiling>,
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::Raised>,
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::Diagonal>,
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::TransparentWall>,
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::Edge>,
+	// Chasms should never be above the player's voxel.
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::Chasm>,
+	SoftwareRenderer::drawVoxelAbove<VoxelDataType::Door>
+};
 
-				// Wet chasms and lava chasms are unaffected by ceiling height.
-				const double chasmDepth = (chasmData.type == VoxelData::ChasmData::Type::Dry) ?
-					voxelHeight : VoxelData::ChasmData::WET_LAVA_DEPTH;
+void SoftwareRenderer::drawInitialVoxelColumn(int x, int voxelX, int voxelZ, const Camera &camera,
+	const Ray &ray, VoxelData::Facing facing, const Double2 &nearPoint, const Double2 &farPoint,
+	double nearZ, double farZ, const ShadingInfo &shadingInfo, double ceilingHeight,
+	const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
+	const std::vector<VoxelDataType> &voxelDataTypes, const std::vector<VoxelTexture> &textures,
+	OcclusionData &occlusion, const FrameView &frame)
+{
+	// This method handles some special cases such as drawing the back-faces of wall sides.
 
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					voxelYReal + voxelHeight,
-					farPoint.y);
-				const Double3 farFloorPoint(
-					farPoint.x,
-					farCeilingPoint.y - chasmDepth,
-					farPoint.y);
+	// When clamping Y values for drawing ranges, subtract 0.5 from starts and add 0.5 to 
+	// ends before converting to integers because the drawing methods sample at the center 
+	// of pixels. The clamping function depends on which side of the range is being clamped; 
+	// either way, the drawing range should be contained within the projected range at the 
+	// sub-pixel level. This ensures that the vertical texture coordinate is always within 0->1.
 
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					farCeilingPoint, farFloorPoint, camera, frame);
+	const double wallU = [&farPoint, facing]()
+	{
+		const double uVal = [&farPoint, facing]()
+		{
+			if (facing == VoxelData::Facing::PositiveX)
+			{
+				return farPoint.y - std::floor(farPoint.y);
+			}
+			else if (facing == VoxelData::Facing::NegativeX)
+			{
+				return Constants::JustBelowOne - (farPoint.y - std::floor(farPoint.y));
+			}
+			else if (facing == VoxelData::Facing::PositiveZ)
+			{
+				return Constants::JustBelowOne - (farPoint.x - std::floor(farPoint.x));
+			}
+			else
+			{
+				return farPoint.x - std::floor(farPoint.x);
+			}
+		}();
 
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, farZ, farU, 0.0,
-					Constants::JustBelowOne, farNormal, textures.at(chasmData.id),
-					shadingInfo, occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Door)
-		{
-			const VoxelData::DoorData &doorData = voxelData.door;
-			const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
-				voxelX, voxelZ, openDoors);
+		return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
+	}();
 
-			RayHit hit;
-			const bool success = SoftwareRenderer::findDoorIntersection(voxelX, voxelZ,
-				doorData.type, percentOpen, facing, nearPoint, farPoint, wallU, hit);
+	// Normal of the wall for the incoming ray, potentially shared between multiple voxels in
+	// this voxel column.
+	const Double3 wallNormal = -VoxelData::getNormal(facing);
 
-			if (success)
-			{
-				if (doorData.type == VoxelData::DoorData::Type::Swinging)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Sliding)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, hit.u, 0.0,
-						Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Raising)
-				{
-					// Top point is fixed, bottom point depends on percent open.
-					const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
-					const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
-
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal + raisedAmount,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					// The start of the vertical texture coordinate depends on the percent open.
-					const double vStart = raisedAmount / voxelHeight;
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, hit.u, vStart,
-						Constants::JustBelowOne, hit.normal, textures.at(doorData.id), shadingInfo,
-						occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Splitting)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, hit.u, 0.0,
-						Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-			}
-		}
-	};
+	const VoxelColumnContext column(x, voxelX, voxelZ, camera, ray, facing, wallNormal,
+		nearPoint, farPoint, nearZ, farZ, wallU, shadingInfo, ceilingHeight, openDoors,
+		voxelGrid, textures, occlusion, frame);
 
-	auto drawVoxelAbove = [x, voxelX, voxelZ, &camera, &ray, facing, &wallNormal, &nearPoint,
-		&farPoint, nearZ, farZ, wallU, &shadingInfo, ceilingHeight, &openDoors, &voxelGrid,
-		&textures, &occlusion, &frame](int voxelY)
+	// Draws the voxel at some Y coordinate with its data type's function from the given
+	// table. Air is skipped before its voxel data is looked up.
+	auto drawVoxelFromTable = [voxelX, voxelZ, &voxelGrid, &voxelDataTypes, &column](
+		const VoxelDrawTable &drawTable, int voxelY)
 	{
 		const uint16_t voxelID = voxelGrid.getVoxel(voxelX, voxelY, voxelZ);
-		const VoxelData &voxelData = voxelGrid.getVoxelData(voxelID);
-		const double voxelHeight = ceilingHeight;
-		const double voxelYReal = static_cast<double>(voxelY) * voxelHeight;
-
-		if (voxelData.dataType == VoxelDataType::Wall)
+		const VoxelDataType dataType = voxelDataTypes[voxelID];
+		if (dataType != VoxelDataType::None)
 		{
-			const VoxelData::WallData &wallData = voxelData.wall;
+			const VoxelData &voxelData = voxelGrid.getVoxelData(voxelID);
+			const VoxelDrawFunction drawFunction = drawTable[static_cast<int>(dataType)];
+			drawFunction(voxelY, voxelData, column);
+		}
+	};
 
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				voxelYReal + voxelHeight,
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal,
-				nearPoint.y);
-			const Double3 farFloorPoint(
-				farPoint.x,
-				nearFloorPoint.y,
-				farPoint.y);
-
-			const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
-				nearCeilingPoint, nearFloorPoint, farFloorPoint, camera, frame);
-			
-			// Wall.
-			SoftwareRenderer::drawPixels(x, drawRanges.at(0), nearZ, wallU, 0.0,
-				Constants::JustBelowOne, wallNormal, textures.at(wallData.sideID), shadingInfo,
-				occlusion, frame);
+	// Relative Y voxel coordinate of the camera, compensating for the ceiling height.
+	const int adjustedVoxelY = camera.getAdjustedEyeVoxelY(ceilingHeight);
 
-			// Floor.
-			SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(1), nearPoint, farPoint,
-				nearZ, farZ, -Double3::UnitY, textures.at(wallData.floorID), shadingInfo,
-				occlusion, frame);
-		}
-		else if (voxelData.dataType == VoxelDataType::Floor)
-		{
-			// Do nothing. Floors can only be seen from above.
-		}
-		else if (voxelData.dataType == VoxelDataType::Ceiling)
-		{
-			// Draw bottom of ceiling voxel.
-			const VoxelData::CeilingData &ceilingData = voxelData.ceiling;
+	// Draw the player's current voxel first.
+	drawVoxelFromTable(SoftwareRenderer::INITIAL_VOXEL_DRAW_TABLE, adjustedVoxelY);
 
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal,
-				nearPoint.y);
-			const Double3 farFloorPoint(
-				farPoint.x,
-				nearFloorPoint.y,
-				farPoint.y);
+	// Draw voxels below the player's voxel.
+	for (int voxelY = (adjustedVoxelY - 1); voxelY >= 0; voxelY--)
+	{
+		drawVoxelFromTable(SoftwareRenderer::INITIAL_VOXEL_BELOW_DRAW_TABLE, voxelY);
+	}
 
-			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				nearFloorPoint, farFloorPoint, camera, frame);
+	// Draw voxels above the player's voxel.
+	for (int voxelY = (adjustedVoxelY + 1); voxelY < voxelGrid.getHeight(); voxelY++)
+	{
+		drawVoxelFromTable(SoftwareRenderer::INITIAL_VOXEL_ABOVE_DRAW_TABLE, voxelY);
+	}
+}
 
-			SoftwareRenderer::drawPerspectivePixels(x, drawRange, nearPoint, farPoint, nearZ,
-				farZ, -Double3::UnitY, textures.at(ceilingData.id), shadingInfo,
-				occlusion, frame);
-		}
-		else if (voxelData.dataType == VoxelDataType::Raised)
-		{
-			const VoxelData::RaisedData &raisedData = voxelData.raised;
+void SoftwareRenderer::drawVoxelColumn(int x, int voxelX, int voxelZ, const Camera &camera,
+	const Ray &ray, VoxelData::Facing facing, const Double2 &nearPoint, const Double2 &farPoint,
+	double nearZ, double farZ, const ShadingInfo &shadingInfo, double ceilingHeight,
+	const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
+	const std::vector<VoxelDataType> &voxelDataTypes, const std::vector<VoxelTexture> &textures,
+	OcclusionData &occlusion, const FrameView &frame)
+{
+	// Much of the code here is duplicated from the initial voxel column drawing method, but
+	// there are a couple differences, like the horizontal texture coordinate being flipped,
+	// and the drawing orders being slightly modified. The reason for having so much code is
+	// so we cover all the different ray casting cases efficiently. It would slow down this 
+	// method if it had to worry about an "initialColumn" boolean that's always false in the
+	// general case.
 
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				voxelYReal + ((raisedData.yOffset + raisedData.ySize) * voxelHeight),
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal + (raisedData.yOffset * voxelHeight),
-				nearPoint.y);
+	// When clamping Y values for drawing ranges, subtract 0.5 from starts and add 0.5 to 
+	// ends before converting to integers because the drawing methods sample at the center 
+	// of pixels. The clamping function depends on which side of the range is being clamped; 
+	// either way, the drawing range should be contained within the projected range at the 
+	// sub-pixel level. This ensures that the vertical texture coordinate is always within 0->1.
 
-			// Draw order depends on the player's Y position relative to the platform.
-			if (camera.eye.y > nearCeilingPoint.y)
+	// Horizontal texture coordinate for the wall, potentially shared between multiple voxels
+	// in this voxel column.
+	const double wallU = [&nearPoint, facing]()
+	{
+		const double uVal = [&nearPoint, facing]()
+		{
+			if (facing == VoxelData::Facing::PositiveX)
 			{
-				// Above platform.
-				const Double3 farCeilingPoint(
-					farPoint.x,
-					nearCeilingPoint.y,
-					farPoint.y);
-
-				const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
-					farCeilingPoint, nearCeilingPoint, nearFloorPoint, camera, frame);
-
-				// Ceiling.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(0), farPoint, nearPoint,
-					farZ, nearZ, Double3::UnitY, textures.at(raisedData.ceilingID), shadingInfo,
-					occlusion, frame);
-
-				// Wall.
-				SoftwareRenderer::drawTransparentPixels(x, drawRanges.at(1), nearZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
+				return Constants::JustBelowOne - (nearPoint.y - std::floor(nearPoint.y));
 			}
-			else if (camera.eye.y < nearFloorPoint.y)
+			else if (facing == VoxelData::Facing::NegativeX)
 			{
-				// Below platform.
-				const Double3 farFloorPoint(
-					farPoint.x,
-					nearFloorPoint.y,
-					farPoint.y);
-
-				const auto drawRanges = SoftwareRenderer::makeDrawRangeTwoPart(
-					nearCeilingPoint, nearFloorPoint, farFloorPoint, camera, frame);
-
-				// Wall.
-				SoftwareRenderer::drawTransparentPixels(x, drawRanges.at(0), nearZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
-
-				// Floor.
-				SoftwareRenderer::drawPerspectivePixels(x, drawRanges.at(1), nearPoint, farPoint,
-					nearZ, farZ, -Double3::UnitY, textures.at(raisedData.floorID), shadingInfo,
-					occlusion, frame);
+				return nearPoint.y - std::floor(nearPoint.y);
 			}
-			else
+			else if (facing == VoxelData::Facing::PositiveZ)
 			{
-				// Between top and bottom.
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					nearCeilingPoint, nearFloorPoint, camera, frame);
-
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, wallU,
-					raisedData.vTop, raisedData.vBottom, wallNormal,
-					textures.at(raisedData.sideID), shadingInfo, occlusion, frame);
+				return nearPoint.x - std::floor(nearPoint.x);
 			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Diagonal)
-		{
-			const VoxelData::DiagonalData &diagData = voxelData.diagonal;
-
-			// Find intersection.
-			RayHit hit;
-			const bool success = diagData.type1 ?
-				SoftwareRenderer::findDiag1Intersection(voxelX, voxelZ, nearPoint, farPoint, hit) :
-				SoftwareRenderer::findDiag2Intersection(voxelX, voxelZ, nearPoint, farPoint, hit);
-
-			if (success)
+			else
 			{
-				const Double3 diagTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight,
-					hit.point.y);
-				const Double3 diagBottomPoint(
-					diagTopPoint.x,
-					voxelYReal,
-					diagTopPoint.z);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					diagTopPoint, diagBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawPixels(x, drawRange, nearZ + hit.innerZ, hit.u, 0.0,
-					Constants::JustBelowOne, hit.normal, textures.at(diagData.id), shadingInfo,
-					occlusion, frame);
+				return Constants::JustBelowOne - (nearPoint.x - std::floor(nearPoint.x));
 			}
-		}
-		else if (voxelData.dataType == VoxelDataType::TransparentWall)
-		{
-			// Draw transparent side.
-			const VoxelData::TransparentWallData &transparentWallData = voxelData.transparentWall;
-
-			const Double3 nearCeilingPoint(
-				nearPoint.x,
-				voxelYReal + voxelHeight,
-				nearPoint.y);
-			const Double3 nearFloorPoint(
-				nearPoint.x,
-				voxelYReal,
-				nearPoint.y);
+		}();
 
-			const auto drawRange = SoftwareRenderer::makeDrawRange(
-				nearCeilingPoint, nearFloorPoint, camera, frame);
+		return MathUtils::clamp(uVal, 0.0, Constants::JustBelowOne);
+	}();
 
-			SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, wallU, 0.0,
-				Constants::JustBelowOne, wallNormal, textures.at(transparentWallData.id),
-				shadingInfo, occlusion, frame);
-		}
-		else if (voxelData.dataType == VoxelDataType::Edge)
-		{
-			const VoxelData::EdgeData &edgeData = voxelData.edge;
+	// Normal of the wall for the incoming ray, potentially shared between multiple voxels in
+	// this voxel column.
+	const Double3 wallNormal = VoxelData::getNormal(facing);
 
-			// Find intersection.
-			RayHit hit;
-			const bool success = SoftwareRenderer::findEdgeIntersection(voxelX, voxelZ,
-				edgeData.facing, edgeData.flipped, facing, nearPoint, farPoint, wallU,
-				camera, ray, hit);
+	const VoxelColumnContext column(x, voxelX, voxelZ, camera, ray, facing, wallNormal,
+		nearPoint, farPoint, nearZ, farZ, wallU, shadingInfo, ceilingHeight, openDoors,
+		voxelGrid, textures, occlusion, frame);
 
-			if (success)
-			{
-				const Double3 edgeTopPoint(
-					hit.point.x,
-					voxelYReal + voxelHeight + edgeData.yOffset,
-					hit.point.y);
-				const Double3 edgeBottomPoint(
-					hit.point.x,
-					voxelYReal + edgeData.yOffset,
-					hit.point.y);
-
-				const auto drawRange = SoftwareRenderer::makeDrawRange(
-					edgeTopPoint, edgeBottomPoint, camera, frame);
-
-				SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ, hit.u,
-					0.0, Constants::JustBelowOne, hit.normal, textures.at(edgeData.id),
-					shadingInfo, occlusion, frame);
-			}
-		}
-		else if (voxelData.dataType == VoxelDataType::Chasm)
-		{
-			// Ignore. Chasms should never be above the player's voxel.
-		}
-		else if (voxelData.dataType == VoxelDataType::Door)
+	// Draws the voxel at some Y coordinate with its data type's function from the given
+	// table. Air is skipped before its voxel data is looked up.
+	auto drawVoxelFromTable = [voxelX, voxelZ, &voxelGrid, &voxelDataTypes, &column](
+		const VoxelDrawTable &drawTable, int voxelY)
+	{
+		const uint16_t voxelID = voxelGrid.getVoxel(voxelX, voxelY, voxelZ);
+		const VoxelDataType dataType = voxelDataTypes[voxelID];
+		if (dataType != VoxelDataType::None)
 		{
-			const VoxelData::DoorData &doorData = voxelData.door;
-			const double percentOpen = SoftwareRenderer::getDoorPercentOpen(
-				voxelX, voxelZ, openDoors);
-
-			RayHit hit;
-			const bool success = SoftwareRenderer::findDoorIntersection(voxelX, voxelZ,
-				doorData.type, percentOpen, facing, nearPoint, farPoint, wallU, hit);
-
-			if (success)
-			{
-				if (doorData.type == VoxelData::DoorData::Type::Swinging)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ + hit.innerZ,
-						hit.u, 0.0, Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Sliding)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, hit.u, 0.0,
-						Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Raising)
-				{
-					// Top point is fixed, bottom point depends on percent open.
-					const double minVisible = SoftwareRenderer::DOOR_MIN_VISIBLE;
-					const double raisedAmount = (voxelHeight * (1.0 - minVisible)) * percentOpen;
-
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal + raisedAmount,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					// The start of the vertical texture coordinate depends on the percent open.
-					const double vStart = raisedAmount / voxelHeight;
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, hit.u, vStart,
-						Constants::JustBelowOne, hit.normal, textures.at(doorData.id), shadingInfo,
-						occlusion, frame);
-				}
-				else if (doorData.type == VoxelData::DoorData::Type::Splitting)
-				{
-					const Double3 doorTopPoint(
-						hit.point.x,
-						voxelYReal + voxelHeight,
-						hit.point.y);
-					const Double3 doorBottomPoint(
-						doorTopPoint.x,
-						voxelYReal,
-						doorTopPoint.z);
-
-					const auto drawRange = SoftwareRenderer::makeDrawRange(
-						doorTopPoint, doorBottomPoint, camera, frame);
-
-					SoftwareRenderer::drawTransparentPixels(x, drawRange, nearZ, hit.u, 0.0,
-						Constants::JustBelowOne, hit.normal, textures.at(doorData.id),
-						shadingInfo, occlusion, frame);
-				}
-			}
+			const VoxelData &voxelData = voxelGrid.getVoxelData(voxelID);
+			const VoxelDrawFunction drawFunction = drawTable[static_cast<int>(dataType)];
+			drawFunction(voxelY, voxelData, column);
 		}
 	};
 
@@ -5752,18 +8086,18 @@ void SoftwareRenderer::drawVoxelColumn(int x, int voxelX, int voxelZ, const Came
 	const int adjustedVoxelY = camera.getAdjustedEyeVoxelY(ceilingHeight);
 
 	// Draw voxel straight ahead first.
-	drawVoxel(adjustedVoxelY);
+	drawVoxelFromTable(SoftwareRenderer::VOXEL_DRAW_TABLE, adjustedVoxelY);
 
 	// Draw voxels below the voxel.
 	for (int voxelY = (adjustedVoxelY - 1); voxelY >= 0; voxelY--)
 	{
-		drawVoxelBelow(voxelY);
+		drawVoxelFromTable(SoftwareRenderer::VOXEL_BELOW_DRAW_TABLE, voxelY);
 	}
 
 	// Draw voxels above the voxel.
 	for (int voxelY = (adjustedVoxelY + 1); voxelY < voxelGrid.getHeight(); voxelY++)
 	{
-		drawVoxelAbove(voxelY);
+		drawVoxelFromTable(SoftwareRenderer::VOXEL_ABOVE_DRAW_TABLE, voxelY);
 	}
 }
 
@@ -5771,11 +8105,6 @@ void SoftwareRenderer::drawFlat(int startX, int endX, const Flat::Frame &flatFra
 	const Double3 &normal, bool flipped, const Double2 &eye, const ShadingInfo &shadingInfo,
 	const FlatTexture &texture, const FrameView &frame)
 {
-	// Contribution from the sun.
-	const double lightNormalDot = std::max(0.0, shadingInfo.sunDirection.dot(normal));
-	const Double3 sunComponent = (shadingInfo.sunColor * lightNormalDot).clamped(
-		0.0, 1.0 - shadingInfo.ambient);
-
 	// X percents across the screen for the given start and end columns.
 	const double startXPercent = (static_cast<double>(startX) + 0.50) / 
 		static_cast<double>(frame.width);
@@ -5830,12 +8159,63 @@ void SoftwareRenderer::drawFlat(int startX, int endX, const Flat::Frame &flatFra
 	const int yStart = SoftwareRenderer::getLowerBoundedPixel(projectedYStart, frame.height);
 	const int yEnd = SoftwareRenderer::getUpperBoundedPixel(projectedYEnd, frame.height);
 
-	// Shading on the texture.
-	// - @todo: contribution from lights.
-	const Double3 shading(
-		shadingInfo.ambient + sunComponent.x,
-		shadingInfo.ambient + sunComponent.y,
-		shadingInfo.ambient + sunComponent.z);
+	// Shading on the texture. Flats do not have emission, and point lights reach them from
+	// any side, so they are lit at their center regardless of facing.
+	const Double3 flatCenter = flatFrame.topStart.lerp(flatFrame.topEnd, 0.50);
+	const Double3 light = shadingInfo.getSunlight(normal) + shadingInfo.lightGrid->getLight(
+		Double2(flatCenter.x, flatCenter.z), Double2::Zero);
+	const auto &shadeTables = SpanKernels::getShadeTables();
+	const auto &shadeTableR = shadeTables[SpanKernels::getLightLevel(light.x)];
+	const auto &shadeTableG = shadeTables[SpanKernels::getLightLevel(light.y)];
+	const auto &shadeTableB = shadeTables[SpanKernels::getLightLevel(light.z)];
+
+	// Texels per pixel down the flat, and texels across it per world unit for finding texels
+	// per pixel across the screen at each column's depth.
+	const double columnTexelsPerPixel = static_cast<double>(texture.height) /
+		std::abs(projectedYEnd - projectedYStart);
+	const double flatWidth = (Double2(flatFrame.topEnd.x, flatFrame.topEnd.z) -
+		Double2(flatFrame.topStart.x, flatFrame.topStart.z)).length();
+	const double rowTexelsPerUnit = static_cast<double>(texture.width) / flatWidth;
+	const int mipLevelCount = static_cast<int>(texture.mipLevels.size());
+
+	// Lambda for the vertical texel position of a row in a mip level with the given height.
+	auto getTextureY = [projectedYStart, projectedYEnd](int y, int levelHeight)
+	{
+		const double yPercent = ((static_cast<double>(y) + 0.50) - projectedYStart) /
+			(projectedYEnd - projectedYStart);
+
+		// Vertical texture coordinate.
+		const double startV = 0.0;
+		const double endV = Constants::JustBelowOne;
+		const double v = startV + ((endV - startV) * yPercent);
+
+		return static_cast<int>(v * static_cast<double>(levelHeight));
+	};
+
+	// Lambda for the first row of the flat whose texel is at or below the given one. The
+	// row is estimated from the inverse of getTextureY(), then nudged until it agrees.
+	auto getTexelRow = [projectedYStart, projectedYEnd, yStart, yEnd, &getTextureY](
+		int textureY, int levelHeight)
+	{
+		const double yPercent = (static_cast<double>(textureY) /
+			static_cast<double>(levelHeight)) / Constants::JustBelowOne;
+		const double yReal = projectedYStart +
+			(yPercent * (projectedYEnd - projectedYStart)) - 0.50;
+		int y = static_cast<int>(std::min(std::max(std::ceil(yReal),
+			static_cast<double>(yStart)), static_cast<double>(yEnd)));
+
+		while ((y > yStart) && (getTextureY(y - 1, levelHeight) >= textureY))
+		{
+			y--;
+		}
+
+		while ((y < yEnd) && (getTextureY(y, levelHeight) < textureY))
+		{
+			y++;
+		}
+
+		return y;
+	};
 
 	// Draw by-column, similar to wall rendering.
 	for (int x = xStart; x < xEnd; x++)
@@ -5846,69 +8226,66 @@ void SoftwareRenderer::drawFlat(int startX, int endX, const Flat::Frame &flatFra
 		// Horizontal texture coordinate.
 		const double u = startU + ((endU - startU) * xPercent);
 
-		// Horizontal texel position.
-		const int textureX = static_cast<int>(
-			(flipped ? (Constants::JustBelowOne - u) : u) *
-			static_cast<double>(texture.width));
-
 		const Double3 topPoint = startTopPoint.lerp(endTopPoint, xPercent);
 
 		// Get the true XZ distance for the depth.
 		const double depth = (Double2(topPoint.x, topPoint.z) - eye).length();
 
-		// Linearly interpolated fog.
-		const Double3 &fogColor = shadingInfo.getFogColor();
-		const double fogPercent = std::min(depth / shadingInfo.fogDistance, 1.0);
-
-		for (int y = yStart; y < yEnd; y++)
+		// Columns in full fog would only draw the fog color over the sky.
+		if (depth >= shadingInfo.fogDistance)
 		{
-			const int index = x + (y * frame.width);
+			continue;
+		}
 
-			if (depth <= frame.depthBuffer[index])
-			{
-				const double yPercent = ((static_cast<double>(y) + 0.50) - projectedYStart) /
-					(projectedYEnd - projectedYStart);
+		// Mip level from how many texels are stepped over per pixel.
+		const double rowTexelsPerPixel = rowTexelsPerUnit * shadingInfo.mipPixelSize * depth;
+		const FlatTexture::MipLevel &mipLevel = texture.mipLevels[SoftwareRenderer::getMipLevel(
+			std::min(rowTexelsPerPixel, columnTexelsPerPixel), mipLevelCount)];
+		const FlatTexel *mipTexels = texture.texels.data() + mipLevel.offset;
+
+		// Horizontal texel position.
+		const int textureX = static_cast<int>(
+			(flipped ? (Constants::JustBelowOne - u) : u) *
+			static_cast<double>(mipLevel.width));
+
+		// Linearly interpolated fog.
+		const int fogFactor = SpanKernels::getFogFactor(depth, shadingInfo.fogScale);
+
+		// Only the opaque runs of the texel column are drawn, so transparent texels are never
+		// sampled or depth tested.
+		const int column = mipLevel.columnOffset + textureX;
+		const int runStart = texture.columnRuns[column];
+		const int runEnd = texture.columnRuns[column + 1];
 
-				// Vertical texture coordinate.
-				const double startV = 0.0;
-				const double endV = Constants::JustBelowOne;
-				const double v = startV + ((endV - startV) * yPercent);
+		for (int i = runStart; i < runEnd; i++)
+		{
+			const FlatTexture::OpaqueRun &run = texture.opaqueRuns[i];
+			const int runYStart = getTexelRow(run.start, mipLevel.height);
+			const int runYEnd = getTexelRow(run.end, mipLevel.height);
 
-				// Vertical texel position.
-				const int textureY = static_cast<int>(v * static_cast<double>(texture.height));
+			// Every row of the run is drawn unless something nearer is there, so rows with
+			// stale depth from earlier frames are drawn without a depth check.
+			const DepthRows clearedRows = frame.claimDepth(x, runYStart, runYEnd);
 
-				// Alpha is checked in this loop, and transparent texels are not drawn.
-				// Flats do not have emission, so ignore it.
-				const int textureIndex = textureX + (textureY * texture.width);
-				const FlatTexel &texel = texture.texels[textureIndex];
+			for (int y = runYStart; y < runYEnd; y++)
+			{
+				const int index = x + (y * frame.width);
+				const bool isStale = (y < clearedRows.yStart) || (y >= clearedRows.yEnd);
 
-				if (texel.a > 0.0)
+				if (isStale || (depth <= frame.getDepth(index)))
 				{
-					// Texture color with shading.
-					const double shadingMax = 1.0;
-					double colorR = texel.r * std::min(shading.x, shadingMax);
-					double colorG = texel.g * std::min(shading.y, shadingMax);
-					double colorB = texel.b * std::min(shading.z, shadingMax);
-
-					// Linearly interpolate with fog.
-					colorR += (fogColor.x - colorR) * fogPercent;
-					colorG += (fogColor.y - colorG) * fogPercent;
-					colorB += (fogColor.z - colorB) * fogPercent;
-
-					// Clamp maximum (don't worry about negative values).
-					const double high = 1.0;
-					colorR = (colorR > high) ? high : colorR;
-					colorG = (colorG > high) ? high : colorG;
-					colorB = (colorB > high) ? high : colorB;
-
-					// Convert floats to integers.
-					const uint32_t colorRGB = static_cast<uint32_t>(
-						((static_cast<uint8_t>(colorR * 255.0)) << 16) |
-						((static_cast<uint8_t>(colorG * 255.0)) << 8) |
-						((static_cast<uint8_t>(colorB * 255.0))));
-
-					frame.colorBuffer[index] = colorRGB;
-					frame.depthBuffer[index] = depth;
+					// Vertical texel position.
+					const int textureY = getTextureY(y, mipLevel.height);
+					const int textureIndex = textureY + (textureX * mipLevel.height);
+					const FlatTexel &texel = mipTexels[textureIndex];
+
+					// Texture color with shading and fog.
+					const uint32_t colorRGB = (static_cast<uint32_t>(shadeTableR[texel.r]) << 16) |
+						(static_cast<uint32_t>(shadeTableG[texel.g]) << 8) |
+						static_cast<uint32_t>(shadeTableB[texel.b]);
+					frame.setColor(index, SpanKernels::blendFog(colorRGB,
+						shadingInfo.fogColorRGB, fogFactor));
+					frame.setDepth(index, depth);
 				}
 			}
 		}
@@ -5918,7 +8295,8 @@ void SoftwareRenderer::drawFlat(int startX, int endX, const Flat::Frame &flatFra
 void SoftwareRenderer::rayCast2D(int x, const Camera &camera, const Ray &ray,
 	const ShadingInfo &shadingInfo, double ceilingHeight,
 	const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
-	const std::vector<VoxelTexture> &textures, OcclusionData &occlusion, const FrameView &frame)
+	const std::vector<VoxelDataType> &voxelDataTypes, const std::vector<VoxelTexture> &textures,
+	OcclusionData &occlusion, const FrameView &frame)
 {
 	// Initially based on Lode Vandevenne's algorithm, this method of 2.5D ray casting is more 
 	// expensive as it does not stop at the first wall intersection, and it also renders voxels 
@@ -6010,8 +8388,8 @@ void SoftwareRenderer::rayCast2D(int x, const Camera &camera, const Ray &ray,
 		// Draw all voxels in a column at the player's XZ coordinate.
 		SoftwareRenderer::drawInitialVoxelColumn(x, camera.eyeVoxel.x, camera.eyeVoxel.z,
 			camera, ray, facing, initialNearPoint, initialFarPoint, SoftwareRenderer::NEAR_PLANE, 
-			zDistance, shadingInfo, ceilingHeight, openDoors, voxelGrid, textures, occlusion,
-			frame);
+			zDistance, shadingInfo, ceilingHeight, openDoors, voxelGrid, voxelDataTypes,
+			textures, occlusion, frame);
 	}
 
 	// The current voxel coordinate in the DDA loop. For all intents and purposes,
@@ -6088,30 +8466,20 @@ void SoftwareRenderer::rayCast2D(int x, const Camera &camera, const Ray &ray,
 		// Draw all voxels in a column at the given XZ coordinate.
 		SoftwareRenderer::drawVoxelColumn(x, savedCellX, savedCellZ, camera, ray, savedFacing,
 			nearPoint, farPoint, wallDistance, zDistance, shadingInfo, ceilingHeight, 
-			openDoors, voxelGrid, textures, occlusion, frame);
+			openDoors, voxelGrid, voxelDataTypes, textures, occlusion, frame);
 	}
 }
 
 void SoftwareRenderer::drawSkyGradient(int startY, int endY, double gradientProjYTop,
 	double gradientProjYBottom, std::vector<Double3> &skyGradientRowCache,
-	std::atomic<bool> &shouldDrawStars, const ShadingInfo &shadingInfo, const FrameView &frame)
+	std::atomic<bool> &shouldDrawStars, const SkyLayer *skyLayer,
+	const ShadingInfo &shadingInfo, const FrameView &frame)
 {
-	// Lambda for drawing one row of colors and depth in the frame buffer.
+	// Lambda for drawing one row of colors in the frame buffer. Depth is cleared later by
+	// whatever draws over the sky.
 	auto drawSkyRow = [&frame](int y, const Double3 &color)
 	{
-		uint32_t *colorPtr = frame.colorBuffer;
-		double *depthPtr = frame.depthBuffer;
-		const int startIndex = y * frame.width;
-		const int endIndex = (y + 1) * frame.width;
-		const uint32_t colorValue = color.toRGB();
-		constexpr double depthValue = std::numeric_limits<double>::infinity();
-
-		// Clear the color and depth of one row.
-		for (int i = startIndex; i < endIndex; i++)
-		{
-			colorPtr[i] = colorValue;
-			depthPtr[i] = depthValue;
-		}
+		frame.fillColor(y * frame.width, frame.width, color.toRGB());
 	};
 
 	// While drawing the sky gradient, determine if it is dark enough for stars to be visible.
@@ -6137,7 +8505,15 @@ void SoftwareRenderer::drawSkyGradient(int startY, int endY, double gradientProj
 		const double maxComp = std::max(std::max(color.x, color.y), color.z);
 		isDarkEnough |= maxComp <= ShadingInfo::STAR_VIS_THRESHOLD;
 
-		drawSkyRow(y, color);
+		// Rows with distant objects already drawn in the sky layer are copied from it.
+		if ((skyLayer != nullptr) && (y >= skyLayer->yStart) && (y < skyLayer->yEnd))
+		{
+			skyLayer->copyRow(y, frame);
+		}
+		else
+		{
+			drawSkyRow(y, color);
+		}
 	}
 
 	if (isDarkEnough)
@@ -6269,16 +8645,17 @@ void SoftwareRenderer::drawDistantSky(int startX, int endX, bool parallaxSky,
 	drawDistantObjRange(visDistantObjs.landStart, visDistantObjs.landEnd, DistantRenderType::General);
 }
 
-void SoftwareRenderer::drawVoxels(int startX, int stride, const Camera &camera,
+void SoftwareRenderer::drawVoxels(int startX, int endX, const Camera &camera,
 	double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
-	const VoxelGrid &voxelGrid, const std::vector<VoxelTexture> &voxelTextures,
-	std::vector<OcclusionData> &occlusion, const ShadingInfo &shadingInfo, const FrameView &frame)
+	const VoxelGrid &voxelGrid, const std::vector<VoxelDataType> &voxelDataTypes,
+	const std::vector<VoxelTexture> &voxelTextures, std::vector<OcclusionData> &occlusion,
+	const ShadingInfo &shadingInfo, const FrameView &frame)
 {
 	const Double2 forwardZoomed(camera.forwardZoomedX, camera.forwardZoomedZ);
 	const Double2 rightAspected(camera.rightAspectedX, camera.rightAspectedZ);
 
-	// Draw pixel columns with spacing determined by the number of render threads.
-	for (int x = startX; x < frame.width; x += stride)
+	// Draw pixel columns in the given range.
+	for (int x = startX; x < endX; x++)
 	{
 		// X percent across the screen.
 		const double xPercent = (static_cast<double>(x) + 0.50) / frame.widthReal;
@@ -6292,21 +8669,28 @@ void SoftwareRenderer::drawVoxels(int startX, int stride, const Camera &camera,
 		const Double2 direction = (forwardZoomed + rightComp).normalized();
 		const Ray ray(direction.x, direction.y);
 
+		// Reset the column's occlusion and cleared depth here instead of on the main thread,
+		// since this is the first thing to draw in the column.
+		OcclusionData &columnOcclusion = occlusion.at(x);
+		columnOcclusion = OcclusionData(0, frame.height);
+		frame.resetDepthRows(x);
+
 		// Cast the 2D ray and fill in the column's pixels with color.
 		SoftwareRenderer::rayCast2D(x, camera, ray, shadingInfo, ceilingHeight, openDoors,
-			voxelGrid, voxelTextures, occlusion.at(x), frame);
+			voxelGrid, voxelDataTypes, voxelTextures, columnOcclusion, frame);
 	}
 }
 
 void SoftwareRenderer::drawFlats(int startX, int endX, const Camera &camera,
 	const Double3 &flatNormal, const std::vector<VisibleFlat> &visibleFlats,
-	const std::vector<FlatTexture> &flatTextures, const ShadingInfo &shadingInfo,
-	const FrameView &frame)
+	const std::vector<int> &flatIndices, const std::vector<FlatTexture> &flatTextures,
+	const ShadingInfo &shadingInfo, const FrameView &frame)
 {
-	// Iterate through all flats, rendering those visible within the given X range of 
+	// Iterate through the given flats, rendering those visible within the given X range of 
 	// the screen.
-	for (const auto &visibleFlat : visibleFlats)
+	for (const int flatIndex : flatIndices)
 	{
+		const VisibleFlat &visibleFlat = visibleFlats[flatIndex];
 		const Flat &flat = visibleFlat.getFlat();
 		const Flat::Frame &flatFrame = visibleFlat.getFrame();
 
@@ -6321,103 +8705,148 @@ void SoftwareRenderer::drawFlats(int startX, int endX, const Camera &camera,
 	}
 }
 
-void SoftwareRenderer::renderThreadLoop(RenderThreadData &threadData, int threadIndex, int startX,
-	int endX, int startY, int endY)
+void SoftwareRenderer::renderThreadLoop(RenderThreadData &threadData, int threadIndex,
+	uint32_t frameNumber)
 {
 	while (true)
 	{
 		// Initial wait condition. The lock must be unlocked after wait() so other threads can
 		// lock it.
 		std::unique_lock<std::mutex> lk(threadData.mutex);
-		threadData.condVar.wait(lk, [&threadData]() { return threadData.go; });
+		threadData.condVar.wait(lk, [&threadData, frameNumber]()
+		{
+			return (threadData.frameNumber != frameNumber) || threadData.isDestructing;
+		});
+
+		frameNumber = threadData.frameNumber;
 		lk.unlock();
 
-		// Received a go signal. Check if the renderer is being destroyed before doing anything.
+		// Check if the renderer is being destroyed before doing anything.
 		if (threadData.isDestructing)
 		{
 			break;
 		}
 
-		// Lambda for making a thread wait until others are finished rendering something. The last
-		// thread to call this calls notify on all others.
-		auto threadBarrier = [&threadData, &lk](auto &data)
+		// Lambda for getting the pixel range of a tile.
+		auto getTileRange = [](int tile, int tileSize, int frameDim, int *outStart, int *outEnd)
 		{
-			lk.lock();
-			data.threadsDone++;
+			*outStart = tile * tileSize;
+			*outEnd = std::min(*outStart + tileSize, frameDim);
+		};
 
-			// If this was the last thread, notify all to continue.
-			if (data.threadsDone == threadData.totalThreads)
-			{
-				lk.unlock();
-				threadData.condVar.notify_all();
-			}
-			else
-			{
-				// Wait for other threads to finish.
-				threadData.condVar.wait(lk, [&threadData, &data]()
-				{
-					return data.threadsDone == threadData.totalThreads;
-				});
+		// Timings of this thread's work for the frame. Time spent waiting for the next frame
+		// isn't counted.
+		FrameTimings::Thread timings;
+		auto lapTime = std::chrono::steady_clock::now();
 
-				lk.unlock();
-			}
+		// Lambda for adding the time since the previous lap to some phase's timing.
+		auto lap = [&lapTime](double &phaseTime)
+		{
+			const auto now = std::chrono::steady_clock::now();
+			phaseTime += std::chrono::duration<double, std::milli>(now - lapTime).count();
+			lapTime = now;
 		};
 
-		// Draw this thread's portion of the sky gradient.
+		const FrameView &frame = *threadData.frame;
+		int tile, start, end;
+
+		// Draw tiles of the sky gradient.
 		RenderThreadData::SkyGradient &skyGradient = threadData.skyGradient;
-		SoftwareRenderer::drawSkyGradient(startY, endY, skyGradient.projectedYTop,
-			skyGradient.projectedYBottom, *skyGradient.rowCache, skyGradient.shouldDrawStars,
-			*threadData.shadingInfo, *threadData.frame);
+		while (skyGradient.tiles.tryTakeTile(threadIndex, &tile))
+		{
+			getTileRange(tile, threadData.tileRows, frame.height, &start, &end);
+			SoftwareRenderer::drawSkyGradient(start, end, skyGradient.projectedYTop,
+				skyGradient.projectedYBottom, *skyGradient.rowCache, skyGradient.shouldDrawStars,
+				skyGradient.skyLayer, *threadData.skyShadingInfo, frame);
+			skyGradient.tiles.setTileDone(tile);
+		}
 
-		// Wait for other threads to finish the sky gradient.
-		threadBarrier(skyGradient);
+		lap(timings.skyGradient);
 
-		// Wait for the visible distant object testing to finish.
+		// Wait for the visible distant object testing to finish. Distant objects also need the
+		// whole sky gradient, since any row might decide whether stars are drawn.
 		RenderThreadData::DistantSky &distantSky = threadData.distantSky;
 		lk.lock();
 		threadData.condVar.wait(lk, [&distantSky]() { return distantSky.doneVisTesting; });
 		lk.unlock();
+		skyGradient.tiles.waitForAll();
+		lap(timings.wait);
+
+		// Draw tiles of distant sky objects, unless the sky gradient already copied them from
+		// the sky layer.
+		while (distantSky.tiles.tryTakeTile(threadIndex, &tile))
+		{
+			if (skyGradient.skyLayer == nullptr)
+			{
+				getTileRange(tile, threadData.tileColumns, frame.width, &start, &end);
+				SoftwareRenderer::drawDistantSky(start, end, distantSky.parallaxSky,
+					*distantSky.visDistantObjs, *distantSky.skyTextures, *skyGradient.rowCache,
+					skyGradient.shouldDrawStars, *threadData.skyShadingInfo, frame);
 
-		// Draw this thread's portion of distant sky objects.
-		SoftwareRenderer::drawDistantSky(startX, endX, distantSky.parallaxSky,
-			*distantSky.visDistantObjs, *distantSky.skyTextures, *skyGradient.rowCache,
-			skyGradient.shouldDrawStars, *threadData.shadingInfo, *threadData.frame);
+				if (distantSky.skyLayer != nullptr)
+				{
+					distantSky.skyLayer->saveColumns(start, end, frame);
+				}
+			}
 
-		// Wait for other threads to finish distant sky objects.
-		threadBarrier(distantSky);
+			distantSky.tiles.setTileDone(tile);
+		}
 
-		// Number of columns to skip per ray cast (for interleaved ray casting as a means of
-		// load-balancing).
-		const int strideX = threadData.totalThreads;
+		lap(timings.distantSky);
 
-		// Draw this thread's portion of voxels.
+		// Draw tiles of voxels once the distant sky behind them is done.
 		RenderThreadData::Voxels &voxels = threadData.voxels;
-		SoftwareRenderer::drawVoxels(threadIndex, strideX, *threadData.camera,
-			voxels.ceilingHeight, *voxels.openDoors, *voxels.voxelGrid, *voxels.voxelTextures,
-			*voxels.occlusion, *threadData.shadingInfo, *threadData.frame);
-
-		// Wait for other threads to finish voxels.
-		threadBarrier(voxels);
+		while (voxels.tiles.tryTakeTile(threadIndex, &tile))
+		{
+			distantSky.tiles.waitForTile(tile);
+			lap(timings.wait);
+			getTileRange(tile, threadData.tileColumns, frame.width, &start, &end);
+			SoftwareRenderer::drawVoxels(start, end, *threadData.camera, voxels.ceilingHeight,
+				*voxels.openDoors, *voxels.voxelGrid, *voxels.voxelDataTypes,
+				*voxels.voxelTextures, *voxels.occlusion, *threadData.shadingInfo, frame);
+			voxels.tiles.setTileDone(tile);
+			lap(timings.voxels);
+		}
 
 		// Wait for the visible flat sorting to finish.
 		RenderThreadData::Flats &flats = threadData.flats;
 		lk.lock();
 		threadData.condVar.wait(lk, [&flats]() { return flats.doneSorting; });
 		lk.unlock();
+		lap(timings.wait);
+
+		// Draw tiles of flats once the voxels in front of and behind them are done.
+		while (flats.tiles.tryTakeTile(threadIndex, &tile))
+		{
+			voxels.tiles.waitForTile(tile);
+			lap(timings.wait);
+			getTileRange(tile, threadData.tileColumns, frame.width, &start, &end);
+			SoftwareRenderer::drawFlats(start, end, *threadData.camera, *flats.flatNormal,
+				*flats.visibleFlats, (*flats.visibleFlatBins)[tile], *flats.flatTextures,
+				*threadData.shadingInfo, frame);
+			flats.tiles.setTileDone(tile);
+			lap(timings.flats);
+		}
 
-		// Draw this thread's portion of flats.
-		SoftwareRenderer::drawFlats(startX, endX, *threadData.camera, *flats.flatNormal,
-			*flats.visibleFlats, *flats.flatTextures, *threadData.shadingInfo, *threadData.frame);
+		// Let the main thread know this thread is done with the frame. Tiles might still be in
+		// progress on other threads, so only the last thread to get here notifies.
+		lk.lock();
+		threadData.threadTimings[threadIndex] = timings;
+		threadData.threadsDone++;
+		const bool isLastThread = threadData.threadsDone == threadData.totalThreads;
+		lk.unlock();
 
-		// Wait for other threads to finish flats.
-		threadBarrier(flats);
+		if (isLastThread)
+		{
+			threadData.condVar.notify_all();
+		}
 	}
 }
 
-void SoftwareRenderer::render(const Double3 &eye, const Double3 &direction, double fovY,
+void SoftwareRenderer::beginFrame(const Double3 &eye, const Double3 &direction, double fovY,
 	double ambient, double daytimePercent, double latitude, bool parallaxSky, double ceilingHeight,
 	const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
-	uint32_t *colorBuffer)
+	bool pipelined, uint32_t *colorBuffer)
 {
 	// Constants for screen dimensions.
 	const double widthReal = static_cast<double>(this->width);
@@ -6427,82 +8856,216 @@ void SoftwareRenderer::render(const Double3 &eye, const Double3 &direction, doub
 	// To account for tall pixels.
 	const double projectionModifier = SoftwareRenderer::TALL_PIXEL_RATIO;
 
-	// 2.5D camera definition.
-	const Camera camera(eye, direction, fovY, aspect, projectionModifier);
-
-	// Normal of all flats (always facing the camera).
-	const Double3 flatNormal = Double3(-camera.forwardX, 0.0, -camera.forwardZ).normalized();
-
-	// Calculate shading information for this frame. Create some helper structs to keep similar
-	// values together.
-	const ShadingInfo shadingInfo(this->skyPalette, daytimePercent, latitude,
-		ambient, this->fogDistance);
-	const FrameView frame(colorBuffer, this->depthBuffer.data(), this->width, this->height);
+	// Calculate the camera and shading information for this frame, and keep them alive until
+	// the render threads are done with them.
+	// - 2.5D camera definition.
+	// - Normal of all flats (always facing the camera).
+	// - Helper structs to keep similar values together.
+	// - The fog is brought in to the max draw distance, so ray casting stops there.
+	// - The sky's time of day moves in steps so the sky layer can be reused between them. The
+	//   game world is shaded at the step too when whole frames can be reused.
+	const Camera newCamera(eye, direction, fovY, aspect, projectionModifier);
+	const DepthFormat depthFormat = SoftwareRenderer::getDepthFormatFromMode(this->depthBufferMode);
+	const double drawDistance = this->getDrawDistance();
+	const int skyDaytimeStep = SoftwareRenderer::getSkyDaytimeStep(daytimePercent);
+	const double skyDaytimePercent = static_cast<double>(skyDaytimeStep) /
+		static_cast<double>(SoftwareRenderer::SKY_DAYTIME_STEPS);
+	const double shadingDaytimePercent = this->frameReuse ? skyDaytimePercent : daytimePercent;
+	this->frameState = std::make_unique<FrameState>(newCamera,
+		ShadingInfo(this->skyPalette, shadingDaytimePercent, latitude, ambient, drawDistance),
+		ShadingInfo(this->skyPalette, skyDaytimePercent, latitude, ambient, drawDistance),
+		FrameView(colorBuffer, this->isPaletted() ?
+			SoftwareRenderer::getCacheLineStart(this->indexBuffer) : nullptr,
+			this->inversePalette.data(), SoftwareRenderer::getCacheLineStart(this->depthBuffer),
+			this->depthRows.data(),
+			depthFormat, drawDistance, this->width, this->height),
+		Double3(-newCamera.forwardX, 0.0, -newCamera.forwardZ).normalized());
+
+	// Sort the point lights near the camera into cells. The render threads aren't using the
+	// light grid since the last frame has finished.
+	this->lightGrid.update(this->lights, this->frameState->camera, drawDistance, this->width);
+	this->frameState->shadingInfo.lightGrid = &this->lightGrid;
+
+	// Column rays are spread evenly across the screen at a depth of one.
+	this->frameState->shadingInfo.mipPixelSize = this->mipmapping ?
+		((2.0 * aspect) / (this->frameState->camera.zoom * widthReal)) : 0.0;
+
+	// Night light texels are yellow and fully lit at night, and black during the day.
+	const Color nightLightColor = this->nightLightsActive ? Color(255, 166, 0) : Color::Black;
+	this->frameState->shadingInfo.nightLightTexel = SpanKernels::packTexel(nightLightColor.r,
+		nightLightColor.g, nightLightColor.b,
+		this->nightLightsActive ? SpanKernels::TEXEL_FLAG_EMISSIVE : 0);
+
+	const Camera &camera = this->frameState->camera;
+	const ShadingInfo &shadingInfo = this->frameState->shadingInfo;
+	const ShadingInfo &skyShadingInfo = this->frameState->skyShadingInfo;
+	const FrameView &frame = this->frameState->frame;
+	const Double3 &flatNormal = this->frameState->flatNormal;
+
+	// Look up the data type of each voxel ID once, so voxel columns can skip air and pick the
+	// drawing function for a voxel without going through its voxel data.
+	const int voxelDataCount = voxelGrid.getVoxelDataCount();
+	this->voxelDataTypes.resize(voxelDataCount);
+	for (int i = 0; i < voxelDataCount; i++)
+	{
+		const VoxelData &voxelData = voxelGrid.getVoxelData(static_cast<uint16_t>(i));
+		this->voxelDataTypes[i] = voxelData.dataType;
+	}
 
 	// Projected Y range of the sky gradient.
 	double gradientProjYTop, gradientProjYBottom;
 	SoftwareRenderer::getSkyGradientProjectedYRange(camera, gradientProjYTop, gradientProjYBottom);
 
+	// See if the distant sky can be copied from the sky layer, or if it has to be drawn again.
+	const SkyLayer::Use skyLayerUse = this->skyLayer.update(direction, fovY, skyDaytimeStep,
+		latitude, SpanKernels::getLightLevel(skyShadingInfo.distantAmbient), parallaxSky,
+		this->distantObjects);
+	const bool copySkyLayer = skyLayerUse == SkyLayer::Use::Copy;
+	const bool saveSkyLayer = skyLayerUse == SkyLayer::Use::DrawAndSave;
+
+	// Keep this frame's values so the next frame can be compared with them.
+	if (this->frameReuse)
+	{
+		this->lastFrame.update(eye, direction, fovY, skyDaytimeStep, ambient, latitude,
+			parallaxSky, ceilingHeight, openDoors, voxelGrid, this->distantObjects);
+	}
+
 	// Set all the render-thread-specific shared data for this frame.
-	this->threadData.init(static_cast<int>(this->renderThreads.size()),
-		camera, shadingInfo, frame);
+	this->threadData.init(camera, shadingInfo, skyShadingInfo, frame);
 	this->threadData.skyGradient.init(gradientProjYTop, gradientProjYBottom,
-		this->skyGradientRowCache);
-	this->threadData.distantSky.init(parallaxSky, this->visDistantObjs, this->skyTextures);
-	this->threadData.voxels.init(ceilingHeight, openDoors, voxelGrid,
+		this->skyGradientRowCache, copySkyLayer ? &this->skyLayer : nullptr);
+	this->threadData.distantSky.init(parallaxSky, this->visDistantObjs, this->skyTextures,
+		saveSkyLayer ? &this->skyLayer : nullptr);
+	this->threadData.voxels.init(ceilingHeight, openDoors, voxelGrid, this->voxelDataTypes,
 		this->voxelTextures, this->occlusion);
-	this->threadData.flats.init(flatNormal, this->visibleFlats, this->flatTextures);
+	this->threadData.flats.init(flatNormal, this->visibleFlats, this->visibleFlatBins,
+		this->flatTextures);
 
-	// Give the render threads the go signal. They can work on the sky and voxels while this thread
-	// does things like resetting occlusion and doing visible flat determination.
+	// Give the render threads the go signal. They can work on the sky gradient while this thread
+	// does visible object determination.
 	// - Note about locks: they must always be locked before wait(), and stay locked after wait().
 	std::unique_lock<std::mutex> lk(this->threadData.mutex);
-	this->threadData.go = true;
+	this->threadData.frameNumber++;
 	lk.unlock();
 	this->threadData.condVar.notify_all();
+	this->frameInFlight = true;
 
-	// Reset occlusion. Don't need to reset sky gradient row cache because it is written to before
-	// it is read.
-	std::fill(this->occlusion.begin(), this->occlusion.end(), OcclusionData(0, this->height));
+	// Occlusion and depth are reset by the render threads one column at a time. Don't need to
+	// reset sky gradient row cache because it is written to before it is read.
 
-	// Refresh the visible distant objects.
-	this->updateVisibleDistantObjects(parallaxSky, shadingInfo, camera, frame);
-
-	lk.lock();
-	this->threadData.condVar.wait(lk, [this]()
+	// Refresh the visible distant objects, unless they're copied from the sky layer.
+	auto visTestStartTime = std::chrono::steady_clock::now();
+	if (!copySkyLayer)
 	{
-		return this->threadData.skyGradient.threadsDone == this->threadData.totalThreads;
-	});
+		this->updateVisibleDistantObjects(parallaxSky, skyShadingInfo, camera, frame);
+
+		if (saveSkyLayer)
+		{
+			this->skyLayer.updateRows(this->visDistantObjs);
+		}
+	}
 
-	// Keep the render threads from getting the go signal again before the next frame.
-	this->threadData.go = false;
+	this->frameState->visibleDistantObjectsTime = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - visTestStartTime).count();
 
-	// Let the render threads know that they can start drawing distant objects.
+	// Let the render threads know that they can start drawing distant objects (and voxels).
+	lk.lock();
 	this->threadData.distantSky.doneVisTesting = true;
-
 	lk.unlock();
 	this->threadData.condVar.notify_all();
 
-	// Refresh the visible flats. This should erase the old list, calculate a new list, and sort
-	// it by depth.
-	this->updateVisibleFlats(camera);
-
-	lk.lock();
-	this->threadData.condVar.wait(lk, [this]()
-	{
-		return this->threadData.voxels.threadsDone == this->threadData.totalThreads;
-	});
+	// Refresh the visible flats. This should erase the old list, calculate a new list, sort
+	// it by depth, and bin it by column tile.
+	visTestStartTime = std::chrono::steady_clock::now();
+	this->updateVisibleFlats(camera, drawDistance, pipelined);
+	this->binVisibleFlats(frame);
+	this->frameState->visibleFlatsTime = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - visTestStartTime).count();
 
 	// Let the render threads know that they can start drawing flats.
+	lk.lock();
 	this->threadData.flats.doneSorting = true;
-
 	lk.unlock();
 	this->threadData.condVar.notify_all();
+}
 
-	// Wait until render threads are done drawing flats.
-	lk.lock();
-	this->threadData.condVar.wait(lk, [this]()
+void SoftwareRenderer::render(const Double3 &eye, const Double3 &direction, double fovY,
+	double ambient, double daytimePercent, double latitude, bool parallaxSky, double ceilingHeight,
+	const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
+	uint32_t *colorBuffer)
+{
+	// A pipelined frame might still be using the per-frame state.
+	this->waitForFrame();
+
+	this->beginFrame(eye, direction, fovY, ambient, daytimePercent, latitude, parallaxSky,
+		ceilingHeight, openDoors, voxelGrid, false, colorBuffer);
+
+	// Wait until render threads are done with the frame.
+	this->waitForFrame();
+
+	if (this->isPaletted())
 	{
-		return this->threadData.flats.threadsDone == this->threadData.totalThreads;
-	});
+		this->expandIndexBuffer(colorBuffer);
+	}
+}
+
+const uint32_t *SoftwareRenderer::renderPipelined(const Double3 &eye, const Double3 &direction,
+	double fovY, double ambient, double daytimePercent, double latitude, bool parallaxSky,
+	double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
+	const VoxelGrid &voxelGrid)
+{
+	// Finish the frame in flight. Its buffer becomes the newest finished frame.
+	if (this->frameInFlight)
+	{
+		this->waitForFrame();
+
+		if (this->isPaletted())
+		{
+			this->expandIndexBuffer(this->backColorBuffer.data());
+		}
+
+		std::swap(this->frontColorBuffer, this->backColorBuffer);
+		this->hasFrontBuffer = true;
+	}
+
+	// Keep showing the newest finished frame if nothing has changed since it was started.
+	if (this->hasFrontBuffer && this->isFrameReusable(eye, direction, fovY, ambient,
+		daytimePercent, latitude, parallaxSky, ceilingHeight, openDoors, voxelGrid))
+	{
+		return this->frontColorBuffer.data();
+	}
+
+	// Copy the scene values that the caller might change while the next frame is drawing.
+	this->pipelinedOpenDoors = openDoors;
+
+	// The voxel grid is only copied again when it has changed since the last copy.
+	if (this->pipelinedVoxelGrid == nullptr)
+	{
+		this->pipelinedVoxelGrid = std::make_unique<VoxelGrid>(voxelGrid);
+	}
+	else if (this->pipelinedVoxelGrid->getRevision() != voxelGrid.getRevision())
+	{
+		*this->pipelinedVoxelGrid = voxelGrid;
+	}
+
+	this->beginFrame(eye, direction, fovY, ambient, daytimePercent, latitude, parallaxSky,
+		ceilingHeight, this->pipelinedOpenDoors, *this->pipelinedVoxelGrid, true,
+		this->backColorBuffer.data());
+
+	// If no frame has finished yet (i.e., the first frame after a reset), finish this one now
+	// so there is something to show.
+	if (!this->hasFrontBuffer)
+	{
+		this->waitForFrame();
+
+		if (this->isPaletted())
+		{
+			this->expandIndexBuffer(this->backColorBuffer.data());
+		}
+
+		std::swap(this->frontColorBuffer, this->backColorBuffer);
+		this->hasFrontBuffer = true;
+	}
+
+	return this->frontColorBuffer.data();
 }
@@ -3,13 +3,16 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "SpanKernels.h"
 #include "../Math/Matrix4.h"
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
@@ -17,6 +20,7 @@
 #include "../World/DistantSky.h"
 #include "../World/LevelData.h"
 #include "../World/VoxelData.h"
+#include "../World/VoxelDataType.h"
 
 // This class runs the CPU-based 3D rendering for the application.
 
@@ -24,47 +28,133 @@ class VoxelGrid;
 
 class SoftwareRenderer
 {
+public:
+	// Ways of splitting a frame between render threads.
+	enum class TileLayout
+	{
+		Columns, // Blocks of columns a whole cache line wide, stolen between threads.
+		Interleaved // Single columns (and rows) dealt out in turn, without stealing.
+	};
+
+	// Timings in milliseconds for the phases of a frame, for telling whether render threads are
+	// busy drawing or stalled waiting on other threads.
+	struct FrameTimings
+	{
+		struct Thread
+		{
+			double skyGradient, distantSky, voxels, flats;
+			double wait; // Waiting on the main thread or on tiles owned by other threads.
+
+			Thread();
+
+			double getTotal() const;
+		};
+
+		std::vector<Thread> threads; // One per render thread.
+		double visibleDistantObjects, visibleFlats; // Main thread work.
+		double frame; // From starting the frame until the main thread sees it finished.
+
+		FrameTimings();
+	};
 private:
+	// Texels are packed into four bytes each (8-bit color channels plus alpha or flags) so the
+	// texture tables stay small enough for the column loops to remain cache-friendly.
 	struct VoxelTexel
 	{
-		double r, g, b, emission;
-		bool transparent; // Voxel texels only support alpha testing, not alpha blending.
+		static const uint8_t FLAG_TRANSPARENT = SpanKernels::TEXEL_FLAG_TRANSPARENT;
+		static const uint8_t FLAG_NIGHT_LIGHT = SpanKernels::TEXEL_FLAG_NIGHT_LIGHT;
+
+		uint8_t r, g, b;
+		uint8_t flags; // Voxel texels only support alpha testing, not alpha blending.
 
 		VoxelTexel();
+
+		bool isTransparent() const;
+		bool isNightLight() const;
+
+		void set(uint32_t argb);
 	};
 
 	struct FlatTexel
 	{
-		double r, g, b, a;
+		uint8_t r, g, b, a;
 
 		FlatTexel();
+
+		void set(uint32_t argb);
 	};
 
 	// For distant sky objects (mountains, clouds, etc.).
 	struct SkyTexel
 	{
-		double r, g, b;
+		uint8_t r, g, b;
 		bool transparent;
 
 		SkyTexel();
+
+		void set(uint32_t argb);
 	};
 
 	struct VoxelTexture
 	{
-		static const int WIDTH = 64;
-		static const int HEIGHT = VoxelTexture::WIDTH;
+		static const int WIDTH = SpanKernels::TEXTURE_WIDTH;
+		static const int HEIGHT = SpanKernels::TEXTURE_HEIGHT;
 		static const int TEXEL_COUNT = VoxelTexture::WIDTH * VoxelTexture::HEIGHT;
 
-		std::array<VoxelTexel, VoxelTexture::TEXEL_COUNT> texels;
-		std::vector<Int2> lightTexels; // Black during the day, yellow at night.
+		// Mip levels go from the full-size texture down to 1x1, each a quarter the size of
+		// the last, so all of them together are a third bigger than the first.
+		static const int MIP_LEVEL_COUNT = SpanKernels::TEXTURE_BITS + 1;
+		static const int MIP_TEXEL_COUNT = ((VoxelTexture::TEXEL_COUNT * 4) - 1) / 3;
+
+		// Texels of each mip level back-to-back, starting with the full-size texture. Each
+		// level is column-major to match the order texels are read in when drawing columns.
+		std::array<VoxelTexel, VoxelTexture::MIP_TEXEL_COUNT> texels;
+
+		// Gets the index of a mip level's first texel. Level 0 is the full-size texture.
+		static int getMipOffset(int mipLevel);
+
+		// Gets the texels of a mip level.
+		const VoxelTexel *getTexels(int mipLevel) const;
+
+		// Regenerates each mip level after the first from the full-size texels.
+		void updateMipLevels();
 	};
 
 	struct FlatTexture
 	{
-		std::vector<FlatTexel> texels;
+		// Flat textures can be any size, so each mip level's size is half of the last one's,
+		// rounded down, until both are 1.
+		struct MipLevel
+		{
+			int offset; // Index of the level's first texel.
+			int columnOffset; // Index of the level's first column in the column runs.
+			int width, height;
+
+			MipLevel(int offset, int columnOffset, int width, int height);
+		};
+
+		// Rows [start, end) of a texture column that are all opaque. Most texels of sprites
+		// are transparent, so only these are drawn.
+		struct OpaqueRun
+		{
+			int start, end;
+
+			OpaqueRun(int start, int end);
+		};
+
+		std::vector<FlatTexel> texels; // Each mip level back-to-back, column-major.
+		std::vector<MipLevel> mipLevels; // Level 0 is the full-size texture.
+		std::vector<OpaqueRun> opaqueRuns; // Runs of each column of each level, top to bottom.
+		std::vector<int> columnRuns; // Index of each column's first run, plus the run count.
 		int width, height;
 
 		FlatTexture();
+
+		// Regenerates each mip level after the first from the full-size texels.
+		void updateMipLevels();
+
+		// Finds the opaque runs of every column in every mip level.
+		void updateOpaqueRuns();
 	};
 
 	struct SkyTexture
@@ -151,6 +241,44 @@ private:
 		Double3 normal;
 	};
 
+	// A point light that lights everything within its intensity (in voxels) of its XZ position,
+	// fading linearly to nothing at that distance. Height is ignored, like with fog.
+	struct Light
+	{
+		Double3 point, color;
+		double intensity;
+
+		Light();
+	};
+
+	// Point lights near the camera sorted into a grid of XZ cells once per frame, so a surface
+	// only checks the few lights whose radius touches its cell.
+	class LightGrid
+	{
+	private:
+		std::vector<Light> lights; // Copied so render threads don't see changes mid-frame.
+		std::vector<int> cellStarts; // Index into 'cellLights' for each cell, plus one at the end.
+		std::vector<int> cellLights; // Light indices of each cell, packed together.
+		std::vector<Double2> columnDirections; // Normalized XZ ray of each screen column.
+		std::vector<Int2> cellLightPairs; // Scratch (cell index, light index) pairs.
+		Double2 eye, origin; // Origin is the corner of the first cell.
+		double cellDim;
+		int cellCount; // Cells per side.
+	public:
+		LightGrid();
+
+		// Rebuilds the grid with the lights that can be seen within the fog distance.
+		void update(const std::unordered_map<int, Light> &lights, const Camera &camera,
+			double fogDistance, int frameWidth);
+
+		// Gets the XZ point at some depth along a screen column's ray.
+		Double2 getColumnPoint(int x, double depth) const;
+
+		// Gets the sum of point lights at an XZ point on a surface. Lights behind the surface's
+		// XZ normal are skipped, so pass a zero normal for surfaces lit from any side.
+		Double3 getLight(const Double2 &point, const Double2 &normal) const;
+	};
+
 	// Helper struct for keeping shading data organized in the renderer. These values are
 	// computed once per frame.
 	struct ShadingInfo
@@ -179,6 +307,20 @@ private:
 		// Distance at which fog is maximum.
 		double fogDistance;
 
+		// Packed fog color, and the scale from depth to a span kernel fog factor.
+		uint32_t fogColorRGB;
+		double fogScale;
+
+		// World width of a pixel at a depth of one, for choosing mip levels. Zero if
+		// mipmapping is off, so the full-size textures are always used.
+		double mipPixelSize;
+
+		// Packed texel drawn in place of voxel texels flagged as night lights.
+		uint32_t nightLightTexel;
+
+		// Point lights for this frame. Owned by the renderer.
+		const LightGrid *lightGrid;
+
 		// Returns whether the current clock time is before noon.
 		bool isAM;
 
@@ -186,18 +328,86 @@ private:
 			double ambient, double fogDistance);
 
 		const Double3 &getFogColor() const;
+
+		// Gets the ambient light plus sunlight on a surface facing the given direction.
+		Double3 getSunlight(const Double3 &normal) const;
+	};
+
+	// Storage formats for the depth buffer. Smaller formats reduce per-frame memory traffic
+	// at high resolutions in exchange for precision.
+	enum class DepthFormat
+	{
+		Double, // 64-bit floating point.
+		Float, // 32-bit floating point.
+		Fixed16 // 16-bit unsigned distance, quantized over the fog distance.
+	};
+
+	// Rows of a frame buffer column whose depth has been cleared in the current frame. Depth
+	// outside of them is left over from earlier frames, so the depth buffer is only cleared
+	// where something is drawn instead of all of it every frame.
+	struct DepthRows
+	{
+		int yStart, yEnd;
+
+		DepthRows();
 	};
 
 	// Helper struct for values related to the frame buffer. The pointers are owned
 	// elsewhere; they are copied here simply for convenience.
 	struct FrameView
 	{
+		// Largest 16-bit depth value, reserved for infinity (i.e., cleared depth).
+		static const uint16_t FIXED16_INFINITY;
+
 		uint32_t *colorBuffer;
-		double *depthBuffer;
+		uint8_t *indexBuffer; // Palette indices drawn instead of colors, if not null.
+		const uint8_t *inversePalette; // Nearest palette index of each 15-bit color.
+		void *depthBuffer; // Interpreted by depth format.
+		DepthRows *depthRows; // One per column.
+		DepthFormat depthFormat;
+		double fixed16Step, fixed16StepRecip; // Distance per 16-bit depth increment.
+		double depthBias; // Least distance a wall must be in front by, per depth format.
 		int width, height;
 		double widthReal, heightReal;
 
-		FrameView(uint32_t *colorBuffer, double *depthBuffer, int width, int height);
+		FrameView(uint32_t *colorBuffer, uint8_t *indexBuffer, const uint8_t *inversePalette,
+			void *depthBuffer, DepthRows *depthRows, DepthFormat depthFormat, double depthRange,
+			int width, int height);
+
+		// Sets the color at the given pixel index, converted to a palette index if paletted.
+		void setColor(int index, uint32_t colorRGB) const;
+
+		// Sets the color of the given number of pixels starting at the given pixel index.
+		void fillColor(int index, int count, uint32_t colorRGB) const;
+
+		// Gets the depth at the given pixel index, converted from the depth format.
+		double getDepth(int index) const;
+
+		// Sets the depth at the given pixel index, converted to the depth format.
+		void setDepth(int index, double depth) const;
+
+		// Like getDepth() and setDepth(), but for a depth format known by its element type,
+		// so loops over many pixels can check the depth format once.
+		template <typename T>
+		double getDepthAs(int index) const;
+		template <typename T>
+		void setDepthAs(int index, double depth) const;
+
+		// Sets the depth of each pixel in the given rows of a column to infinity.
+		void clearDepth(int x, int yStart, int yEnd) const;
+
+		// Marks none of a column's depth as cleared. Done once per column each frame.
+		void resetDepthRows(int x) const;
+
+		// Clears any of the given rows of a column not cleared yet this frame, plus any rows
+		// between them and the cleared ones. Depth must be prepared before it's read.
+		void prepareDepth(int x, int yStart, int yEnd) const;
+
+		// Like prepareDepth(), but for drawing that writes every given row it finds cleared,
+		// so only rows between them and the cleared ones are cleared. Returns the rows cleared
+		// before; the caller must write the depth of the given rows outside of them without
+		// reading it first.
+		DepthRows claimDepth(int x, int yStart, int yEnd) const;
 	};
 
 	// A flat is a 2D surface always facing perpendicular to the Y axis, and opposite to
@@ -227,6 +437,16 @@ private:
 		};
 	};
 
+	// Flats in one square area of the XZ plane, for finding flats near the view frustum
+	// without checking every flat in the world.
+	struct FlatChunk
+	{
+		std::vector<const Flat*> flats; // Points into the renderer's flats map.
+		double maxHalfWidth; // Farthest any flat reaches past the chunk's bounds.
+
+		FlatChunk();
+	};
+
 	// Helper class for visible flat data.
 	class VisibleFlat
 	{
@@ -238,6 +458,9 @@ private:
 
 		const Flat &getFlat() const;
 		const Flat::Frame &getFrame() const;
+
+		// Points to a copy of the flat instead (i.e., for pipelined frames).
+		void setFlat(const Flat &flat);
 	};
 
 	// Pairs together a distant sky object with its render texture index. If it's an animation,
@@ -251,6 +474,27 @@ private:
 		DistantObject(const T &obj, int textureIndex);
 	};
 
+	// Distant objects grouped by direction, so visibility testing only has to look at the groups
+	// that might be on-screen. Each bucket is the objects of one azimuth and elevation cell,
+	// with a cone around them that is tested in place of each object.
+	struct DistantBuckets
+	{
+		struct Bucket
+		{
+			std::vector<int> indices; // Objects in the bucket, in ascending order.
+			Double3 direction; // Center of the cone.
+			double radius; // Angle from the center to the farthest object, in radians.
+			double maxHalfWidthRadians; // Horizontal half size of the widest object.
+			double maxHeight; // Height of the tallest object relative to the identity dim.
+		};
+
+		std::vector<Bucket> buckets; // Only non-empty buckets.
+
+		// Groups objects by direction. Dimensions are relative to the identity dim.
+		void init(const std::vector<Double3> &directions, const std::vector<Double2> &dimensions);
+		void clear();
+	};
+
 	// Collection of all distant objects.
 	struct DistantObjects
 	{
@@ -262,6 +506,7 @@ private:
 		std::vector<DistantObject<DistantSky::AirObject>> airs;
 		std::vector<DistantObject<DistantSky::MoonObject>> moons;
 		std::vector<DistantObject<DistantSky::StarObject>> stars;
+		DistantBuckets landBuckets, animLandBuckets, airBuckets, starBuckets;
 		int sunTextureIndex; // Points into skyTextures if the sun exists, or NO_SUN if it doesn't.
 
 		DistantObjects();
@@ -314,55 +559,166 @@ private:
 		void clear();
 	};
 
+	// Sky gradient and distant sky pixels saved by a frame that drew the distant sky. While the
+	// sky would look the same (i.e., the camera isn't turning and the sky's time of day is in
+	// the same step), frames copy the rows with distant objects from here instead of drawing
+	// the distant sky again. The other rows are only one color each, so they aren't kept.
+	struct SkyLayer
+	{
+		// What a frame does with the sky layer. It's only saved once the sky is the same two
+		// frames in a row, so a turning camera doesn't pay for saving it every frame.
+		enum class Use { Draw, DrawAndSave, Copy };
+
+		std::vector<uint32_t> colors;
+		std::vector<uint8_t> indices; // Used instead of colors when frames are paletted.
+		std::vector<int> animLandIndices; // Image index of each animated land object.
+		Double3 direction; // Camera direction.
+		double fovY, latitude;
+		int width, daytimeStep, distantLightLevel;
+		int yStart, yEnd; // Rows with distant objects in them.
+		bool parallaxSky;
+		bool saved; // True if the colors have the sky for the values above.
+
+		SkyLayer();
+
+		// Reallocates for new frame dimensions. Nothing is saved afterwards.
+		void init(int width, int height);
+
+		// Compares the values the sky depends on with the last frame's and keeps the new ones.
+		// Returns what the frame with these values does with the sky layer.
+		Use update(const Double3 &direction, double fovY, int daytimeStep, double latitude,
+			int distantLightLevel, bool parallaxSky, const DistantObjects &distantObjects);
+
+		// Sets the rows to keep from the newly visible distant objects.
+		void updateRows(const VisDistantObjects &visDistantObjs);
+
+		// Copies a row of the layer to the frame buffer.
+		void copyRow(int y, const FrameView &frame) const;
+
+		// Saves the kept rows of the given columns from the frame buffer.
+		void saveColumns(int startX, int endX, const FrameView &frame);
+	};
+
+	// Values the last started frame was drawn with. When the next frame's values are the same
+	// and nothing else in the renderer has changed, the last frame can be shown again instead.
+	struct LastFrame
+	{
+		std::vector<LevelData::DoorState> openDoors;
+		std::vector<int> animLandIndices; // Image index of each animated land object.
+		Double3 eye, direction;
+		double fovY, ambient, latitude, ceilingHeight;
+		uint64_t voxelRevision; // Changes whenever the voxel grid or its voxel data does.
+		int daytimeStep;
+		bool parallaxSky;
+		bool valid; // True if the values above are the last started frame's.
+
+		LastFrame();
+
+		// Returns whether a frame with these values would look the same as the last one. The
+		// time of day only has to be in the same step, since frames are shaded at the step.
+		bool matches(const Double3 &eye, const Double3 &direction, double fovY,
+			int daytimeStep, double ambient, double latitude, bool parallaxSky,
+			double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
+			const VoxelGrid &voxelGrid, const DistantObjects &distantObjects) const;
+
+		// Keeps the values of a new frame.
+		void update(const Double3 &eye, const Double3 &direction, double fovY,
+			int daytimeStep, double ambient, double latitude, bool parallaxSky,
+			double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
+			const VoxelGrid &voxelGrid, const DistantObjects &distantObjects);
+	};
+
 	// Data owned by the main thread that is referenced by render threads.
 	struct RenderThreadData
 	{
+		// One step of the frame split into tiles (groups of rows or columns). Each render thread
+		// starts the frame owning a contiguous range of tiles and takes them from the front.
+		// When its range is empty, it steals from the back of another thread's range, so one
+		// slow region of the screen doesn't leave the other threads idle. A range is packed
+		// into one atomic so both ends can be claimed with compare-and-swap.
+		// - When interleaved, a thread owns every Nth tile instead (N being the thread count),
+		//   its range counts only those tiles, and it never steals.
+		struct TilePhase
+		{
+			std::vector<std::atomic<uint64_t>> ranges; // Begin and end tile of each thread.
+			std::vector<std::atomic<bool>> tilesDone;
+			std::atomic<int> doneCount;
+			int tileCount;
+			bool interleaved;
+
+			TilePhase();
+
+			// Reallocates for a new tile or thread count.
+			void init(int tileCount, int threadCount, bool interleaved);
+
+			// Gives each thread its initial range of tiles and marks all tiles as not done.
+			void reset();
+
+			// Takes a tile from the given thread's range, or steals one from another thread.
+			// Returns false when every tile has been taken.
+			bool tryTakeTile(int threadIndex, int *outTile);
+
+			void setTileDone(int tile);
+			bool isTileDone(int tile) const;
+
+			// Yields until the given tile (or every tile) is done. Only meant for tiles that
+			// have already been taken, so the wait is bounded by another thread's tile.
+			void waitForTile(int tile) const;
+			void waitForAll() const;
+		};
+
 		struct SkyGradient
 		{
-			int threadsDone;
+			TilePhase tiles; // Rows.
 			std::vector<Double3> *rowCache;
+			const SkyLayer *skyLayer; // Copied from if reused this frame, otherwise null.
 			double projectedYTop, projectedYBottom; // Projected Y range of sky gradient.
 			std::atomic<bool> shouldDrawStars; // True if the sky is dark enough.
 
 			void init(double projectedYTop, double projectedYBottom,
-				std::vector<Double3> &rowCache);
+				std::vector<Double3> &rowCache, const SkyLayer *skyLayer);
 		};
 
 		struct DistantSky
 		{
-			int threadsDone;
+			TilePhase tiles; // Columns.
 			const VisDistantObjects *visDistantObjs;
 			const std::vector<SkyTexture> *skyTextures;
+			SkyLayer *skyLayer; // Saved to after drawing, or null if not saved this frame.
 			bool parallaxSky;
 			bool doneVisTesting; // True when render threads can start rendering distant sky.
 
 			void init(bool parallaxSky, const VisDistantObjects &visDistantObjs,
-				const std::vector<SkyTexture> &skyTextures);
+				const std::vector<SkyTexture> &skyTextures, SkyLayer *skyLayer);
 		};
 
 		struct Voxels
 		{
-			int threadsDone;
+			TilePhase tiles; // Columns. A tile depends on the same distant sky tile.
 			const std::vector<LevelData::DoorState> *openDoors;
 			const VoxelGrid *voxelGrid;
+			const std::vector<VoxelDataType> *voxelDataTypes;
 			const std::vector<VoxelTexture> *voxelTextures;
 			std::vector<OcclusionData> *occlusion;
 			double ceilingHeight;
 
 			void init(double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
-				const VoxelGrid &voxelGrid, const std::vector<VoxelTexture> &voxelTextures,
+				const VoxelGrid &voxelGrid, const std::vector<VoxelDataType> &voxelDataTypes,
+				const std::vector<VoxelTexture> &voxelTextures,
 				std::vector<OcclusionData> &occlusion);
 		};
 
 		struct Flats
 		{
-			int threadsDone;
+			TilePhase tiles; // Columns. A tile depends on the same voxel tile.
 			const Double3 *flatNormal;
 			const std::vector<VisibleFlat> *visibleFlats;
+			const std::vector<std::vector<int>> *visibleFlatBins; // One bin per tile.
 			const std::vector<FlatTexture> *flatTextures;
 			bool doneSorting; // True when render threads can start rendering flats.
 
 			void init(const Double3 &flatNormal, const std::vector<VisibleFlat> &visibleFlats,
+				const std::vector<std::vector<int>> &visibleFlatBins,
 				const std::vector<FlatTexture> &flatTextures);
 		};
 
@@ -372,24 +728,90 @@ private:
 		Flats flats;
 		const Camera *camera;
 		const ShadingInfo *shadingInfo;
+		const ShadingInfo *skyShadingInfo; // At the sky's time of day step.
 		const FrameView *frame;
 
+		std::vector<FrameTimings::Thread> threadTimings; // Each render thread writes its own.
 		std::condition_variable condVar;
 		std::mutex mutex;
+		int tileRows; // Rows in a sky gradient tile.
+		int tileColumns; // Columns in a tile of every other phase.
 		int totalThreads;
-		bool go; // Initial go signal to start work each frame.
+		int threadsDone; // Number of render threads finished with the current frame.
+		uint32_t frameNumber; // Incremented by the main thread to start a frame.
 		bool isDestructing; // Helps shut down threads in the renderer destructor.
 
 		RenderThreadData();
 
-		void init(int totalThreads, const Camera &camera, const ShadingInfo &shadingInfo,
+		// Reallocates the tile phases for new dimensions, a new thread count, or new tile sizes.
+		void initTiles(int width, int height, int totalThreads, int tileRows, int tileColumns,
+			bool interleaved);
+
+		void init(const Camera &camera, const ShadingInfo &shadingInfo,
+			const ShadingInfo &skyShadingInfo, const FrameView &frame);
+	};
+
+	// Per-frame values referenced by render threads. They are kept in the renderer instead of
+	// on the stack so a pipelined frame can keep drawing after render returns.
+	struct FrameState
+	{
+		Camera camera;
+		ShadingInfo shadingInfo; // At the time of day step if frame reuse is on.
+		ShadingInfo skyShadingInfo; // At the sky's time of day step.
+		FrameView frame;
+		Double3 flatNormal;
+		std::chrono::steady_clock::time_point startTime;
+		double visibleDistantObjectsTime, visibleFlatsTime; // Main thread work in milliseconds.
+
+		FrameState(const Camera &camera, ShadingInfo &&shadingInfo,
+			ShadingInfo &&skyShadingInfo, const FrameView &frame, const Double3 &flatNormal);
+	};
+
+	// Values shared by every voxel drawn in one voxel column of a screen column, so the voxel
+	// drawing functions only take what changes from voxel to voxel.
+	struct VoxelColumnContext
+	{
+		int x, voxelX, voxelZ;
+		const Camera &camera;
+		const Ray &ray;
+		VoxelData::Facing facing;
+		const Double3 &wallNormal;
+		const Double2 &nearPoint, &farPoint;
+		double nearZ, farZ, wallU;
+		const ShadingInfo &shadingInfo;
+		double ceilingHeight;
+		const std::vector<LevelData::DoorState> &openDoors;
+		const VoxelGrid &voxelGrid;
+		const std::vector<VoxelTexture> &textures;
+		OcclusionData &occlusion;
+		const FrameView &frame;
+
+		VoxelColumnContext(int x, int voxelX, int voxelZ, const Camera &camera, const Ray &ray,
+			VoxelData::Facing facing, const Double3 &wallNormal, const Double2 &nearPoint,
+			const Double2 &farPoint, double nearZ, double farZ, double wallU,
+			const ShadingInfo &shadingInfo, double ceilingHeight,
+			const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
+			const std::vector<VoxelTexture> &textures, OcclusionData &occlusion,
 			const FrameView &frame);
 	};
 
+	// Draws one voxel of a voxel column. There is one of these for each voxel data type and
+	// position in the column, so the column only has to look up which one to call.
+	typedef void (*VoxelDrawFunction)(int voxelY, const VoxelData &voxelData,
+		const VoxelColumnContext &column);
+
+	// Voxel drawing functions indexed by voxel data type (the last one is Door). The tables
+	// are checked against the data type order where they are defined.
+	static constexpr int VOXEL_DATA_TYPE_COUNT = static_cast<int>(VoxelDataType::Door) + 1;
+	typedef std::array<VoxelDrawFunction, VOXEL_DATA_TYPE_COUNT> VoxelDrawTable;
+
 	// Clipping planes for Z coordinates.
 	static const double NEAR_PLANE;
 	static const double FAR_PLANE;
 
+	// Closest that fog can be maximum at. Keeps the fog and depth buffer scales finite.
+	static const double MIN_DRAW_DISTANCE;
+
 	// Default texture array sizes (using vector instead of array to avoid stack overflow).
 	static const int DEFAULT_VOXEL_TEXTURE_COUNT;
 	static const int DEFAULT_FLAT_TEXTURE_COUNT;
@@ -403,30 +825,146 @@ private:
 	// Max angle of distant clouds above the horizon, in degrees.
 	static const double DISTANT_CLOUDS_MAX_ANGLE;
 
-	std::vector<double> depthBuffer; // 2D buffer, mostly consists of depth in the XZ plane.
+	// Number of azimuth and elevation cells that distant objects are grouped into. Star
+	// buckets are in space, before the latitude and time of day rotation.
+	static const int DISTANT_BUCKET_AZIMUTHS;
+	static const int DISTANT_BUCKET_ELEVATIONS;
+
+	// Number of steps in a day that the sky's time of day moves in, so the sky layer can be
+	// reused between steps. The game world is only shaded at the step when frame reuse is on,
+	// so a reused frame looks the same as a new one.
+	static const int SKY_DAYTIME_STEPS;
+
+	// Number of rows in a sky gradient tile. Tiles of the other phases are columns, as many
+	// as fill a cache line of each frame buffer's rows.
+	static const int TILE_ROWS;
+
+	// Bytes in a cache line. Column tiles on different threads never write to the same one
+	// (as long as the frame width is a multiple of the tile columns).
+	static const int CACHE_LINE_SIZE;
+
+	// Width and depth of a flat chunk in voxels.
+	static const int FLAT_CHUNK_DIM;
+
+	// Width and depth of a light grid cell in voxels, max cells per side of the light grid
+	// (cells get bigger past that), and max lights that can affect one cell.
+	static const double LIGHT_CELL_DIM;
+	static const int MAX_LIGHT_CELLS;
+	static const int MAX_LIGHTS_PER_CELL;
+
+	// Voxel drawing functions for the camera's voxel column and for the rest of the voxel
+	// columns a ray passes through. Each column has one table for the voxel at the camera's
+	// height, and ones for the voxels below and above it.
+	static const VoxelDrawTable INITIAL_VOXEL_DRAW_TABLE;
+	static const VoxelDrawTable INITIAL_VOXEL_BELOW_DRAW_TABLE;
+	static const VoxelDrawTable INITIAL_VOXEL_ABOVE_DRAW_TABLE;
+	static const VoxelDrawTable VOXEL_DRAW_TABLE;
+	static const VoxelDrawTable VOXEL_BELOW_DRAW_TABLE;
+	static const VoxelDrawTable VOXEL_ABOVE_DRAW_TABLE;
+
+	std::vector<uint8_t> depthBuffer; // 2D buffer, mostly consists of depth in the XZ plane.
+	std::vector<DepthRows> depthRows; // Cleared depth rows of each column.
 	std::vector<OcclusionData> occlusion; // Min and max Y for each column.
 	std::unordered_map<int, Flat> flats; // All flats in world.
+	std::unordered_map<Int2, FlatChunk> flatChunks; // Flats grouped by chunk.
 	std::vector<VisibleFlat> visibleFlats; // Flats to be drawn.
+	std::vector<std::vector<int>> visibleFlatBins; // Visible flat indices in each column tile.
+	std::unordered_map<int, Light> lights; // All point lights in world.
+	LightGrid lightGrid; // Lights near the camera for the current frame.
 	DistantObjects distantObjects; // Distant sky objects (mountains, clouds, etc.).
 	VisDistantObjects visDistantObjs; // Visible distant sky objects.
+	std::vector<VoxelDataType> voxelDataTypes; // Data type of each voxel ID in the voxel grid.
 	std::vector<VoxelTexture> voxelTextures; // Max 64 voxel textures in original engine.
 	std::vector<FlatTexture> flatTextures; // Max 256 flat textures in original engine.
 	std::vector<SkyTexture> skyTextures; // Distant object textures. Size is managed internally.
 	std::vector<Double3> skyPalette; // Colors for each time of day.
 	std::vector<Double3> skyGradientRowCache; // Contains row colors of most recent sky gradient.
+	std::vector<uint32_t> palette; // Colors of paletted frames, one per palette index.
+	std::vector<uint8_t> inversePalette; // Nearest palette index of each 15-bit color.
+	int paletteCount; // Colors given with the palette. The rest of the entries are black.
+	std::vector<uint8_t> indexBuffer; // Palette indices of the frame being drawn, if paletted.
+	SkyLayer skyLayer; // Distant sky of the last frame that drew it.
+	LastFrame lastFrame; // Values of the last started frame, if frame reuse is on.
 	std::vector<std::thread> renderThreads; // Threads used for rendering the world.
 	RenderThreadData threadData; // Managed by main thread, used by render threads.
+	std::unique_ptr<FrameState> frameState; // Values for the most recently started frame.
+	FrameTimings frameTimings; // Timings of the most recently finished frame.
+	std::vector<uint32_t> frontColorBuffer, backColorBuffer; // Pipelined frames only.
+	std::vector<LevelData::DoorState> pipelinedOpenDoors; // Copy for the frame in flight.
+	std::unique_ptr<VoxelGrid> pipelinedVoxelGrid; // Copy for the frame in flight.
+	std::vector<Flat> pipelinedFlats; // Copies of the frame in flight's visible flats.
 	double fogDistance; // Distance at which fog is maximum.
+	double maxDrawDistance; // Fog is maximum here if it's closer than the fog distance.
 	int width, height; // Dimensions of frame buffer.
 	int renderThreadsMode; // Determines number of threads to use for rendering.
+	int depthBufferMode; // Determines the storage format of the depth buffer.
+	TileLayout tileLayout; // How frames are split between render threads.
+	bool framePipelining; // Whether render threads draw a frame while the caller presents.
+	bool frameReuse; // Whether the last frame can be shown again when nothing has changed.
+	bool mipmapping; // Whether distant textures are drawn with smaller mip levels.
+	bool palettedRendering; // Whether frames are drawn as palette indices when there's a palette.
+	bool nightLightsActive; // Whether night light texels are lit.
+	bool frameInFlight; // Whether render threads are still drawing the last started frame.
+	bool hasFrontBuffer; // Whether the front color buffer holds a finished frame.
 
-	// Gets the number of render threads to use based on the given mode.
-	static int getRenderThreadsFromMode(int mode);
+	// Gets the depth buffer format to use based on the given mode.
+	static DepthFormat getDepthFormatFromMode(int mode);
+
+	// Gets the size in bytes of one depth value in the given format.
+	static int getDepthFormatSize(DepthFormat depthFormat);
+
+	// Gets which of the sky's time of day steps the given time of day is in.
+	static int getSkyDaytimeStep(double daytimePercent);
+
+	// Gets the first byte of a frame buffer that starts on a cache line. Frame buffers are
+	// allocated with one cache line of spare bytes for this.
+	static uint8_t *getCacheLineStart(std::vector<uint8_t> &buffer);
+
+	// Reallocates the depth buffer for the current dimensions and depth buffer mode. It isn't
+	// cleared; each frame clears the rows it draws to.
+	void initDepthBuffer();
+
+	// Whether frames are drawn as palette indices. A palette must be set for them to be.
+	bool isPaletted() const;
+
+	// Builds the inverse palette for the current palette if frames are paletted and it isn't
+	// built yet. It takes a while, so it waits until paletted frames are first drawn.
+	void initInversePalette();
+
+	// Reallocates the palette index buffer for the current dimensions, or frees it if frames
+	// aren't paletted.
+	void initIndexBuffer();
+
+	// Converts the palette indices of a finished frame to ARGB8888 colors.
+	void expandIndexBuffer(uint32_t *colorBuffer);
+
+	// Gets the number of columns in a render thread tile for the current tile layout and
+	// depth buffer format.
+	int getTileColumns() const;
+
+	// Splits frames of the given dimensions into tiles for the given number of render threads.
+	void initTiles(int width, int height, int threadCount);
 
 	// Initializes render threads that run in the background for the duration of the renderer's
 	// lifetime. This can also be used to reset threads after a screen resize.
 	void initRenderThreads(int width, int height, int threadCount);
 
+	// Sets up the per-frame state, starts the render threads on it, and does the main thread's
+	// part of the frame (visible object determination). Returns without waiting for the
+	// render threads to finish. Pipelined frames draw copies of the visible flats, since the
+	// caller can change flats before the frame is finished.
+	void beginFrame(const Double3 &eye, const Double3 &direction, double fovY, double ambient,
+		double daytimePercent, double latitude, bool parallaxSky, double ceilingHeight,
+		const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
+		bool pipelined, uint32_t *colorBuffer);
+
+	// Waits for the render threads to finish the frame in flight, if any.
+	void waitForFrame();
+
+	// Finishes any frame in flight and forgets the last pipelined frame. This must be called
+	// before anything the render threads read is changed.
+	void resetFramePipeline();
+
 	// Turns off each thread in the render threads list peacefully. The render threads are expected
 	// to be at their initial wait condition before being given the go + destruct signals.
 	void resetRenderThreads();
@@ -435,8 +973,26 @@ private:
 	void updateVisibleDistantObjects(bool parallaxSky, const ShadingInfo &shadingInfo,
 		const Camera &camera, const FrameView &frame);
 
-	// Refreshes the list of flats to be drawn.
-	void updateVisibleFlats(const Camera &camera);
+	// Gets the flat chunk that contains the given point.
+	static Int2 getFlatChunk(const Double3 &position);
+
+	// Adds or removes a flat from the chunk it's in. The chunk is erased once it's empty.
+	void addFlatToChunk(const Flat &flat);
+	void removeFlatFromChunk(const Flat &flat, const Int2 &chunk);
+
+	// Gets the distance at which fog is maximum for this frame. Nothing past it is drawn.
+	// Never closer than MIN_DRAW_DISTANCE.
+	double getDrawDistance() const;
+
+	// Refreshes the list of flats to be drawn. Only flats in chunks that touch the view
+	// frustum within the draw distance are checked. Visible flats point to copies if
+	// requested, or else into the flats map.
+	void updateVisibleFlats(const Camera &camera, double drawDistance, bool copyFlats);
+
+	// Puts the index of each visible flat into the bin of every column tile it overlaps, so
+	// a render thread only looks at the flats in its own tiles. Each bin stays sorted
+	// farthest to nearest.
+	void binVisibleFlats(const FrameView &frame);
 	
 	// Gets the facing value for the far side of a chasm.
 	static VoxelData::Facing getInitialChasmFarFacing(int voxelX, int voxelZ,
@@ -451,6 +1007,19 @@ private:
 	// Calculates the projected Y coordinate of a 3D point given a transform and Y-shear value.
 	static double getProjectedY(const Double3 &point, const Matrix4d &transform, double yShear);
 
+	// Calculates the projected Y coordinate of the bottom of a distant object at the given
+	// angle above the horizon. Higher angles are always higher on-screen.
+	static double getDistantProjectedY(double yAngleRadians, const Camera &camera);
+
+	// Gets the mip level whose texels are closest to one per pixel without going under,
+	// given the texels per pixel of the full-size texture.
+	static int getMipLevel(double texelsPerPixel, int mipLevelCount);
+
+	// Gets the voxel texture mip level for a span from its texels per pixel down the column.
+	// Texels per pixel across the screen at the given depth are used instead if fewer.
+	static int getVoxelMipLevel(double columnTexelsPerPixel, double depth,
+		const ShadingInfo &shadingInfo);
+
 	// Gets the pixel coordinate with the nearest available pixel center based on the projected
 	// value and some bounding rule. This is used to keep integer drawing ranges clamped in such
 	// a way that they never allow sampling of texture coordinates outside of the 0->1 range.
@@ -545,6 +1114,29 @@ private:
 	// (Unused for now; keeping for reference).
 	//Double3 castRay(const Double3 &direction, const VoxelGrid &voxelGrid) const;
 
+	// Gets the total light on a surface point facing the given direction (ambient, sun, and
+	// point lights).
+	static Double3 getSurfaceLight(const Double3 &normal, const Double2 &point,
+		const ShadingInfo &shadingInfo);
+
+	// Gets the per-span shading values given to the span kernels for some surface light.
+	static SpanKernels::Shading getSpanShading(const Double3 &light, const ShadingInfo &shadingInfo);
+
+	// Draws a chunk of a voxel column's sampled texels. A row is drawn if its texel is opaque
+	// (when transparency is checked) and either outside the cleared rows (when given) or no
+	// farther than the depth buffer minus the bias. Depths are per row when given. Only rows
+	// that are drawn get shaded, with light interpolated by depth if a perspective span is
+	// given. The frame's depth and color formats are checked once here instead of at each pixel.
+	static void drawColumnRows(int x, int yStart, int yEnd, const uint32_t *texels,
+		bool checkTransparency, const double *depths, double depth, double depthBias,
+		const DepthRows *clearedRows, const SpanKernels::Shading &shading,
+		const SpanKernels::PerspectiveSpan *perspectiveSpan, const FrameView &frame);
+	template <typename DepthType, bool Paletted>
+	static void drawColumnRows(int x, int yStart, int yEnd, const uint32_t *texels,
+		bool checkTransparency, const double *depths, double depth, double depthBias,
+		const DepthRows *clearedRows, const SpanKernels::Shading &shading,
+		const SpanKernels::PerspectiveSpan *perspectiveSpan, const FrameView &frame);
+
 	// Draws a column of pixels with no perspective or transparency.
 	static void drawPixels(int x, const DrawRange &drawRange, double depth, double u,
 		double vStart, double vEnd, const Double3 &normal, const VoxelTexture &texture,
@@ -580,21 +1172,48 @@ private:
 		double vEnd, const SkyTexture &texture, const std::vector<Double3> &skyGradientRowCache,
 		const ShadingInfo &shadingInfo, const FrameView &frame);
 
+	// Draw one voxel of the given data type in the column that the player is in, either at the
+	// player's height, below it, or above it. Data types without a specialization have nothing
+	// visible from that position (i.e., air, or floors from below).
+	template <VoxelDataType DataType>
+	static void drawInitialVoxel(int voxelY, const VoxelData &voxelData,
+		const VoxelColumnContext &column);
+	template <VoxelDataType DataType>
+	static void drawInitialVoxelBelow(int voxelY, const VoxelData &voxelData,
+		const VoxelColumnContext &column);
+	template <VoxelDataType DataType>
+	static void drawInitialVoxelAbove(int voxelY, const VoxelData &voxelData,
+		const VoxelColumnContext &column);
+
+	// Draw one voxel of the given data type in a voxel column the ray passes through, either at
+	// the player's height, below it, or above it.
+	template <VoxelDataType DataType>
+	static void drawVoxel(int voxelY, const VoxelData &voxelData,
+		const VoxelColumnContext &column);
+	template <VoxelDataType DataType>
+	static void drawVoxelBelow(int voxelY, const VoxelData &voxelData,
+		const VoxelColumnContext &column);
+	template <VoxelDataType DataType>
+	static void drawVoxelAbove(int voxelY, const VoxelData &voxelData,
+		const VoxelColumnContext &column);
+
 	// Manages drawing voxels in the column that the player is in.
 	static void drawInitialVoxelColumn(int x, int voxelX, int voxelZ, const Camera &camera,
 		const Ray &ray, VoxelData::Facing facing, const Double2 &nearPoint,
 		const Double2 &farPoint, double nearZ, double farZ, const ShadingInfo &shadingInfo,
 		double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
-		const VoxelGrid &voxelGrid, const std::vector<VoxelTexture> &textures,
-		OcclusionData &occlusion, const FrameView &frame);
+		const VoxelGrid &voxelGrid, const std::vector<VoxelDataType> &voxelDataTypes,
+		const std::vector<VoxelTexture> &textures, OcclusionData &occlusion,
+		const FrameView &frame);
 
 	// Manages drawing voxels in the column of the given XZ coordinate in the voxel grid.
 	static void drawVoxelColumn(int x, int voxelX, int voxelZ, const Camera &camera,
 		const Ray &ray, VoxelData::Facing facing, const Double2 &nearPoint,
 		const Double2 &farPoint, double nearZ, double farZ, const ShadingInfo &shadingInfo,
 		double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
-		const VoxelGrid &voxelGrid, const std::vector<VoxelTexture> &textures,
-		OcclusionData &occlusion, const FrameView &frame);
+		const VoxelGrid &voxelGrid, const std::vector<VoxelDataType> &voxelDataTypes,
+		const std::vector<VoxelTexture> &textures, OcclusionData &occlusion,
+		const FrameView &frame);
 
 	// Draws the portion of a flat contained within the given X range of the screen. The end
 	// X value is exclusive.
@@ -610,40 +1229,45 @@ private:
 	static void rayCast2D(int x, const Camera &camera, const Ray &ray,
 		const ShadingInfo &shadingInfo, double ceilingHeight,
 		const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
+		const std::vector<VoxelDataType> &voxelDataTypes,
 		const std::vector<VoxelTexture> &textures, OcclusionData &occlusion,
 		const FrameView &frame);
 
 	// Draws a portion of the sky gradient. The start and end Y are determined from current
-	// threading settings.
+	// threading settings. If a sky layer is given, rows with distant objects are copied from it.
 	static void drawSkyGradient(int startY, int endY, double gradientProjYTop,
 		double gradientProjYBottom, std::vector<Double3> &skyGradientRowCache,
-		std::atomic<bool> &shouldDrawStars, const ShadingInfo &shadingInfo,
-		const FrameView &frame);
+		std::atomic<bool> &shouldDrawStars, const SkyLayer *skyLayer,
+		const ShadingInfo &shadingInfo, const FrameView &frame);
 
 	// Draws some columns of distant sky objects (mountains, clouds, etc.). The start and end X
-	// are determined from current threading settings.
+	// are given by a render thread tile.
 	static void drawDistantSky(int startX, int endX, bool parallaxSky,
 		const VisDistantObjects &visDistantObjs, const std::vector<SkyTexture> &skyTextures,
 		const std::vector<Double3> &skyGradientRowCache, bool shouldDrawStars,
 		const ShadingInfo &shadingInfo, const FrameView &frame);
 
-	// Handles drawing all voxels for the current frame.
-	static void drawVoxels(int startX, int stride, const Camera &camera, double ceilingHeight,
+	// Draws the voxels in some columns of the current frame.
+	static void drawVoxels(int startX, int endX, const Camera &camera, double ceilingHeight,
 		const std::vector<LevelData::DoorState> &openDoors, const VoxelGrid &voxelGrid,
+		const std::vector<VoxelDataType> &voxelDataTypes,
 		const std::vector<VoxelTexture> &voxelTextures, std::vector<OcclusionData> &occlusion,
 		const ShadingInfo &shadingInfo, const FrameView &frame);
 
-	// Handles drawing all flats for the current frame.
+	// Draws the given visible flats in some columns of the current frame.
 	static void drawFlats(int startX, int endX, const Camera &camera, const Double3 &flatNormal,
-		const std::vector<VisibleFlat> &visibleFlats, const std::vector<FlatTexture> &flatTextures,
-		const ShadingInfo &shadingInfo, const FrameView &frame);
+		const std::vector<VisibleFlat> &visibleFlats, const std::vector<int> &flatIndices,
+		const std::vector<FlatTexture> &flatTextures, const ShadingInfo &shadingInfo,
+		const FrameView &frame);
 
 	// Thread loop for each render thread. All threads are initialized in the constructor and
-	// wait for a go signal at the beginning of each render(). If the renderer is destructing,
-	// then each render thread still gets a go signal, but they immediately leave their loop
-	// and terminate. Non-thread-data parameters are for start/end column/row for each thread.
-	static void renderThreadLoop(RenderThreadData &threadData, int threadIndex, int startX,
-		int endX, int startY, int endY);
+	// wait for the frame number to change at the beginning of each render(). If the renderer
+	// is destructing, they leave their loop and terminate. Each frame, a thread works through
+	// the tiles of each phase in order, stealing from other threads when it runs out (unless
+	// interleaved). A tile only waits on the tile it depends on in the previous phase, not on
+	// the whole phase.
+	static void renderThreadLoop(RenderThreadData &threadData, int threadIndex,
+		uint32_t frameNumber);
 public:
 	SoftwareRenderer();
 	~SoftwareRenderer();
@@ -651,11 +1275,41 @@ public:
 	// Height ratio between normal pixels and tall pixels.
 	static const double TALL_PIXEL_RATIO;
 
+	// Gets the number of render threads to use based on the given mode.
+	static int getRenderThreadsFromMode(int mode);
+
 	bool isInited() const;
 
 	// Sets the render threads mode to use (low, medium, high, etc.).
 	void setRenderThreadsMode(int mode);
 
+	// Sets the depth buffer mode to use (64-bit, 32-bit, or 16-bit depth).
+	void setDepthBufferMode(int mode);
+
+	// Sets how frames are split between render threads.
+	void setTileLayout(TileLayout tileLayout);
+
+	// Sets whether the render threads draw the next frame while the caller presents the
+	// previous one. This hides presentation time at the cost of one frame of latency.
+	void setFramePipelining(bool enabled);
+
+	bool isFramePipelining() const;
+
+	// Sets whether the values of each frame are kept, so isFrameReusable() can find frames
+	// that would look the same as the last one.
+	void setFrameReuse(bool enabled);
+
+	// Returns whether the last frame given to the caller can be shown again for these values
+	// because nothing it depends on has changed, so render() doesn't need to be called. Always
+	// false while frame reuse is off or a pipelined frame is in flight.
+	bool isFrameReusable(const Double3 &eye, const Double3 &direction, double fovY,
+		double ambient, double daytimePercent, double latitude, bool parallaxSky,
+		double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
+		const VoxelGrid &voxelGrid) const;
+
+	// Gets the phase timings of the most recently finished frame.
+	const FrameTimings &getFrameTimings() const;
+
 	// Adds a flat. Causes an error if the ID exists.
 	void addFlat(int id, const Double3 &position, double width, double height, int textureID);
 
@@ -675,6 +1329,23 @@ public:
 	// Sets the distance at which the fog is maximum.
 	void setFogDistance(double fogDistance);
 
+	// Sets the farthest distance to ray cast and draw flats at. If it's closer than the fog
+	// distance, the fog is brought in to it so nothing pops out of view.
+	void setMaxDrawDistance(double maxDrawDistance);
+
+	// Sets whether voxels and flats farther away are drawn with smaller mip levels of their
+	// textures, which alias less and are kinder to the cache.
+	void setMipmapping(bool mipmapping);
+
+	// Sets the 256-color palette (in ARGB8888 format) that paletted frames are drawn with.
+	// Colors are drawn as the nearest palette color.
+	void setPalette(const uint32_t *colors, int count);
+
+	// Sets whether frames are drawn to an 8-bit buffer of palette indices and converted to
+	// ARGB8888 at the end, which cuts memory traffic while drawing. Colors are reduced to the
+	// palette's, like the original game's. Frames are drawn in ARGB8888 until a palette is set.
+	void setPalettedRendering(bool paletted);
+
 	// Sets textures for the distant sky (mountains, clouds, etc.).
 	void setDistantSky(const DistantSky &distantSky);
 
@@ -707,7 +1378,8 @@ public:
 
 	// Initializes software renderer with the given frame buffer dimensions. This can be called
 	// on first start or to reset the software renderer.
-	void init(int width, int height, int renderThreadsMode);
+	void init(int width, int height, int renderThreadsMode, int depthBufferMode,
+		bool framePipelining);
 
 	// Resizes the frame buffer and related values.
 	void resize(int width, int height);
@@ -717,6 +1389,15 @@ public:
 		double ambient, double daytimePercent, double latitude, bool parallaxSky,
 		double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
 		const VoxelGrid &voxelGrid, uint32_t *colorBuffer);
+
+	// Pipelined version of render(). Starts drawing the scene into an internal buffer and
+	// returns the newest finished frame in ARGB8888 format, which is at most one frame behind.
+	// Open doors and the voxel grid are copied, so the caller can change them right away.
+	// If the newest finished frame is reusable for these values, no new frame is started.
+	const uint32_t *renderPipelined(const Double3 &eye, const Double3 &direction, double fovY,
+		double ambient, double daytimePercent, double latitude, bool parallaxSky,
+		double ceilingHeight, const std::vector<LevelData::DoorState> &openDoors,
+		const VoxelGrid &voxelGrid);
 };
 
 #endif
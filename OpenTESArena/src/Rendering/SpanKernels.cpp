@@ -0,0 +1,750 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "SpanKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SPAN_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace
+{
+	static_assert(SpanKernels::TEXTURE_WIDTH == SpanKernels::TEXTURE_HEIGHT,
+		"Span kernels compute texel indices with a shift by the texture bits.");
+
+	// Each channel value multiplied by the light percent of each level. Done in integers so
+	// the SIMD kernels can compute the same values.
+	const SpanKernels::ShadeTables ShadeTablesInstance = []()
+	{
+		SpanKernels::ShadeTables tables;
+		for (int level = 0; level <= SpanKernels::LIGHT_LEVEL_MAX; level++)
+		{
+			for (int i = 0; i < static_cast<int>(tables[level].size()); i++)
+			{
+				const int product = i * level;
+				const int channel = product / SpanKernels::LIGHT_LEVEL_MAX;
+				assert(channel == ((product * SpanKernels::LIGHT_DIVIDE_MULTIPLIER) >>
+					(16 + SpanKernels::LIGHT_DIVIDE_SHIFT)));
+				tables[level][i] = static_cast<uint8_t>(channel);
+			}
+		}
+
+		return tables;
+	}();
+
+	// Reference shading for one packed voxel texel, given the shade tables for its light level.
+	uint32_t shadeTexel(uint32_t texel, uint32_t nightLightTexel, const uint8_t *tableR,
+		const uint8_t *tableG, const uint8_t *tableB, uint32_t fogColor, int fogFactor)
+	{
+		// Night light texels get their color and emission from the time of day, so textures
+		// don't have to change when night lights are toggled.
+		if (((texel >> 24) & SpanKernels::TEXEL_FLAG_NIGHT_LIGHT) != 0)
+		{
+			texel = nightLightTexel;
+		}
+
+		// Emissive texels are fully lit.
+		if (((texel >> 24) & SpanKernels::TEXEL_FLAG_EMISSIVE) != 0)
+		{
+			const uint8_t *table = ShadeTablesInstance[SpanKernels::LIGHT_LEVEL_MAX].data();
+			tableR = table;
+			tableG = table;
+			tableB = table;
+		}
+
+		const uint32_t color = (static_cast<uint32_t>(tableR[texel & 0xFF]) << 16) |
+			(static_cast<uint32_t>(tableG[(texel >> 8) & 0xFF]) << 8) |
+			static_cast<uint32_t>(tableB[(texel >> 16) & 0xFF]);
+		return SpanKernels::blendFog(color, fogColor, fogFactor);
+	}
+
+	uint32_t loadTexel(const uint8_t *texels, int textureIndex)
+	{
+		const uint8_t *texel = texels + (textureIndex * 4);
+		return static_cast<uint32_t>(texel[0]) | (static_cast<uint32_t>(texel[1]) << 8) |
+			(static_cast<uint32_t>(texel[2]) << 16) | (static_cast<uint32_t>(texel[3]) << 24);
+	}
+
+#if defined(SPAN_KERNELS_SSE2)
+	// Loads two packed texels into the low lanes of an integer vector.
+	__m128i loadTexelsSSE2(const uint8_t *texels, __m128i indices)
+	{
+		alignas(16) int32_t indexArray[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(indexArray), indices);
+
+		uint32_t texel0, texel1;
+		std::memcpy(&texel0, texels + (indexArray[0] * 4), sizeof(texel0));
+		std::memcpy(&texel1, texels + (indexArray[1] * 4), sizeof(texel1));
+		return _mm_set_epi32(0, 0, static_cast<int>(texel1), static_cast<int>(texel0));
+	}
+
+	// Percent of each row's center between the projected start and end of the span.
+	__m128d getYPercentsSSE2(int y, double yProjStart, double yProjRange)
+	{
+		const __m128d yCenters = _mm_add_pd(_mm_set_pd(static_cast<double>(y + 1),
+			static_cast<double>(y)), _mm_set1_pd(0.50));
+		return _mm_div_pd(_mm_sub_pd(yCenters, _mm_set1_pd(yProjStart)), _mm_set1_pd(yProjRange));
+	}
+
+	// Floor for values that fit in a 32-bit integer (SSE2 has no rounding instruction).
+	__m128d floorSSE2(__m128d value)
+	{
+		const __m128d truncated = _mm_cvtepi32_pd(_mm_cvttpd_epi32(value));
+		const __m128d roundedUp = _mm_cmpgt_pd(truncated, value);
+		return _mm_sub_pd(truncated, _mm_and_pd(roundedUp, _mm_set1_pd(1.0)));
+	}
+
+	// Same as std::round() (halfway cases away from zero) for values that fit in a 32-bit
+	// integer. The fraction is exact, so this matches it bit for bit.
+	__m128d roundSSE2(__m128d value)
+	{
+		const __m128d truncated = _mm_cvtepi32_pd(_mm_cvttpd_epi32(value));
+		const __m128d fraction = _mm_sub_pd(value, truncated);
+		const __m128d one = _mm_set1_pd(1.0);
+		const __m128d roundUp = _mm_and_pd(_mm_cmpge_pd(fraction, _mm_set1_pd(0.50)), one);
+		const __m128d roundDown = _mm_and_pd(_mm_cmple_pd(fraction, _mm_set1_pd(-0.50)), one);
+		return _mm_sub_pd(_mm_add_pd(truncated, roundUp), roundDown);
+	}
+
+	// Fog factors of four depths, like SpanKernels::getFogFactor().
+	__m128i getFogFactorsSSE2(const double *depths, __m128d fogScale)
+	{
+		const __m128d fogFactorMax = _mm_set1_pd(static_cast<double>(SpanKernels::FOG_FACTOR_MAX));
+		const __m128i fogFactors01 = _mm_cvttpd_epi32(
+			_mm_min_pd(_mm_mul_pd(_mm_loadu_pd(depths), fogScale), fogFactorMax));
+		const __m128i fogFactors23 = _mm_cvttpd_epi32(
+			_mm_min_pd(_mm_mul_pd(_mm_loadu_pd(depths + 2), fogScale), fogFactorMax));
+		return _mm_unpacklo_epi64(fogFactors01, fogFactors23);
+	}
+
+	// Light levels of one channel for four rows some percent between the start and end levels,
+	// like shadePerspectiveTexelsScalar().
+	__m128i getRowLevelsSSE2(int start, int end, __m128d percents01, __m128d percents23)
+	{
+		const __m128d range = _mm_set1_pd(static_cast<double>(end - start));
+		const __m128i offsets01 = _mm_cvttpd_epi32(roundSSE2(_mm_mul_pd(range, percents01)));
+		const __m128i offsets23 = _mm_cvttpd_epi32(roundSSE2(_mm_mul_pd(range, percents23)));
+		return _mm_add_epi32(_mm_set1_epi32(start),
+			_mm_unpacklo_epi64(offsets01, offsets23));
+	}
+
+	// Spreads a 32-bit value per texel (four texels) over 16-bit lanes, four lanes per texel.
+	// The low vector gets the first two texels, like _mm_unpacklo_epi8() does with texels.
+	void spreadTexelValuesSSE2(__m128i values, __m128i *outLo, __m128i *outHi)
+	{
+		const __m128i values16 = _mm_packs_epi32(values, values);
+		const __m128i pairs = _mm_unpacklo_epi16(values16, values16);
+		*outLo = _mm_unpacklo_epi32(pairs, pairs);
+		*outHi = _mm_unpackhi_epi32(pairs, pairs);
+	}
+
+	// Interleaves the light levels of each channel (four texels) into 16-bit lanes as
+	// { r, g, b, 0 } for each texel, with the first two texels in the low vector.
+	void interleaveLevelsSSE2(__m128i levelsR, __m128i levelsG, __m128i levelsB,
+		__m128i *outLo, __m128i *outHi)
+	{
+		const __m128i levelsRG = _mm_unpacklo_epi16(_mm_packs_epi32(levelsR, levelsR),
+			_mm_packs_epi32(levelsG, levelsG));
+		const __m128i levelsB0 = _mm_unpacklo_epi16(_mm_packs_epi32(levelsB, levelsB),
+			_mm_setzero_si128());
+		*outLo = _mm_unpacklo_epi32(levelsRG, levelsB0);
+		*outHi = _mm_unpackhi_epi32(levelsRG, levelsB0);
+	}
+
+	// Light levels as { r, g, b, 0 } for both texels in a vector.
+	__m128i getLevelsSSE2(int levelR, int levelG, int levelB)
+	{
+		return _mm_set_epi16(0, static_cast<short>(levelB), static_cast<short>(levelG),
+			static_cast<short>(levelR), 0, static_cast<short>(levelB),
+			static_cast<short>(levelG), static_cast<short>(levelR));
+	}
+
+	// Shades the unpacked channels of two texels (16-bit lanes, four per texel) with their
+	// light levels and fog factors, and puts them in packed color order.
+	__m128i shadeChannelsSSE2(__m128i channels, __m128i levels, __m128i fogFactors,
+		__m128i fogColor)
+	{
+		// Channel times light level divided by the max level, like the shade tables.
+		const __m128i lit = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(channels, levels),
+			_mm_set1_epi16(static_cast<short>(SpanKernels::LIGHT_DIVIDE_MULTIPLIER))),
+			SpanKernels::LIGHT_DIVIDE_SHIFT);
+
+		// Same as SpanKernels::blendFog(). Each sum fits in 16 bits.
+		const __m128i colorPercents = _mm_sub_epi16(
+			_mm_set1_epi16(SpanKernels::FOG_FACTOR_MAX), fogFactors);
+		const __m128i blended = _mm_srli_epi16(_mm_add_epi16(
+			_mm_mullo_epi16(lit, colorPercents), _mm_mullo_epi16(fogColor, fogFactors)),
+			SpanKernels::FOG_FACTOR_BITS);
+
+		// Texels are red, green, blue, flags, and colors are blue, green, red, zero.
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(blended, _MM_SHUFFLE(3, 0, 1, 2)),
+			_MM_SHUFFLE(3, 0, 1, 2));
+	}
+
+	// Shades four packed texels like shadeTexel(). Light levels are { r, g, b, 0 } and fog
+	// factors are repeated four times in 16-bit lanes for each texel, with the first two texels
+	// in the low vectors. The fog color is in the same layout as the levels.
+	__m128i shadeTexelsSSE2(__m128i texels, __m128i levelsLo, __m128i levelsHi,
+		__m128i fogFactorsLo, __m128i fogFactorsHi, __m128i fogColor, __m128i nightLightTexel)
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		// Night light texels are replaced before checking for emission, like the scalar version.
+		const __m128i isNotNightLight = _mm_cmpeq_epi32(zero, _mm_and_si128(texels,
+			_mm_set1_epi32(SpanKernels::TEXEL_FLAG_NIGHT_LIGHT << 24)));
+		texels = _mm_or_si128(_mm_and_si128(isNotNightLight, texels),
+			_mm_andnot_si128(isNotNightLight, nightLightTexel));
+
+		// Emissive texels are fully lit.
+		const __m128i isNotEmissive = _mm_cmpeq_epi32(zero, _mm_and_si128(texels,
+			_mm_set1_epi32(SpanKernels::TEXEL_FLAG_EMISSIVE << 24)));
+		const __m128i isNotEmissiveLo = _mm_unpacklo_epi32(isNotEmissive, isNotEmissive);
+		const __m128i isNotEmissiveHi = _mm_unpackhi_epi32(isNotEmissive, isNotEmissive);
+		const __m128i maxLevels = getLevelsSSE2(SpanKernels::LIGHT_LEVEL_MAX,
+			SpanKernels::LIGHT_LEVEL_MAX, SpanKernels::LIGHT_LEVEL_MAX);
+		levelsLo = _mm_or_si128(_mm_and_si128(isNotEmissiveLo, levelsLo),
+			_mm_andnot_si128(isNotEmissiveLo, maxLevels));
+		levelsHi = _mm_or_si128(_mm_and_si128(isNotEmissiveHi, levelsHi),
+			_mm_andnot_si128(isNotEmissiveHi, maxLevels));
+
+		const __m128i colorsLo = shadeChannelsSSE2(_mm_unpacklo_epi8(texels, zero), levelsLo,
+			fogFactorsLo, fogColor);
+		const __m128i colorsHi = shadeChannelsSSE2(_mm_unpackhi_epi8(texels, zero), levelsHi,
+			fogFactorsHi, fogColor);
+		return _mm_packus_epi16(colorsLo, colorsHi);
+	}
+
+	// Fog color channels in the same layout as getLevelsSSE2().
+	__m128i getFogColorSSE2(uint32_t fogColor)
+	{
+		return getLevelsSSE2((fogColor >> 16) & 0xFF, (fogColor >> 8) & 0xFF, fogColor & 0xFF);
+	}
+
+	void sampleWallRowsSSE2(const SpanKernels::WallSpan &span, int y, int yStart,
+		double yProjRange, double vRange, uint32_t *texels)
+	{
+		const __m128d yPercents = getYPercentsSSE2(y, span.yProjStart, yProjRange);
+		const __m128d v = _mm_add_pd(_mm_set1_pd(span.vStart),
+			_mm_mul_pd(_mm_set1_pd(vRange), yPercents));
+		const __m128i textureY = _mm_cvttpd_epi32(
+			_mm_mul_pd(v, _mm_set1_pd(static_cast<double>(1 << span.textureBits))));
+		const __m128i indices = _mm_add_epi32(
+			_mm_set1_epi32(span.textureX << span.textureBits), textureY);
+
+		const __m128i rowTexels = loadTexelsSSE2(span.texels, indices);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(texels + (y - yStart)), rowTexels);
+	}
+
+	void samplePerspectiveRowsSSE2(const SpanKernels::PerspectiveSpan &span, int y, int yStart,
+		double yProjRange, double depthRecipRange, uint32_t *texels, double *depths)
+	{
+		const __m128d yPercents = getYPercentsSSE2(y, span.yProjStart, yProjRange);
+
+		// Interpolate between the near and far depth.
+		const __m128d depth = _mm_div_pd(_mm_set1_pd(1.0), _mm_add_pd(
+			_mm_set1_pd(span.depthStartRecip), _mm_mul_pd(_mm_set1_pd(depthRecipRange), yPercents)));
+
+		// Interpolate between start and end points.
+		const __m128d currentPointX = _mm_mul_pd(_mm_add_pd(_mm_set1_pd(span.startPointDivX),
+			_mm_mul_pd(_mm_set1_pd(span.pointDivDiffX), yPercents)), depth);
+		const __m128d currentPointY = _mm_mul_pd(_mm_add_pd(_mm_set1_pd(span.startPointDivY),
+			_mm_mul_pd(_mm_set1_pd(span.pointDivDiffY), yPercents)), depth);
+
+		// Texture coordinates.
+		const __m128d justBelowOne = _mm_set1_pd(span.justBelowOne);
+		const __m128d zero = _mm_setzero_pd();
+		const __m128d u = _mm_min_pd(_mm_max_pd(_mm_sub_pd(justBelowOne,
+			_mm_sub_pd(currentPointX, floorSSE2(currentPointX))), zero), justBelowOne);
+		const __m128d v = _mm_min_pd(_mm_max_pd(_mm_sub_pd(justBelowOne,
+			_mm_sub_pd(currentPointY, floorSSE2(currentPointY))), zero), justBelowOne);
+
+		const __m128d textureSize = _mm_set1_pd(static_cast<double>(1 << span.textureBits));
+		const __m128i textureX = _mm_cvttpd_epi32(_mm_mul_pd(u, textureSize));
+		const __m128i textureY = _mm_cvttpd_epi32(_mm_mul_pd(v, textureSize));
+		const __m128i indices = _mm_add_epi32(
+			_mm_sll_epi32(textureX, _mm_cvtsi32_si128(span.textureBits)), textureY);
+
+		const __m128i rowTexels = loadTexelsSSE2(span.texels, indices);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(texels + (y - yStart)), rowTexels);
+		_mm_storeu_pd(depths + (y - yStart), depth);
+	}
+#endif
+
+	bool cpuSupportsAVX2()
+	{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		// The OS must save AVX registers on context switches.
+		__cpuid(info, 1);
+		const bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+		const bool hasAVX = (info[2] & (1 << 28)) != 0;
+		if (!hasOSXSave || !hasAVX || ((_xgetbv(0) & 0x6) != 0x6))
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return false;
+#endif
+	}
+}
+
+const SpanKernels::ShadeTables &SpanKernels::getShadeTables()
+{
+	return ShadeTablesInstance;
+}
+
+int SpanKernels::getLightLevel(double lightPercent)
+{
+	const double clampedPercent = std::min(std::max(lightPercent, 0.0), 1.0);
+	return static_cast<int>(std::round(clampedPercent * static_cast<double>(LIGHT_LEVEL_MAX)));
+}
+
+int SpanKernels::getFogFactor(double depth, double fogScale)
+{
+	return static_cast<int>(std::min(depth * fogScale, static_cast<double>(FOG_FACTOR_MAX)));
+}
+
+double SpanKernels::getFogScale(double fogDistance)
+{
+	assert(fogDistance > 0.0);
+	return static_cast<double>(FOG_FACTOR_MAX) / fogDistance;
+}
+
+uint32_t SpanKernels::packColor(double colorR, double colorG, double colorB)
+{
+	return static_cast<uint32_t>(
+		((static_cast<uint8_t>(colorR * 255.0)) << 16) |
+		((static_cast<uint8_t>(colorG * 255.0)) << 8) |
+		((static_cast<uint8_t>(colorB * 255.0))));
+}
+
+uint32_t SpanKernels::packTexel(uint8_t r, uint8_t g, uint8_t b, uint8_t flags)
+{
+	return static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8) |
+		(static_cast<uint32_t>(b) << 16) | (static_cast<uint32_t>(flags) << 24);
+}
+
+uint32_t SpanKernels::blendFog(uint32_t color, uint32_t fogColor, int fogFactor)
+{
+	// Red and blue are blended together since neither can overflow into the other.
+	const uint32_t colorPercent = static_cast<uint32_t>(FOG_FACTOR_MAX - fogFactor);
+	const uint32_t fogPercent = static_cast<uint32_t>(fogFactor);
+	const uint32_t redBlue = (((color & 0xFF00FF) * colorPercent) +
+		((fogColor & 0xFF00FF) * fogPercent)) >> FOG_FACTOR_BITS;
+	const uint32_t green = (((color & 0xFF00) * colorPercent) +
+		((fogColor & 0xFF00) * fogPercent)) >> FOG_FACTOR_BITS;
+	return (redBlue & 0xFF00FF) | (green & 0xFF00);
+}
+
+bool SpanKernels::isTexelTransparent(uint32_t texel)
+{
+	return ((texel >> 24) & TEXEL_FLAG_TRANSPARENT) != 0;
+}
+
+void SpanKernels::shadeWallTexelsScalar(const Shading &shading, int fogFactor, int count,
+	uint32_t *colors)
+{
+	const uint8_t *tableR = ShadeTablesInstance[shading.lightR].data();
+	const uint8_t *tableG = ShadeTablesInstance[shading.lightG].data();
+	const uint8_t *tableB = ShadeTablesInstance[shading.lightB].data();
+
+	for (int i = 0; i < count; i++)
+	{
+		colors[i] = shadeTexel(colors[i], shading.nightLightTexel, tableR, tableG, tableB,
+			shading.fogColor, fogFactor);
+	}
+}
+
+void SpanKernels::shadePerspectiveTexelsScalar(const PerspectiveSpan &span,
+	const Shading &shading, const double *depths, int count, uint32_t *colors)
+{
+	const bool constantLight = (span.lightEndR == shading.lightR) &&
+		(span.lightEndG == shading.lightG) && (span.lightEndB == shading.lightB);
+
+	if (constantLight)
+	{
+		const uint8_t *tableR = ShadeTablesInstance[shading.lightR].data();
+		const uint8_t *tableG = ShadeTablesInstance[shading.lightG].data();
+		const uint8_t *tableB = ShadeTablesInstance[shading.lightB].data();
+
+		for (int i = 0; i < count; i++)
+		{
+			const int fogFactor = SpanKernels::getFogFactor(depths[i], shading.fogScale);
+			colors[i] = shadeTexel(colors[i], shading.nightLightTexel, tableR, tableG, tableB,
+				shading.fogColor, fogFactor);
+		}
+	}
+	else
+	{
+		// The surface point moves linearly with depth along the column's ray, so the light at
+		// each row is interpolated by how far its depth is between the two ends.
+		const double depthStart = 1.0 / span.depthStartRecip;
+		const double depthEnd = 1.0 / span.depthEndRecip;
+		const double depthRange = depthEnd - depthStart;
+		const double depthRangeRecip = (depthRange != 0.0) ? (1.0 / depthRange) : 0.0;
+
+		auto getRowLevel = [](int start, int end, double percent)
+		{
+			return start + static_cast<int>(std::round(static_cast<double>(end - start) * percent));
+		};
+
+		for (int i = 0; i < count; i++)
+		{
+			const double depth = depths[i];
+			const double percent = std::min(std::max(
+				(depth - depthStart) * depthRangeRecip, 0.0), 1.0);
+			const uint8_t *tableR =
+				ShadeTablesInstance[getRowLevel(shading.lightR, span.lightEndR, percent)].data();
+			const uint8_t *tableG =
+				ShadeTablesInstance[getRowLevel(shading.lightG, span.lightEndG, percent)].data();
+			const uint8_t *tableB =
+				ShadeTablesInstance[getRowLevel(shading.lightB, span.lightEndB, percent)].data();
+
+			const int fogFactor = SpanKernels::getFogFactor(depth, shading.fogScale);
+			colors[i] = shadeTexel(colors[i], shading.nightLightTexel, tableR, tableG, tableB,
+				shading.fogColor, fogFactor);
+		}
+	}
+}
+
+void SpanKernels::shadeWallTexelsSSE2(const Shading &shading, int fogFactor, int count,
+	uint32_t *colors)
+{
+#if defined(SPAN_KERNELS_SSE2)
+	const __m128i levels = getLevelsSSE2(shading.lightR, shading.lightG, shading.lightB);
+	const __m128i fogFactors = _mm_set1_epi16(static_cast<short>(fogFactor));
+	const __m128i fogColor = getFogColorSSE2(shading.fogColor);
+	const __m128i nightLightTexel = _mm_set1_epi32(static_cast<int>(shading.nightLightTexel));
+
+	int i = 0;
+	for (; (i + 4) <= count; i += 4)
+	{
+		__m128i *texels = reinterpret_cast<__m128i*>(colors + i);
+		_mm_storeu_si128(texels, shadeTexelsSSE2(_mm_loadu_si128(texels), levels, levels,
+			fogFactors, fogFactors, fogColor, nightLightTexel));
+	}
+
+	SpanKernels::shadeWallTexelsScalar(shading, fogFactor, count - i, colors + i);
+#else
+	SpanKernels::shadeWallTexelsScalar(shading, fogFactor, count, colors);
+#endif
+}
+
+void SpanKernels::shadePerspectiveTexelsSSE2(const PerspectiveSpan &span,
+	const Shading &shading, const double *depths, int count, uint32_t *colors)
+{
+#if defined(SPAN_KERNELS_SSE2)
+	const bool constantLight = (span.lightEndR == shading.lightR) &&
+		(span.lightEndG == shading.lightG) && (span.lightEndB == shading.lightB);
+	const double depthStart = 1.0 / span.depthStartRecip;
+	const double depthEnd = 1.0 / span.depthEndRecip;
+	const double depthRange = depthEnd - depthStart;
+	const double depthRangeRecip = (depthRange != 0.0) ? (1.0 / depthRange) : 0.0;
+
+	const __m128i levels = getLevelsSSE2(shading.lightR, shading.lightG, shading.lightB);
+	const __m128d fogScale = _mm_set1_pd(shading.fogScale);
+	const __m128i fogColor = getFogColorSSE2(shading.fogColor);
+	const __m128i nightLightTexel = _mm_set1_epi32(static_cast<int>(shading.nightLightTexel));
+
+	// Percent of two rows' depths between the two ends, which their light is interpolated by.
+	auto getPercents = [depthStart, depthRangeRecip](const double *rowDepths)
+	{
+		const __m128d percents = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(rowDepths),
+			_mm_set1_pd(depthStart)), _mm_set1_pd(depthRangeRecip));
+		return _mm_min_pd(_mm_max_pd(percents, _mm_setzero_pd()), _mm_set1_pd(1.0));
+	};
+
+	int i = 0;
+	for (; (i + 4) <= count; i += 4)
+	{
+		__m128i fogFactorsLo, fogFactorsHi;
+		spreadTexelValuesSSE2(getFogFactorsSSE2(depths + i, fogScale), &fogFactorsLo,
+			&fogFactorsHi);
+
+		__m128i levelsLo = levels;
+		__m128i levelsHi = levels;
+		if (!constantLight)
+		{
+			const __m128d percents01 = getPercents(depths + i);
+			const __m128d percents23 = getPercents(depths + i + 2);
+			interleaveLevelsSSE2(
+				getRowLevelsSSE2(shading.lightR, span.lightEndR, percents01, percents23),
+				getRowLevelsSSE2(shading.lightG, span.lightEndG, percents01, percents23),
+				getRowLevelsSSE2(shading.lightB, span.lightEndB, percents01, percents23),
+				&levelsLo, &levelsHi);
+		}
+
+		__m128i *texels = reinterpret_cast<__m128i*>(colors + i);
+		_mm_storeu_si128(texels, shadeTexelsSSE2(_mm_loadu_si128(texels), levelsLo, levelsHi,
+			fogFactorsLo, fogFactorsHi, fogColor, nightLightTexel));
+	}
+
+	SpanKernels::shadePerspectiveTexelsScalar(span, shading, depths + i, count - i, colors + i);
+#else
+	SpanKernels::shadePerspectiveTexelsScalar(span, shading, depths, count, colors);
+#endif
+}
+
+void SpanKernels::expandIndicesScalar(const uint32_t *palette, const uint8_t *indices,
+	int count, uint32_t *colors)
+{
+	for (int i = 0; i < count; i++)
+	{
+		colors[i] = palette[indices[i]];
+	}
+}
+
+void SpanKernels::expandIndicesSSE2(const uint32_t *palette, const uint8_t *indices,
+	int count, uint32_t *colors)
+{
+#if defined(SPAN_KERNELS_SSE2)
+	// SSE2 has no gather, so the lookups stay scalar but each group of four colors is one
+	// store.
+	int i = 0;
+	for (; (i + 4) <= count; i += 4)
+	{
+		const __m128i pixelColors = _mm_setr_epi32(
+			static_cast<int>(palette[indices[i]]), static_cast<int>(palette[indices[i + 1]]),
+			static_cast<int>(palette[indices[i + 2]]), static_cast<int>(palette[indices[i + 3]]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(colors + i), pixelColors);
+	}
+
+	SpanKernels::expandIndicesScalar(palette, indices + i, count - i, colors + i);
+#else
+	SpanKernels::expandIndicesScalar(palette, indices, count, colors);
+#endif
+}
+
+void SpanKernels::sampleWallSpanScalar(const WallSpan &span, int yStart, int yEnd,
+	uint32_t *texels)
+{
+	const double textureSize = static_cast<double>(1 << span.textureBits);
+
+	for (int y = yStart; y < yEnd; y++)
+	{
+		// Percent stepped from beginning to end on the column.
+		const double yPercent =
+			((static_cast<double>(y) + 0.50) - span.yProjStart) / (span.yProjEnd - span.yProjStart);
+
+		// Vertical texture coordinate.
+		const double v = span.vStart + ((span.vEnd - span.vStart) * yPercent);
+
+		// Y position in texture.
+		const int textureY = static_cast<int>(v * textureSize);
+
+		const int textureIndex = (span.textureX << span.textureBits) + textureY;
+		texels[y - yStart] = loadTexel(span.texels, textureIndex);
+	}
+}
+
+void SpanKernels::sampleWallSpanSSE2(const WallSpan &span, int yStart, int yEnd,
+	uint32_t *texels)
+{
+#if defined(SPAN_KERNELS_SSE2)
+	const double yProjRange = span.yProjEnd - span.yProjStart;
+	const double vRange = span.vEnd - span.vStart;
+
+	// Four rows per iteration, two per vector.
+	int y = yStart;
+	for (; (y + 4) <= yEnd; y += 4)
+	{
+		sampleWallRowsSSE2(span, y, yStart, yProjRange, vRange, texels);
+		sampleWallRowsSSE2(span, y + 2, yStart, yProjRange, vRange, texels);
+	}
+
+	SpanKernels::sampleWallSpanScalar(span, y, yEnd, texels + (y - yStart));
+#else
+	SpanKernels::sampleWallSpanScalar(span, yStart, yEnd, texels);
+#endif
+}
+
+void SpanKernels::samplePerspectiveSpanScalar(const PerspectiveSpan &span, int yStart, int yEnd,
+	uint32_t *texels, double *depths)
+{
+	const double textureSize = static_cast<double>(1 << span.textureBits);
+
+	for (int y = yStart; y < yEnd; y++)
+	{
+		// Percent stepped from beginning to end on the column.
+		const double yPercent =
+			((static_cast<double>(y) + 0.50) - span.yProjStart) / (span.yProjEnd - span.yProjStart);
+
+		// Interpolate between the near and far depth.
+		const double depth = 1.0 /
+			(span.depthStartRecip + ((span.depthEndRecip - span.depthStartRecip) * yPercent));
+
+		// Interpolate between start and end points.
+		const double currentPointX = (span.startPointDivX + (span.pointDivDiffX * yPercent)) * depth;
+		const double currentPointY = (span.startPointDivY + (span.pointDivDiffY * yPercent)) * depth;
+
+		// Texture coordinates.
+		const double u = std::min(std::max(
+			span.justBelowOne - (currentPointX - std::floor(currentPointX)), 0.0), span.justBelowOne);
+		const double v = std::min(std::max(
+			span.justBelowOne - (currentPointY - std::floor(currentPointY)), 0.0), span.justBelowOne);
+
+		// Offsets in texture.
+		const int textureX = static_cast<int>(u * textureSize);
+		const int textureY = static_cast<int>(v * textureSize);
+
+		// Alpha is ignored, so transparent texels will appear black.
+		const int textureIndex = (textureX << span.textureBits) + textureY;
+		texels[y - yStart] = loadTexel(span.texels, textureIndex);
+		depths[y - yStart] = depth;
+	}
+}
+
+void SpanKernels::samplePerspectiveSpanSSE2(const PerspectiveSpan &span, int yStart, int yEnd,
+	uint32_t *texels, double *depths)
+{
+#if defined(SPAN_KERNELS_SSE2)
+	const double yProjRange = span.yProjEnd - span.yProjStart;
+	const double depthRecipRange = span.depthEndRecip - span.depthStartRecip;
+
+	// Four rows per iteration, two per vector.
+	int y = yStart;
+	for (; (y + 4) <= yEnd; y += 4)
+	{
+		samplePerspectiveRowsSSE2(span, y, yStart, yProjRange, depthRecipRange, texels, depths);
+		samplePerspectiveRowsSSE2(span, y + 2, yStart, yProjRange, depthRecipRange, texels,
+			depths);
+	}
+
+	SpanKernels::samplePerspectiveSpanScalar(span, y, yEnd, texels + (y - yStart),
+		depths + (y - yStart));
+#else
+	SpanKernels::samplePerspectiveSpanScalar(span, yStart, yEnd, texels, depths);
+#endif
+}
+
+bool SpanKernels::isSSE2Built()
+{
+#if defined(SPAN_KERNELS_SSE2)
+	return true;
+#else
+	return false;
+#endif
+}
+
+SpanKernels::InstructionSet SpanKernels::getBestInstructionSet()
+{
+	static const InstructionSet instructionSet = []()
+	{
+		if (SpanKernels::isAVX2Built() && cpuSupportsAVX2())
+		{
+			return InstructionSet::AVX2;
+		}
+		else if (SpanKernels::isSSE2Built())
+		{
+			return InstructionSet::SSE2;
+		}
+		else
+		{
+			return InstructionSet::Scalar;
+		}
+	}();
+
+	return instructionSet;
+}
+
+SpanKernels::WallSpanFunction SpanKernels::getWallSpanFunction(InstructionSet instructionSet)
+{
+	if (instructionSet == InstructionSet::AVX2)
+	{
+		return SpanKernels::sampleWallSpanAVX2;
+	}
+	else if (instructionSet == InstructionSet::SSE2)
+	{
+		return SpanKernels::sampleWallSpanSSE2;
+	}
+	else
+	{
+		return SpanKernels::sampleWallSpanScalar;
+	}
+}
+
+SpanKernels::PerspectiveSpanFunction SpanKernels::getPerspectiveSpanFunction(
+	InstructionSet instructionSet)
+{
+	if (instructionSet == InstructionSet::AVX2)
+	{
+		return SpanKernels::samplePerspectiveSpanAVX2;
+	}
+	else if (instructionSet == InstructionSet::SSE2)
+	{
+		return SpanKernels::samplePerspectiveSpanSSE2;
+	}
+	else
+	{
+		return SpanKernels::samplePerspectiveSpanScalar;
+	}
+}
+
+SpanKernels::ShadeWallFunction SpanKernels::getShadeWallFunction(InstructionSet instructionSet)
+{
+	if (instructionSet == InstructionSet::AVX2)
+	{
+		return SpanKernels::shadeWallTexelsAVX2;
+	}
+	else if (instructionSet == InstructionSet::SSE2)
+	{
+		return SpanKernels::shadeWallTexelsSSE2;
+	}
+	else
+	{
+		return SpanKernels::shadeWallTexelsScalar;
+	}
+}
+
+SpanKernels::ShadePerspectiveFunction SpanKernels::getShadePerspectiveFunction(
+	InstructionSet instructionSet)
+{
+	if (instructionSet == InstructionSet::AVX2)
+	{
+		return SpanKernels::shadePerspectiveTexelsAVX2;
+	}
+	else if (instructionSet == InstructionSet::SSE2)
+	{
+		return SpanKernels::shadePerspectiveTexelsSSE2;
+	}
+	else
+	{
+		return SpanKernels::shadePerspectiveTexelsScalar;
+	}
+}
+
+SpanKernels::ExpandIndicesFunction SpanKernels::getExpandIndicesFunction(
+	InstructionSet instructionSet)
+{
+	if (instructionSet == InstructionSet::AVX2)
+	{
+		return SpanKernels::expandIndicesAVX2;
+	}
+	else if (instructionSet == InstructionSet::SSE2)
+	{
+		return SpanKernels::expandIndicesSSE2;
+	}
+	else
+	{
+		return SpanKernels::expandIndicesScalar;
+	}
+}
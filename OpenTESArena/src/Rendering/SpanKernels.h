@@ -0,0 +1,177 @@
+#ifndef SPAN_KERNELS_H
+#define SPAN_KERNELS_H
+
+#include <array>
+#include <cstdint>
+
+// Kernels for vertical spans of voxel pixels in the software renderer. Sampling kernels turn a
+// range of rows into packed texels (plus depths for perspective spans); the caller does the
+// depth test, shades the texels of rows that pass with a shading kernel (light, fog, and
+// packing), and writes to the frame buffer. Paletted frames are expanded to colors with an
+// index kernel once they're finished.
+
+// Every kernel has a scalar reference version and SIMD versions (SSE2 and AVX2) that do the
+// same double-precision operations in the same order and the same integer math, so their
+// output is bit-identical. The renderer benchmark's --check-kernels mode compares them. The
+// best version for the current CPU is chosen at runtime.
+
+namespace SpanKernels
+{
+	// Voxel texture dimensions. Voxel texels are four bytes each: red, green, blue, and flags.
+	// Textures and their mip levels are square, with a power-of-two size. Texels are stored
+	// column by column, so stepping down a wall column reads texels in order.
+	constexpr int TEXTURE_BITS = 6;
+	constexpr int TEXTURE_WIDTH = 1 << TEXTURE_BITS;
+	constexpr int TEXTURE_HEIGHT = 1 << TEXTURE_BITS;
+	constexpr uint8_t TEXEL_FLAG_TRANSPARENT = 1 << 0;
+	constexpr uint8_t TEXEL_FLAG_EMISSIVE = 1 << 1;
+	constexpr uint8_t TEXEL_FLAG_NIGHT_LIGHT = 1 << 2; // Drawn as the shading's night light texel.
+
+	// Max number of rows a kernel is given at once, so callers can use fixed-size buffers.
+	constexpr int MAX_ROWS = 64;
+
+	// Fog factors go from zero (no fog) to FOG_FACTOR_MAX (only fog).
+	constexpr int FOG_FACTOR_BITS = 8;
+	constexpr int FOG_FACTOR_MAX = 1 << FOG_FACTOR_BITS;
+
+	// Light levels go from zero (unlit) to LIGHT_LEVEL_MAX (fully lit). Emissive texels are
+	// always fully lit.
+	constexpr int LIGHT_LEVEL_MAX = 127;
+
+	enum class InstructionSet { Scalar, SSE2, AVX2 };
+
+	// Shaded value of each 8-bit texel channel at each light level, which is
+	// (channel * level) / LIGHT_LEVEL_MAX.
+	typedef std::array<std::array<uint8_t, 256>, LIGHT_LEVEL_MAX + 1> ShadeTables;
+
+	// SIMD kernels divide by LIGHT_LEVEL_MAX with a 16-bit multiply instead of table lookups:
+	// x / LIGHT_LEVEL_MAX is (x * LIGHT_DIVIDE_MULTIPLIER) >> (16 + LIGHT_DIVIDE_SHIFT) for
+	// every channel times light level.
+	constexpr int LIGHT_DIVIDE_MULTIPLIER = 33027;
+	constexpr int LIGHT_DIVIDE_SHIFT = 6;
+
+	// Per-column lighting values shared by all kernels.
+	struct Shading
+	{
+		int lightR, lightG, lightB; // Light level of each channel.
+		uint32_t fogColor; // Packed RGB.
+		double fogScale; // Depth to fog factor.
+		uint32_t nightLightTexel; // Packed texel for the time of day (i.e., lit windows at night).
+	};
+
+	// A span with constant depth and horizontal texture coordinate (i.e., a wall column).
+	struct WallSpan
+	{
+		const uint8_t *texels;
+		int textureBits; // Width and height of the texels' mip level are 1 << textureBits.
+		int textureX;
+		double yProjStart, yProjEnd;
+		double vStart, vEnd;
+	};
+
+	// A span with perspective-correct depth and texture coordinates (i.e., a floor or ceiling).
+	struct PerspectiveSpan
+	{
+		const uint8_t *texels;
+		int textureBits; // Width and height of the texels' mip level are 1 << textureBits.
+		double yProjStart, yProjEnd;
+		double depthStartRecip, depthEndRecip;
+		double startPointDivX, startPointDivY;
+		double pointDivDiffX, pointDivDiffY;
+		double justBelowOne;
+
+		// Light levels at the end of the span. The shading's light levels are at the start, and
+		// each row's light is interpolated between them by depth.
+		int lightEndR, lightEndG, lightEndB;
+	};
+
+	// Writes the packed texel of each row in [yStart, yEnd) to 'texels' (indexed from zero).
+	typedef void (*WallSpanFunction)(const WallSpan &span, int yStart, int yEnd,
+		uint32_t *texels);
+
+	// Writes the packed texel and depth of each row in [yStart, yEnd) to 'texels' and 'depths'
+	// (indexed from zero).
+	typedef void (*PerspectiveSpanFunction)(const PerspectiveSpan &span, int yStart, int yEnd,
+		uint32_t *texels, double *depths);
+
+	// Replaces each packed texel with its shaded color. Callers shade only the sampled texels
+	// that passed the depth test. Wall texels share one fog factor, and perspective texels get
+	// their fog and light from their depths.
+	typedef void (*ShadeWallFunction)(const Shading &shading, int fogFactor, int count,
+		uint32_t *colors);
+	typedef void (*ShadePerspectiveFunction)(const PerspectiveSpan &span,
+		const Shading &shading, const double *depths, int count, uint32_t *colors);
+
+	// Writes the palette color of each 8-bit palette index to 'colors'. The palette has 256
+	// entries.
+	typedef void (*ExpandIndicesFunction)(const uint32_t *palette, const uint8_t *indices,
+		int count, uint32_t *colors);
+
+	void sampleWallSpanScalar(const WallSpan &span, int yStart, int yEnd, uint32_t *texels);
+	void sampleWallSpanSSE2(const WallSpan &span, int yStart, int yEnd, uint32_t *texels);
+	void sampleWallSpanAVX2(const WallSpan &span, int yStart, int yEnd, uint32_t *texels);
+
+	void samplePerspectiveSpanScalar(const PerspectiveSpan &span, int yStart, int yEnd,
+		uint32_t *texels, double *depths);
+	void samplePerspectiveSpanSSE2(const PerspectiveSpan &span, int yStart, int yEnd,
+		uint32_t *texels, double *depths);
+	void samplePerspectiveSpanAVX2(const PerspectiveSpan &span, int yStart, int yEnd,
+		uint32_t *texels, double *depths);
+
+	void shadeWallTexelsScalar(const Shading &shading, int fogFactor, int count,
+		uint32_t *colors);
+	void shadeWallTexelsSSE2(const Shading &shading, int fogFactor, int count, uint32_t *colors);
+	void shadeWallTexelsAVX2(const Shading &shading, int fogFactor, int count, uint32_t *colors);
+
+	void shadePerspectiveTexelsScalar(const PerspectiveSpan &span, const Shading &shading,
+		const double *depths, int count, uint32_t *colors);
+	void shadePerspectiveTexelsSSE2(const PerspectiveSpan &span, const Shading &shading,
+		const double *depths, int count, uint32_t *colors);
+	void shadePerspectiveTexelsAVX2(const PerspectiveSpan &span, const Shading &shading,
+		const double *depths, int count, uint32_t *colors);
+
+	void expandIndicesScalar(const uint32_t *palette, const uint8_t *indices, int count,
+		uint32_t *colors);
+	void expandIndicesSSE2(const uint32_t *palette, const uint8_t *indices, int count,
+		uint32_t *colors);
+	void expandIndicesAVX2(const uint32_t *palette, const uint8_t *indices, int count,
+		uint32_t *colors);
+
+	// Gets the table shared by all kernels for shading texels.
+	const ShadeTables &getShadeTables();
+
+	// Gets the light level for a light percent (clamped to [0, 1]).
+	int getLightLevel(double lightPercent);
+
+	// Gets the fog factor for some depth, given the scale from getFogScale().
+	int getFogFactor(double depth, double fogScale);
+	double getFogScale(double fogDistance);
+
+	// Converts color channels in the [0, 1] range to a packed RGB color.
+	uint32_t packColor(double colorR, double colorG, double colorB);
+
+	// Packs texel channels and flags the same way kernels load them from texture memory.
+	uint32_t packTexel(uint8_t r, uint8_t g, uint8_t b, uint8_t flags);
+
+	// Linearly interpolates from a packed color to the fog color.
+	uint32_t blendFog(uint32_t color, uint32_t fogColor, int fogFactor);
+
+	// Whether a packed texel is transparent (and so isn't drawn by transparent spans).
+	bool isTexelTransparent(uint32_t texel);
+
+	// Whether the SIMD kernels were compiled in (depends on target architecture and flags).
+	bool isSSE2Built();
+	bool isAVX2Built();
+
+	// Gets the fastest instruction set that is both compiled in and supported by the CPU.
+	InstructionSet getBestInstructionSet();
+
+	// Gets the kernels for the given instruction set.
+	WallSpanFunction getWallSpanFunction(InstructionSet instructionSet);
+	PerspectiveSpanFunction getPerspectiveSpanFunction(InstructionSet instructionSet);
+	ShadeWallFunction getShadeWallFunction(InstructionSet instructionSet);
+	ShadePerspectiveFunction getShadePerspectiveFunction(InstructionSet instructionSet);
+	ExpandIndicesFunction getExpandIndicesFunction(InstructionSet instructionSet);
+}
+
+#endif
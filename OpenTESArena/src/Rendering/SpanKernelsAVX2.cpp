@@ -0,0 +1,364 @@
+#include "SpanKernels.h"
+
+// This file is compiled with AVX2 enabled, and its kernels are only called after a runtime
+// CPU check. It must not use inline functions from other headers (i.e., the standard library),
+// otherwise the linker might pick an AVX2-compiled copy of them for the rest of the program.
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace
+{
+	// Gathers four packed texels.
+	__m128i loadTexelsAVX2(const uint8_t *texels, __m128i indices)
+	{
+		return _mm_i32gather_epi32(reinterpret_cast<const int*>(texels), indices, 4);
+	}
+
+	// Percent of each row's center between the projected start and end of the span.
+	__m256d getYPercentsAVX2(int y, double yProjStart, double yProjRange)
+	{
+		const __m256d yCenters = _mm256_add_pd(_mm256_cvtepi32_pd(
+			_mm_add_epi32(_mm_set1_epi32(y), _mm_set_epi32(3, 2, 1, 0))), _mm256_set1_pd(0.50));
+		return _mm256_div_pd(_mm256_sub_pd(yCenters, _mm256_set1_pd(yProjStart)),
+			_mm256_set1_pd(yProjRange));
+	}
+
+	void sampleWallRowsAVX2(const SpanKernels::WallSpan &span, int y, int yStart,
+		double yProjRange, double vRange, uint32_t *texels)
+	{
+		const __m256d yPercents = getYPercentsAVX2(y, span.yProjStart, yProjRange);
+		const __m256d v = _mm256_add_pd(_mm256_set1_pd(span.vStart),
+			_mm256_mul_pd(_mm256_set1_pd(vRange), yPercents));
+		const __m128i textureY = _mm256_cvttpd_epi32(
+			_mm256_mul_pd(v, _mm256_set1_pd(static_cast<double>(1 << span.textureBits))));
+		const __m128i indices = _mm_add_epi32(
+			_mm_set1_epi32(span.textureX << span.textureBits), textureY);
+
+		const __m128i rowTexels = loadTexelsAVX2(span.texels, indices);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(texels + (y - yStart)), rowTexels);
+	}
+
+	void samplePerspectiveRowsAVX2(const SpanKernels::PerspectiveSpan &span, int y, int yStart,
+		double yProjRange, double depthRecipRange, uint32_t *texels, double *depths)
+	{
+		const __m256d yPercents = getYPercentsAVX2(y, span.yProjStart, yProjRange);
+
+		// Interpolate between the near and far depth.
+		const __m256d depth = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_add_pd(
+			_mm256_set1_pd(span.depthStartRecip),
+			_mm256_mul_pd(_mm256_set1_pd(depthRecipRange), yPercents)));
+
+		// Interpolate between start and end points.
+		const __m256d currentPointX = _mm256_mul_pd(_mm256_add_pd(
+			_mm256_set1_pd(span.startPointDivX),
+			_mm256_mul_pd(_mm256_set1_pd(span.pointDivDiffX), yPercents)), depth);
+		const __m256d currentPointY = _mm256_mul_pd(_mm256_add_pd(
+			_mm256_set1_pd(span.startPointDivY),
+			_mm256_mul_pd(_mm256_set1_pd(span.pointDivDiffY), yPercents)), depth);
+
+		// Texture coordinates.
+		const __m256d justBelowOne = _mm256_set1_pd(span.justBelowOne);
+		const __m256d zero = _mm256_setzero_pd();
+		const __m256d u = _mm256_min_pd(_mm256_max_pd(_mm256_sub_pd(justBelowOne,
+			_mm256_sub_pd(currentPointX, _mm256_floor_pd(currentPointX))), zero), justBelowOne);
+		const __m256d v = _mm256_min_pd(_mm256_max_pd(_mm256_sub_pd(justBelowOne,
+			_mm256_sub_pd(currentPointY, _mm256_floor_pd(currentPointY))), zero), justBelowOne);
+
+		const __m256d textureSize = _mm256_set1_pd(static_cast<double>(1 << span.textureBits));
+		const __m128i textureX = _mm256_cvttpd_epi32(_mm256_mul_pd(u, textureSize));
+		const __m128i textureY = _mm256_cvttpd_epi32(_mm256_mul_pd(v, textureSize));
+		const __m128i indices = _mm_add_epi32(
+			_mm_sll_epi32(textureX, _mm_cvtsi32_si128(span.textureBits)), textureY);
+
+		const __m128i rowTexels = loadTexelsAVX2(span.texels, indices);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(texels + (y - yStart)), rowTexels);
+		_mm256_storeu_pd(depths + (y - yStart), depth);
+	}
+
+	// Joins two vectors of four 32-bit values into one of eight.
+	__m256i combineAVX2(__m128i lo, __m128i hi)
+	{
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+	}
+
+	// Same as std::round() (halfway cases away from zero) for values that fit in a 32-bit
+	// integer. The fraction is exact, so this matches it bit for bit.
+	__m256d roundAVX2(__m256d value)
+	{
+		const __m256d truncated = _mm256_round_pd(value, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+		const __m256d fraction = _mm256_sub_pd(value, truncated);
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d roundUp = _mm256_and_pd(
+			_mm256_cmp_pd(fraction, _mm256_set1_pd(0.50), _CMP_GE_OQ), one);
+		const __m256d roundDown = _mm256_and_pd(
+			_mm256_cmp_pd(fraction, _mm256_set1_pd(-0.50), _CMP_LE_OQ), one);
+		return _mm256_sub_pd(_mm256_add_pd(truncated, roundUp), roundDown);
+	}
+
+	// Fog factors of eight depths, like SpanKernels::getFogFactor().
+	__m256i getFogFactorsAVX2(const double *depths, __m256d fogScale)
+	{
+		const __m256d fogFactorMax =
+			_mm256_set1_pd(static_cast<double>(SpanKernels::FOG_FACTOR_MAX));
+		const __m128i fogFactorsLo = _mm256_cvttpd_epi32(
+			_mm256_min_pd(_mm256_mul_pd(_mm256_loadu_pd(depths), fogScale), fogFactorMax));
+		const __m128i fogFactorsHi = _mm256_cvttpd_epi32(
+			_mm256_min_pd(_mm256_mul_pd(_mm256_loadu_pd(depths + 4), fogScale), fogFactorMax));
+		return combineAVX2(fogFactorsLo, fogFactorsHi);
+	}
+
+	// Light levels of one channel for eight rows some percent between the start and end
+	// levels, like shadePerspectiveTexelsScalar().
+	__m256i getRowLevelsAVX2(int start, int end, __m256d percentsLo, __m256d percentsHi)
+	{
+		const __m256d range = _mm256_set1_pd(static_cast<double>(end - start));
+		const __m128i offsetsLo = _mm256_cvttpd_epi32(roundAVX2(_mm256_mul_pd(range, percentsLo)));
+		const __m128i offsetsHi = _mm256_cvttpd_epi32(roundAVX2(_mm256_mul_pd(range, percentsHi)));
+		return _mm256_add_epi32(_mm256_set1_epi32(start), combineAVX2(offsetsLo, offsetsHi));
+	}
+
+	// Spreads a 32-bit value per texel (eight texels) over 16-bit lanes, four lanes per texel.
+	// Like _mm256_unpacklo_epi8() does with texels, the low vector gets texels 0, 1, 4, and 5,
+	// and the high vector gets texels 2, 3, 6, and 7.
+	void spreadTexelValuesAVX2(__m256i values, __m256i *outLo, __m256i *outHi)
+	{
+		const __m256i values16 = _mm256_packs_epi32(values, values);
+		const __m256i pairs = _mm256_unpacklo_epi16(values16, values16);
+		*outLo = _mm256_unpacklo_epi32(pairs, pairs);
+		*outHi = _mm256_unpackhi_epi32(pairs, pairs);
+	}
+
+	// Interleaves the light levels of each channel (eight texels) into 16-bit lanes as
+	// { r, g, b, 0 } for each texel, in the same texel order as spreadTexelValuesAVX2().
+	void interleaveLevelsAVX2(__m256i levelsR, __m256i levelsG, __m256i levelsB,
+		__m256i *outLo, __m256i *outHi)
+	{
+		const __m256i levelsRG = _mm256_unpacklo_epi16(_mm256_packs_epi32(levelsR, levelsR),
+			_mm256_packs_epi32(levelsG, levelsG));
+		const __m256i levelsB0 = _mm256_unpacklo_epi16(_mm256_packs_epi32(levelsB, levelsB),
+			_mm256_setzero_si256());
+		*outLo = _mm256_unpacklo_epi32(levelsRG, levelsB0);
+		*outHi = _mm256_unpackhi_epi32(levelsRG, levelsB0);
+	}
+
+	// Light levels as { r, g, b, 0 } for every texel in a vector.
+	__m256i getLevelsAVX2(int levelR, int levelG, int levelB)
+	{
+		return _mm256_set1_epi64x(static_cast<long long>(levelR) |
+			(static_cast<long long>(levelG) << 16) | (static_cast<long long>(levelB) << 32));
+	}
+
+	// Shades the unpacked channels of four texels (16-bit lanes, four per texel) with their
+	// light levels and fog factors, and puts them in packed color order.
+	__m256i shadeChannelsAVX2(__m256i channels, __m256i levels, __m256i fogFactors,
+		__m256i fogColor)
+	{
+		// Channel times light level divided by the max level, like the shade tables.
+		const __m256i lit = _mm256_srli_epi16(_mm256_mulhi_epu16(
+			_mm256_mullo_epi16(channels, levels),
+			_mm256_set1_epi16(static_cast<short>(SpanKernels::LIGHT_DIVIDE_MULTIPLIER))),
+			SpanKernels::LIGHT_DIVIDE_SHIFT);
+
+		// Same as SpanKernels::blendFog(). Each sum fits in 16 bits.
+		const __m256i colorPercents = _mm256_sub_epi16(
+			_mm256_set1_epi16(SpanKernels::FOG_FACTOR_MAX), fogFactors);
+		const __m256i blended = _mm256_srli_epi16(_mm256_add_epi16(
+			_mm256_mullo_epi16(lit, colorPercents), _mm256_mullo_epi16(fogColor, fogFactors)),
+			SpanKernels::FOG_FACTOR_BITS);
+
+		// Texels are red, green, blue, flags, and colors are blue, green, red, zero.
+		return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(blended, _MM_SHUFFLE(3, 0, 1, 2)),
+			_MM_SHUFFLE(3, 0, 1, 2));
+	}
+
+	// Shades eight packed texels like the SSE2 version. The light levels and fog factors are
+	// in the texel order of spreadTexelValuesAVX2().
+	__m256i shadeTexelsAVX2(__m256i texels, __m256i levelsLo, __m256i levelsHi,
+		__m256i fogFactorsLo, __m256i fogFactorsHi, __m256i fogColor, __m256i nightLightTexel)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+
+		// Night light texels are replaced before checking for emission, like the scalar version.
+		const __m256i isNightLight = _mm256_cmpgt_epi32(_mm256_and_si256(texels,
+			_mm256_set1_epi32(SpanKernels::TEXEL_FLAG_NIGHT_LIGHT << 24)), zero);
+		texels = _mm256_blendv_epi8(texels, nightLightTexel, isNightLight);
+
+		// Emissive texels are fully lit.
+		const __m256i isEmissive = _mm256_cmpgt_epi32(_mm256_and_si256(texels,
+			_mm256_set1_epi32(SpanKernels::TEXEL_FLAG_EMISSIVE << 24)), zero);
+		const __m256i maxLevels = getLevelsAVX2(SpanKernels::LIGHT_LEVEL_MAX,
+			SpanKernels::LIGHT_LEVEL_MAX, SpanKernels::LIGHT_LEVEL_MAX);
+		levelsLo = _mm256_blendv_epi8(levelsLo, maxLevels,
+			_mm256_unpacklo_epi32(isEmissive, isEmissive));
+		levelsHi = _mm256_blendv_epi8(levelsHi, maxLevels,
+			_mm256_unpackhi_epi32(isEmissive, isEmissive));
+
+		const __m256i colorsLo = shadeChannelsAVX2(_mm256_unpacklo_epi8(texels, zero), levelsLo,
+			fogFactorsLo, fogColor);
+		const __m256i colorsHi = shadeChannelsAVX2(_mm256_unpackhi_epi8(texels, zero), levelsHi,
+			fogFactorsHi, fogColor);
+		return _mm256_packus_epi16(colorsLo, colorsHi);
+	}
+
+	// Fog color channels in the same layout as getLevelsAVX2().
+	__m256i getFogColorAVX2(uint32_t fogColor)
+	{
+		return getLevelsAVX2((fogColor >> 16) & 0xFF, (fogColor >> 8) & 0xFF, fogColor & 0xFF);
+	}
+}
+#endif
+
+bool SpanKernels::isAVX2Built()
+{
+#if defined(__AVX2__)
+	return true;
+#else
+	return false;
+#endif
+}
+
+void SpanKernels::sampleWallSpanAVX2(const WallSpan &span, int yStart, int yEnd,
+	uint32_t *texels)
+{
+#if defined(__AVX2__)
+	const double yProjRange = span.yProjEnd - span.yProjStart;
+	const double vRange = span.vEnd - span.vStart;
+
+	// Eight rows per iteration, four per vector.
+	int y = yStart;
+	for (; (y + 8) <= yEnd; y += 8)
+	{
+		sampleWallRowsAVX2(span, y, yStart, yProjRange, vRange, texels);
+		sampleWallRowsAVX2(span, y + 4, yStart, yProjRange, vRange, texels);
+	}
+
+	SpanKernels::sampleWallSpanScalar(span, y, yEnd, texels + (y - yStart));
+#else
+	SpanKernels::sampleWallSpanSSE2(span, yStart, yEnd, texels);
+#endif
+}
+
+void SpanKernels::samplePerspectiveSpanAVX2(const PerspectiveSpan &span, int yStart, int yEnd,
+	uint32_t *texels, double *depths)
+{
+#if defined(__AVX2__)
+	const double yProjRange = span.yProjEnd - span.yProjStart;
+	const double depthRecipRange = span.depthEndRecip - span.depthStartRecip;
+
+	// Eight rows per iteration, four per vector.
+	int y = yStart;
+	for (; (y + 8) <= yEnd; y += 8)
+	{
+		samplePerspectiveRowsAVX2(span, y, yStart, yProjRange, depthRecipRange, texels, depths);
+		samplePerspectiveRowsAVX2(span, y + 4, yStart, yProjRange, depthRecipRange, texels,
+			depths);
+	}
+
+	SpanKernels::samplePerspectiveSpanScalar(span, y, yEnd, texels + (y - yStart),
+		depths + (y - yStart));
+#else
+	SpanKernels::samplePerspectiveSpanSSE2(span, yStart, yEnd, texels, depths);
+#endif
+}
+
+void SpanKernels::shadeWallTexelsAVX2(const Shading &shading, int fogFactor, int count,
+	uint32_t *colors)
+{
+#if defined(__AVX2__)
+	const __m256i levels = getLevelsAVX2(shading.lightR, shading.lightG, shading.lightB);
+	const __m256i fogFactors = _mm256_set1_epi16(static_cast<short>(fogFactor));
+	const __m256i fogColor = getFogColorAVX2(shading.fogColor);
+	const __m256i nightLightTexel =
+		_mm256_set1_epi32(static_cast<int>(shading.nightLightTexel));
+
+	int i = 0;
+	for (; (i + 8) <= count; i += 8)
+	{
+		__m256i *texels = reinterpret_cast<__m256i*>(colors + i);
+		_mm256_storeu_si256(texels, shadeTexelsAVX2(_mm256_loadu_si256(texels), levels, levels,
+			fogFactors, fogFactors, fogColor, nightLightTexel));
+	}
+
+	SpanKernels::shadeWallTexelsSSE2(shading, fogFactor, count - i, colors + i);
+#else
+	SpanKernels::shadeWallTexelsSSE2(shading, fogFactor, count, colors);
+#endif
+}
+
+void SpanKernels::shadePerspectiveTexelsAVX2(const PerspectiveSpan &span,
+	const Shading &shading, const double *depths, int count, uint32_t *colors)
+{
+#if defined(__AVX2__)
+	const bool constantLight = (span.lightEndR == shading.lightR) &&
+		(span.lightEndG == shading.lightG) && (span.lightEndB == shading.lightB);
+	const double depthStart = 1.0 / span.depthStartRecip;
+	const double depthEnd = 1.0 / span.depthEndRecip;
+	const double depthRange = depthEnd - depthStart;
+	const double depthRangeRecip = (depthRange != 0.0) ? (1.0 / depthRange) : 0.0;
+
+	const __m256i levels = getLevelsAVX2(shading.lightR, shading.lightG, shading.lightB);
+	const __m256d fogScale = _mm256_set1_pd(shading.fogScale);
+	const __m256i fogColor = getFogColorAVX2(shading.fogColor);
+	const __m256i nightLightTexel =
+		_mm256_set1_epi32(static_cast<int>(shading.nightLightTexel));
+
+	// Percent of four rows' depths between the two ends, which their light is interpolated by.
+	auto getPercents = [depthStart, depthRangeRecip](const double *rowDepths)
+	{
+		const __m256d percents = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(rowDepths),
+			_mm256_set1_pd(depthStart)), _mm256_set1_pd(depthRangeRecip));
+		return _mm256_min_pd(_mm256_max_pd(percents, _mm256_setzero_pd()),
+			_mm256_set1_pd(1.0));
+	};
+
+	int i = 0;
+	for (; (i + 8) <= count; i += 8)
+	{
+		__m256i fogFactorsLo, fogFactorsHi;
+		spreadTexelValuesAVX2(getFogFactorsAVX2(depths + i, fogScale), &fogFactorsLo,
+			&fogFactorsHi);
+
+		__m256i levelsLo = levels;
+		__m256i levelsHi = levels;
+		if (!constantLight)
+		{
+			const __m256d percentsLo = getPercents(depths + i);
+			const __m256d percentsHi = getPercents(depths + i + 4);
+			interleaveLevelsAVX2(
+				getRowLevelsAVX2(shading.lightR, span.lightEndR, percentsLo, percentsHi),
+				getRowLevelsAVX2(shading.lightG, span.lightEndG, percentsLo, percentsHi),
+				getRowLevelsAVX2(shading.lightB, span.lightEndB, percentsLo, percentsHi),
+				&levelsLo, &levelsHi);
+		}
+
+		__m256i *texels = reinterpret_cast<__m256i*>(colors + i);
+		_mm256_storeu_si256(texels, shadeTexelsAVX2(_mm256_loadu_si256(texels), levelsLo,
+			levelsHi, fogFactorsLo, fogFactorsHi, fogColor, nightLightTexel));
+	}
+
+	SpanKernels::shadePerspectiveTexelsSSE2(span, shading, depths + i, count - i, colors + i);
+#else
+	SpanKernels::shadePerspectiveTexelsSSE2(span, shading, depths, count, colors);
+#endif
+}
+
+void SpanKernels::expandIndicesAVX2(const uint32_t *palette, const uint8_t *indices,
+	int count, uint32_t *colors)
+{
+#if defined(__AVX2__)
+	int i = 0;
+	for (; (i + 8) <= count; i += 8)
+	{
+		const __m256i paletteIndices = _mm256_cvtepu8_epi32(
+			_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i)));
+		const __m256i pixelColors = _mm256_i32gather_epi32(
+			reinterpret_cast<const int*>(palette), paletteIndices, 4);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(colors + i), pixelColors);
+	}
+
+	SpanKernels::expandIndicesSSE2(palette, indices + i, count - i, colors + i);
+#else
+	SpanKernels::expandIndicesSSE2(palette, indices, count, colors);
+#endif
+}
@@ -0,0 +1,116 @@
+#include <string>
+
+#include "SpriteBatch.h"
+#include "../Utilities/Debug.h"
+
+SpriteBatch::SpriteBatch()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// The SDL library might be older than the headers the game was built with.
+	SDL_version version;
+	SDL_GetVersion(&version);
+	this->geometrySupported = SDL_VERSIONNUM(version.major, version.minor, version.patch) >=
+		SDL_VERSIONNUM(2, 0, 18);
+#else
+	this->geometrySupported = false;
+#endif
+}
+
+void SpriteBatch::drawRun(int start, int end, SDL_Renderer *renderer)
+{
+	SDL_Texture *texture = this->sprites[start].texture;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// One geometry call for the whole run instead of one copy per sprite.
+	if (this->geometrySupported && ((end - start) > 1))
+	{
+		int textureWidth, textureHeight;
+		SDL_QueryTexture(texture, nullptr, nullptr, &textureWidth, &textureHeight);
+		const float uScale = 1.0f / static_cast<float>(textureWidth);
+		const float vScale = 1.0f / static_cast<float>(textureHeight);
+
+		const SDL_Color white = { 255, 255, 255, 255 };
+		this->vertices.clear();
+		this->indices.clear();
+		for (int i = start; i < end; i++)
+		{
+			const Sprite &sprite = this->sprites[i];
+			const SDL_Rect &src = sprite.srcRect;
+			const SDL_Rect &dst = sprite.dstRect;
+			const float left = static_cast<float>(dst.x);
+			const float top = static_cast<float>(dst.y);
+			const float right = static_cast<float>(dst.x + dst.w);
+			const float bottom = static_cast<float>(dst.y + dst.h);
+			const float uStart = static_cast<float>(src.x) * uScale;
+			const float vStart = static_cast<float>(src.y) * vScale;
+			const float uEnd = static_cast<float>(src.x + src.w) * uScale;
+			const float vEnd = static_cast<float>(src.y + src.h) * vScale;
+
+			// Top left, top right, bottom left, bottom right.
+			const int firstIndex = static_cast<int>(this->vertices.size());
+			this->vertices.push_back({ { left, top }, white, { uStart, vStart } });
+			this->vertices.push_back({ { right, top }, white, { uEnd, vStart } });
+			this->vertices.push_back({ { left, bottom }, white, { uStart, vEnd } });
+			this->vertices.push_back({ { right, bottom }, white, { uEnd, vEnd } });
+
+			this->indices.push_back(firstIndex);
+			this->indices.push_back(firstIndex + 1);
+			this->indices.push_back(firstIndex + 2);
+			this->indices.push_back(firstIndex + 2);
+			this->indices.push_back(firstIndex + 1);
+			this->indices.push_back(firstIndex + 3);
+		}
+
+		const int status = SDL_RenderGeometry(renderer, texture, this->vertices.data(),
+			static_cast<int>(this->vertices.size()), this->indices.data(),
+			static_cast<int>(this->indices.size()));
+
+		if (status == 0)
+		{
+			return;
+		}
+
+		// The renderer can't draw geometry, so copy the sprites from now on.
+		DebugWarning("Couldn't draw sprites as geometry, " + std::string(SDL_GetError()));
+		this->geometrySupported = false;
+	}
+#endif
+
+	// Copies with the same texture in a row don't rebind it.
+	for (int i = start; i < end; i++)
+	{
+		const Sprite &sprite = this->sprites[i];
+		SDL_RenderCopy(renderer, texture, &sprite.srcRect, &sprite.dstRect);
+	}
+}
+
+bool SpriteBatch::isEmpty() const
+{
+	return this->sprites.size() == 0;
+}
+
+void SpriteBatch::add(SDL_Texture *texture, const SDL_Rect &srcRect, const SDL_Rect &dstRect)
+{
+	Sprite sprite;
+	sprite.texture = texture;
+	sprite.srcRect = srcRect;
+	sprite.dstRect = dstRect;
+	this->sprites.push_back(sprite);
+}
+
+void SpriteBatch::flush(SDL_Renderer *renderer)
+{
+	// Split the sprites into runs of the same texture, keeping their order.
+	const int spriteCount = static_cast<int>(this->sprites.size());
+	int runStart = 0;
+	for (int i = 1; i <= spriteCount; i++)
+	{
+		if ((i == spriteCount) || (this->sprites[i].texture != this->sprites[runStart].texture))
+		{
+			this->drawRun(runStart, i, renderer);
+			runStart = i;
+		}
+	}
+
+	this->sprites.clear();
+}
@@ -0,0 +1,51 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include <vector>
+
+#include "SDL.h"
+
+// Collects texture copies so that runs of them from the same texture (i.e., a texture atlas
+// page) can be submitted together. Copies are drawn in the order they were added, so
+// overlapping sprites stay layered the same.
+
+// Only textures that outlive the batch should be added, since copies are drawn later.
+
+// Runs are drawn as one piece of geometry with SDL 2.0.18 or newer, and as separate copies
+// otherwise, or if the renderer can't draw geometry.
+
+class SpriteBatch
+{
+private:
+	struct Sprite
+	{
+		SDL_Texture *texture;
+		SDL_Rect srcRect, dstRect;
+	};
+
+	std::vector<Sprite> sprites;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// Two triangles for each sprite in a run, reused between runs.
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+#endif
+
+	// Whether runs can be drawn as geometry with the SDL library in use.
+	bool geometrySupported;
+
+	// Submits the sprites in the range [start, end), which all have the same texture.
+	void drawRun(int start, int end, SDL_Renderer *renderer);
+public:
+	SpriteBatch();
+
+	bool isEmpty() const;
+
+	// Adds a copy of part of a texture to some area of the render target.
+	void add(SDL_Texture *texture, const SDL_Rect &srcRect, const SDL_Rect &dstRect);
+
+	// Draws all added sprites to the renderer's current render target and empties the batch.
+	void flush(SDL_Renderer *renderer);
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SDL.h"
+
+#include "Renderer.h"
+#include "TextureAtlas.h"
+#include "../Utilities/Debug.h"
+
+const int TextureAtlas::PAGE_SIZE = 1024;
+const int TextureAtlas::MAX_ENTRY_WIDTH = 320;
+const int TextureAtlas::MAX_ENTRY_HEIGHT = 128;
+const int TextureAtlas::PADDING = 1;
+
+TextureAtlas::Entry::Entry(SDL_Texture *page, int x, int y, int width, int height)
+{
+	this->page = page;
+	this->x = x;
+	this->y = y;
+	this->width = width;
+	this->height = height;
+}
+
+TextureAtlas::Shelf::Shelf(int y, int height)
+{
+	this->y = y;
+	this->height = height;
+	this->usedWidth = 0;
+}
+
+TextureAtlas::Page::Page(SDL_Texture *texture)
+{
+	this->texture = texture;
+	this->usedHeight = 0;
+}
+
+bool TextureAtlas::Page::allocate(int width, int height, int *x, int *y)
+{
+	// Pick the shortest shelf the entry fits in, so short entries don't use up tall shelves.
+	Shelf *bestShelf = nullptr;
+	for (Shelf &shelf : this->shelves)
+	{
+		const bool fits = (shelf.height >= height) &&
+			((shelf.usedWidth + width) <= TextureAtlas::PAGE_SIZE);
+
+		if (fits && ((bestShelf == nullptr) || (shelf.height < bestShelf->height)))
+		{
+			bestShelf = &shelf;
+		}
+	}
+
+	if (bestShelf == nullptr)
+	{
+		// Start a new shelf below the others if there's room.
+		if ((this->usedHeight + height) > TextureAtlas::PAGE_SIZE)
+		{
+			return false;
+		}
+
+		this->shelves.push_back(Shelf(this->usedHeight, height));
+		this->usedHeight += height;
+		bestShelf = &this->shelves.back();
+	}
+
+	*x = bestShelf->usedWidth;
+	*y = bestShelf->y;
+	bestShelf->usedWidth += width;
+	return true;
+}
+
+TextureAtlas::TextureAtlas()
+{
+
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	this->clear();
+}
+
+bool TextureAtlas::add(SDL_Texture *texture, SDL_Surface *surface,
+	const std::string &paletteName, SDL_Renderer *renderer)
+{
+	assert(texture != nullptr);
+	assert(surface != nullptr);
+
+	if (this->entries.find(texture) != this->entries.end())
+	{
+		return true;
+	}
+
+	const int width = surface->w;
+	const int height = surface->h;
+	if ((width > TextureAtlas::MAX_ENTRY_WIDTH) || (height > TextureAtlas::MAX_ENTRY_HEIGHT))
+	{
+		return false;
+	}
+
+	// Get the pixels in the page format before finding room for them, so a failed
+	// conversion doesn't use up any space.
+	SDL_Surface *convertedSurface = nullptr;
+	if (surface->format->format != Renderer::DEFAULT_PIXELFORMAT)
+	{
+		convertedSurface = SDL_ConvertSurfaceFormat(surface, Renderer::DEFAULT_PIXELFORMAT, 0);
+		if (convertedSurface == nullptr)
+		{
+			DebugWarning("Couldn't convert texture for the atlas, " +
+				std::string(SDL_GetError()));
+			return false;
+		}
+	}
+
+	const SDL_Surface *srcSurface = (convertedSurface != nullptr) ? convertedSurface : surface;
+
+	// Find room in an existing page of the palette, or else make a new one.
+	std::vector<Page> &pages = this->palettePages[paletteName];
+	const int paddedWidth = width + TextureAtlas::PADDING;
+	const int paddedHeight = height + TextureAtlas::PADDING;
+	int x, y;
+	Page *page = nullptr;
+	for (Page &existingPage : pages)
+	{
+		if (existingPage.allocate(paddedWidth, paddedHeight, &x, &y))
+		{
+			page = &existingPage;
+			break;
+		}
+	}
+
+	if (page == nullptr)
+	{
+		SDL_Texture *pageTexture = SDL_CreateTexture(renderer, Renderer::DEFAULT_PIXELFORMAT,
+			SDL_TEXTUREACCESS_STATIC, TextureAtlas::PAGE_SIZE, TextureAtlas::PAGE_SIZE);
+		DebugAssertMsg(pageTexture != nullptr, "Couldn't create texture atlas page, " +
+			std::string(SDL_GetError()));
+
+		// Start transparent so the padding between entries is.
+		const int pagePixelCount = TextureAtlas::PAGE_SIZE * TextureAtlas::PAGE_SIZE;
+		const std::vector<uint32_t> clearPixels(pagePixelCount, 0);
+		SDL_UpdateTexture(pageTexture, nullptr, clearPixels.data(),
+			TextureAtlas::PAGE_SIZE * sizeof(uint32_t));
+		SDL_SetTextureBlendMode(pageTexture, SDL_BLENDMODE_BLEND);
+
+		pages.push_back(Page(pageTexture));
+		page = &pages.back();
+
+		// Entries are never bigger than a page.
+		const bool allocated = page->allocate(paddedWidth, paddedHeight, &x, &y);
+		DebugAssertMsg(allocated, "Couldn't allocate " + std::to_string(width) + "x" +
+			std::to_string(height) + " in an empty texture atlas page.");
+	}
+
+	const SDL_Rect rect = { x, y, width, height };
+	SDL_UpdateTexture(page->texture, &rect, srcSurface->pixels, srcSurface->pitch);
+
+	if (convertedSurface != nullptr)
+	{
+		SDL_FreeSurface(convertedSurface);
+	}
+
+	this->entries.insert(std::make_pair(texture, Entry(page->texture, x, y, width, height)));
+	return true;
+}
+
+const TextureAtlas::Entry *TextureAtlas::find(SDL_Texture *texture) const
+{
+	const auto entryIter = this->entries.find(texture);
+	return (entryIter != this->entries.end()) ? &entryIter->second : nullptr;
+}
+
+void TextureAtlas::clear()
+{
+	for (auto &pair : this->palettePages)
+	{
+		for (Page &page : pair.second)
+		{
+			SDL_DestroyTexture(page.texture);
+		}
+	}
+
+	this->palettePages.clear();
+	this->entries.clear();
+}
@@ -0,0 +1,80 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Packs small interface textures (icons, buttons, cursors, etc.) into a few large page
+// textures, so drawing many of them in a row doesn't switch textures. Each packed texture
+// still has its own SDL texture, which is used to look up where its copy is in the atlas.
+// Textures of each palette get their own pages, since a screen's textures share a palette.
+
+struct SDL_Renderer;
+struct SDL_Surface;
+struct SDL_Texture;
+
+class TextureAtlas
+{
+public:
+	// Where a packed texture's copy is.
+	struct Entry
+	{
+		SDL_Texture *page;
+		int x, y, width, height;
+
+		Entry(SDL_Texture *page, int x, int y, int width, int height);
+	};
+private:
+	// A row of entries in a page. Entries are placed left to right in the shelf with the
+	// least height to spare, and a new shelf is started below the others if none fit.
+	struct Shelf
+	{
+		int y, height, usedWidth;
+
+		Shelf(int y, int height);
+	};
+
+	struct Page
+	{
+		SDL_Texture *texture;
+		std::vector<Shelf> shelves;
+		int usedHeight;
+
+		Page(SDL_Texture *texture);
+
+		// Finds room for an entry of the given size. Returns false if the page is full.
+		bool allocate(int width, int height, int *x, int *y);
+	};
+
+	// Width and height of each page. Power-of-two and small enough for any renderer.
+	static const int PAGE_SIZE;
+
+	// Largest entry dimensions. Bigger textures (i.e., full screen images) are only drawn
+	// once per frame anyway.
+	static const int MAX_ENTRY_WIDTH;
+	static const int MAX_ENTRY_HEIGHT;
+
+	// Transparent pixels between entries, so scaling never samples a neighbor.
+	static const int PADDING;
+
+	std::unordered_map<std::string, std::vector<Page>> palettePages; // Pages of each palette.
+	std::unordered_map<SDL_Texture*, Entry> entries;
+public:
+	TextureAtlas();
+	~TextureAtlas();
+
+	// Copies the given texture's pixels into a page of the given palette so it can be drawn
+	// from the atlas. The surface must have the texture's pixels. Returns false if the
+	// texture is too big or its pixels couldn't be converted.
+	bool add(SDL_Texture *texture, SDL_Surface *surface, const std::string &paletteName,
+		SDL_Renderer *renderer);
+
+	// Gets where the given texture is in the atlas, or null if it isn't packed.
+	const Entry *find(SDL_Texture *texture) const;
+
+	// Destroys all pages. Must be called before the SDL renderer is destroyed.
+	void clear();
+};
+
+#endif
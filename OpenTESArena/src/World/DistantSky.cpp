@@ -701,6 +701,36 @@ void DistantSky::init(int localCityID, int provinceID, WeatherType weatherType,
 	}
 }
 
+void DistantSky::addLandObject(const LandObject &landObject)
+{
+	this->landObjects.push_back(landObject);
+}
+
+void DistantSky::addAnimatedLandObject(const AnimatedLandObject &animLandObject)
+{
+	this->animLandObjects.push_back(animLandObject);
+}
+
+void DistantSky::addAirObject(const AirObject &airObject)
+{
+	this->airObjects.push_back(airObject);
+}
+
+void DistantSky::addMoonObject(const MoonObject &moonObject)
+{
+	this->moonObjects.push_back(moonObject);
+}
+
+void DistantSky::addStarObject(const StarObject &starObject)
+{
+	this->starObjects.push_back(starObject);
+}
+
+void DistantSky::setSunSurface(const Surface &surface)
+{
+	this->sunSurface = &surface;
+}
+
 void DistantSky::tick(double dt)
 {
 	// Only animated distant land needs updating.
@@ -165,6 +165,15 @@ public:
 	void init(int localCityID, int provinceID, WeatherType weatherType, int currentDay,
 		int starCount, const MiscAssets &miscAssets, TextureManager &textureManager);
 
+	// Adds objects directly instead of loading them from game data (i.e., for synthetic
+	// scenes in tools). Each object's surfaces must outlive the distant sky.
+	void addLandObject(const LandObject &landObject);
+	void addAnimatedLandObject(const AnimatedLandObject &animLandObject);
+	void addAirObject(const AirObject &airObject);
+	void addMoonObject(const MoonObject &moonObject);
+	void addStarObject(const StarObject &starObject);
+	void setSunSurface(const Surface &surface);
+
 	void tick(double dt);
 };
 
@@ -2,6 +2,12 @@
 
 #include "VoxelGrid.h"
 
+namespace
+{
+	// Last revision given to any voxel grid. Grids are only changed on the main thread.
+	uint64_t LastRevision = 0;
+}
+
 VoxelGrid::VoxelGrid(int width, int height, int depth)
 {
 	const int voxelCount = width * height * depth;
@@ -10,6 +16,7 @@ VoxelGrid::VoxelGrid(int width, int height, int depth)
 	this->width = width;
 	this->height = height;
 	this->depth = depth;
+	this->markChanged();
 }
 
 int VoxelGrid::getIndex(int x, int y, int z) const
@@ -17,6 +24,12 @@ int VoxelGrid::getIndex(int x, int y, int z) const
 	return x + (y * this->width) + (z * this->width * this->height);
 }
 
+void VoxelGrid::markChanged()
+{
+	LastRevision++;
+	this->revision = LastRevision;
+}
+
 Int2 VoxelGrid::getTransformedCoordinate(const Int2 &voxel, int gridWidth, int gridDepth)
 {
 	// These have a -1 whereas the Double2 version does not since all .MIF start points
@@ -49,8 +62,14 @@ int VoxelGrid::getDepth() const
 	return this->depth;
 }
 
+uint64_t VoxelGrid::getRevision() const
+{
+	return this->revision;
+}
+
 uint16_t *VoxelGrid::getVoxels()
 {
+	this->markChanged();
 	return this->voxels.data();
 }
 
@@ -67,6 +86,7 @@ uint16_t VoxelGrid::getVoxel(int x, int y, int z) const
 
 VoxelData &VoxelGrid::getVoxelData(uint16_t id)
 {
+	this->markChanged();
 	return this->voxelData.at(id);
 }
 
@@ -75,9 +95,15 @@ const VoxelData &VoxelGrid::getVoxelData(uint16_t id) const
 	return this->voxelData.at(id);
 }
 
+int VoxelGrid::getVoxelDataCount() const
+{
+	return static_cast<int>(this->voxelData.size());
+}
+
 uint16_t VoxelGrid::addVoxelData(const VoxelData &voxelData)
 {
 	this->voxelData.push_back(voxelData);
+	this->markChanged();
 
 	return static_cast<uint16_t>(this->voxelData.size() - 1);
 }
@@ -86,4 +112,5 @@ void VoxelGrid::setVoxel(int x, int y, int z, uint16_t id)
 {
 	const int index = this->getIndex(x, y, z);
 	this->voxels.data()[index] = id;
+	this->markChanged();
 }
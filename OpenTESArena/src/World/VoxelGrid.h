@@ -19,6 +19,10 @@ private:
 	std::vector<uint16_t> voxels;
 	std::vector<VoxelData> voxelData;
 	int width, height, depth;
+	uint64_t revision;
+
+	// Gives the grid a new revision after a change.
+	void markChanged();
 
 	// Converts XYZ coordinate to index.
 	int getIndex(int x, int y, int z) const;
@@ -36,17 +40,26 @@ public:
 	int getHeight() const;
 	int getDepth() const;
 
-	// Gets a pointer to the voxel grid data.
+	// Gets a value that is different every time any grid's voxels or voxel data might have
+	// changed, so it can be compared instead of the grid itself. Copies of a grid share its
+	// revision until one of them changes.
+	uint64_t getRevision() const;
+
+	// Gets a pointer to the voxel grid data. The non-const version counts as a change, since
+	// the caller can write through it.
 	uint16_t *getVoxels();
 	const uint16_t *getVoxels() const;
 
 	// Convenience method for getting a voxel's ID.
 	uint16_t getVoxel(int x, int y, int z) const;
 
-	// Gets the voxel data associated with an ID.
+	// Gets the voxel data associated with an ID. The non-const version counts as a change.
 	VoxelData &getVoxelData(uint16_t id);
 	const VoxelData &getVoxelData(uint16_t id) const;
 
+	// Gets the number of voxel data objects (i.e., one past the highest voxel ID).
+	int getVoxelDataCount() const;
+
 	// Adds a voxel data object and returns its assigned ID.
 	uint16_t addVoxelData(const VoxelData &voxelData);
 